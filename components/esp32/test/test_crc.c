@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_crc.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp32/rom/crc.h"
+
+TEST_CASE("esp_crc32_le matches ROM crc32_le", "[crc]")
+{
+    const size_t MAX_LEN = 100;
+    uint8_t *buf = heap_caps_malloc(MAX_LEN + 8, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_NOT_NULL(buf);
+    srand(0);
+    for (size_t i = 0; i < MAX_LEN + 8; i++) {
+        buf[i] = rand();
+    }
+    // all alignments and lengths around the word and double word loops
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= MAX_LEN; len++) {
+            uint32_t init = rand();
+            TEST_ASSERT_EQUAL_HEX32(crc32_le(init, buf + offset, len), esp_crc32_le(init, buf + offset, len));
+            TEST_ASSERT_EQUAL_HEX32(crc32_le(init, buf + offset, len), esp_crc32_le_sliced(init, buf + offset, len));
+        }
+    }
+    free(buf);
+}
+
+TEST_CASE("esp_crc32_le performance", "[crc]")
+{
+    const unsigned CALLS = 256;
+    const unsigned CALL_SZ = 4096;
+    uint8_t *buf = heap_caps_malloc(CALL_SZ, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_NOT_NULL(buf);
+    memset(buf, 0x55, CALL_SZ);
+
+    uint32_t crc_rom = 0;
+    int64_t start = esp_timer_get_time();
+    for (int c = 0; c < CALLS; c++) {
+        crc_rom = crc32_le(crc_rom, buf, CALL_SZ);
+    }
+    int64_t rom_time = esp_timer_get_time() - start;
+
+    uint32_t crc_sliced = 0;
+    start = esp_timer_get_time();
+    for (int c = 0; c < CALLS; c++) {
+        crc_sliced = esp_crc32_le_sliced(crc_sliced, buf, CALL_SZ);
+    }
+    int64_t sliced_time = esp_timer_get_time() - start;
+    free(buf);
+
+    TEST_ASSERT_EQUAL_HEX32(crc_rom, crc_sliced);
+    // bytes/usec = MB/sec
+    printf("ROM crc32_le %.3fMB/sec, esp_crc32_le_sliced %.3fMB/sec\n",
+           (float)(CALL_SZ * CALLS) / rom_time, (float)(CALL_SZ * CALLS) / sliced_time);
+}
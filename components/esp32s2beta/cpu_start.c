@@ -314,6 +314,9 @@ void start_cpu0_default(void)
 #endif
     err = esp_pthread_init();
     assert(err == ESP_OK && "Failed to init pthread module!");
+#if CONFIG_LOG_DEFERRED
+    esp_log_deferred_init();
+#endif
 
     do_global_ctors();
 
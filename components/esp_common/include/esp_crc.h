@@ -30,6 +30,20 @@ extern "C" {
 * CRC32        x32+x26+x23+x22+x16+x12+x11+x10+x8+x7+x5+x4+x2+x1+1     0x04c11db7
 ********************************************************************************/
 
+/**
+* @brief CRC32 value in little endian, computed in software.
+*
+* Gives the same result as the ROM function crc32_le(). Up to eight bytes are processed
+* at a time, using CONFIG_ESP_CRC32_TABLE_SLICES lookup tables of 1 KB each.
+* Usually called through esp_crc32_le().
+*
+* @param crc: Initial CRC value (result of last calculation or 0 for the first time)
+* @param buf: Data buffer that used to calculate the CRC value
+* @param len: Length of the data buffer
+* @return CRC32 value
+*/
+uint32_t esp_crc32_le_sliced(uint32_t crc, uint8_t const *buf, uint32_t len);
+
 /**
 * @brief CRC32 value in little endian.
 *
@@ -40,7 +54,11 @@ extern "C" {
 */
 static inline uint32_t esp_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
 {
+#if CONFIG_ESP_CRC32_TABLE_SLICES > 1
+    return esp_crc32_le_sliced(crc, buf, len);
+#else
     return crc32_le(crc, buf, len);
+#endif
 }
 
 /**
@@ -0,0 +1,101 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_crc.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+// Host builds on ARMv8 have instructions for this polynomial
+#include <arm_acle.h>
+#endif
+
+#if CONFIG_ESP_CRC32_TABLE_SLICES > 1
+#define ESP_CRC32_TABLE_SLICES CONFIG_ESP_CRC32_TABLE_SLICES
+#else
+// Host stand-ins of the ROM function use the byte table only
+#define ESP_CRC32_TABLE_SLICES 1
+#endif
+
+#if CONFIG_ESP_CRC32_IN_IRAM
+#include "esp_attr.h"
+#define CRC32_TABLE_ATTR DRAM_ATTR
+#define CRC32_CODE_ATTR IRAM_ATTR
+#else
+#define CRC32_TABLE_ATTR
+#define CRC32_CODE_ATTR
+#endif
+
+#include "esp_crc_table.h"
+
+_Static_assert(ESP_CRC32_TABLE_SLICES == 1 || ESP_CRC32_TABLE_SLICES == 4 || ESP_CRC32_TABLE_SLICES == 8,
+               "CRC32 table must have 1, 4 or 8 slices");
+
+#define CRC32_BYTE(crc, b) (s_crc32_le_table[0][((crc) ^ (b)) & 0xff] ^ ((crc) >> 8))
+
+/* Words are read as little endian, like the CPUs of all supported targets */
+static inline uint32_t load_word(const uint8_t *buf)
+{
+    uint32_t word;
+    memcpy(&word, buf, sizeof(word));
+    return word;
+}
+
+CRC32_CODE_ATTR uint32_t esp_crc32_le_sliced(uint32_t crc, uint8_t const *buf, uint32_t len)
+{
+    crc = ~crc;
+#if defined(__ARM_FEATURE_CRC32)
+    for (; len >= 8; len -= 8, buf += 8) {
+        uint64_t dword;
+        memcpy(&dword, buf, sizeof(dword));
+        crc = __crc32d(crc, dword);
+    }
+    for (; len > 0; len--, buf++) {
+        crc = __crc32b(crc, *buf);
+    }
+#else
+    // Word reads have to be aligned on the ESP32
+    for (; len > 0 && ((uintptr_t)buf & 3) != 0; len--, buf++) {
+        crc = CRC32_BYTE(crc, *buf);
+    }
+#if ESP_CRC32_TABLE_SLICES >= 8
+    for (; len >= 8; len -= 8, buf += 8) {
+        uint32_t one = load_word(buf) ^ crc;
+        uint32_t two = load_word(buf + 4);
+        crc = s_crc32_le_table[7][one & 0xff] ^
+              s_crc32_le_table[6][(one >> 8) & 0xff] ^
+              s_crc32_le_table[5][(one >> 16) & 0xff] ^
+              s_crc32_le_table[4][one >> 24] ^
+              s_crc32_le_table[3][two & 0xff] ^
+              s_crc32_le_table[2][(two >> 8) & 0xff] ^
+              s_crc32_le_table[1][(two >> 16) & 0xff] ^
+              s_crc32_le_table[0][two >> 24];
+    }
+#endif
+#if ESP_CRC32_TABLE_SLICES >= 4
+    for (; len >= 4; len -= 4, buf += 4) {
+        uint32_t one = load_word(buf) ^ crc;
+        crc = s_crc32_le_table[3][one & 0xff] ^
+              s_crc32_le_table[2][(one >> 8) & 0xff] ^
+              s_crc32_le_table[1][(one >> 16) & 0xff] ^
+              s_crc32_le_table[0][one >> 24];
+    }
+#endif
+    for (; len > 0; len--, buf++) {
+        crc = CRC32_BYTE(crc, *buf);
+    }
+#endif // __ARM_FEATURE_CRC32
+    return ~crc;
+}
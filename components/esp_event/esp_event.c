@@ -392,15 +392,40 @@ static void loop_node_remove_all_handler(esp_event_loop_node_t* loop_node)
     }
 }
 
-static void inline __attribute__((always_inline)) post_instance_delete(esp_event_post_instance_t* post)
+// Allocate memory for a copy of posted event data, from the loop's pool if it is small enough
+static inline __attribute__((always_inline)) void* post_data_alloc(esp_event_loop_instance_t* loop, size_t size)
+{
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    if (size <= CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE) {
+        void* data = heap_pool_alloc(loop->data_pool);
+        if (data != NULL) {
+            return data;
+        }
+    }
+#endif
+    return malloc(size);
+}
+
+static void inline __attribute__((always_inline)) post_data_free(esp_event_loop_instance_t* loop, void* data)
+{
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    if (heap_pool_contains(loop->data_pool, data)) {
+        heap_pool_free(loop->data_pool, data);
+        return;
+    }
+#endif
+    free(data);
+}
+
+static void inline __attribute__((always_inline)) post_instance_delete(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post)
 {
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
     if (post->data_allocated && post->data.ptr) {
-        free(post->data.ptr);
+        post_data_free(loop, post->data.ptr);
     }
 #else
     if (post->data) {
-        free(post->data);
+        post_data_free(loop, post->data);
     }
 #endif
     memset(post, 0, sizeof(*post));
@@ -441,6 +466,16 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         goto on_err;
     }
 
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    // one block for each queued event, and one for the event being dispatched
+    loop->data_pool = heap_pool_create(CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE, event_loop_args->queue_size + 1,
+                                       MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (loop->data_pool == NULL) {
+        ESP_LOGE(TAG, "create event loop data pool failed");
+        goto on_err;
+    }
+#endif
+
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     loop->profiling_mutex = xSemaphoreCreateMutex();
     if (loop->profiling_mutex == NULL) {
@@ -494,6 +529,10 @@ on_err:
         vSemaphoreDelete(loop->mutex);
     }
 
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    heap_pool_delete(loop->data_pool);
+#endif
+
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     if (loop->profiling_mutex != NULL) {
         vSemaphoreDelete(loop->profiling_mutex);
@@ -572,7 +611,7 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
         esp_event_base_t base = post.base;
         int32_t id = post.id;
 
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
         if (ticks_to_run != portMAX_DELAY) {
             end = xTaskGetTickCount();
@@ -634,11 +673,14 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
     // Drop existing posts on the queue
     esp_event_post_instance_t post;
     while(xQueueReceive(loop->queue, &post, 0) == pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
     }
 
     // Cleanup loop
     vQueueDelete(loop->queue);
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    heap_pool_delete(loop->data_pool);
+#endif
     free(loop);
     // Free loop mutex before deleting
     xSemaphoreGiveRecursive(loop_mutex);
@@ -769,7 +811,7 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
 
     if (event_data != NULL && event_data_size != 0) {
         // Make persistent copy of event data on heap.
-        void* event_data_copy = calloc(1, event_data_size);
+        void* event_data_copy = post_data_alloc(loop, event_data_size);
 
         if (event_data_copy == NULL) {
             return ESP_ERR_NO_MEM;
@@ -814,7 +856,7 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     }
 
     if (result != pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
         atomic_fetch_add(&loop->events_dropped, 1);
@@ -844,11 +886,23 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
     esp_event_post_instance_t post;
     memset((void*)(&post), 0, sizeof(post));
 
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    if (event_data_size > sizeof(post.data.val) && event_data_size <= CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE
+            && event_data != NULL) {
+        // Larger data is copied into a block of the pool, which can be taken from an ISR
+        void* event_data_copy = heap_pool_alloc(loop->data_pool);
+        if (event_data_copy == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(event_data_copy, event_data, event_data_size);
+        post.data.ptr = event_data_copy;
+        post.data_allocated = true;
+        post.data_set = true;
+    } else
+#endif
     if (event_data_size > sizeof(post.data.val)) {
         return ESP_ERR_INVALID_ARG;
-    }
-
-    if (event_data != NULL && event_data_size != 0) {
+    } else if (event_data != NULL && event_data_size != 0) {
         memcpy((void*)(&(post.data.val)), event_data, event_data_size);
         post.data_allocated = false;
         post.data_set = true;
@@ -862,7 +916,7 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
     result = xQueueSendToBackFromISR(loop->queue, &post, task_unblocked);
 
     if (result != pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
         atomic_fetch_add(&loop->events_dropped, 1);
@@ -17,6 +17,7 @@
 
 #include "esp_event.h"
 #include "stdatomic.h"
+#include "esp_heap_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +78,9 @@ typedef struct esp_event_loop_instance {
     SemaphoreHandle_t mutex;                                        /**< mutex for updating the events linked list */
     esp_event_loop_nodes_t loop_nodes;                              /**< set of linked lists containing the
                                                                             registered handlers for the loop */
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    heap_pool_handle_t data_pool;                                   /**< blocks for copies of posted event data */
+#endif
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     atomic_uint_least32_t events_recieved;                          /**< number of events successfully posted to the loop */
     atomic_uint_least32_t events_dropped;                           /**< number of events dropped due to queue being full */
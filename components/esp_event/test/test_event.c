@@ -16,6 +16,7 @@
 #include "esp_event_internal.h"
 
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 #include "sdkconfig.h"
 #include "unity.h"
@@ -915,6 +916,51 @@ TEST_CASE("performance test - no dedicated task", "[event]")
     performance_test(false);
 }
 
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+#define TEST_POOL_DATA_SIZE     CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE
+#else
+#define TEST_POOL_DATA_SIZE     32
+#endif
+#define TEST_POOL_POSTS         10000
+
+// Returns the average time in ns to post an event with 'size' bytes of data and dispatch it
+static int post_data_performance(esp_event_loop_handle_t loop, size_t size)
+{
+    uint8_t data[TEST_POOL_DATA_SIZE + 4] = { 0 };
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < TEST_POOL_POSTS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, data, size, 0));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_run(loop, 0));
+    }
+    return (esp_timer_get_time() - start) * 1000 / TEST_POOL_POSTS;
+}
+
+TEST_CASE("performance test - posting event data", "[event]")
+{
+    TEST_SETUP();
+
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_create(&loop_args, &loop));
+
+    // Data of up to the pool block size is copied into the pool, larger data always goes to the heap
+    int small_ns = post_data_performance(loop, TEST_POOL_DATA_SIZE);
+    int large_ns = post_data_performance(loop, TEST_POOL_DATA_SIZE + 4);
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    printf("post and dispatch: %d ns with %d bytes of data from the pool, %d ns with %d bytes from the heap\n",
+           small_ns, TEST_POOL_DATA_SIZE, large_ns, TEST_POOL_DATA_SIZE + 4);
+#else
+    printf("post and dispatch: %d ns with %d bytes of data, %d ns with %d bytes, both from the heap\n",
+           small_ns, TEST_POOL_DATA_SIZE, large_ns, TEST_POOL_DATA_SIZE + 4);
+#endif
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_delete(loop));
+
+    TEST_TEARDOWN();
+}
+
 TEST_CASE("can post to loop from handler - dedicated task", "[event]")
 {
     TEST_SETUP();
@@ -1222,6 +1268,69 @@ TEST_CASE("can properly prepare event data posted to loop", "[event]")
     TEST_TEARDOWN();
 }
 
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+TEST_CASE("event data is copied into the loop's data pool", "[event]")
+{
+    TEST_SETUP();
+
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+
+    loop_args.task_name = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_create(&loop_args, &loop));
+
+    esp_event_post_instance_t post;
+    esp_event_loop_instance_t* loop_def = (esp_event_loop_instance_t*) loop;
+    uint8_t sample[CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE + 1];
+    for (int i = 0; i < sizeof(sample); i++) {
+        sample[i] = i;
+    }
+
+    // Data of up to a block is copied into the pool, from a task or from an ISR
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, sample,
+                                                CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(loop_def->queue, &post, portMAX_DELAY));
+    TEST_ASSERT(heap_pool_contains(loop_def->data_pool, post.data.ptr));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sample, post.data.ptr, CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE);
+    heap_pool_free(loop_def->data_pool, post.data.ptr);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_isr_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, sample,
+                                                    CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE, NULL));
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(loop_def->queue, &post, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(true, post.data_set);
+    TEST_ASSERT_EQUAL(true, post.data_allocated);
+    TEST_ASSERT(heap_pool_contains(loop_def->data_pool, post.data.ptr));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sample, post.data.ptr, CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE);
+    heap_pool_free(loop_def->data_pool, post.data.ptr);
+
+    // Larger data goes to the heap from a task, and can't be posted from an ISR
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, sample, sizeof(sample), portMAX_DELAY));
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(loop_def->queue, &post, portMAX_DELAY));
+    TEST_ASSERT_FALSE(heap_pool_contains(loop_def->data_pool, post.data.ptr));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sample, post.data.ptr, sizeof(sample));
+    free(post.data.ptr);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_event_isr_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, sample,
+                                                                 sizeof(sample), NULL));
+
+    // An ISR can't fall back to the heap when all blocks are in use
+    void* blocks[CONFIG_ESP_SYSTEM_EVENT_QUEUE_SIZE + 1];
+    int count = 0;
+    while ((blocks[count] = heap_pool_alloc(loop_def->data_pool)) != NULL) {
+        count++;
+    }
+    TEST_ASSERT_EQUAL(CONFIG_ESP_SYSTEM_EVENT_QUEUE_SIZE + 1, count);
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, esp_event_isr_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, sample,
+                                                            CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE, NULL));
+    for (int i = 0; i < count; i++) {
+        heap_pool_free(loop_def->data_pool, blocks[i]);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_delete(loop));
+
+    TEST_TEARDOWN();
+}
+#endif // CONFIG_ESP_EVENT_POST_DATA_POOL
+
 static void test_handler_post_from_isr(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
     SemaphoreHandle_t *sem = (SemaphoreHandle_t*) event_handler_arg;
@@ -1242,8 +1351,13 @@ void IRAM_ATTR test_event_on_timer_alarm(void* para)
     timer_group_set_alarm_value_in_isr(TIMER_GROUP_0, TIMER_0, timer_counter_value);
 
     int data = (int) para;
-    // Posting events with data more than 4 bytes should fail.
+    // Posting events with data more than 4 bytes, or more than a block of the data pool, should fail.
+#if CONFIG_ESP_EVENT_POST_DATA_POOL
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_event_isr_post(s_test_base1, TEST_EVENT_BASE1_EV1, &data,
+                                                              CONFIG_ESP_EVENT_POST_DATA_POOL_BLOCK_SIZE + 1, NULL));
+#else
     TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_event_isr_post(s_test_base1, TEST_EVENT_BASE1_EV1, &data, 5, NULL));
+#endif
     // This should succeedd, as data is int-sized. The handler for the event checks that the passed event data
     // is correct.
     BaseType_t task_unblocked;
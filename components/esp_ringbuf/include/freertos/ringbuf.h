@@ -53,9 +53,43 @@ typedef enum {
      * time.
      */
     RINGBUF_TYPE_BYTEBUF,
+    /**
+     * Multi-producer buffers store items like no-split buffers, but items are
+     * received in the order they were sent rather than the order their space
+     * was acquired. Several tasks and ISRs (on either core) can each acquire
+     * space with xRingbufferSendAcquire() or xRingbufferSendAcquireFromISR(),
+     * fill it in place and send it with xRingbufferSendComplete() or
+     * xRingbufferSendCompleteFromISR() in any order, and an item which is
+     * still being filled doesn't hold back items sent after it.
+     */
+    RINGBUF_TYPE_MULTI_PRODUCER,
+    /**
+     * Single producer/single consumer buffers store items like no-split
+     * buffers, but are accessed without taking a lock or a semaphore. Use them
+     * when items are only ever sent by one task or ISR and only ever received
+     * by one task or ISR, for example from a driver ISR to a processing task.
+     * Items acquired with xRingbufferSendAcquire() must be sent before the next
+     * one is acquired, and received items must be returned in the order they
+     * were received. A task blocked sending or receiving is woken by a task
+     * notification, so the task's notification value must not be used for
+     * anything else. These buffers can't be added to queue sets.
+     */
+    RINGBUF_TYPE_SPSC,
     RINGBUF_TYPE_MAX,
 } RingbufferType_t;
 
+/**
+ * @brief Struct describing an item retrieved by xRingbufferReceiveMultiple()
+ *
+ * Split items of allow-split buffers are described by two consecutive structs,
+ * one for each part. For byte buffers each struct describes a contiguous piece
+ * of data.
+ */
+typedef struct {
+    void *pvItem;       /**< Pointer to the retrieved item */
+    size_t xItemSize;   /**< Size of the retrieved item in bytes */
+} RingbufferItem_t;
+
 /**
  * @brief Struct that is equivalent in size to the ring buffer's data structure
  *
@@ -73,7 +107,7 @@ typedef struct xSTATIC_RINGBUFFER {
     size_t xDummy1[2];
     UBaseType_t uxDummy2;
     BaseType_t xDummy3;
-    void *pvDummy4[11];
+    void *pvDummy4[13];
     StaticSemaphore_t xDummy5[2];
     portMUX_TYPE muxDummy;
     /** @endcond */
@@ -191,17 +225,18 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
  *
  * The item, as well as the following items ``SendAcquire`` or ``Send`` after it,
  * will not be able to be read from the ring buffer until this item is actually
- * sent into the ring buffer.
+ * sent into the ring buffer. In multi-producer ring buffers, only this item
+ * waits: items are read in the order they are sent.
  *
  * @param[in]   xRingbuffer     Ring buffer to allocate the memory
  * @param[out]  ppvItem         Double pointer to memory acquired (set to NULL if no memory were retrieved)
  * @param[in]   xItemSize       Size of item to acquire.
  * @param[in]   xTicksToWait    Ticks to wait for room in the ring buffer.
  *
- * @note Only applicable for no-split ring buffers now, the actual size of
- *       memory that the item will occupy will be rounded up to the nearest 32-bit
- *       aligned size. This is done to ensure all items are always stored in 32-bit
- *       aligned fashion.
+ * @note Only applicable for no-split and multi-producer ring buffers now, the
+ *       actual size of memory that the item will occupy will be rounded up to the
+ *       nearest 32-bit aligned size. This is done to ensure all items are always
+ *       stored in 32-bit aligned fashion.
  *
  * @return
  *      - pdTRUE if succeeded
@@ -209,6 +244,26 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
  */
 BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, TickType_t xTicksToWait);
 
+/**
+ * @brief Acquire memory from the ring buffer in an ISR, to be written to and
+ *        sent later.
+ *
+ * Same as xRingbufferSendAcquire(), but returns immediately if there is
+ * insufficient free space in the buffer.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to allocate the memory
+ * @param[out]  ppvItem         Double pointer to memory acquired (set to NULL if no memory were retrieved)
+ * @param[in]   xItemSize       Size of item to acquire.
+ * @param[out]  pxHigherPriorityTaskWoken   Value pointed to will be set to pdTRUE if the function woke up a higher priority task.
+ *
+ * @note Only applicable for no-split and multi-producer ring buffers.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE when the ring buffer does not have space.
+ */
+BaseType_t xRingbufferSendAcquireFromISR(RingbufHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, BaseType_t *pxHigherPriorityTaskWoken);
+
 /**
  * @brief       Actually send an item into the ring buffer allocated before by
  *              ``xRingbufferSendAcquire``.
@@ -216,8 +271,9 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
  * @param[in]   xRingbuffer     Ring buffer to insert the item into
  * @param[in]   pvItem          Pointer to item in allocated memory to insert.
  *
- * @note Only applicable for no-split ring buffers. Only call for items
- *       allocated by ``xRingbufferSendAcquire``.
+ * @note Only applicable for no-split and multi-producer ring buffers. Only call
+ *       for items allocated by ``xRingbufferSendAcquire`` or
+ *       ``xRingbufferSendAcquireFromISR``.
  *
  * @return
  *      - pdTRUE if succeeded
@@ -225,6 +281,23 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
  */
 BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem);
 
+/**
+ * @brief       Send an item acquired before into the ring buffer, in an ISR
+ *
+ * Same as xRingbufferSendComplete(), for use in an ISR.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to insert the item into
+ * @param[in]   pvItem          Pointer to item in allocated memory to insert.
+ * @param[out]  pxHigherPriorityTaskWoken   Value pointed to will be set to pdTRUE if the function woke up a higher priority task.
+ *
+ * @note Only applicable for no-split and multi-producer ring buffers.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE if fail for some reason.
+ */
+BaseType_t xRingbufferSendCompleteFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
+
 /**
  * @brief   Retrieve an item from the ring buffer
  *
@@ -367,6 +440,50 @@ void *xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer,
  */
 void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize, size_t xMaxSize);
 
+/**
+ * @brief   Retrieve several items from the ring buffer at once
+ *
+ * Attempt to retrieve as many items as are available, up to uxMaxItems, from
+ * the ring buffer. The ring buffer is only locked once for all of the items, so
+ * consumers which handle many small items should use this rather than
+ * calling xRingbufferReceive() for each item. This function will block until at
+ * least one item is available or until timeout.
+ *
+ * - For no-split and multi-producer buffers, each entry of pxItems is one item.
+ * - For allow-split buffers, a split item fills two consecutive entries, one
+ *   for each part. A split item is only retrieved if both parts fit in pxItems.
+ * - For byte buffers, at most two entries are filled: the data until the end of
+ *   the buffer storage area, and the data that wrapped around.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  pxItems         Array of structs to which the retrieved items will be written
+ * @param[in]   uxMaxItems      Number of entries of pxItems. Must be at least 2 for allow-split buffers.
+ * @param[in]   xTicksToWait    Ticks to wait for items in the ring buffer.
+ *
+ * @note    A call to vRingbufferReturnItems() (or vRingbufferReturnItem() for
+ *          each entry) is required after this to free the items retrieved.
+ * @note    Byte buffers do not allow multiple retrievals before returning the data
+ *
+ * @return  Number of entries of pxItems filled, 0 on timeout.
+ */
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems, TickType_t xTicksToWait);
+
+/**
+ * @brief   Retrieve several items from the ring buffer at once in an ISR
+ *
+ * Same as xRingbufferReceiveMultiple(), but returns immediately if no items are
+ * available.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  pxItems         Array of structs to which the retrieved items will be written
+ * @param[in]   uxMaxItems      Number of entries of pxItems. Must be at least 2 for allow-split buffers.
+ *
+ * @note    A call to vRingbufferReturnItemsFromISR() is required after this to free the items retrieved.
+ *
+ * @return  Number of entries of pxItems filled, 0 if the ring buffer is empty.
+ */
+UBaseType_t xRingbufferReceiveMultipleFromISR(RingbufHandle_t xRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems);
+
 /**
  * @brief   Return a previously-retrieved item to the ring buffer
  *
@@ -389,6 +506,28 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
  */
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief   Return several previously-retrieved items to the ring buffer
+ *
+ * The ring buffer is only locked once for all of the items.
+ *
+ * @param[in]   xRingbuffer Ring buffer the items were retrieved from
+ * @param[in]   pxItems     Items that were received earlier, for example by xRingbufferReceiveMultiple()
+ * @param[in]   uxItems     Number of items in pxItems
+ */
+void vRingbufferReturnItems(RingbufHandle_t xRingbuffer, const RingbufferItem_t *pxItems, UBaseType_t uxItems);
+
+/**
+ * @brief   Return several previously-retrieved items to the ring buffer from an ISR
+ *
+ * @param[in]   xRingbuffer Ring buffer the items were retrieved from
+ * @param[in]   pxItems     Items that were received earlier, for example by xRingbufferReceiveMultipleFromISR()
+ * @param[in]   uxItems     Number of items in pxItems
+ * @param[out]  pxHigherPriorityTaskWoken   Value pointed to will be set to pdTRUE
+ *                                          if the function woke up a higher priority task.
+ */
+void vRingbufferReturnItemsFromISR(RingbufHandle_t xRingbuffer, const RingbufferItem_t *pxItems, UBaseType_t uxItems, BaseType_t *pxHigherPriorityTaskWoken);
+
 /**
  * @brief   Delete a ring buffer
  *
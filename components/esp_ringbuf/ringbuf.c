@@ -28,6 +28,8 @@
 #define rbBYTE_BUFFER_FLAG          ( ( UBaseType_t ) 2 )   //The ring buffer is a byte buffer
 #define rbBUFFER_FULL_FLAG          ( ( UBaseType_t ) 4 )   //The ring buffer is currently full (write pointer == free pointer)
 #define rbBUFFER_STATIC_FLAG        ( ( UBaseType_t ) 8 )   //The ring buffer is statically allocated
+#define rbMULTI_PRODUCER_FLAG       ( ( UBaseType_t ) 16 )  //Items are read in the order they were sent, see RINGBUF_TYPE_MULTI_PRODUCER
+#define rbSPSC_FLAG                 ( ( UBaseType_t ) 32 )  //Single producer/single consumer buffer, accessed without locks
 
 //Item flags
 #define rbITEM_FREE_FLAG            ( ( UBaseType_t ) 1 )   //Item has been retrieved and returned by application, free to overwrite
@@ -35,6 +37,16 @@
 #define rbITEM_SPLIT_FLAG           ( ( UBaseType_t ) 4 )   //Valid for RINGBUF_TYPE_ALLOWSPLIT, indicating that rest of the data is wrapped around
 #define rbITEM_WRITTEN_FLAG         ( ( UBaseType_t ) 8 )   //Item has been written to by the application, thus can be read
 
+/*
+ * In multi-producer buffers, written items which have not been read yet form a
+ * list in the order they were sent. The upper bits of an item's flags hold the
+ * offset of the next item in the list. Offsets are 32-bit aligned, so shifting
+ * them up by 2 leaves the flag bits clear.
+ */
+#define rbITEM_FLAGS_MASK           ( ( UBaseType_t ) 0xF )
+#define rbITEM_NEXT_SHIFT           2
+#define rbMULTI_PRODUCER_MAX_SIZE   ( ( size_t ) 1 << ( 32 - rbITEM_NEXT_SHIFT ) )
+
 //Static allocation related
 #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
 #define rbGET_TX_SEM_HANDLE( pxRingbuffer ) ( (SemaphoreHandle_t) &(pxRingbuffer->xTransSemStatic) )
@@ -94,6 +106,13 @@ typedef struct RingbufferDefinition {
      *        making the ring buffer's control structure slightly smaller when
      *        static allocation is disabled.
      */
+    /*
+     * Single producer/single consumer buffers don't use the semaphores. A task
+     * blocked sending to or receiving from the buffer stores its handle here,
+     * and is woken by a task notification.
+     */
+    TaskHandle_t xSpscSendTask;
+    TaskHandle_t xSpscRecvTask;
 #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
     StaticSemaphore_t xTransSemStatic;
     StaticSemaphore_t xRecvSemStatic;
@@ -199,6 +218,46 @@ static void prvReturnItemDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
 //Return data to a byte buffer
 static void prvReturnItemByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
 
+/*
+Copies an item to a multi-producer ring buffer
+Entry:
+    - Must have already guaranteed there is sufficient space for item by calling prvCheckItemFitsDefault()
+Exit:
+    - New item copied into ring buffer and appended to the list of items to read
+*/
+static void prvCopyItemMultiProducer(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
+
+/*
+Retrieve the item which was sent first from a multi-producer ring buffer
+Entry:
+    - Must have already guaranteed that there is an item available for retrieval by calling prvCheckItemAvail()
+Exit:
+    - Item is returned and removed from the list of items to read
+    - pucRead updated to point to the next item in the list
+*/
+static void *prvGetItemMultiProducer(Ringbuffer_t *pxRingbuffer,
+                                     BaseType_t *pxIsSplit,
+                                     size_t xUnusedParam,
+                                     size_t *pxItemSize);
+
+/*
+Return an item to a multi-producer ring buffer
+Exit:
+    - Item is marked free rbITEM_FREE_FLAG
+    - pucFree is progressed as far as possible, skipping over already freed items or dummy items
+*/
+static void prvReturnItemMultiProducer(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
+/*
+Retrieve as many items as are available, up to uxMaxItems, from a ring buffer
+Entry:
+    - Must have already guaranteed that there is an item available for retrieval by calling prvCheckItemAvail()
+Exit:
+    - pxItems filled with the retrieved items (or parts of split items, or contiguous pieces of byte buffer data)
+    - Returns the number of entries of pxItems filled
+*/
+static UBaseType_t prvGetItems(Ringbuffer_t *pxRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems);
+
 //Get the maximum size an item that can currently have if sent to a no-split ring buffer
 static size_t prvGetCurMaxSizeNoSplit(Ringbuffer_t *pxRingbuffer);
 
@@ -230,6 +289,51 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer,
                                            size_t *xItemSize2,
                                            size_t xMaxSize);
 
+/*
+Functions used by single producer/single consumer ring buffers. The producer
+only changes pucAcquire and pucWrite, the consumer only changes pucRead and
+pucFree, so each side only has to read the pointer published by the other side
+and no lock is needed.
+*/
+//Reserve space for an item without making it visible to the consumer, returns NULL if it doesn't fit
+static uint8_t *prvAcquireItemSpsc(Ringbuffer_t *pxRingbuffer, size_t xItemSize);
+
+//Make the item reserved by prvAcquireItemSpsc() visible to the consumer
+static void prvSendItemDoneSpsc(Ringbuffer_t *pxRingbuffer, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken);
+
+//Retrieve the next item, returns NULL if the buffer is empty
+static void *prvGetItemSpsc(Ringbuffer_t *pxRingbuffer, size_t *pxItemSize);
+
+//Return the oldest item which has been retrieved, making its space available to the producer
+static void prvReturnItemSpsc(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken);
+
+//Get the maximum size an item that can currently have if sent to a single producer/single consumer buffer
+static size_t prvGetCurMaxSizeSpsc(Ringbuffer_t *pxRingbuffer);
+
+//Count the items which have not been retrieved yet. The count isn't kept as both sides would have to update it
+static UBaseType_t prvGetItemsWaitingSpsc(Ringbuffer_t *pxRingbuffer);
+
+/*
+Wait for the other side of a single producer/single consumer buffer. The first
+call stores the calling task's handle in pxWaitingTask, after which the caller
+checks the buffer again, the next call blocks until the task is notified.
+Returns pdFALSE on timeout.
+*/
+static BaseType_t prvWaitSpsc(TaskHandle_t *pxWaitingTask, BaseType_t *pxRegistered, TickType_t xTicksToWait, TickType_t xTicksEnd, TickType_t *pxTicksRemaining);
+
+/*
+Clear the handle stored by prvWaitSpsc(). If the other side has already taken
+the handle, wait for its notification so that it can't wake a later wait of
+the task.
+*/
+static void prvUnregisterSpsc(TaskHandle_t *pxWaitingTask);
+
+//Acquire space for an item, waiting up to xTicksToWait for it. Returns NULL on timeout
+static uint8_t *prvAcquireSpsc(Ringbuffer_t *pxRingbuffer, size_t xItemSize, TickType_t xTicksToWait);
+
+//Retrieve up to uxMaxItems items, waiting up to xTicksToWait for the first one
+static UBaseType_t prvReceiveSpsc(Ringbuffer_t *pxRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems, TickType_t xTicksToWait);
+
 /* --------------------------- Static Definitions --------------------------- */
 
 static void prvInitializeNewRingbuffer(size_t xBufferSize,
@@ -248,12 +352,35 @@ static void prvInitializeNewRingbuffer(size_t xBufferSize,
     pxNewRingbuffer->xItemsWaiting = 0;
     pxNewRingbuffer->uxRingbufferFlags = 0;
 
+    pxNewRingbuffer->xSpscSendTask = NULL;
+    pxNewRingbuffer->xSpscRecvTask = NULL;
+
     //Initialize type dependent values and function pointers
-    if (xBufferType == RINGBUF_TYPE_NOSPLIT) {
+    if (xBufferType == RINGBUF_TYPE_SPSC) {
+        /*
+         * Items are stored as in no-split buffers. The public functions don't
+         * use the function pointers for this type.
+         */
+        pxNewRingbuffer->uxRingbufferFlags |= rbSPSC_FLAG;
+        pxNewRingbuffer->xCheckItemFits = NULL;
+        pxNewRingbuffer->vCopyItem = NULL;
+        pxNewRingbuffer->pvGetItem = NULL;
+        pxNewRingbuffer->vReturnItem = NULL;
+        pxNewRingbuffer->xMaxItemSize = rbALIGN_SIZE(pxNewRingbuffer->xSize / 2) - rbHEADER_SIZE;
+        pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeSpsc;
+    } else if (xBufferType == RINGBUF_TYPE_NOSPLIT || xBufferType == RINGBUF_TYPE_MULTI_PRODUCER) {
+        if (xBufferType == RINGBUF_TYPE_MULTI_PRODUCER) {
+            configASSERT(xBufferSize < rbMULTI_PRODUCER_MAX_SIZE);
+            pxNewRingbuffer->uxRingbufferFlags |= rbMULTI_PRODUCER_FLAG;
+            pxNewRingbuffer->vCopyItem = prvCopyItemMultiProducer;
+            pxNewRingbuffer->pvGetItem = prvGetItemMultiProducer;
+            pxNewRingbuffer->vReturnItem = prvReturnItemMultiProducer;
+        } else {
+            pxNewRingbuffer->vCopyItem = prvCopyItemNoSplit;
+            pxNewRingbuffer->pvGetItem = prvGetItemDefault;
+            pxNewRingbuffer->vReturnItem = prvReturnItemDefault;
+        }
         pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsDefault;
-        pxNewRingbuffer->vCopyItem = prvCopyItemNoSplit;
-        pxNewRingbuffer->pvGetItem = prvGetItemDefault;
-        pxNewRingbuffer->vReturnItem = prvReturnItemDefault;
         /*
          * Worst case scenario is when the read/write/acquire/free pointers are all
          * pointing to the halfway point of the buffer.
@@ -436,6 +563,42 @@ static void prvCopyItemNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucIte
     prvSendItemDoneNoSplit(pxRingbuffer, item_addr);
 }
 
+static void prvSendItemDoneMultiProducer(Ringbuffer_t *pxRingbuffer, uint8_t* pucItem)
+{
+    //Check arguments and buffer state
+    configASSERT(rbCHECK_ALIGNED(pucItem));
+    configASSERT(pucItem >= pxRingbuffer->pucHead);
+    configASSERT(pucItem <= pxRingbuffer->pucTail);     //Inclusive of pucTail in the case of zero length item at the very end
+
+    //Get and check header of the item
+    ItemHeader_t *pxCurHeader = (ItemHeader_t *)(pucItem - rbHEADER_SIZE);
+    configASSERT(pxCurHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) == 0); //Dummy items should never have been written
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_WRITTEN_FLAG) == 0);    //Indicates item has already been written before
+    pxCurHeader->uxItemFlags |= rbITEM_WRITTEN_FLAG;                        //Mark as written
+
+    /*
+     * Items can be read as soon as they are written, whatever the order they
+     * were acquired in. Append the item to the list of items to read: pucRead
+     * points to the first item of the list and pucWrite to the last one.
+     */
+    if (pxRingbuffer->xItemsWaiting == 0) {
+        pxRingbuffer->pucRead = (uint8_t *)pxCurHeader;
+    } else {
+        ItemHeader_t *pxLastHeader = (ItemHeader_t *)pxRingbuffer->pucWrite;
+        pxLastHeader->uxItemFlags |= (UBaseType_t)((uint8_t *)pxCurHeader - pxRingbuffer->pucHead) << rbITEM_NEXT_SHIFT;
+    }
+    pxRingbuffer->pucWrite = (uint8_t *)pxCurHeader;
+    pxRingbuffer->xItemsWaiting++;
+}
+
+static void prvCopyItemMultiProducer(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+{
+    uint8_t* item_addr = prvAcquireItemNoSplit(pxRingbuffer, xItemSize);
+    memcpy(item_addr, pucItem, xItemSize);
+    prvSendItemDoneMultiProducer(pxRingbuffer, item_addr);
+}
+
 static void prvCopyItemAllowSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
 {
     //Check arguments and buffer state
@@ -526,6 +689,9 @@ static void prvCopyItemByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucIte
 
 static BaseType_t prvCheckItemAvail(Ringbuffer_t *pxRingbuffer)
 {
+    if (pxRingbuffer->uxRingbufferFlags & rbMULTI_PRODUCER_FLAG) {
+        return (pxRingbuffer->xItemsWaiting > 0) ? pdTRUE : pdFALSE;    //Only written items are counted
+    }
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && pxRingbuffer->pucRead != pxRingbuffer->pucFree) {
         return pdFALSE;     //Byte buffers do not allow multiple retrievals before return
     }
@@ -577,6 +743,68 @@ static void *prvGetItemDefault(Ringbuffer_t *pxRingbuffer,
     return (void *)pcReturn;
 }
 
+static void *prvGetItemMultiProducer(Ringbuffer_t *pxRingbuffer,
+                                     BaseType_t *pxIsSplit,
+                                     size_t xUnusedParam,
+                                     size_t *pxItemSize)
+{
+    //Check arguments and buffer state
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pxRingbuffer->pucRead;
+    configASSERT(pxIsSplit != NULL);
+    configASSERT(pxRingbuffer->xItemsWaiting > 0);                  //Check there are items to be read
+    configASSERT(rbCHECK_ALIGNED(pxRingbuffer->pucRead));
+    configASSERT(pxRingbuffer->pucRead >= pxRingbuffer->pucHead && pxRingbuffer->pucRead < pxRingbuffer->pucTail);      //Check read pointer is within bounds
+    configASSERT(pxHeader->uxItemFlags & rbITEM_WRITTEN_FLAG);      //Only written items are in the list
+    configASSERT(pxHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+
+    *pxItemSize = pxHeader->xItemLen;
+    *pxIsSplit = pdFALSE;
+    pxRingbuffer->xItemsWaiting--;
+    if (pxRingbuffer->xItemsWaiting > 0) {
+        //Follow the list to the next written item
+        pxRingbuffer->pucRead = pxRingbuffer->pucHead + ((pxHeader->uxItemFlags & ~rbITEM_FLAGS_MASK) >> rbITEM_NEXT_SHIFT);
+    }
+    return (void *)((uint8_t *)pxHeader + rbHEADER_SIZE);
+}
+
+static UBaseType_t prvGetItems(Ringbuffer_t *pxRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems)
+{
+    UBaseType_t uxCount = 0;
+    if (pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) {
+        //Retrieve all contiguous data from the read pointer
+        pxItems[0].pvItem = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, 0, &pxItems[0].xItemSize);
+        if (uxMaxItems > 1 && pxRingbuffer->xItemsWaiting > 0) {
+            //The rest of the data has wrapped around to the start of the buffer
+            configASSERT(pxRingbuffer->pucRead == pxRingbuffer->pucHead);
+            pxItems[1].pvItem = pxRingbuffer->pucRead;
+            pxItems[1].xItemSize = pxRingbuffer->xItemsWaiting;
+            pxRingbuffer->pucRead += pxRingbuffer->xItemsWaiting;
+            pxRingbuffer->xItemsWaiting = 0;
+            return 2;
+        }
+        return 1;
+    }
+
+    while (uxCount < uxMaxItems && prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
+        //Only retrieve a split item if there is room for both of its parts
+        if ((pxRingbuffer->uxRingbufferFlags & rbALLOW_SPLIT_FLAG) &&
+            (((ItemHeader_t *)pxRingbuffer->pucRead)->uxItemFlags & rbITEM_SPLIT_FLAG) &&
+            uxCount + 2 > uxMaxItems) {
+            break;
+        }
+        BaseType_t xIsSplit;
+        pxItems[uxCount].pvItem = pxRingbuffer->pvGetItem(pxRingbuffer, &xIsSplit, 0, &pxItems[uxCount].xItemSize);
+        uxCount++;
+        if (xIsSplit == pdTRUE) {
+            pxItems[uxCount].pvItem = pxRingbuffer->pvGetItem(pxRingbuffer, &xIsSplit, 0, &pxItems[uxCount].xItemSize);
+            configASSERT(pxItems[uxCount].pvItem < pxItems[uxCount - 1].pvItem);  //Check wrap around has occurred
+            configASSERT(xIsSplit == pdFALSE);  //Second part should not have wrapped flag
+            uxCount++;
+        }
+    }
+    return uxCount;
+}
+
 static void *prvGetItemByteBuf(Ringbuffer_t *pxRingbuffer,
                                BaseType_t *pxUnusedParam,
                                size_t xMaxSize,
@@ -670,6 +898,49 @@ static void prvReturnItemDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
     }
 }
 
+static void prvReturnItemMultiProducer(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    //Check arguments and buffer state
+    configASSERT(rbCHECK_ALIGNED(pucItem));
+    configASSERT(pucItem >= pxRingbuffer->pucHead);
+    configASSERT(pucItem <= pxRingbuffer->pucTail);     //Inclusive of pucTail in the case of zero length item at the very end
+
+    //Get and check header of the item
+    ItemHeader_t *pxCurHeader = (ItemHeader_t *)(pucItem - rbHEADER_SIZE);
+    configASSERT(pxCurHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+    configASSERT(pxCurHeader->uxItemFlags & rbITEM_WRITTEN_FLAG);          //Item should have been written and read
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_FREE_FLAG) == 0);       //Indicates item has already been returned before
+    pxCurHeader->uxItemFlags |= rbITEM_FREE_FLAG;                           //Mark as free
+
+    /*
+     * Items are read in the order they were written, not in the order they are
+     * stored, so pucRead doesn't limit the free pointer. Move the free pointer
+     * past items that have been freed and dummy items, up to the first item in
+     * use or to the acquire pointer. Items which are acquired, written or read
+     * but not returned don't have the free flag.
+     */
+    pxCurHeader = (ItemHeader_t *)pxRingbuffer->pucFree;
+    while ((pxCurHeader->uxItemFlags & (rbITEM_FREE_FLAG | rbITEM_DUMMY_DATA_FLAG)) &&
+           (pxRingbuffer->pucFree != pxRingbuffer->pucAcquire || (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG))) {
+        if (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+            pxRingbuffer->pucFree = pxRingbuffer->pucHead;    //Wrap around due to dummy data
+        } else {
+            //Item with data that has already been freed, advance free pointer past this item
+            size_t xAlignedItemSize = rbALIGN_SIZE(pxCurHeader->xItemLen);
+            pxRingbuffer->pucFree += xAlignedItemSize + rbHEADER_SIZE;
+            //Redundancy check to ensure free pointer has not overshot buffer bounds
+            configASSERT(pxRingbuffer->pucFree <= pxRingbuffer->pucHead + pxRingbuffer->xSize);
+        }
+        //Check if pucFree requires wrap around
+        if ((pxRingbuffer->pucTail - pxRingbuffer->pucFree) < rbHEADER_SIZE) {
+            pxRingbuffer->pucFree = pxRingbuffer->pucHead;
+        }
+        //Free pointer has moved, so the buffer is no longer full
+        pxRingbuffer->uxRingbufferFlags &= ~rbBUFFER_FULL_FLAG;
+        pxCurHeader = (ItemHeader_t *)pxRingbuffer->pucFree;      //Update header to point to item
+    }
+}
+
 static void prvReturnItemByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
 {
     //Check pointer points to address inside buffer
@@ -874,6 +1145,269 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer,
     return xReturn;
 }
 
+static UBaseType_t prvReceiveMultipleGeneric(Ringbuffer_t *pxRingbuffer,
+                                             RingbufferItem_t *pxItems,
+                                             UBaseType_t uxMaxItems,
+                                             TickType_t xTicksToWait)
+{
+    UBaseType_t uxReturn = 0;
+    BaseType_t xReturnSemaphore = pdFALSE;
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        //Block until an item becomes available or timeout
+        if (xSemaphoreTake(rbGET_RX_SEM_HANDLE(pxRingbuffer), xTicksRemaining) != pdTRUE) {
+            break;      //Timed out attempting to get semaphore
+        }
+
+        //Semaphore obtained, retrieve all the items available (up to uxMaxItems)
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        if (prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
+            uxReturn = prvGetItems(pxRingbuffer, pxItems, uxMaxItems);
+            if (pxRingbuffer->xItemsWaiting > 0) {
+                xReturnSemaphore = pdTRUE;
+            }
+            portEXIT_CRITICAL(&pxRingbuffer->mux);
+            break;
+        }
+        //No item available for retrieval, adjust ticks and take the semaphore again
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+    }
+
+    if (xReturnSemaphore == pdTRUE) {
+        xSemaphoreGive(rbGET_RX_SEM_HANDLE(pxRingbuffer));  //Give semaphore back so other tasks can retrieve
+    }
+    return uxReturn;
+}
+
+static uint8_t *prvAcquireItemSpsc(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
+{
+    size_t xTotalItemSize = rbALIGN_SIZE(xItemSize) + rbHEADER_SIZE;
+    uint8_t *pucWrite = pxRingbuffer->pucWrite;
+    uint8_t *pucFree = __atomic_load_n(&pxRingbuffer->pucFree, __ATOMIC_ACQUIRE);
+    uint8_t *pucItem = pucWrite;
+    configASSERT(pxRingbuffer->pucAcquire == pucWrite);     //Only one item can be acquired at a time
+
+    /*
+     * The write pointer must never catch up with the free pointer from behind,
+     * as the buffer would then look empty. This leaves at least 4 bytes unused
+     * when the buffer is full.
+     */
+    if (pucFree > pucWrite) {
+        //Free space does not wrap around
+        if (xTotalItemSize >= pucFree - pucWrite) {
+            return NULL;
+        }
+    } else if (xTotalItemSize <= pxRingbuffer->pucTail - pucWrite) {
+        //Item fits at the end of the buffer. Check the write pointer can wrap around after the item if it needs to
+        if (pxRingbuffer->pucTail - (pucWrite + xTotalItemSize) < rbHEADER_SIZE && pucFree == pxRingbuffer->pucHead) {
+            return NULL;
+        }
+    } else {
+        //Item must be stored at the start of the buffer
+        if (xTotalItemSize >= pucFree - pxRingbuffer->pucHead) {
+            return NULL;
+        }
+        pucItem = pxRingbuffer->pucHead;
+        ItemHeader_t *pxDummy = (ItemHeader_t *)pucWrite;
+        pxDummy->uxItemFlags = rbITEM_DUMMY_DATA_FLAG;      //Set remaining length as dummy data
+        pxDummy->xItemLen = 0;
+    }
+
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pucItem;
+    pxHeader->xItemLen = xItemSize;
+    pxHeader->uxItemFlags = 0;
+    pxRingbuffer->pucAcquire = pucItem + xTotalItemSize;
+    if (pxRingbuffer->pucTail - pxRingbuffer->pucAcquire < rbHEADER_SIZE) {
+        pxRingbuffer->pucAcquire = pxRingbuffer->pucHead;   //Wrap around pucAcquire
+    }
+    return pucItem + rbHEADER_SIZE;
+}
+
+static void prvNotifySpsc(TaskHandle_t *pxWaitingTask, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    //Order the pointer update before reading the waiting task, pairs with the barrier in prvWaitSpsc()
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(pxWaitingTask, __ATOMIC_RELAXED) == NULL) {
+        return;
+    }
+    TaskHandle_t xTask = __atomic_exchange_n(pxWaitingTask, NULL, __ATOMIC_ACQ_REL);
+    if (xTask == NULL) {
+        return;
+    }
+    if (xFromISR) {
+        vTaskNotifyGiveFromISR(xTask, pxHigherPriorityTaskWoken);
+    } else {
+        xTaskNotifyGive(xTask);
+    }
+}
+
+static void prvSendItemDoneSpsc(Ringbuffer_t *pxRingbuffer, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    //Publish the item, the release store orders the item's header and data before the write pointer
+    __atomic_store_n(&pxRingbuffer->pucWrite, pxRingbuffer->pucAcquire, __ATOMIC_RELEASE);
+    prvNotifySpsc(&pxRingbuffer->xSpscRecvTask, xFromISR, pxHigherPriorityTaskWoken);
+}
+
+static void *prvGetItemSpsc(Ringbuffer_t *pxRingbuffer, size_t *pxItemSize)
+{
+    uint8_t *pucRead = pxRingbuffer->pucRead;
+    if (pucRead == __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE)) {
+        return NULL;    //No items available
+    }
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pucRead;
+    if (pxHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+        pucRead = pxRingbuffer->pucHead;    //Wrap around due to dummy data
+        pxHeader = (ItemHeader_t *)pucRead;
+    }
+    configASSERT(pxHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+    *pxItemSize = pxHeader->xItemLen;
+
+    pxRingbuffer->pucRead = pucRead + rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen);
+    if (pxRingbuffer->pucTail - pxRingbuffer->pucRead < rbHEADER_SIZE) {
+        pxRingbuffer->pucRead = pxRingbuffer->pucHead;
+    }
+    return pucRead + rbHEADER_SIZE;
+}
+
+static void prvReturnItemSpsc(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    uint8_t *pucFree = pxRingbuffer->pucFree;
+    if (((ItemHeader_t *)pucFree)->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+        pucFree = pxRingbuffer->pucHead;    //Wrap around due to dummy data
+    }
+    ItemHeader_t *pxHeader = (ItemHeader_t *)(pucItem - rbHEADER_SIZE);
+    configASSERT((uint8_t *)pxHeader == pucFree);      //Items must be returned in the order they were retrieved
+    configASSERT(pucFree != pxRingbuffer->pucRead);     //Item must have been retrieved
+
+    pucFree += rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen);
+    if (pxRingbuffer->pucTail - pucFree < rbHEADER_SIZE) {
+        pucFree = pxRingbuffer->pucHead;
+    }
+    __atomic_store_n(&pxRingbuffer->pucFree, pucFree, __ATOMIC_RELEASE);
+    prvNotifySpsc(&pxRingbuffer->xSpscSendTask, xFromISR, pxHigherPriorityTaskWoken);
+}
+
+static size_t prvGetCurMaxSizeSpsc(Ringbuffer_t *pxRingbuffer)
+{
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE);
+    uint8_t *pucFree = __atomic_load_n(&pxRingbuffer->pucFree, __ATOMIC_ACQUIRE);
+    BaseType_t xFreeSize;
+    if (pucFree > pucWrite) {
+        xFreeSize = pucFree - pucWrite - 4;
+    } else {
+        //Select largest contiguous free space, see prvAcquireItemSpsc()
+        BaseType_t xSize1 = pxRingbuffer->pucTail - pucWrite - ((pucFree == pxRingbuffer->pucHead) ? rbHEADER_SIZE : 0);
+        BaseType_t xSize2 = pucFree - pxRingbuffer->pucHead - 4;
+        xFreeSize = (xSize1 > xSize2) ? xSize1 : xSize2;
+    }
+    xFreeSize -= rbHEADER_SIZE;
+    if (xFreeSize < 0) {
+        xFreeSize = 0;
+    } else if (xFreeSize > pxRingbuffer->xMaxItemSize) {
+        xFreeSize = pxRingbuffer->xMaxItemSize;
+    }
+    return xFreeSize;
+}
+
+static UBaseType_t prvGetItemsWaitingSpsc(Ringbuffer_t *pxRingbuffer)
+{
+    UBaseType_t uxItems = 0;
+    uint8_t *pucRead = pxRingbuffer->pucRead;
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE);
+    while (pucRead != pucWrite) {
+        ItemHeader_t *pxHeader = (ItemHeader_t *)pucRead;
+        if (pxHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+            pucRead = pxRingbuffer->pucHead;    //Wrap around due to dummy data
+            continue;
+        }
+        uxItems++;
+        pucRead += rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen);
+        if (pxRingbuffer->pucTail - pucRead < rbHEADER_SIZE) {
+            pucRead = pxRingbuffer->pucHead;
+        }
+    }
+    return uxItems;
+}
+
+static BaseType_t prvWaitSpsc(TaskHandle_t *pxWaitingTask, BaseType_t *pxRegistered, TickType_t xTicksToWait, TickType_t xTicksEnd, TickType_t *pxTicksRemaining)
+{
+    if (*pxTicksRemaining == 0 || *pxTicksRemaining > xTicksToWait) {   //xTicksRemaining will underflow once xTaskGetTickCount() > ticks_end
+        return pdFALSE;
+    }
+    if (*pxRegistered == pdFALSE) {
+        /*
+         * The other side reads the task handle after updating its pointer, so
+         * the caller must check the buffer again after the handle is stored
+         * and before blocking.
+         */
+        __atomic_store_n(pxWaitingTask, xTaskGetCurrentTaskHandle(), __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        *pxRegistered = pdTRUE;
+        return pdTRUE;
+    }
+    if (ulTaskNotifyTake(pdTRUE, *pxTicksRemaining) == 0) {
+        //Timed out, clear the handle so that the task isn't notified once it stops waiting
+        prvUnregisterSpsc(pxWaitingTask);
+    }
+    *pxRegistered = pdFALSE;    //If notified, the handle was cleared by the task which notified us
+    if (xTicksToWait != portMAX_DELAY) {
+        *pxTicksRemaining = xTicksEnd - xTaskGetTickCount();
+    }
+    return pdTRUE;
+}
+
+static void prvUnregisterSpsc(TaskHandle_t *pxWaitingTask)
+{
+    if (__atomic_exchange_n(pxWaitingTask, NULL, __ATOMIC_ACQ_REL) == NULL) {
+        //The other side exchanged the handle in prvNotifySpsc(), the notification is sent right after
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+static uint8_t *prvAcquireSpsc(Ringbuffer_t *pxRingbuffer, size_t xItemSize, TickType_t xTicksToWait)
+{
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    BaseType_t xRegistered = pdFALSE;
+    uint8_t *pucItem;
+    while ((pucItem = prvAcquireItemSpsc(pxRingbuffer, xItemSize)) == NULL) {
+        if (prvWaitSpsc(&pxRingbuffer->xSpscSendTask, &xRegistered, xTicksToWait, xTicksEnd, &xTicksRemaining) == pdFALSE) {
+            break;
+        }
+    }
+    if (xRegistered == pdTRUE) {
+        prvUnregisterSpsc(&pxRingbuffer->xSpscSendTask);
+    }
+    return pucItem;
+}
+
+static UBaseType_t prvReceiveSpsc(Ringbuffer_t *pxRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems, TickType_t xTicksToWait)
+{
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    BaseType_t xRegistered = pdFALSE;
+    while ((pxItems[0].pvItem = prvGetItemSpsc(pxRingbuffer, &pxItems[0].xItemSize)) == NULL) {
+        if (prvWaitSpsc(&pxRingbuffer->xSpscRecvTask, &xRegistered, xTicksToWait, xTicksEnd, &xTicksRemaining) == pdFALSE) {
+            break;
+        }
+    }
+    if (xRegistered == pdTRUE) {
+        prvUnregisterSpsc(&pxRingbuffer->xSpscRecvTask);
+    }
+    if (pxItems[0].pvItem == NULL) {
+        return 0;
+    }
+    UBaseType_t uxCount = 1;
+    while (uxCount < uxMaxItems && (pxItems[uxCount].pvItem = prvGetItemSpsc(pxRingbuffer, &pxItems[uxCount].xItemSize)) != NULL) {
+        uxCount++;
+    }
+    return uxCount;
+}
+
 /* --------------------------- Public Definitions --------------------------- */
 
 RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType)
@@ -962,6 +1496,10 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
     if (xItemSize > pxRingbuffer->xMaxItemSize) {
         return pdFALSE;     //Data will never ever fit in the queue.
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        *ppvItem = prvAcquireSpsc(pxRingbuffer, xItemSize, xTicksToWait);
+        return (*ppvItem != NULL) ? pdTRUE : pdFALSE;
+    }
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
@@ -1016,14 +1554,88 @@ BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem)
     configASSERT(pvItem != NULL);
     configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvSendItemDoneSpsc(pxRingbuffer, pdFALSE, NULL);
+        return pdTRUE;
+    }
+
     portENTER_CRITICAL(&pxRingbuffer->mux);
-    prvSendItemDoneNoSplit(pxRingbuffer, pvItem);
+    if (pxRingbuffer->uxRingbufferFlags & rbMULTI_PRODUCER_FLAG) {
+        prvSendItemDoneMultiProducer(pxRingbuffer, pvItem);
+    } else {
+        prvSendItemDoneNoSplit(pxRingbuffer, pvItem);
+    }
     portEXIT_CRITICAL(&pxRingbuffer->mux);
 
     xSemaphoreGive(rbGET_RX_SEM_HANDLE(pxRingbuffer));
     return pdTRUE;
 }
 
+BaseType_t xRingbufferSendAcquireFromISR(RingbufHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItem != NULL);
+    //currently only supported in NoSplit buffers
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+
+    *ppvItem = NULL;
+    if (xItemSize > pxRingbuffer->xMaxItemSize) {
+        return pdFALSE;     //Data will never ever fit in the queue.
+    }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        *ppvItem = prvAcquireItemSpsc(pxRingbuffer, xItemSize);
+        return (*ppvItem != NULL) ? pdTRUE : pdFALSE;
+    }
+
+    //Attempt to acquire space for an item
+    BaseType_t xReturn;
+    BaseType_t xReturnSemaphore = pdFALSE;
+    portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+    if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdTRUE) {
+        *ppvItem = prvAcquireItemNoSplit(pxRingbuffer, xItemSize);
+        xReturn = pdTRUE;
+        //Check if the free semaphore should be returned to allow other tasks to send
+        if (prvGetFreeSize(pxRingbuffer) > 0) {
+            xReturnSemaphore = pdTRUE;
+        }
+    } else {
+        xReturn = pdFALSE;
+    }
+    portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+
+    if (xReturnSemaphore == pdTRUE) {
+        xSemaphoreGiveFromISR(rbGET_TX_SEM_HANDLE(pxRingbuffer), pxHigherPriorityTaskWoken);  //Give back semaphore so other tasks can send
+    }
+    return xReturn;
+}
+
+BaseType_t xRingbufferSendCompleteFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvSendItemDoneSpsc(pxRingbuffer, pdTRUE, pxHigherPriorityTaskWoken);
+        return pdTRUE;
+    }
+
+    portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+    if (pxRingbuffer->uxRingbufferFlags & rbMULTI_PRODUCER_FLAG) {
+        prvSendItemDoneMultiProducer(pxRingbuffer, pvItem);
+    } else {
+        prvSendItemDoneNoSplit(pxRingbuffer, pvItem);
+    }
+    portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+
+    xSemaphoreGiveFromISR(rbGET_RX_SEM_HANDLE(pxRingbuffer), pxHigherPriorityTaskWoken);
+    return pdTRUE;
+}
+
 BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer,
                            const void *pvItem,
                            size_t xItemSize,
@@ -1039,6 +1651,15 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer,
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        uint8_t *pucItem = prvAcquireSpsc(pxRingbuffer, xItemSize, xTicksToWait);
+        if (pucItem == NULL) {
+            return pdFALSE;
+        }
+        memcpy(pucItem, pvItem, xItemSize);
+        prvSendItemDoneSpsc(pxRingbuffer, pdFALSE, NULL);
+        return pdTRUE;
+    }
 
     //Attempt to send an item
     BaseType_t xReturn = pdFALSE;
@@ -1100,6 +1721,15 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        uint8_t *pucItem = prvAcquireItemSpsc(pxRingbuffer, xItemSize);
+        if (pucItem == NULL) {
+            return pdFALSE;
+        }
+        memcpy(pucItem, pvItem, xItemSize);
+        prvSendItemDoneSpsc(pxRingbuffer, pdTRUE, pxHigherPriorityTaskWoken);
+        return pdTRUE;
+    }
 
     //Attempt to send an item
     BaseType_t xReturn;
@@ -1133,6 +1763,17 @@ void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickTy
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        RingbufferItem_t xItem;
+        if (prvReceiveSpsc(pxRingbuffer, &xItem, 1, xTicksToWait) == 0) {
+            return NULL;
+        }
+        if (pxItemSize != NULL) {
+            *pxItemSize = xItem.xItemSize;
+        }
+        return xItem.pvItem;
+    }
+
     //Attempt to retrieve an item
     void *pvTempItem;
     size_t xTempSize;
@@ -1152,6 +1793,15 @@ void *xRingbufferReceiveFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize)
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        size_t xTempSize;
+        void *pvTempItem = prvGetItemSpsc(pxRingbuffer, &xTempSize);
+        if (pvTempItem != NULL && pxItemSize != NULL) {
+            *pxItemSize = xTempSize;
+        }
+        return pvTempItem;
+    }
+
     //Attempt to retrieve an item
     void *pvTempItem;
     size_t xTempSize;
@@ -1292,12 +1942,60 @@ void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemS
     }
 }
 
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems, TickType_t xTicksToWait)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxItems != NULL);
+    configASSERT(uxMaxItems >= ((pxRingbuffer->uxRingbufferFlags & rbALLOW_SPLIT_FLAG) ? 2 : 1));    //Split items need two entries
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvReceiveSpsc(pxRingbuffer, pxItems, uxMaxItems, xTicksToWait);
+    }
+    return prvReceiveMultipleGeneric(pxRingbuffer, pxItems, uxMaxItems, xTicksToWait);
+}
+
+UBaseType_t xRingbufferReceiveMultipleFromISR(RingbufHandle_t xRingbuffer, RingbufferItem_t *pxItems, UBaseType_t uxMaxItems)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxItems != NULL);
+    configASSERT(uxMaxItems >= ((pxRingbuffer->uxRingbufferFlags & rbALLOW_SPLIT_FLAG) ? 2 : 1));    //Split items need two entries
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvReceiveSpsc(pxRingbuffer, pxItems, uxMaxItems, 0);
+    }
+
+    UBaseType_t uxReturn = 0;
+    BaseType_t xReturnSemaphore = pdFALSE;
+    portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+    if (prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
+        uxReturn = prvGetItems(pxRingbuffer, pxItems, uxMaxItems);
+        if (pxRingbuffer->xItemsWaiting > 0) {
+            xReturnSemaphore = pdTRUE;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+
+    if (xReturnSemaphore == pdTRUE) {
+        xSemaphoreGiveFromISR(rbGET_RX_SEM_HANDLE(pxRingbuffer), NULL);  //Give semaphore back so other tasks can retrieve
+    }
+    return uxReturn;
+}
+
 void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvReturnItemSpsc(pxRingbuffer, (uint8_t *)pvItem, pdFALSE, NULL);
+        return;
+    }
+
     portENTER_CRITICAL(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     portEXIT_CRITICAL(&pxRingbuffer->mux);
@@ -1310,12 +2008,63 @@ void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, Bas
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvReturnItemSpsc(pxRingbuffer, (uint8_t *)pvItem, pdTRUE, pxHigherPriorityTaskWoken);
+        return;
+    }
+
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
     xSemaphoreGiveFromISR(rbGET_TX_SEM_HANDLE(pxRingbuffer), pxHigherPriorityTaskWoken);
 }
 
+void vRingbufferReturnItems(RingbufHandle_t xRingbuffer, const RingbufferItem_t *pxItems, UBaseType_t uxItems)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxItems != NULL || uxItems == 0);
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        for (UBaseType_t i = 0; i < uxItems; i++) {
+            configASSERT(pxItems[i].pvItem != NULL);
+            prvReturnItemSpsc(pxRingbuffer, (uint8_t *)pxItems[i].pvItem, pdFALSE, NULL);
+        }
+        return;
+    }
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    for (UBaseType_t i = 0; i < uxItems; i++) {
+        configASSERT(pxItems[i].pvItem != NULL);
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pxItems[i].pvItem);
+    }
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+    xSemaphoreGive(rbGET_TX_SEM_HANDLE(pxRingbuffer));
+}
+
+void vRingbufferReturnItemsFromISR(RingbufHandle_t xRingbuffer, const RingbufferItem_t *pxItems, UBaseType_t uxItems, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxItems != NULL || uxItems == 0);
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        for (UBaseType_t i = 0; i < uxItems; i++) {
+            configASSERT(pxItems[i].pvItem != NULL);
+            prvReturnItemSpsc(pxRingbuffer, (uint8_t *)pxItems[i].pvItem, pdTRUE, pxHigherPriorityTaskWoken);
+        }
+        return;
+    }
+
+    portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+    for (UBaseType_t i = 0; i < uxItems; i++) {
+        configASSERT(pxItems[i].pvItem != NULL);
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pxItems[i].pvItem);
+    }
+    portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+    xSemaphoreGiveFromISR(rbGET_TX_SEM_HANDLE(pxRingbuffer), pxHigherPriorityTaskWoken);
+}
+
 void vRingbufferDelete(RingbufHandle_t xRingbuffer)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
@@ -1357,6 +2106,7 @@ BaseType_t xRingbufferAddToQueueSetRead(RingbufHandle_t xRingbuffer, QueueSetHan
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) == 0);   //Single producer/single consumer buffers don't use semaphores
 
     BaseType_t xReturn;
     portENTER_CRITICAL(&pxRingbuffer->mux);
@@ -1421,7 +2171,11 @@ void vRingbufferGetInfo(RingbufHandle_t xRingbuffer,
         *uxAcquire = (UBaseType_t)(pxRingbuffer->pucAcquire - pxRingbuffer->pucHead);
     }
     if (uxItemsWaiting != NULL) {
-        *uxItemsWaiting = (UBaseType_t)(pxRingbuffer->xItemsWaiting);
+        if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+            *uxItemsWaiting = prvGetItemsWaitingSpsc(pxRingbuffer);
+        } else {
+            *uxItemsWaiting = (UBaseType_t)(pxRingbuffer->xItemsWaiting);
+        }
     }
     portEXIT_CRITICAL(&pxRingbuffer->mux);
 }
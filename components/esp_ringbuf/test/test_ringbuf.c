@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -14,6 +15,7 @@
 #include "driver/timer.h"
 #include "esp_heap_caps.h"
 #include "esp_spi_flash.h"
+#include "esp_timer.h"
 #include "unity.h"
 #include "test_utils.h"
 
@@ -616,6 +618,406 @@ TEST_CASE("TC#3: Byte buffer", "[esp_ringbuf]")
     vRingbufferDelete(buffer_handle);
 }
 
+/* ------------------------ Multi-producer ring buffer ------------------------
+ * The following test cases test that items in multi-producer ring buffers are
+ * read in the order they were sent, whatever the order they were acquired in.
+ * Test case will do the following...
+ * 1) Acquire two items, send the second one, then check that it can be read
+ *    while the first one is still being filled
+ * 2) Send the first item and check that it is read
+ * 3) Repeat so that the buffer wraps around and is filled up
+ */
+
+TEST_CASE("TC#1: Multi-producer", "[esp_ringbuf]")
+{
+    //Create buffer
+    RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_MULTI_PRODUCER);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+    TEST_ASSERT_MESSAGE(xRingbufferGetMaxItemSize(buffer_handle) == ((BUFFER_SIZE >> 1) - ITEM_HDR_SIZE), "Incorrect max item size received");
+
+    int no_of_pairs = BUFFER_SIZE / (2 * (ITEM_HDR_SIZE + SMALL_ITEM_SIZE));
+    for (int iter = 0; iter < 3; iter++) {
+        void *first, *second;
+        for (int i = 0; i < no_of_pairs; i++) {
+            TEST_ASSERT_MESSAGE(xRingbufferSendAcquire(buffer_handle, &first, SMALL_ITEM_SIZE, TIMEOUT_TICKS) == pdTRUE, "Failed to acquire item");
+            TEST_ASSERT_MESSAGE(xRingbufferSendAcquire(buffer_handle, &second, LARGE_ITEM_SIZE, TIMEOUT_TICKS) == pdTRUE, "Failed to acquire item");
+
+            //The second item can be read before the first one is sent
+            memcpy(second, large_item, LARGE_ITEM_SIZE);
+            TEST_ASSERT(xRingbufferSendComplete(buffer_handle, second) == pdTRUE);
+            receive_check_and_return_item_no_split(buffer_handle, large_item, LARGE_ITEM_SIZE, 0, false);
+            size_t item_size;
+            TEST_ASSERT_MESSAGE(xRingbufferReceive(buffer_handle, &item_size, 0) == NULL, "Received an item which was not sent");
+
+            memcpy(first, small_item, SMALL_ITEM_SIZE);
+            TEST_ASSERT(xRingbufferSendComplete(buffer_handle, first) == pdTRUE);
+            receive_check_and_return_item_no_split(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+        }
+
+        //Fill the buffer, sending items in the reverse order of acquisition
+        void *items[BUFFER_SIZE / (ITEM_HDR_SIZE + SMALL_ITEM_SIZE)];
+        int no_of_items = 0;
+        while (no_of_items < sizeof(items) / sizeof(items[0]) &&
+               xRingbufferSendAcquire(buffer_handle, &items[no_of_items], SMALL_ITEM_SIZE, 0) == pdTRUE) {
+            no_of_items++;
+        }
+        TEST_ASSERT_MESSAGE(no_of_items > 1, "Failed to acquire items");
+        send_item_and_check_failure(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+        for (int i = no_of_items - 1; i >= 0; i--) {
+            memset(items[i], i, SMALL_ITEM_SIZE);
+            TEST_ASSERT(xRingbufferSendComplete(buffer_handle, items[i]) == pdTRUE);
+        }
+        UBaseType_t items_waiting;
+        vRingbufferGetInfo(buffer_handle, NULL, NULL, NULL, NULL, &items_waiting);
+        TEST_ASSERT_MESSAGE(items_waiting == no_of_items, "Incorrect items waiting");
+        for (int i = no_of_items - 1; i >= 0; i--) {
+            uint8_t expected[SMALL_ITEM_SIZE];
+            memset(expected, i, SMALL_ITEM_SIZE);
+            receive_check_and_return_item_no_split(buffer_handle, expected, SMALL_ITEM_SIZE, 0, false);
+        }
+        TEST_ASSERT_MESSAGE(xRingbufferGetCurFreeSize(buffer_handle) == ((BUFFER_SIZE >> 1) - ITEM_HDR_SIZE), "Incorrect buffer free size received");
+    }
+
+    //Cleanup
+    vRingbufferDelete(buffer_handle);
+}
+
+/* ------------------- Multi-producer ring buffer throughput -------------------
+ * A producer task pinned to each core fills items in place while a consumer
+ * task reads them. Each producer numbers its items, and the consumer checks
+ * that the items of each producer are received in order. The same is then
+ * done by copying the items with xRingbufferSend() to compare throughput.
+ */
+
+#define MP_TEST_ITEMS           10000
+#define MP_TEST_ITEM_SIZE       32
+#define MP_TEST_BUFF_LEN        1024
+
+static SemaphoreHandle_t mp_done;
+
+typedef struct {
+    RingbufHandle_t buffer;
+    uint32_t producer;
+    bool zero_copy;
+} mp_task_args_t;
+
+static void mp_producer_task(void *args)
+{
+    mp_task_args_t *task_args = (mp_task_args_t *)args;
+    uint32_t item[MP_TEST_ITEM_SIZE / sizeof(uint32_t)] = { 0 };
+    item[0] = task_args->producer;
+
+    for (uint32_t i = 0; i < MP_TEST_ITEMS; i++) {
+        item[1] = i;
+        if (task_args->zero_copy) {
+            uint32_t *acquired;
+            TEST_ASSERT(xRingbufferSendAcquire(task_args->buffer, (void **)&acquired, MP_TEST_ITEM_SIZE, portMAX_DELAY) == pdTRUE);
+            memcpy(acquired, item, MP_TEST_ITEM_SIZE);
+            TEST_ASSERT(xRingbufferSendComplete(task_args->buffer, acquired) == pdTRUE);
+        } else {
+            TEST_ASSERT(xRingbufferSend(task_args->buffer, item, MP_TEST_ITEM_SIZE, portMAX_DELAY) == pdTRUE);
+        }
+    }
+    xSemaphoreGive(mp_done);
+    vTaskDelete(NULL);
+}
+
+static int mp_run_producers(RingbufferType_t type, bool zero_copy)
+{
+    RingbufHandle_t buffer = xRingbufferCreate(MP_TEST_BUFF_LEN, type);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+    mp_done = xSemaphoreCreateCounting(portNUM_PROCESSORS, 0);
+
+    mp_task_args_t task_args[portNUM_PROCESSORS];
+    uint32_t next_item[portNUM_PROCESSORS] = { 0 };
+    int64_t start = esp_timer_get_time();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        task_args[core].buffer = buffer;
+        task_args[core].producer = core;
+        task_args[core].zero_copy = zero_copy;
+        xTaskCreatePinnedToCore(mp_producer_task, "mp tsk", 2048, (void *)&task_args[core], UNITY_FREERTOS_PRIORITY - 1, NULL, core);
+    }
+    for (int i = 0; i < portNUM_PROCESSORS * MP_TEST_ITEMS; i++) {
+        size_t item_size;
+        uint32_t *item = (uint32_t *)xRingbufferReceive(buffer, &item_size, portMAX_DELAY);
+        TEST_ASSERT_MESSAGE(item != NULL && item_size == MP_TEST_ITEM_SIZE, "Failed to receive item");
+        TEST_ASSERT(item[0] < portNUM_PROCESSORS);
+        TEST_ASSERT_MESSAGE(item[1] == next_item[item[0]], "Items of a producer received out of order");
+        next_item[item[0]]++;
+        vRingbufferReturnItem(buffer, item);
+    }
+    int time_us = esp_timer_get_time() - start;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        xSemaphoreTake(mp_done, portMAX_DELAY);
+    }
+    vTaskDelay(5);  //Allow idle to clean up
+    vSemaphoreDelete(mp_done);
+    vRingbufferDelete(buffer);
+    return time_us;
+}
+
+TEST_CASE("Test multi-producer ring buffer throughput", "[esp_ringbuf]")
+{
+    int zero_copy_us = mp_run_producers(RINGBUF_TYPE_MULTI_PRODUCER, true);
+    int copy_us = mp_run_producers(RINGBUF_TYPE_NOSPLIT, false);
+    printf("%d producers, %d items of %d bytes each: in place %d us, copied %d us\n",
+           portNUM_PROCESSORS, MP_TEST_ITEMS, MP_TEST_ITEM_SIZE, zero_copy_us, copy_us);
+}
+
+/* ------------------------- Batch receive and return -------------------------
+ * The following test cases test xRingbufferReceiveMultiple() and
+ * vRingbufferReturnItems() on each type of ring buffer. Test case will do the
+ * following...
+ * 1) Send numbered items until the buffer is full, then receive them in
+ *    batches and check that the data is received in order
+ * 2) Repeat so that the buffer wraps around
+ * 3) Compare the time taken to receive items one by one and in batches
+ */
+
+#define BATCH_MAX_ITEMS         8
+#define BATCH_TEST_ITERATIONS   1000
+
+static int send_numbered_items(RingbufHandle_t handle, uint8_t *next_byte)
+{
+    int no_of_items = 0;
+    while (1) {
+        uint8_t item[SMALL_ITEM_SIZE];
+        for (int i = 0; i < SMALL_ITEM_SIZE; i++) {
+            item[i] = (uint8_t)(*next_byte + i);
+        }
+        if (xRingbufferSend(handle, item, SMALL_ITEM_SIZE, 0) != pdTRUE) {
+            break;
+        }
+        *next_byte += SMALL_ITEM_SIZE;
+        no_of_items++;
+    }
+    return no_of_items;
+}
+
+TEST_CASE("Test ring buffer batch receive", "[esp_ringbuf]")
+{
+    for (RingbufferType_t buf_type = 0; buf_type < RINGBUF_TYPE_MAX; buf_type++) {
+        RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, buf_type);
+        TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+
+        uint8_t next_tx = 0, next_rx = 0;
+        for (int iter = 0; iter < 4; iter++) {
+            int no_of_items = send_numbered_items(buffer_handle, &next_tx);
+            TEST_ASSERT_MESSAGE(no_of_items > 0, "Failed to send items");
+            size_t bytes_left = no_of_items * SMALL_ITEM_SIZE;
+            while (bytes_left > 0) {
+                RingbufferItem_t items[BATCH_MAX_ITEMS];
+                UBaseType_t received = xRingbufferReceiveMultiple(buffer_handle, items, BATCH_MAX_ITEMS, TIMEOUT_TICKS);
+                TEST_ASSERT_MESSAGE(received > 0 && received <= BATCH_MAX_ITEMS, "Failed to receive items");
+                for (int i = 0; i < received; i++) {
+                    uint8_t *data = (uint8_t *)items[i].pvItem;
+                    for (int j = 0; j < items[i].xItemSize; j++) {
+                        TEST_ASSERT_MESSAGE(data[j] == next_rx, "Item data is invalid");
+                        next_rx++;
+                    }
+                    bytes_left -= items[i].xItemSize;
+                }
+                vRingbufferReturnItems(buffer_handle, items, received);
+            }
+
+            //Verify that no items are waiting
+            RingbufferItem_t items[BATCH_MAX_ITEMS];
+            TEST_ASSERT_MESSAGE(xRingbufferReceiveMultiple(buffer_handle, items, BATCH_MAX_ITEMS, 0) == 0, "Received items from an empty buffer");
+        }
+        vRingbufferDelete(buffer_handle);
+    }
+}
+
+TEST_CASE("Test ring buffer batch receive performance", "[esp_ringbuf]")
+{
+    RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+    int no_of_items = BUFFER_SIZE / (2 * (ITEM_HDR_SIZE + SMALL_ITEM_SIZE));
+    TEST_ASSERT(no_of_items <= BATCH_MAX_ITEMS);
+
+    int64_t single_us = 0, batch_us = 0;
+    for (int iter = 0; iter < BATCH_TEST_ITERATIONS; iter++) {
+        for (int i = 0; i < no_of_items; i++) {
+            send_item_and_check(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+        }
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < no_of_items; i++) {
+            size_t item_size;
+            void *item = xRingbufferReceive(buffer_handle, &item_size, 0);
+            TEST_ASSERT_MESSAGE(item != NULL, "Failed to receive item");
+            vRingbufferReturnItem(buffer_handle, item);
+        }
+        single_us += esp_timer_get_time() - start;
+
+        for (int i = 0; i < no_of_items; i++) {
+            send_item_and_check(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+        }
+        start = esp_timer_get_time();
+        RingbufferItem_t items[BATCH_MAX_ITEMS];
+        TEST_ASSERT_EQUAL(no_of_items, xRingbufferReceiveMultiple(buffer_handle, items, BATCH_MAX_ITEMS, 0));
+        vRingbufferReturnItems(buffer_handle, items, no_of_items);
+        batch_us += esp_timer_get_time() - start;
+    }
+    printf("Receiving %d items %d times: one by one %d us, in batches %d us\n",
+           no_of_items, BATCH_TEST_ITERATIONS, (int)single_us, (int)batch_us);
+    TEST_ASSERT(batch_us < single_us);
+    vRingbufferDelete(buffer_handle);
+}
+
+/* --------------- Single producer/single consumer ring buffer ----------------
+ * The following test cases test single producer/single consumer ring buffers.
+ * Test case will do the following...
+ * 1) Send items until the buffer is full, using both xRingbufferSend() and
+ *    xRingbufferSendAcquire()
+ * 2) Check that sending fails and receive the items
+ * 3) Repeat so that the buffer wraps around
+ * 4) Measure throughput with the producer and consumer on different cores, and
+ *    latency of sending then receiving an item, comparing with other types
+ */
+
+TEST_CASE("TC#1: SPSC", "[esp_ringbuf]")
+{
+    RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_SPSC);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+    TEST_ASSERT_MESSAGE(xRingbufferGetMaxItemSize(buffer_handle) == ((BUFFER_SIZE >> 1) - ITEM_HDR_SIZE), "Incorrect max item size received");
+
+    for (int iter = 0; iter < 5; iter++) {
+        //Fill the buffer, alternating between copying items and writing them in place
+        int no_of_items = 0;
+        while (1) {
+            void *item;
+            if (no_of_items % 2) {
+                if (xRingbufferSend(buffer_handle, large_item, LARGE_ITEM_SIZE, 0) != pdTRUE) {
+                    break;
+                }
+            } else {
+                if (xRingbufferSendAcquire(buffer_handle, &item, LARGE_ITEM_SIZE, 0) != pdTRUE) {
+                    break;
+                }
+                memcpy(item, large_item, LARGE_ITEM_SIZE);
+                TEST_ASSERT(xRingbufferSendComplete(buffer_handle, item) == pdTRUE);
+            }
+            no_of_items++;
+        }
+        TEST_ASSERT_MESSAGE(no_of_items >= (BUFFER_SIZE / 2) / (ITEM_HDR_SIZE + LARGE_ITEM_SIZE), "Failed to send items");
+        TEST_ASSERT_MESSAGE(xRingbufferGetCurFreeSize(buffer_handle) < LARGE_ITEM_SIZE, "Buffer full not achieved");
+        send_item_and_check_failure(buffer_handle, large_item, LARGE_ITEM_SIZE, TIMEOUT_TICKS, false);
+
+        UBaseType_t items_waiting;
+        vRingbufferGetInfo(buffer_handle, NULL, NULL, NULL, NULL, &items_waiting);
+        TEST_ASSERT_MESSAGE(items_waiting == no_of_items, "Incorrect items waiting");
+        for (int i = 0; i < no_of_items; i++) {
+            receive_check_and_return_item_no_split(buffer_handle, large_item, LARGE_ITEM_SIZE, 0, false);
+        }
+        TEST_ASSERT_MESSAGE(xRingbufferReceive(buffer_handle, NULL, 0) == NULL, "Received an item from an empty buffer");
+
+        //Move the pointers so that the buffer wraps around at a different item in the next iteration
+        send_item_and_check(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+        receive_check_and_return_item_no_split(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+    }
+    vRingbufferDelete(buffer_handle);
+}
+
+#define SPSC_TEST_ITEMS         20000
+#define SPSC_TEST_BUFF_LEN      1024
+
+static void spsc_producer_task(void *args)
+{
+    RingbufHandle_t buffer = (RingbufHandle_t)args;
+    for (uint32_t i = 0; i < SPSC_TEST_ITEMS; i++) {
+        TEST_ASSERT(xRingbufferSend(buffer, &i, sizeof(i), portMAX_DELAY) == pdTRUE);
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Test SPSC ring buffer performance", "[esp_ringbuf]")
+{
+    static const RingbufferType_t types[] = { RINGBUF_TYPE_NOSPLIT, RINGBUF_TYPE_BYTEBUF, RINGBUF_TYPE_SPSC };
+    done_sem = xSemaphoreCreateBinary();
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        RingbufHandle_t buffer = xRingbufferCreate(SPSC_TEST_BUFF_LEN, types[t]);
+        TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+
+        //Latency of sending then receiving an item in the same task
+        int64_t start = esp_timer_get_time();
+        for (uint32_t i = 0; i < SPSC_TEST_ITEMS; i++) {
+            size_t item_size;
+            TEST_ASSERT(xRingbufferSend(buffer, &i, sizeof(i), 0) == pdTRUE);
+            void *item = (types[t] == RINGBUF_TYPE_BYTEBUF) ? xRingbufferReceiveUpTo(buffer, &item_size, 0, sizeof(i)) :
+                         xRingbufferReceive(buffer, &item_size, 0);
+            TEST_ASSERT(item != NULL && item_size == sizeof(i));
+            vRingbufferReturnItem(buffer, item);
+        }
+        int latency_ns = (esp_timer_get_time() - start) * 1000 / SPSC_TEST_ITEMS;
+
+        //Throughput with the producer pinned to the other core
+        start = esp_timer_get_time();
+        xTaskCreatePinnedToCore(spsc_producer_task, "spsc tsk", 2048, buffer, UNITY_FREERTOS_PRIORITY, NULL, (xPortGetCoreID() + 1) % portNUM_PROCESSORS);
+        for (uint32_t i = 0; i < SPSC_TEST_ITEMS; i++) {
+            size_t item_size;
+            uint32_t *item = (types[t] == RINGBUF_TYPE_BYTEBUF) ? xRingbufferReceiveUpTo(buffer, &item_size, portMAX_DELAY, sizeof(i)) :
+                             xRingbufferReceive(buffer, &item_size, portMAX_DELAY);
+            TEST_ASSERT(item != NULL && item_size == sizeof(i));
+            TEST_ASSERT_MESSAGE(*item == i, "Received data is corrupted");
+            vRingbufferReturnItem(buffer, item);
+        }
+        int time_us = esp_timer_get_time() - start;
+        xSemaphoreTake(done_sem, portMAX_DELAY);
+        vTaskDelay(5);  //Allow idle to clean up
+
+        printf("Type %d: send and receive %d ns, %d items/s between tasks\n", types[t], latency_ns, (int)(SPSC_TEST_ITEMS * 1000000LL / time_us));
+        vRingbufferDelete(buffer);
+    }
+    vSemaphoreDelete(done_sem);
+}
+
+/*
+ * A task which timed out waiting on an SPSC buffer must not be notified by
+ * later sends or receives, the task may have been deleted since. Wait on an
+ * empty and a full buffer in a task that is deleted afterwards, then wait in
+ * this task and check that no notification is left for it.
+ */
+
+static void spsc_timeout_task(void *args)
+{
+    RingbufHandle_t buffer = (RingbufHandle_t)args;
+    size_t item_size;
+    TEST_ASSERT(xRingbufferReceive(buffer, &item_size, TIMEOUT_TICKS) == NULL);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Test SPSC ring buffer wait timeout", "[esp_ringbuf]")
+{
+    RingbufHandle_t buffer = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_SPSC);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+    done_sem = xSemaphoreCreateBinary();
+
+    //Time out in a task, then send after the task has been deleted and cleaned up
+    xTaskCreate(spsc_timeout_task, "spsc tsk", 2048, buffer, UNITY_FREERTOS_PRIORITY + 1, NULL);
+    xSemaphoreTake(done_sem, portMAX_DELAY);
+    vTaskDelay(5);  //Allow idle to clean up
+    send_item_and_check(buffer, small_item, SMALL_ITEM_SIZE, 0, false);
+    receive_check_and_return_item_no_split(buffer, small_item, SMALL_ITEM_SIZE, 0, false);
+
+    //Time out receiving and sending in this task
+    ulTaskNotifyTake(pdTRUE, 0);
+    TEST_ASSERT(xRingbufferReceive(buffer, NULL, TIMEOUT_TICKS) == NULL);
+    send_item_and_check(buffer, small_item, SMALL_ITEM_SIZE, 0, false);
+    receive_check_and_return_item_no_split(buffer, small_item, SMALL_ITEM_SIZE, 0, false);
+    TEST_ASSERT_MESSAGE(ulTaskNotifyTake(pdTRUE, 0) == 0, "Notified after receive timed out");
+    while (xRingbufferSend(buffer, large_item, LARGE_ITEM_SIZE, 0) == pdTRUE) {
+    }
+    send_item_and_check_failure(buffer, large_item, LARGE_ITEM_SIZE, TIMEOUT_TICKS, false);
+    receive_check_and_return_item_no_split(buffer, large_item, LARGE_ITEM_SIZE, 0, false);
+    TEST_ASSERT_MESSAGE(ulTaskNotifyTake(pdTRUE, 0) == 0, "Notified after send timed out");
+
+    vSemaphoreDelete(done_sem);
+    vRingbufferDelete(buffer);
+}
+
 /* ----------------------- Ring buffer queue sets test ------------------------
  * The following test case will test receiving from ring buffers that have been
  * added to a queue set. The test case will do the following...
@@ -862,7 +1264,7 @@ static void read_from_buffer(RingbufHandle_t buffer, RingbufferType_t buf_type,
             char *item_data, *item_data2;
 
             //Select appropriate receive function for type of ring buffer
-            if (buf_type ==  RINGBUF_TYPE_NOSPLIT) {
+            if (buf_type ==  RINGBUF_TYPE_NOSPLIT || buf_type == RINGBUF_TYPE_MULTI_PRODUCER || buf_type == RINGBUF_TYPE_SPSC) {
                 item_data = (char *)xRingbufferReceive(buffer, &item_size, TIMEOUT_TICKS);
             } else if (buf_type == RINGBUF_TYPE_ALLOWSPLIT) {
                 BaseType_t ret = xRingbufferReceiveSplit(buffer, (void **)&item_data, (void **)&item_data2, &item_size, &item_size2, TIMEOUT_TICKS);
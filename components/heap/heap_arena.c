@@ -0,0 +1,112 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/param.h>
+#include "multi_heap_config.h"
+#include "esp_heap_arena.h"
+#include "heap_arena_internal.h"
+
+/* Bump allocator for esp_heap_arena.h. Arenas allocated from the heaps are created by heap_arena_create() in
+   heap_caps_arena.c; this file only deals with the memory of an arena, so it can also be built for the host tests.
+*/
+
+#ifdef MULTI_HEAP_POISONING_SLOW
+/* Same pattern as multi_heap_poisoning.c uses for free memory, to catch use of memory after it is released */
+#define ARENA_FREE_FILL_PATTERN 0xfe
+#endif
+
+void heap_arena_init(struct heap_arena *arena, void *start, void *end)
+{
+    arena->start = start;
+    arena->end = end;
+    arena->next = start;
+    arena->max_used = 0;
+}
+
+heap_arena_handle_t heap_arena_create_with_buffer(void *buffer, size_t size)
+{
+    uintptr_t start = HEAP_ARENA_ALIGN_UP((uintptr_t)buffer);
+    uintptr_t end = (uintptr_t)buffer + size;
+    if (buffer == NULL || end < start || end - start < sizeof(struct heap_arena)) {
+        return NULL;
+    }
+
+    struct heap_arena *arena = (struct heap_arena *)start;
+    heap_arena_init(arena, arena + 1, (void *)end);
+    return arena;
+}
+
+void *heap_arena_alloc(heap_arena_handle_t arena, size_t size)
+{
+    if (size == 0 || size > (size_t)(arena->end - arena->next)) {
+        return NULL;
+    }
+
+    uint8_t *ret = arena->next;
+    // the end of the arena may not be aligned, so the padding of the last allocation may not fit
+    arena->next += MIN(HEAP_ARENA_ALIGN_UP(size), (size_t)(arena->end - arena->next));
+    arena->max_used = MAX(arena->max_used, (size_t)(arena->next - arena->start));
+    return ret;
+}
+
+void *heap_arena_calloc(heap_arena_handle_t arena, size_t n, size_t size)
+{
+    size_t size_bytes;
+    if (__builtin_mul_overflow(n, size, &size_bytes)) {
+        return NULL;
+    }
+
+    void *ret = heap_arena_alloc(arena, size_bytes);
+    if (ret != NULL) {
+        memset(ret, 0, size_bytes);
+    }
+    return ret;
+}
+
+void heap_arena_reset(heap_arena_handle_t arena)
+{
+    heap_arena_rollback(arena, 0);
+}
+
+heap_arena_checkpoint_t heap_arena_checkpoint(heap_arena_handle_t arena)
+{
+    return arena->next - arena->start;
+}
+
+void heap_arena_rollback(heap_arena_handle_t arena, heap_arena_checkpoint_t checkpoint)
+{
+    uint8_t *next = arena->start + checkpoint;
+    assert(next <= arena->next && "checkpoint was discarded by an earlier rollback or reset");
+#ifdef ARENA_FREE_FILL_PATTERN
+    memset(next, ARENA_FREE_FILL_PATTERN, arena->next - next);
+#endif
+    arena->next = next;
+}
+
+size_t heap_arena_get_used_size(heap_arena_handle_t arena)
+{
+    return arena->next - arena->start;
+}
+
+size_t heap_arena_get_free_size(heap_arena_handle_t arena)
+{
+    return arena->end - arena->next;
+}
+
+size_t heap_arena_get_max_used_size(heap_arena_handle_t arena)
+{
+    return arena->max_used;
+}
@@ -0,0 +1,38 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_heap_arena.h"
+
+/* Arena state, kept at the start of the arena memory.
+
+   Shared by heap_arena.c (the allocator itself, also built for the host tests) and heap_caps_arena.c (arenas allocated
+   from the heaps).
+*/
+struct heap_arena {
+    uint8_t *start; ///< First byte which can be allocated
+    uint8_t *end;   ///< End of the arena
+    uint8_t *next;  ///< Next byte to allocate
+    size_t max_used;
+};
+
+/* Alignment of all arena allocations */
+#define HEAP_ARENA_ALIGN sizeof(void *)
+
+#define HEAP_ARENA_ALIGN_UP(X) (((X) + HEAP_ARENA_ALIGN - 1) & ~(HEAP_ARENA_ALIGN - 1))
+
+/* Set up an arena to allocate from the memory between start and end. start must be aligned to HEAP_ARENA_ALIGN */
+void heap_arena_init(struct heap_arena *arena, void *start, void *end);
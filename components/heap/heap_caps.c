@@ -19,6 +19,7 @@
 #include "esp_attr.h"
 #include "esp_heap_caps.h"
 #include "multi_heap.h"
+#include "multi_heap_internal.h"
 #include "esp_log.h"
 #include "heap_private.h"
 
@@ -59,36 +60,12 @@ bool heap_caps_match(const heap_t *heap, uint32_t caps)
 }
 
 /*
-Routine to allocate a bit of memory with certain capabilities. caps is a bitfield of MALLOC_CAP_* bits.
+Search the registered heaps in priority order for one which can allocate 'size' bytes with capabilities 'caps'.
 */
-IRAM_ATTR void *heap_caps_malloc( size_t size, uint32_t caps )
+IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps )
 {
     void *ret = NULL;
 
-    if (size > HEAP_SIZE_MAX) {
-        // Avoids int overflow when adding small numbers to size, or
-        // calculating 'end' from start+size, by limiting 'size' to the possible range
-        return NULL;
-    }
-
-    if (caps & MALLOC_CAP_EXEC) {
-        //MALLOC_CAP_EXEC forces an alloc from IRAM. There is a region which has both this as well as the following
-        //caps, but the following caps are not possible for IRAM.  Thus, the combination is impossible and we return
-        //NULL directly, even although our heap capabilities (based on soc_memory_tags & soc_memory_regions) would
-        //indicate there is a tag for this.
-        if ((caps & MALLOC_CAP_8BIT) || (caps & MALLOC_CAP_DMA)) {
-            return NULL;
-        }
-        caps |= MALLOC_CAP_32BIT; // IRAM is 32-bit accessible RAM
-    }
-
-    if (caps & MALLOC_CAP_32BIT) {
-        /* 32-bit accessible RAM should allocated in 4 byte aligned sizes
-         * (Future versions of ESP-IDF should possibly fail if an invalid size is requested)
-         */
-        size = (size + 3) & (~3); // int overflow checked above
-    }
-
     for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
         //Iterate over heaps and check capabilities at this priority
         heap_t *heap;
@@ -125,6 +102,60 @@ IRAM_ATTR void *heap_caps_malloc( size_t size, uint32_t caps )
     return NULL;
 }
 
+/*
+Routine to allocate a bit of memory with certain capabilities. caps is a bitfield of MALLOC_CAP_* bits.
+*/
+IRAM_ATTR void *heap_caps_malloc( size_t size, uint32_t caps )
+{
+    void *ret = NULL;
+
+    if (size > HEAP_SIZE_MAX) {
+        // Avoids int overflow when adding small numbers to size, or
+        // calculating 'end' from start+size, by limiting 'size' to the possible range
+        return NULL;
+    }
+
+    if (caps & MALLOC_CAP_EXEC) {
+        //MALLOC_CAP_EXEC forces an alloc from IRAM. There is a region which has both this as well as the following
+        //caps, but the following caps are not possible for IRAM.  Thus, the combination is impossible and we return
+        //NULL directly, even although our heap capabilities (based on soc_memory_tags & soc_memory_regions) would
+        //indicate there is a tag for this.
+        if ((caps & MALLOC_CAP_8BIT) || (caps & MALLOC_CAP_DMA)) {
+            return NULL;
+        }
+        caps |= MALLOC_CAP_32BIT; // IRAM is 32-bit accessible RAM
+    }
+
+    if (caps & MALLOC_CAP_32BIT) {
+        /* 32-bit accessible RAM should allocated in 4 byte aligned sizes
+         * (Future versions of ESP-IDF should possibly fail if an invalid size is requested)
+         */
+        size = (size + 3) & (~3); // int overflow checked above
+    }
+
+#if CONFIG_HEAP_SLAB_CACHE
+    size_t slab_size = heap_caps_slab_size(size, caps);
+    if (slab_size != 0) {
+        ret = heap_caps_slab_get(slab_size);
+        if (ret != NULL) {
+            return ret;
+        }
+        //Allocate a block of the cached size, so it can go into a cache when it is freed
+        size = slab_size;
+    }
+#endif
+
+    ret = heap_caps_malloc_base(size, caps);
+
+#if CONFIG_HEAP_SLAB_CACHE
+    if (ret == NULL && heap_caps_slab_flush()) {
+        //Memory was low enough for the allocation to fail, but some was held in the caches. Try again.
+        ret = heap_caps_malloc_base(size, caps);
+    }
+#endif
+    return ret;
+}
+
 
 #define MALLOC_DISABLE_EXTERNAL_ALLOCS -1
 //Dual-use: -1 (=MALLOC_DISABLE_EXTERNAL_ALLOCS) disables allocations in external memory, >=0 sets the limit for allocations preferring internal memory.
@@ -241,7 +272,7 @@ IRAM_ATTR void *heap_caps_calloc_prefer( size_t n, size_t size, size_t num, ...
    (This confirms if ptr is inside the heap's region, doesn't confirm if 'ptr'
    is an allocated block or is some other random address inside the heap.)
 */
-IRAM_ATTR static heap_t *find_containing_heap(void *ptr )
+IRAM_ATTR heap_t *find_containing_heap(void *ptr )
 {
     intptr_t p = (intptr_t)ptr;
     heap_t *heap;
@@ -269,6 +300,11 @@ IRAM_ATTR void heap_caps_free( void *ptr)
 
     heap_t *heap = find_containing_heap(ptr);
     assert(heap != NULL && "free() target pointer is outside heap areas");
+#if CONFIG_HEAP_SLAB_CACHE
+    if (heap_caps_slab_put(heap, ptr)) {
+        return;
+    }
+#endif
     multi_heap_free(heap->heap, ptr);
 }
 
@@ -345,6 +381,22 @@ IRAM_ATTR void *heap_caps_realloc( void *ptr, size_t size, int caps)
     return NULL;
 }
 
+IRAM_ATTR bool heap_caps_try_expand( void *ptr, size_t size )
+{
+    if (ptr == NULL || size > HEAP_SIZE_MAX) {
+        return false;
+    }
+
+    //Aliased IRAM pointers are never resized in place, same as in heap_caps_realloc()
+    if (esp_ptr_in_diram_iram(ptr)) {
+        return false;
+    }
+
+    heap_t *heap = find_containing_heap(ptr);
+    assert(heap != NULL && "try_expand() pointer is outside heap areas");
+    return multi_heap_try_expand(heap->heap, ptr, size);
+}
+
 IRAM_ATTR void *heap_caps_calloc( size_t n, size_t size, uint32_t caps)
 {
     void *result;
@@ -424,6 +476,31 @@ void heap_caps_get_info( multi_heap_info_t *info, uint32_t caps )
             info->total_blocks += hinfo.total_blocks;
         }
     }
+    heap_caps_arena_get_info(info, caps);
+#if CONFIG_HEAP_SLAB_CACHE
+    heap_caps_slab_get_info(info, caps);
+#endif
+}
+
+void heap_caps_get_fragmentation_info( multi_heap_fragmentation_info_t *info, uint32_t caps )
+{
+    bzero(info, sizeof(multi_heap_fragmentation_info_t));
+
+    heap_t *heap;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        if (heap_caps_match(heap, caps)) {
+            multi_heap_fragmentation_info_t hinfo;
+            multi_heap_get_fragmentation_info(heap->heap, &hinfo);
+
+            info->total_free_bytes += hinfo.total_free_bytes;
+            info->free_blocks += hinfo.free_blocks;
+            for (int i = 0; i < MULTI_HEAP_FREE_SIZE_CLASSES; i++) {
+                info->free_blocks_by_size[i] += hinfo.free_blocks_by_size[i];
+            }
+            info->free_bytes_squared += hinfo.free_bytes_squared;
+        }
+    }
+    info->fragmentation = multi_heap_internal_fragmentation(info->total_free_bytes, info->free_bytes_squared);
 }
 
 void heap_caps_print_heap_info( uint32_t caps )
@@ -433,19 +510,27 @@ void heap_caps_print_heap_info( uint32_t caps )
     heap_t *heap;
     SLIST_FOREACH(heap, &registered_heaps, next) {
         if (heap_caps_match(heap, caps)) {
+            multi_heap_fragmentation_info_t frag_info;
             multi_heap_get_info(heap->heap, &info);
+            multi_heap_get_fragmentation_info(heap->heap, &frag_info);
 
             printf("  At 0x%08x len %d free %d allocated %d min_free %d\n",
                    heap->start, heap->end - heap->start, info.total_free_bytes, info.total_allocated_bytes, info.minimum_free_bytes);
-            printf("    largest_free_block %d alloc_blocks %d free_blocks %d total_blocks %d\n",
+            printf("    largest_free_block %d alloc_blocks %d free_blocks %d total_blocks %d fragmentation %d%%\n",
                    info.largest_free_block, info.allocated_blocks,
-                   info.free_blocks, info.total_blocks);
+                   info.free_blocks, info.total_blocks, frag_info.fragmentation);
         }
     }
     printf("  Totals:\n");
     heap_caps_get_info(&info, caps);
 
     printf("    free %d allocated %d min_free %d largest_free_block %d\n", info.total_free_bytes, info.total_allocated_bytes, info.minimum_free_bytes, info.largest_free_block);
+    if (info.arena_bytes != 0) {
+        printf("    arenas %d used %d\n", info.arena_bytes, info.arena_used_bytes);
+    }
+#if CONFIG_HEAP_SLAB_CACHE
+    printf("    cached %d in %d blocks\n", info.cached_bytes, info.cached_blocks);
+#endif
 }
 
 bool heap_caps_check_integrity(uint32_t caps, bool print_errors)
@@ -460,6 +545,7 @@ bool heap_caps_check_integrity(uint32_t caps, bool print_errors)
             valid = multi_heap_check(heap->heap, print_errors) && valid;
         }
     }
+    valid = heap_caps_pool_check_integrity(caps, print_errors) && valid;
 
     return valid;
 }
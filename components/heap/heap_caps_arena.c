@@ -0,0 +1,88 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdbool.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_heap_arena.h"
+#include "heap_arena_internal.h"
+#include "heap_private.h"
+
+/*
+  Arenas allocated from the heaps, see heap_arena_create().
+
+  This isn't part of heap_caps.c, so that the calls to heap_caps_malloc() and heap_caps_free() here go through the
+  heap tracing wrappers and the arena memory shows up in heap traces.
+
+  All these arenas are kept in a list, so heap_caps_get_info() can report how much of the memory they hold is
+  actually used.
+*/
+
+typedef struct heap_caps_arena_ {
+    struct heap_arena arena; // must be first, handles point here
+    heap_t *heap;
+    SLIST_ENTRY(heap_caps_arena_) next;
+} heap_caps_arena_t;
+
+static SLIST_HEAD(heap_caps_arena_ll, heap_caps_arena_) s_arenas = SLIST_HEAD_INITIALIZER(s_arenas);
+
+static multi_heap_lock_t s_arenas_lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER;
+
+heap_arena_handle_t heap_arena_create(size_t size, uint32_t caps)
+{
+    // arenas hold data, and the heap they are in has to be found from their address
+    if (size == 0 || size > HEAP_SIZE_MAX || (caps & MALLOC_CAP_EXEC)) {
+        return NULL;
+    }
+
+    heap_caps_arena_t *caps_arena = heap_caps_malloc(sizeof(heap_caps_arena_t) + HEAP_ARENA_ALIGN_UP(size), caps);
+    if (caps_arena == NULL) {
+        return NULL;
+    }
+
+    uint8_t *start = (uint8_t *)(caps_arena + 1);
+    heap_arena_init(&caps_arena->arena, start, start + HEAP_ARENA_ALIGN_UP(size));
+    caps_arena->heap = find_containing_heap(caps_arena);
+    assert(caps_arena->heap != NULL);
+
+    MULTI_HEAP_LOCK(&s_arenas_lock);
+    SLIST_INSERT_HEAD(&s_arenas, caps_arena, next);
+    MULTI_HEAP_UNLOCK(&s_arenas_lock);
+    return &caps_arena->arena;
+}
+
+void heap_arena_destroy(heap_arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+
+    heap_caps_arena_t *caps_arena = (heap_caps_arena_t *)arena;
+    MULTI_HEAP_LOCK(&s_arenas_lock);
+    SLIST_REMOVE(&s_arenas, caps_arena, heap_caps_arena_, next);
+    MULTI_HEAP_UNLOCK(&s_arenas_lock);
+    heap_caps_free(caps_arena);
+}
+
+void heap_caps_arena_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    heap_caps_arena_t *caps_arena;
+    MULTI_HEAP_LOCK(&s_arenas_lock);
+    SLIST_FOREACH(caps_arena, &s_arenas, next) {
+        if (heap_caps_match(caps_arena->heap, caps)) {
+            info->arena_bytes += caps_arena->arena.end - caps_arena->arena.start;
+            info->arena_used_bytes += heap_arena_get_used_size(&caps_arena->arena);
+        }
+    }
+    MULTI_HEAP_UNLOCK(&s_arenas_lock);
+}
@@ -0,0 +1,171 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "multi_heap.h"
+#include "heap_private.h"
+#include "sdkconfig.h"
+
+/*
+  Per-CPU caches of small free blocks, sitting in front of the heaps (CONFIG_HEAP_SLAB_CACHE).
+
+  heap_caps_free() keeps blocks of exactly 16, 32, 64 or 128 bytes in a small stack belonging to the CPU it runs
+  on, instead of returning them to their heap. heap_caps_malloc() rounds small requests up to one of these sizes and
+  takes a block from the current CPU's stack before searching the heaps. Each stack has its own spinlock, which is
+  only ever contended while another CPU flushes the caches or reads their statistics, so the CPUs don't contend
+  for the lock of the heap they both allocate small blocks from.
+
+  Blocks in the caches are still allocated blocks as far as their heap is concerned. Only blocks from heaps with
+  all of SLAB_CACHE_CAPS are cached, so any cached block can serve a request for a subset of these capabilities.
+*/
+
+#define SLAB_CLASS_MIN_SIZE_LOG2 4
+#define SLAB_CLASS_COUNT 4
+#define SLAB_CLASS_MAX_SIZE (1 << (SLAB_CLASS_MIN_SIZE_LOG2 + SLAB_CLASS_COUNT - 1))
+
+#define SLAB_CACHE_CAPS (MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT | MALLOC_CAP_32BIT)
+
+typedef struct {
+    void *ptr;
+    heap_t *heap;
+} slab_block_t;
+
+typedef struct {
+    multi_heap_lock_t lock;
+    size_t count[SLAB_CLASS_COUNT];
+    slab_block_t blocks[SLAB_CLASS_COUNT][CONFIG_HEAP_SLAB_CACHE_DEPTH];
+} slab_cache_t;
+
+static slab_cache_t s_slab_caches[portNUM_PROCESSORS] = {
+    [0 ... portNUM_PROCESSORS - 1] = { .lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER },
+};
+
+static inline IRAM_ATTR size_t class_size(int class)
+{
+    return 1 << (SLAB_CLASS_MIN_SIZE_LOG2 + class);
+}
+
+/* Return the class of the smallest blocks that can hold 'size' bytes (size must be 1..SLAB_CLASS_MAX_SIZE) */
+static inline IRAM_ATTR int size_to_class(size_t size)
+{
+    if (size <= class_size(0)) {
+        return 0;
+    }
+    return (32 - __builtin_clz(size - 1)) - SLAB_CLASS_MIN_SIZE_LOG2;
+}
+
+/* The task may move to the other CPU after this returns, in which case it uses the other CPU's cache. This is
+   still correct because every cache is protected by its own lock, it is just not as fast. */
+static inline IRAM_ATTR slab_cache_t *this_cpu_cache(void)
+{
+    return &s_slab_caches[xPortGetCoreID()];
+}
+
+IRAM_ATTR size_t heap_caps_slab_size(size_t size, uint32_t caps)
+{
+    if (size == 0 || size > SLAB_CLASS_MAX_SIZE || (caps & ~SLAB_CACHE_CAPS) != 0) {
+        return 0;
+    }
+    return class_size(size_to_class(size));
+}
+
+IRAM_ATTR void *heap_caps_slab_get(size_t slab_size)
+{
+    int class = size_to_class(slab_size);
+    slab_cache_t *cache = this_cpu_cache();
+    void *ret = NULL;
+
+    MULTI_HEAP_LOCK(&cache->lock);
+    if (cache->count[class] > 0) {
+        ret = cache->blocks[class][--cache->count[class]].ptr;
+    }
+    MULTI_HEAP_UNLOCK(&cache->lock);
+    return ret;
+}
+
+IRAM_ATTR bool heap_caps_slab_put(heap_t *heap, void *ptr)
+{
+    if ((get_all_caps(heap) & SLAB_CACHE_CAPS) != SLAB_CACHE_CAPS) {
+        return false;
+    }
+
+    size_t size = multi_heap_get_allocated_size(heap->heap, ptr);
+    if (size < class_size(0) || size > SLAB_CLASS_MAX_SIZE || (size & (size - 1)) != 0) {
+        return false;
+    }
+
+    if (multi_heap_free_size(heap->heap) < CONFIG_HEAP_SLAB_CACHE_LOW_MEMORY) {
+        // Memory is getting low, don't hold on to any more of it
+        return false;
+    }
+
+    int class = size_to_class(size);
+    slab_cache_t *cache = this_cpu_cache();
+    bool cached = false;
+
+    MULTI_HEAP_LOCK(&cache->lock);
+    if (cache->count[class] < CONFIG_HEAP_SLAB_CACHE_DEPTH) {
+        slab_block_t *block = &cache->blocks[class][cache->count[class]++];
+        block->ptr = ptr;
+        block->heap = heap;
+        cached = true;
+    }
+    MULTI_HEAP_UNLOCK(&cache->lock);
+    return cached;
+}
+
+IRAM_ATTR bool heap_caps_slab_flush(void)
+{
+    bool flushed = false;
+
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        slab_cache_t *cache = &s_slab_caches[cpu];
+        MULTI_HEAP_LOCK(&cache->lock);
+        for (int class = 0; class < SLAB_CLASS_COUNT; class++) {
+            for (size_t i = 0; i < cache->count[class]; i++) {
+                slab_block_t *block = &cache->blocks[class][i];
+                multi_heap_free(block->heap->heap, block->ptr);
+            }
+            flushed = flushed || (cache->count[class] > 0);
+            cache->count[class] = 0;
+        }
+        MULTI_HEAP_UNLOCK(&cache->lock);
+    }
+    return flushed;
+}
+
+void heap_caps_slab_cache_flush(void)
+{
+    heap_caps_slab_flush();
+}
+
+void heap_caps_slab_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        slab_cache_t *cache = &s_slab_caches[cpu];
+        MULTI_HEAP_LOCK(&cache->lock);
+        for (int class = 0; class < SLAB_CLASS_COUNT; class++) {
+            for (size_t i = 0; i < cache->count[class]; i++) {
+                if (heap_caps_match(cache->blocks[class][i].heap, caps)) {
+                    info->cached_bytes += class_size(class);
+                    info->cached_blocks++;
+                }
+            }
+        }
+        MULTI_HEAP_UNLOCK(&cache->lock);
+    }
+}
@@ -0,0 +1,287 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_pool.h"
+#include "multi_heap_config.h"
+#include "heap_private.h"
+
+/*
+  Fixed size block pools, see esp_heap_pool.h.
+
+  The free blocks form a singly linked list. The first word of each free block holds the index of the next free
+  block. The head of the list is a single word: the index of the first free block in the low 16 bits, and a
+  counter in the high 16 bits which changes on every update. The head is only ever updated with compare-and-set
+  (S32C1I), and the counter makes the compare fail if the list was changed in between, even if the same block is
+  at the head again ("ABA" problem).
+
+  Interrupts are disabled on the current CPU while a compare-and-set loop runs, so a task can't be pre-empted
+  between reading the head and setting it; the counter can't wrap around in the few cycles this takes. The other
+  CPU is never blocked.
+*/
+
+#define POOL_INDEX_NONE 0xFFFF
+#define POOL_MAX_BLOCKS (POOL_INDEX_NONE - 1)
+
+#define HEAD(TAG, INDEX) (((uint32_t)(TAG) << 16) | (INDEX))
+#define HEAD_INDEX(HEAD) ((HEAD) & 0xFFFF)
+#define HEAD_TAG(HEAD) ((HEAD) >> 16)
+
+#define POOL_ALIGN sizeof(void *)
+
+#ifdef MULTI_HEAP_POISONING_SLOW
+/* Same patterns as multi_heap_poisoning.c */
+#define MALLOC_FILL_PATTERN 0xce
+#define FREE_FILL_PATTERN 0xfe
+#endif
+
+struct heap_pool {
+    volatile uint32_t head;     ///< Counter and index of the first free block, see above
+    volatile uint32_t used;     ///< Blocks currently allocated
+    volatile uint32_t max_used; ///< Highest value of 'used'
+    uint8_t *blocks;
+    size_t block_size;
+    size_t block_count;
+    heap_t *heap;               ///< Heap containing the blocks
+    SLIST_ENTRY(heap_pool) next;
+};
+
+/* All pools, so heap_caps_check_integrity() can check them */
+static SLIST_HEAD(heap_pool_ll, heap_pool) s_pools = SLIST_HEAD_INITIALIZER(s_pools);
+
+static multi_heap_lock_t s_pools_lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER;
+
+static inline IRAM_ATTR bool compare_set(volatile uint32_t *addr, uint32_t compare, uint32_t value)
+{
+    uint32_t set = value;
+    uxPortCompareSet(addr, compare, &set);
+    return set == compare;
+}
+
+static inline IRAM_ATTR uint32_t *block_link(heap_pool_handle_t pool, uint32_t index)
+{
+    return (uint32_t *)(pool->blocks + index * pool->block_size);
+}
+
+heap_pool_handle_t heap_pool_create(size_t block_size, size_t block_count, uint32_t caps)
+{
+    size_t blocks_size;
+
+    if (block_size == 0 || block_count == 0 || block_count > POOL_MAX_BLOCKS || (caps & MALLOC_CAP_EXEC)) {
+        return NULL;
+    }
+    block_size = (block_size + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1);
+    if (__builtin_mul_overflow(block_size, block_count, &blocks_size)) {
+        return NULL;
+    }
+
+    heap_pool_handle_t pool = heap_caps_calloc(1, sizeof(struct heap_pool), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->blocks = heap_caps_malloc(blocks_size, caps);
+    if (pool->blocks == NULL) {
+        heap_caps_free(pool);
+        return NULL;
+    }
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->heap = find_containing_heap(pool->blocks);
+    assert(pool->heap != NULL);
+
+    for (size_t i = 0; i < block_count; i++) {
+#ifdef MULTI_HEAP_POISONING_SLOW
+        memset(block_link(pool, i), FREE_FILL_PATTERN, block_size);
+#endif
+        *block_link(pool, i) = (i + 1 < block_count) ? i + 1 : POOL_INDEX_NONE;
+    }
+    pool->head = HEAD(0, 0);
+
+    MULTI_HEAP_LOCK(&s_pools_lock);
+    SLIST_INSERT_HEAD(&s_pools, pool, next);
+    MULTI_HEAP_UNLOCK(&s_pools_lock);
+    return pool;
+}
+
+void heap_pool_delete(heap_pool_handle_t pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    assert(pool->used == 0 && "pool blocks are still in use");
+
+    MULTI_HEAP_LOCK(&s_pools_lock);
+    SLIST_REMOVE(&s_pools, pool, heap_pool, next);
+    MULTI_HEAP_UNLOCK(&s_pools_lock);
+    heap_caps_free(pool->blocks);
+    heap_caps_free(pool);
+}
+
+IRAM_ATTR void *heap_pool_alloc(heap_pool_handle_t pool)
+{
+    uint32_t head;
+    uint32_t index;
+
+    unsigned state = portENTER_CRITICAL_NESTED();
+    do {
+        head = pool->head;
+        index = HEAD_INDEX(head);
+        if (index == POOL_INDEX_NONE) {
+            portEXIT_CRITICAL_NESTED(state);
+            return NULL;
+        }
+        // If the block was taken by the other CPU meanwhile, this reads user data. The compare-and-set then fails
+        // because the head has changed, so the value is never used.
+    } while (!compare_set(&pool->head, head, HEAD(HEAD_TAG(head) + 1, *block_link(pool, index))));
+
+    uint32_t used;
+    do {
+        used = pool->used;
+    } while (!compare_set(&pool->used, used, used + 1));
+
+    uint32_t max_used;
+    do {
+        max_used = pool->max_used;
+    } while (max_used < used + 1 && !compare_set(&pool->max_used, max_used, used + 1));
+    portEXIT_CRITICAL_NESTED(state);
+
+    uint32_t *block = block_link(pool, index);
+#ifdef MULTI_HEAP_POISONING_SLOW
+    for (size_t i = sizeof(uint32_t); i < pool->block_size; i++) {
+        MULTI_HEAP_ASSERT(((uint8_t *)block)[i] == FREE_FILL_PATTERN, (uint8_t *)block + i);
+    }
+    memset(block, MALLOC_FILL_PATTERN, pool->block_size);
+#endif
+    return block;
+}
+
+IRAM_ATTR void heap_pool_free(heap_pool_handle_t pool, void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    MULTI_HEAP_ASSERT(heap_pool_contains(pool, ptr), ptr); // not a block of this pool
+
+    uint32_t index = ((uint8_t *)ptr - pool->blocks) / pool->block_size;
+    uint32_t *link = ptr;
+#ifdef MULTI_HEAP_POISONING_SLOW
+    memset(ptr, FREE_FILL_PATTERN, pool->block_size);
+#endif
+
+    // 'used' is decremented before the block is returned and incremented after a block is taken, so it never
+    // counts more blocks than are really in use
+    uint32_t used;
+    unsigned state = portENTER_CRITICAL_NESTED();
+    do {
+        used = pool->used;
+    } while (!compare_set(&pool->used, used, used - 1));
+
+    uint32_t head;
+    do {
+        head = pool->head;
+        *link = HEAD_INDEX(head);
+    } while (!compare_set(&pool->head, head, HEAD(HEAD_TAG(head) + 1, index)));
+    portEXIT_CRITICAL_NESTED(state);
+}
+
+IRAM_ATTR bool heap_pool_contains(heap_pool_handle_t pool, const void *ptr)
+{
+    const uint8_t *p = ptr;
+    return p >= pool->blocks
+        && p < pool->blocks + pool->block_size * pool->block_count
+        && (p - pool->blocks) % pool->block_size == 0;
+}
+
+void heap_pool_get_info(heap_pool_handle_t pool, heap_pool_info_t *info)
+{
+    info->block_size = pool->block_size;
+    info->total_blocks = pool->block_count;
+    info->free_blocks = pool->block_count - pool->used;
+    info->minimum_free_blocks = pool->block_count - pool->max_used;
+}
+
+#define FAIL_PRINT(MSG, ...) do {                                       \
+        if (print_errors) {                                             \
+            MULTI_HEAP_STDERR_PRINTF(MSG, __VA_ARGS__);                 \
+        }                                                               \
+    } while(0)
+
+/* The free list may change while it is walked. The walk is only trusted if the head is the same afterwards, as
+   every change to the list also changes the head. */
+#define CHECK_ATTEMPTS 10
+
+bool heap_pool_check(heap_pool_handle_t pool, bool print_errors)
+{
+    for (int attempt = 0; attempt < CHECK_ATTEMPTS; attempt++) {
+        uint32_t head = pool->head;
+        uint32_t bad_index = POOL_INDEX_NONE;
+        intptr_t bad_address = 0;
+        size_t free_count = 0;
+
+        for (uint32_t index = HEAD_INDEX(head); index != POOL_INDEX_NONE; index = *block_link(pool, index)) {
+            if (index >= pool->block_count || free_count == pool->block_count) {
+                bad_index = index;
+                break;
+            }
+#ifdef MULTI_HEAP_POISONING_SLOW
+            const uint8_t *block = (const uint8_t *)block_link(pool, index);
+            for (size_t i = sizeof(uint32_t); i < pool->block_size; i++) {
+                if (block[i] != FREE_FILL_PATTERN) {
+                    bad_address = (intptr_t)&block[i];
+                    break;
+                }
+            }
+            if (bad_address != 0) {
+                break;
+            }
+#endif
+            free_count++;
+        }
+
+        if (pool->head != head) {
+            continue; // changed while walking it, try again
+        }
+        if (bad_address != 0) {
+            FAIL_PRINT("CORRUPT POOL: Free block of pool 0x%08x was written to at 0x%08x\n",
+                       (intptr_t)pool, bad_address);
+            return false;
+        }
+        if (bad_index != POOL_INDEX_NONE) {
+            FAIL_PRINT("CORRUPT POOL: Bad free list entry %u in pool 0x%08x\n", bad_index, (intptr_t)pool);
+            return false;
+        }
+        return true;
+    }
+    // The pool is too busy to get a consistent view of the free list, don't report errors which may not be real
+    return true;
+}
+
+bool heap_caps_pool_check_integrity(uint32_t caps, bool print_errors)
+{
+    bool all_heaps = caps & MALLOC_CAP_INVALID;
+    bool valid = true;
+    heap_pool_handle_t pool;
+
+    MULTI_HEAP_LOCK(&s_pools_lock);
+    SLIST_FOREACH(pool, &s_pools, next) {
+        if (all_heaps || heap_caps_match(pool->heap, caps)) {
+            valid = heap_pool_check(pool, print_errors) && valid;
+        }
+    }
+    MULTI_HEAP_UNLOCK(&s_pools_lock);
+    return valid;
+}
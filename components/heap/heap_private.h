@@ -50,6 +50,17 @@ extern SLIST_HEAD(registered_heap_ll, heap_t_) registered_heaps;
 
 bool heap_caps_match(const heap_t *heap, uint32_t caps);
 
+/* Find the heap which contains ptr, or return NULL if it's not in any heap */
+heap_t *find_containing_heap(void *ptr);
+
+/* Add the memory of the arenas created by heap_arena_create() in heaps matching caps to the arena_bytes and
+   arena_used_bytes fields of info. Implemented in heap_caps_arena.c */
+void heap_caps_arena_get_info(multi_heap_info_t *info, uint32_t caps);
+
+/* Check the pools created by heap_pool_create() with blocks in heaps matching caps (or all pools, if caps has
+   MALLOC_CAP_INVALID set). Implemented in heap_pool.c */
+bool heap_caps_pool_check_integrity(uint32_t caps, bool print_errors);
+
 /* return all possible capabilities (across all priorities) for a given heap */
 inline static IRAM_ATTR uint32_t get_all_caps(const heap_t *heap)
 {
@@ -71,6 +82,25 @@ inline static IRAM_ATTR uint32_t get_all_caps(const heap_t *heap)
 void *heap_caps_realloc_default(void *p, size_t size);
 void *heap_caps_malloc_default(size_t size);
 
+#if CONFIG_HEAP_SLAB_CACHE
+/* Per-CPU caches of small blocks, implemented in heap_caps_slab.c */
+
+/* Return the size of the cached blocks which would serve this request, or 0 if it can't be served from the caches */
+size_t heap_caps_slab_size(size_t size, uint32_t caps);
+
+/* Take a block of slab_size (as returned by heap_caps_slab_size()) from the current CPU's cache, or return NULL */
+void *heap_caps_slab_get(size_t slab_size);
+
+/* Keep a block being freed in the current CPU's cache. Returns false if the caller should free it to the heap */
+bool heap_caps_slab_put(heap_t *heap, void *ptr);
+
+/* Return all cached blocks to their heaps. Returns true if there were any */
+bool heap_caps_slab_flush(void);
+
+/* Add the blocks cached from heaps matching caps to the cached_bytes and cached_blocks fields of info */
+void heap_caps_slab_get_info(multi_heap_info_t *info, uint32_t caps);
+#endif
+
 
 #ifdef __cplusplus
 }
@@ -45,6 +45,7 @@ size_t heap_caps_get_per_task_info(heap_task_info_params_t *params)
             for (size_t type = 0; type < NUM_HEAP_TASK_CAPS; ++type) {
                 params->totals[i].size[type] = 0;
                 params->totals[i].count[type] = 0;
+                params->totals[i].fragmenting_count[type] = 0;
             }
         }
     }
@@ -68,16 +69,24 @@ size_t heap_caps_get_per_task_info(heap_task_info_params_t *params)
             continue;
         }
 
-        multi_heap_block_handle_t b = multi_heap_get_first_block(heap);
+        multi_heap_block_handle_t first = multi_heap_get_first_block(heap);
+        multi_heap_block_handle_t b = first;
+        bool prev_free = false;
         multi_heap_internal_lock(heap);
         for ( ; b ; b = multi_heap_get_next_block(heap, b)) {
             if (multi_heap_is_free(b)) {
+                prev_free = (b != first);
                 continue;
             }
             void *p = multi_heap_get_block_address(b);  // Safe, only arithmetic
             size_t bsize = multi_heap_get_allocated_size(heap, p); // Validates
             TaskHandle_t btask = (TaskHandle_t)multi_heap_get_block_owner(b);
 
+            // A block with free memory on both sides splits the free memory in two
+            multi_heap_block_handle_t next = multi_heap_get_next_block(heap, b);
+            size_t fragmenting = (prev_free && next != NULL && multi_heap_is_free(next)) ? 1 : 0;
+            prev_free = false;
+
             // Accumulate per-task allocation totals.
             if (params->totals) {
                 size_t i;
@@ -89,12 +98,14 @@ size_t heap_caps_get_per_task_info(heap_task_info_params_t *params)
                 if (i < count) {
                     params->totals[i].size[type] += bsize;
                     params->totals[i].count[type] += 1;
+                    params->totals[i].fragmenting_count[type] += fragmenting;
                 }
                 else {
                     if (count < params->max_totals) {
                         params->totals[count].task = btask;
                         params->totals[count].size[type] = bsize;
                         params->totals[i].count[type] = 1;
+                        params->totals[count].fragmenting_count[type] = fragmenting;
                         ++count;
                     }
                 }
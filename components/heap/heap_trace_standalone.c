@@ -31,11 +31,28 @@ static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
 static bool tracing;
 static heap_trace_mode_t mode;
 
-/* Buffer used for records, starting at offset 0
+/* Buffer used for records. Records are not kept in order in the buffer: each record is either in the list of
+   traced allocations, or in the list of unused records.
 */
 static heap_trace_record_t *buffer;
 static size_t total_records;
 
+TAILQ_HEAD(heap_trace_record_list, heap_trace_record_);
+
+/* Traced allocations, oldest first. When the buffer is full, the oldest record is dropped for a new one. */
+static struct heap_trace_record_list records;
+
+/* Records which are free to use */
+static struct heap_trace_record_list unused;
+
+/* Traced allocations by address, so a free finds its record without searching the whole buffer.
+
+   New records are added at the head of each bucket, so if an address is in several records (in HEAP_TRACE_ALL
+   mode), the newest one is found first.
+*/
+LIST_HEAD(heap_trace_hash_bucket, heap_trace_record_);
+static struct heap_trace_hash_bucket hash_map[CONFIG_HEAP_TRACING_HASH_MAP_SIZE];
+
 /* Count of entries logged in the buffer.
 
    Maximum total_records
@@ -51,6 +68,32 @@ static size_t total_frees;
 /* Has the buffer overflowed and lost trace entries? */
 static bool has_overflowed = false;
 
+/* Allocations which are recorded, see heap_trace_set_sampling() */
+static size_t sample_min_size = 0;
+static uint32_t sample_period = 1;
+static uint32_t sample_counter;
+
+/* Last record returned by heap_trace_get(), so reading all records in order doesn't walk the list each time.
+   Cleared whenever the list changes.
+*/
+static heap_trace_record_t *cached_record;
+static size_t cached_index;
+
+/* Called with trace_mux held, or when no tracing is possible */
+static void reset_records(void)
+{
+    TAILQ_INIT(&records);
+    TAILQ_INIT(&unused);
+    for (int i = 0; i < CONFIG_HEAP_TRACING_HASH_MAP_SIZE; i++) {
+        LIST_INIT(&hash_map[i]);
+    }
+    for (int i = 0; i < total_records; i++) {
+        TAILQ_INSERT_TAIL(&unused, &buffer[i], list);
+    }
+    count = 0;
+    cached_record = NULL;
+}
+
 esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t num_records)
 {
     if (tracing) {
@@ -59,6 +102,7 @@ esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t
     buffer = record_buffer;
     total_records = num_records;
     memset(buffer, 0, num_records * sizeof(heap_trace_record_t));
+    reset_records();
     return ESP_OK;
 }
 
@@ -72,10 +116,11 @@ esp_err_t heap_trace_start(heap_trace_mode_t mode_param)
 
     tracing = false;
     mode = mode_param;
-    count = 0;
+    reset_records();
     total_allocations = 0;
     total_frees = 0;
     has_overflowed = false;
+    sample_counter = 0;
     heap_trace_resume();
 
     portEXIT_CRITICAL(&trace_mux);
@@ -101,6 +146,19 @@ esp_err_t heap_trace_resume(void)
     return set_tracing(true);
 }
 
+esp_err_t heap_trace_set_sampling(size_t min_size, uint32_t period)
+{
+    if (period == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&trace_mux);
+    sample_min_size = min_size;
+    sample_period = period;
+    sample_counter = 0;
+    portEXIT_CRITICAL(&trace_mux);
+    return ESP_OK;
+}
+
 size_t heap_trace_get_count(void)
 {
     return count;
@@ -117,7 +175,18 @@ esp_err_t heap_trace_get(size_t index, heap_trace_record_t *record)
     if (index >= count) {
         result = ESP_ERR_INVALID_ARG; /* out of range for 'count' */
     } else {
-        memcpy(record, &buffer[index], sizeof(heap_trace_record_t));
+        heap_trace_record_t *rec = TAILQ_FIRST(&records);
+        size_t i = 0;
+        if (cached_record != NULL && cached_index <= index) {
+            rec = cached_record;
+            i = cached_index;
+        }
+        for (; i < index; i++) {
+            rec = TAILQ_NEXT(rec, list);
+        }
+        cached_record = rec;
+        cached_index = index;
+        memcpy(record, rec, sizeof(heap_trace_record_t));
     }
     portEXIT_CRITICAL(&trace_mux);
     return result;
@@ -132,7 +201,11 @@ void heap_trace_dump(void)
            count, total_records);
     size_t start_count = count;
     for (int i = 0; i < count; i++) {
-        heap_trace_record_t *rec = &buffer[i];
+        heap_trace_record_t rec_copy;
+        heap_trace_record_t *rec = &rec_copy;
+        if (heap_trace_get(i, rec) != ESP_OK) {
+            break; // records were removed while dumping
+        }
 
         if (rec->address != NULL) {
             printf("%d bytes (@ %p) allocated CPU %d ccount 0x%08x caller ",
@@ -168,8 +241,21 @@ void heap_trace_dump(void)
     if (has_overflowed) {
         printf("(NB: Buffer has overflowed, so trace data is incomplete.)\n");
     }
+    if (sample_min_size != 0 || sample_period != 1) {
+        printf("(NB: Only 1 of every %u allocations of %u bytes or more is traced.)\n",
+               sample_period, sample_min_size);
+    }
+}
+
+static inline IRAM_ATTR struct heap_trace_hash_bucket *hash_bucket(void *p)
+{
+    // heap allocations are at least 4 byte aligned
+    return &hash_map[((uintptr_t)p >> 2) % CONFIG_HEAP_TRACING_HASH_MAP_SIZE];
 }
 
+// remove a record, used when freeing and when the buffer is full
+static void remove_record(heap_trace_record_t *rec);
+
 /* Add a new allocation to the heap trace records */
 static IRAM_ATTR void record_allocation(const heap_trace_record_t *record)
 {
@@ -179,29 +265,26 @@ static IRAM_ATTR void record_allocation(const heap_trace_record_t *record)
 
     portENTER_CRITICAL(&trace_mux);
     if (tracing) {
-        if (count == total_records) {
-            has_overflowed = true;
-            /* Move the whole buffer back one slot.
-
-               This is a bit slow, compared to treating this buffer as a ringbuffer and rotating a head pointer.
-
-               However, ringbuffer code gets tricky when we remove elements in mid-buffer (for leak trace mode) while
-               trying to keep track of an item count that may overflow.
-            */
-            memmove(&buffer[0], &buffer[1], sizeof(heap_trace_record_t) * (total_records -1));
-            count--;
-        }
-        // Copy new record into place
-        memcpy(&buffer[count], record, sizeof(heap_trace_record_t));
-        count++;
         total_allocations++;
+        if (record->size >= sample_min_size && ++sample_counter >= sample_period) {
+            sample_counter = 0;
+            if (count == total_records) {
+                has_overflowed = true;
+                // Drop the oldest record
+                remove_record(TAILQ_FIRST(&records));
+            }
+            heap_trace_record_t *rec = TAILQ_FIRST(&unused);
+            TAILQ_REMOVE(&unused, rec, list);
+            // Copy new record into place, the list entries are set below
+            memcpy(rec, record, sizeof(heap_trace_record_t));
+            TAILQ_INSERT_TAIL(&records, rec, list);
+            LIST_INSERT_HEAD(hash_bucket(rec->address), rec, hash);
+            count++;
+        }
     }
     portEXIT_CRITICAL(&trace_mux);
 }
 
-// remove a record, used when freeing
-static void remove_record(int index);
-
 /* record a free event in the heap trace log
 
    For HEAP_TRACE_ALL, this means filling in the freed_by pointer.
@@ -216,38 +299,36 @@ static IRAM_ATTR void record_free(void *p, void **callers)
     portENTER_CRITICAL(&trace_mux);
     if (tracing && count > 0) {
         total_frees++;
-        /* search backwards for the allocation record matching this free */
-        int i;
-        for (i = count - 1; i >= 0; i--) {
-            if (buffer[i].address == p) {
+        /* find the newest allocation record matching this free */
+        heap_trace_record_t *rec;
+        LIST_FOREACH(rec, hash_bucket(p), hash) {
+            if (rec->address == p) {
                 break;
             }
         }
 
-        if (i >= 0) {
+        if (rec != NULL) {
             if (mode == HEAP_TRACE_ALL) {
-                memcpy(buffer[i].freed_by, callers, sizeof(void *) * STACK_DEPTH);
+                memcpy(rec->freed_by, callers, sizeof(void *) * STACK_DEPTH);
             } else { // HEAP_TRACE_LEAKS
                 // Leak trace mode, once an allocation is freed we remove it from the list
-                remove_record(i);
+                remove_record(rec);
             }
         }
     }
     portEXIT_CRITICAL(&trace_mux);
 }
 
-/* remove the entry at 'index' from the ringbuffer of saved records */
-static IRAM_ATTR void remove_record(int index)
+/* remove a record from the lists of traced allocations, and make it available for reuse */
+static IRAM_ATTR void remove_record(heap_trace_record_t *rec)
 {
-    if (index < count - 1) {
-        // Remove the buffer entry from the list
-        memmove(&buffer[index], &buffer[index+1],
-                sizeof(heap_trace_record_t) * (total_records - index - 1));
-    } else {
-        // For last element, just zero it out to avoid ambiguity
-        memset(&buffer[index], 0, sizeof(heap_trace_record_t));
-    }
+    TAILQ_REMOVE(&records, rec, list);
+    LIST_REMOVE(rec, hash);
+    // zero it out to avoid ambiguity
+    memset(rec, 0, sizeof(heap_trace_record_t));
+    TAILQ_INSERT_TAIL(&unused, rec, list);
     count--;
+    cached_record = NULL;
 }
 
 #include "heap_trace.inc"
@@ -0,0 +1,160 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Arena allocator
+
+   An arena is a single block of memory which small allocations are taken from in order, by moving a pointer
+   forward. The allocations aren't freed one by one. Instead, all of them are released at once by
+   heap_arena_reset() or heap_arena_destroy(), or the ones made after a checkpoint by heap_arena_rollback().
+   All of these operations take constant time.
+
+   This suits memory that is only needed while handling a single request, such as the buffers used while parsing
+   a message, and avoids fragmenting the heaps with many short lived allocations.
+
+   Arena functions are not thread safe. An arena should only be used by one task at a time.
+*/
+
+/** @brief Opaque handle to an arena */
+typedef struct heap_arena *heap_arena_handle_t;
+
+/** @brief Position in an arena, returned by heap_arena_checkpoint() */
+typedef size_t heap_arena_checkpoint_t;
+
+/**
+ * @brief Create an arena in memory with the given capabilities
+ *
+ * The arena is allocated by heap_caps_malloc() as one block, so it is shown by heap tracing as a single
+ * allocation made by the caller of this function. The bytes it holds are reported by heap_caps_get_info() in the
+ * arena_bytes and arena_used_bytes fields.
+ *
+ * @param size Number of bytes which can be allocated from the arena
+ * @param caps Bitwise OR of MALLOC_CAP_* flags indicating the type of memory to use
+ *
+ * @return Handle of the new arena, or NULL if the memory couldn't be allocated.
+ */
+heap_arena_handle_t heap_arena_create(size_t size, uint32_t caps);
+
+/**
+ * @brief Create an arena in a buffer supplied by the caller
+ *
+ * The arena keeps its state at the start of the buffer, so slightly less than 'size' bytes can be allocated from
+ * it. The buffer must stay valid until the arena is no longer used. The arena doesn't need to be destroyed.
+ *
+ * @param buffer Memory to use for the arena
+ * @param size Size of the buffer in bytes
+ *
+ * @return Handle of the new arena, or NULL if the buffer is too small to hold the arena state.
+ */
+heap_arena_handle_t heap_arena_create_with_buffer(void *buffer, size_t size);
+
+/**
+ * @brief Destroy an arena created by heap_arena_create()
+ *
+ * All memory allocated from the arena is freed.
+ *
+ * @param arena Arena handle, or NULL.
+ */
+void heap_arena_destroy(heap_arena_handle_t arena);
+
+/**
+ * @brief Allocate memory from an arena
+ *
+ * The returned memory is aligned for any type of up to pointer size.
+ *
+ * @param arena Arena handle
+ * @param size Number of bytes to allocate
+ *
+ * @return Pointer to the allocated memory, or NULL if size is 0 or the arena doesn't have enough free space.
+ */
+void *heap_arena_alloc(heap_arena_handle_t arena, size_t size);
+
+/**
+ * @brief Allocate zeroed memory for an array from an arena
+ *
+ * @param arena Arena handle
+ * @param n Number of elements
+ * @param size Size of each element in bytes
+ *
+ * @return Pointer to the allocated memory, or NULL if the arena doesn't have enough free space.
+ */
+void *heap_arena_calloc(heap_arena_handle_t arena, size_t n, size_t size);
+
+/**
+ * @brief Free all memory allocated from an arena
+ *
+ * @param arena Arena handle
+ */
+void heap_arena_reset(heap_arena_handle_t arena);
+
+/**
+ * @brief Return the current position of an arena
+ *
+ * Checkpoints can be nested: rolling back to a checkpoint also discards the checkpoints taken after it.
+ *
+ * @param arena Arena handle
+ *
+ * @return Checkpoint to pass to heap_arena_rollback().
+ */
+heap_arena_checkpoint_t heap_arena_checkpoint(heap_arena_handle_t arena);
+
+/**
+ * @brief Free all memory allocated from an arena since a checkpoint was taken
+ *
+ * @param arena Arena handle
+ * @param checkpoint Value returned by heap_arena_checkpoint() for this arena, since the last reset and not
+ *                   discarded by rolling back to an earlier checkpoint.
+ */
+void heap_arena_rollback(heap_arena_handle_t arena, heap_arena_checkpoint_t checkpoint);
+
+/**
+ * @brief Return the number of bytes currently allocated from an arena
+ *
+ * @param arena Arena handle
+ *
+ * @return Allocated bytes, including alignment padding.
+ */
+size_t heap_arena_get_used_size(heap_arena_handle_t arena);
+
+/**
+ * @brief Return the number of bytes which can still be allocated from an arena
+ *
+ * @param arena Arena handle
+ *
+ * @return Free bytes.
+ */
+size_t heap_arena_get_free_size(heap_arena_handle_t arena);
+
+/**
+ * @brief Return the largest number of bytes allocated from an arena at any time since it was created
+ *
+ * This can be used to choose the size of an arena.
+ *
+ * @param arena Arena handle
+ *
+ * @return Peak allocated bytes.
+ */
+size_t heap_arena_get_max_used_size(heap_arena_handle_t arena);
+
+#ifdef __cplusplus
+}
+#endif
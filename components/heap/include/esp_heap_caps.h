@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "multi_heap.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,6 +86,21 @@ void heap_caps_free( void *ptr);
  */
 void *heap_caps_realloc( void *ptr, size_t size, int caps);
 
+/**
+ * @brief Try to grow memory previously allocated via heap_caps_malloc() or heap_caps_realloc(), without moving it.
+ *
+ * Unlike heap_caps_realloc(), the buffer is never moved or copied: it only grows if the memory directly after it
+ * is free. Code which builds up a buffer piece by piece can call this first and only fall back to a realloc (or to
+ * starting a new buffer) when it fails.
+ *
+ * @param ptr Pointer to previously allocated memory.
+ * @param size Size in bytes that the buffer should hold. If the buffer is already at least this big, it is not changed.
+ *
+ * @return true if the buffer at 'ptr' now holds at least 'size' bytes, false if it could not be grown in place.
+ *         The buffer is unchanged if this function fails.
+ */
+bool heap_caps_try_expand( void *ptr, size_t size );
+
 /**
  * @brief Allocate a aligned chunk of memory which has the given capabilities
  *
@@ -222,6 +238,37 @@ size_t heap_caps_get_largest_free_block( uint32_t caps );
  */
 void heap_caps_get_info( multi_heap_info_t *info, uint32_t caps );
 
+/**
+ * @brief Get fragmentation data of the heaps with the given capabilities
+ *
+ * Calls multi_heap_get_fragmentation_info() on all heaps which share the given capabilities, and adds up the
+ * results. This doesn't walk the heaps, so it is cheap enough to be called periodically, for example to alert when
+ * fragmentation rises before allocations start to fail.
+ *
+ * The fragmentation index of the result treats the free memory of all matching heaps as a whole. So it is not 0 if
+ * more than one heap has free memory, even if no heap is fragmented.
+ *
+ * Blocks held by the small allocation caches (CONFIG_HEAP_SLAB_CACHE) are not free blocks of the heaps and are not
+ * counted.
+ *
+ * @param info        Pointer to a structure which will be filled with the fragmentation data.
+ * @param caps        Bitwise OR of MALLOC_CAP_* flags indicating the type
+ *                    of memory
+ */
+void heap_caps_get_fragmentation_info( multi_heap_fragmentation_info_t *info, uint32_t caps );
+
+#if CONFIG_HEAP_SLAB_CACHE
+/**
+ * @brief Return the blocks held in the per-CPU small allocation caches to their heaps.
+ *
+ * With CONFIG_HEAP_SLAB_CACHE, freed blocks of 16, 32, 64 and 128 bytes are kept in a cache for the CPU which freed
+ * them, and are counted as allocated by heap_caps_get_free_size() and related functions. heap_caps_malloc()
+ * flushes the caches itself before failing an allocation, so this function is only needed when exact free
+ * memory figures are required, for example to check for leaks.
+ */
+void heap_caps_slab_cache_flush(void);
+#endif
+
 
 /**
  * @brief Print a summary of all memory with the given capabilities.
@@ -0,0 +1,125 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fixed size block pools
+
+   A pool holds a fixed number of blocks of the same size, allocated from the heaps when the pool is created.
+   heap_pool_alloc() and heap_pool_free() take and return blocks in constant time, without taking any lock, so
+   they can also be called from interrupt handlers. This suits objects of the same type which are allocated and
+   freed often.
+*/
+
+/** @brief Opaque handle to a pool */
+typedef struct heap_pool *heap_pool_handle_t;
+
+/** @brief Statistics of a pool, returned by heap_pool_get_info() */
+typedef struct {
+    size_t block_size;          ///< Size of each block in bytes, after rounding up
+    size_t total_blocks;        ///< Number of blocks in the pool
+    size_t free_blocks;         ///< Number of blocks which are currently free
+    size_t minimum_free_blocks; ///< Lowest number of free blocks since the pool was created
+} heap_pool_info_t;
+
+/**
+ * @brief Create a pool of blocks
+ *
+ * The blocks are allocated together with heap_caps_malloc(). The state of the pool is always in internal memory,
+ * as the atomic operations used on it don't work in external memory.
+ *
+ * @param block_size Size of each block in bytes. It is rounded up to a multiple of the pointer size.
+ * @param block_count Number of blocks, from 1 to 65534
+ * @param caps Bitwise OR of MALLOC_CAP_* flags indicating the type of memory for the blocks.
+ *             MALLOC_CAP_EXEC is not supported.
+ *
+ * @return Handle of the new pool, or NULL if the arguments are invalid or the memory couldn't be allocated.
+ */
+heap_pool_handle_t heap_pool_create(size_t block_size, size_t block_count, uint32_t caps);
+
+/**
+ * @brief Delete a pool and free its memory
+ *
+ * All blocks of the pool must have been returned with heap_pool_free() first.
+ *
+ * @param pool Pool handle, or NULL.
+ */
+void heap_pool_delete(heap_pool_handle_t pool);
+
+/**
+ * @brief Take a block from a pool
+ *
+ * Can be called from an interrupt handler. If the blocks are in internal memory, it can also be called while the
+ * flash cache is disabled.
+ *
+ * @param pool Pool handle
+ *
+ * @return Pointer to the block, or NULL if all blocks are in use.
+ */
+void *heap_pool_alloc(heap_pool_handle_t pool);
+
+/**
+ * @brief Return a block to its pool
+ *
+ * Can be called from an interrupt handler, like heap_pool_alloc().
+ *
+ * @param pool Pool handle
+ * @param ptr NULL, or a block returned by heap_pool_alloc() for the same pool.
+ */
+void heap_pool_free(heap_pool_handle_t pool, void *ptr);
+
+/**
+ * @brief Check whether a pointer is a block of a pool
+ *
+ * This allows code which uses both a pool and the heap to find out how a pointer has to be freed.
+ *
+ * @param pool Pool handle
+ * @param ptr Any pointer
+ *
+ * @return true if ptr points to the start of a block of this pool.
+ */
+bool heap_pool_contains(heap_pool_handle_t pool, const void *ptr);
+
+/**
+ * @brief Get statistics of a pool
+ *
+ * @param pool Pool handle
+ * @param[out] info Filled with the pool statistics
+ */
+void heap_pool_get_info(heap_pool_handle_t pool, heap_pool_info_t *info);
+
+/**
+ * @brief Check the integrity of a pool
+ *
+ * Walks the list of free blocks of the pool. If heap poisoning is set to "Comprehensive", also checks that free
+ * blocks were not written to after they were freed. All pools are also checked by heap_caps_check_integrity()
+ * and related functions.
+ *
+ * @param pool Pool handle
+ * @param print_errors If true, errors will be printed to stderr.
+ *
+ * @return true if the pool is valid, false otherwise.
+ */
+bool heap_pool_check(heap_pool_handle_t pool, bool print_errors);
+
+#ifdef __cplusplus
+}
+#endif
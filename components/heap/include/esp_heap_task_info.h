@@ -28,6 +28,7 @@ typedef struct {
     TaskHandle_t task;                ///< Task to which these totals belong
     size_t size[NUM_HEAP_TASK_CAPS];  ///< Total allocations partitioned by selected caps
     size_t count[NUM_HEAP_TASK_CAPS]; ///< Number of blocks partitioned by selected caps
+    size_t fragmenting_count[NUM_HEAP_TASK_CAPS]; ///< Number of these blocks with free memory directly before and after them, which split the free memory of the heap
 } heap_task_totals_t;
 
 /** @brief Structure providing details about a block allocated by a task */
@@ -15,6 +15,7 @@
 
 #include "sdkconfig.h"
 #include <stdint.h>
+#include <sys/queue.h>
 #include <esp_err.h>
 
 #ifdef __cplusplus
@@ -37,12 +38,16 @@ typedef enum {
 /**
  * @brief Trace record data type. Stores information about an allocated region of memory.
  */
-typedef struct {
+typedef struct heap_trace_record_ {
     uint32_t ccount; ///< CCOUNT of the CPU when the allocation was made. LSB (bit value 1) is the CPU number (0 or 1).
     void *address;   ///< Address which was allocated
     size_t size;     ///< Size of the allocation
     void *alloced_by[CONFIG_HEAP_TRACING_STACK_DEPTH]; ///< Call stack of the caller which allocated the memory.
     void *freed_by[CONFIG_HEAP_TRACING_STACK_DEPTH];   ///< Call stack of the caller which freed the memory (all zero if not freed.)
+#if CONFIG_HEAP_TRACING_STANDALONE
+    TAILQ_ENTRY(heap_trace_record_) list;  ///< Internal: position in the list of records, oldest first
+    LIST_ENTRY(heap_trace_record_) hash;   ///< Internal: position in the hash table bucket for 'address'
+#endif
 } heap_trace_record_t;
 
 /**
@@ -53,7 +58,8 @@ typedef struct {
  * To disable heap tracing and allow the buffer to be freed, stop tracing and then call heap_trace_init_standalone(NULL, 0);
  *
  * @param record_buffer Provide a buffer to use for heap trace data. Must remain valid any time heap tracing is enabled, meaning
- * it must be allocated from internal memory not in PSRAM.
+ * it must be allocated from internal memory not in PSRAM. The records are not stored in the buffer in order, use
+ * heap_trace_get() to read them.
  * @param num_records Size of the heap trace buffer, as number of record structures.
  * @return
  *  - ESP_ERR_NOT_SUPPORTED Project was compiled without heap tracing enabled in menuconfig.
@@ -116,6 +122,26 @@ esp_err_t heap_trace_stop(void);
  */
 esp_err_t heap_trace_resume(void);
 
+/**
+ * @brief Only trace some of the allocations
+ *
+ * Tracing every allocation can slow the system down enough to change its behaviour, and fills the trace buffer
+ * quickly. This function limits the allocations which are recorded in the trace buffer to those of at least
+ * min_size bytes, and of these only one in every sample_period allocations.
+ *
+ * The setting stays in effect until it is changed, also when heap_trace_start() is called again.
+ *
+ * @note Only supported by standalone heap tracing.
+ *
+ * @param min_size Minimum size of the allocations to record, in bytes. 0 records allocations of any size.
+ * @param sample_period Record one of every sample_period allocations which are large enough. 1 records all of them.
+ * @return
+ * - ESP_ERR_NOT_SUPPORTED Project was compiled without standalone heap tracing enabled in menuconfig.
+ * - ESP_ERR_INVALID_ARG sample_period is 0.
+ * - ESP_OK Sampling set.
+ */
+esp_err_t heap_trace_set_sampling(size_t min_size, uint32_t sample_period);
+
 /**
  * @brief Return number of records in the heap trace buffer
  *
@@ -80,6 +80,21 @@ void multi_heap_free(multi_heap_handle_t heap, void *p);
  */
 void *multi_heap_realloc(multi_heap_handle_t heap, void *p, size_t size);
 
+/** @brief Try to grow a buffer in a given heap without moving it.
+ *
+ * The buffer is only grown into a free block which directly follows it, so its address and contents never change.
+ * This suits callers which can't update every pointer to the buffer, or which can fall back to a different
+ * strategy (for example a second buffer) instead of paying for realloc() copying the data.
+ *
+ * @param heap Handle to a registered heap.
+ * @param p Pointer previously returned from multi_heap_malloc() or multi_heap_realloc() for the same heap.
+ * @param size Desired new size for buffer. If this is not more than the current size, the buffer is not changed.
+ *
+ * @return true if the buffer at 'p' now holds at least 'size' bytes, false if it could not be grown (the buffer
+ * is then unchanged).
+ */
+bool multi_heap_try_expand(multi_heap_handle_t heap, void *p, size_t size);
+
 
 /** @brief Return the size that a particular pointer was allocated with.
  *
@@ -174,6 +189,10 @@ typedef struct {
     size_t allocated_blocks;      ///<  Number of (variable size) blocks allocated in the heap.
     size_t free_blocks;           ///<  Number of (variable size) free blocks in the heap.
     size_t total_blocks;          ///<  Total number of (variable size) blocks in the heap.
+    size_t cached_bytes;          ///<  Bytes in blocks held by the heap_caps small allocation caches (CONFIG_HEAP_SLAB_CACHE). These are included in total_allocated_bytes.
+    size_t cached_blocks;         ///<  Number of blocks held by the heap_caps small allocation caches. These are included in allocated_blocks.
+    size_t arena_bytes;           ///<  Bytes held by arenas created with heap_arena_create(). These are included in total_allocated_bytes.
+    size_t arena_used_bytes;      ///<  Bytes allocated from these arenas.
 } multi_heap_info_t;
 
 /** @brief Return metadata about a given heap
@@ -185,6 +204,30 @@ typedef struct {
  */
 void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t *info);
 
+/** @brief Number of free block size classes in multi_heap_fragmentation_info_t */
+#define MULTI_HEAP_FREE_SIZE_CLASSES 12
+
+/** @brief Structure to access heap fragmentation data via multi_heap_get_fragmentation_info */
+typedef struct {
+    size_t total_free_bytes;      ///<  Total free bytes in the heap.
+    size_t free_blocks;           ///<  Number of free blocks in the heap.
+    size_t free_blocks_by_size[MULTI_HEAP_FREE_SIZE_CLASSES]; ///<  Number of free blocks in each size class. Class 0 counts blocks of less than 32 bytes, class n blocks of 2^(n+4) to 2^(n+5)-1 bytes, and the last class all blocks of 32 KB or more.
+    uint64_t free_bytes_squared;  ///<  Sum of the squares of the sizes of all free blocks.
+    uint32_t fragmentation;       ///<  Fragmentation index from 0 to 100: 100 * (1 - free_bytes_squared / total_free_bytes^2). 0 if all free memory is in one block, close to 100 if it is split into many small blocks.
+} multi_heap_fragmentation_info_t;
+
+/** @brief Return fragmentation data about a given heap
+ *
+ * Unlike multi_heap_get_info(), this doesn't walk the heap. The data is kept up to date as blocks are allocated and
+ * freed, so this can be called often, for example to monitor fragmentation trends in the field.
+ *
+ * Sizes are those of the free blocks in the heap, heap poisoning overhead is not subtracted.
+ *
+ * @param heap Handle to a registered heap.
+ * @param info Pointer to a structure to fill with fragmentation data.
+ */
+void multi_heap_get_fragmentation_info(multi_heap_handle_t heap, multi_heap_fragmentation_info_t *info);
+
 #ifdef __cplusplus
 }
 #endif
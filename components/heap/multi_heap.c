@@ -45,6 +45,9 @@ void multi_heap_aligned_free(multi_heap_handle_t heap, void *p)
 void *multi_heap_realloc(multi_heap_handle_t heap, void *p, size_t size)
     __attribute__((alias("multi_heap_realloc_impl")));
 
+bool multi_heap_try_expand(multi_heap_handle_t heap, void *p, size_t size)
+    __attribute__((alias("multi_heap_try_expand_impl")));
+
 size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void *p)
     __attribute__((alias("multi_heap_get_allocated_size_impl")));
 
@@ -108,6 +111,7 @@ typedef struct multi_heap_info {
     void *lock;
     size_t free_bytes;
     size_t minimum_free_bytes;
+    multi_heap_free_stats_t free_stats;
     heap_block_t *last_block;
     heap_block_t first_block; /* initial 'free block', never allocated */
 } heap_t;
@@ -236,6 +240,10 @@ static heap_block_t *merge_adjacent(heap_t *heap, heap_block_t *a, heap_block_t
         prev_free->next_free = free_block->next_free;
 
         heap->free_bytes -= block_data_size(free_block);
+        multi_heap_internal_free_stats_remove(&heap->free_stats, block_data_size(free_block));
+    } else if (free) {
+        multi_heap_internal_free_stats_remove(&heap->free_stats, block_data_size(a));
+        multi_heap_internal_free_stats_remove(&heap->free_stats, block_data_size(b));
     }
 
     a->header = b->header & NEXT_BLOCK_MASK;
@@ -250,6 +258,7 @@ static heap_block_t *merge_adjacent(heap_t *heap, heap_block_t *a, heap_block_t
 
         /* b's header can be put into the pool of free bytes */
         heap->free_bytes += sizeof(a->header);
+        multi_heap_internal_free_stats_add(&heap->free_stats, block_data_size(a));
     }
 
 #ifdef MULTI_HEAP_POISONING_SLOW
@@ -285,6 +294,7 @@ static void split_if_necessary(heap_t *heap, heap_block_t *block, size_t size, h
 
     if (is_free(next_block) && !is_last_block(next_block)) {
         /* The next block is free, just extend it upwards. */
+        multi_heap_internal_free_stats_remove(&heap->free_stats, block_data_size(next_block));
         new_block->header = next_block->header;
         new_block->next_free = next_block->next_free;
         if (prev_free_block == NULL) {
@@ -295,6 +305,7 @@ static void split_if_necessary(heap_t *heap, heap_block_t *block, size_t size, h
                           &prev_free_block->next_free); // free blocks should be in order
         /* Note: We have not introduced a new block header, hence the simple math. */
         heap->free_bytes += block_size - size;
+        multi_heap_internal_free_stats_add(&heap->free_stats, block_data_size(new_block));
 #ifdef MULTI_HEAP_POISONING_SLOW
         /* next_block header needs to be replaced with a fill pattern */
         multi_heap_internal_poison_fill_region(next_block, sizeof(heap_block_t), true /* free */);
@@ -314,6 +325,7 @@ static void split_if_necessary(heap_t *heap, heap_block_t *block, size_t size, h
         MULTI_HEAP_ASSERT(prev_free_block->next_free > new_block,
                           &prev_free_block->next_free); // free blocks should be in order
         heap->free_bytes += block_data_size(new_block);
+        multi_heap_internal_free_stats_add(&heap->free_stats, block_data_size(new_block));
     }
     block->header = (intptr_t)new_block;
     prev_free_block->next_free = new_block;
@@ -368,6 +380,8 @@ multi_heap_handle_t multi_heap_register_impl(void *start_ptr, size_t size)
     */
     heap->free_bytes = size - sizeof(heap_t) - sizeof(first_free_block->header) - sizeof(heap_block_t);
     heap->minimum_free_bytes = heap->free_bytes;
+    memset(&heap->free_stats, 0, sizeof(heap->free_stats));
+    multi_heap_internal_free_stats_add(&heap->free_stats, heap->free_bytes);
 
     return heap;
 }
@@ -458,6 +472,7 @@ void *multi_heap_malloc_impl(multi_heap_handle_t heap, size_t size)
     best_block->header &= ~BLOCK_FREE_FLAG;
 
     heap->free_bytes -= block_data_size(best_block);
+    multi_heap_internal_free_stats_remove(&heap->free_stats, block_data_size(best_block));
 
     split_if_necessary(heap, best_block, size, prev_free);
 
@@ -554,6 +569,7 @@ void multi_heap_free_impl(multi_heap_handle_t heap, void *p)
     pb->header |= BLOCK_FREE_FLAG;
 
     heap->free_bytes += block_data_size(pb);
+    multi_heap_internal_free_stats_add(&heap->free_stats, block_data_size(pb));
 
     /* Try and merge previous free block into this one */
     if (get_next_block(prev_free) == pb) {
@@ -599,7 +615,11 @@ void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size)
     multi_heap_internal_lock(heap);
     result = NULL;
 
-    if (size <= block_data_size(pb)) {
+    if (size == block_data_size(pb)) {
+        // Same size, nothing to do
+        result = pb->data;
+    }
+    else if (size < block_data_size(pb)) {
         // Shrinking....
         split_if_necessary(heap, pb, size, NULL);
         result = pb->data;
@@ -661,6 +681,41 @@ void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size)
     return result;
 }
 
+bool multi_heap_try_expand_impl(multi_heap_handle_t heap, void *p, size_t size)
+{
+    heap_block_t *pb = get_block(p);
+    bool result = false;
+    size = ALIGN_UP(size);
+
+    assert(heap != NULL);
+    assert(p != NULL);
+
+    assert_valid_block(heap, pb);
+    MULTI_HEAP_ASSERT(!is_free(pb), pb); // block should be allocated
+
+    multi_heap_internal_lock(heap);
+
+    if (size <= block_data_size(pb)) {
+        result = true;
+    } else {
+        // Only the next block can be used, growing into the previous one would move the data
+        heap_block_t *next = get_next_block(pb);
+        if (is_free(next) && !is_last_block(next)
+            && block_data_size(pb) + sizeof(next->header) + block_data_size(next) >= size) {
+            pb = merge_adjacent(heap, pb, next);
+            split_if_necessary(heap, pb, size, NULL);
+            result = true;
+        }
+    }
+
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+
+    multi_heap_internal_unlock(heap);
+    return result;
+}
+
 #define FAIL_PRINT(MSG, ...) do {                                       \
         if (print_errors) {                                             \
             MULTI_HEAP_STDERR_PRINTF(MSG, __VA_ARGS__);                 \
@@ -673,6 +728,7 @@ bool multi_heap_check(multi_heap_handle_t heap, bool print_errors)
 {
     bool valid = true;
     size_t total_free_bytes = 0;
+    multi_heap_free_stats_t free_stats = { 0 };
     assert(heap != NULL);
 
     multi_heap_internal_lock(heap);
@@ -708,6 +764,9 @@ bool multi_heap_check(multi_heap_handle_t heap, bool print_errors)
             if (!is_first_block(heap, b)) {
                 total_free_bytes += block_data_size(b);
             }
+            if (!is_first_block(heap, b) && !is_last_block(b)) {
+                multi_heap_internal_free_stats_add(&free_stats, block_data_size(b));
+            }
         }
         prev = b;
 
@@ -739,6 +798,12 @@ bool multi_heap_check(multi_heap_handle_t heap, bool print_errors)
         FAIL_PRINT("CORRUPT HEAP: Expected %u free bytes counted %u\n", (unsigned)heap->free_bytes, (unsigned)total_free_bytes);
     }
 
+    if (heap->free_stats.free_blocks != free_stats.free_blocks
+            || heap->free_stats.free_bytes_squared != free_stats.free_bytes_squared
+            || memcmp(heap->free_stats.free_blocks_by_size, free_stats.free_blocks_by_size, sizeof(free_stats.free_blocks_by_size)) != 0) {
+        FAIL_PRINT("CORRUPT HEAP: Free block statistics don't match the %u free blocks counted\n", (unsigned)free_stats.free_blocks);
+    }
+
  done:
     multi_heap_internal_unlock(heap);
 
@@ -778,6 +843,24 @@ size_t multi_heap_minimum_free_size_impl(multi_heap_handle_t heap)
     return heap->minimum_free_bytes;
 }
 
+void multi_heap_get_fragmentation_info(multi_heap_handle_t heap, multi_heap_fragmentation_info_t *info)
+{
+    memset(info, 0, sizeof(multi_heap_fragmentation_info_t));
+
+    if (heap == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+    info->total_free_bytes = heap->free_bytes;
+    info->free_blocks = heap->free_stats.free_blocks;
+    memcpy(info->free_blocks_by_size, heap->free_stats.free_blocks_by_size, sizeof(info->free_blocks_by_size));
+    info->free_bytes_squared = heap->free_stats.free_bytes_squared;
+    multi_heap_internal_unlock(heap);
+
+    info->fragmentation = multi_heap_internal_fragmentation(info->total_free_bytes, info->free_bytes_squared);
+}
+
 void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info)
 {
     memset(info, 0, sizeof(multi_heap_info_t));
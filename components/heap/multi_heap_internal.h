@@ -29,6 +29,7 @@ void *multi_heap_aligned_alloc_impl(multi_heap_handle_t heap, size_t size, size_
 void multi_heap_free_impl(multi_heap_handle_t heap, void *p);
 void multi_heap_aligned_free_impl(multi_heap_handle_t heap, void *p);
 void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size);
+bool multi_heap_try_expand_impl(multi_heap_handle_t heap, void *p, size_t size);
 multi_heap_handle_t multi_heap_register_impl(void *start, size_t size);
 void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info);
 size_t multi_heap_free_size_impl(multi_heap_handle_t heap);
@@ -36,6 +37,49 @@ size_t multi_heap_minimum_free_size_impl(multi_heap_handle_t heap);
 size_t multi_heap_get_allocated_size_impl(multi_heap_handle_t heap, void *p);
 void *multi_heap_get_block_address_impl(multi_heap_block_handle_t block);
 
+/* Statistics of the free blocks in a heap, kept up to date by the allocator for
+   multi_heap_get_fragmentation_info(). The heap's first and last blocks are not counted.
+*/
+typedef struct {
+    size_t free_blocks;
+    uint64_t free_bytes_squared;
+    size_t free_blocks_by_size[MULTI_HEAP_FREE_SIZE_CLASSES];
+} multi_heap_free_stats_t;
+
+static inline size_t multi_heap_internal_size_class(size_t size)
+{
+    if (size < 32) {
+        return 0;
+    }
+    size_t log2 = 8 * sizeof(unsigned long) - 1 - __builtin_clzl(size);
+    return (log2 - 4 < MULTI_HEAP_FREE_SIZE_CLASSES) ? log2 - 4 : MULTI_HEAP_FREE_SIZE_CLASSES - 1;
+}
+
+/* Called when a free block of 'size' bytes is added to the heap */
+static inline void multi_heap_internal_free_stats_add(multi_heap_free_stats_t *stats, size_t size)
+{
+    stats->free_blocks++;
+    stats->free_bytes_squared += (uint64_t)size * size;
+    stats->free_blocks_by_size[multi_heap_internal_size_class(size)]++;
+}
+
+/* Called when a free block of 'size' bytes is removed from the heap, allocated or merged */
+static inline void multi_heap_internal_free_stats_remove(multi_heap_free_stats_t *stats, size_t size)
+{
+    stats->free_blocks--;
+    stats->free_bytes_squared -= (uint64_t)size * size;
+    stats->free_blocks_by_size[multi_heap_internal_size_class(size)]--;
+}
+
+/* Fragmentation index 0-100 of free memory with the given total size and sum of squared block sizes */
+static inline uint32_t multi_heap_internal_fragmentation(size_t free_bytes, uint64_t free_bytes_squared)
+{
+    if (free_bytes == 0) {
+        return 0;
+    }
+    return 100 - (uint32_t)(free_bytes_squared * 100 / ((uint64_t)free_bytes * free_bytes));
+}
+
 /* Some internal functions for heap poisoning use */
 
 /* Check an allocated block's poison bytes are correct. Called by multi_heap_check(). */
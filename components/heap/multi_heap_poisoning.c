@@ -330,6 +330,35 @@ void *multi_heap_realloc(multi_heap_handle_t heap, void *p, size_t size)
     return result;
 }
 
+bool multi_heap_try_expand(multi_heap_handle_t heap, void *p, size_t size)
+{
+    if (size > SIZE_MAX - POISON_OVERHEAD) {
+        return false;
+    }
+
+    poison_head_t *head = verify_allocated_region(p, true);
+    assert(head != NULL);
+
+    multi_heap_internal_lock(heap);
+
+    size_t orig_alloc_size = head->alloc_size;
+    bool result = (size <= orig_alloc_size);
+    if (!result && multi_heap_try_expand_impl(heap, head, size + POISON_OVERHEAD)) {
+#ifdef SLOW
+        /* the new part of the block held the old tail canary and parts of the absorbed free block. Fill it as
+           malloc leaves a block: data with MALLOC_FILL_PATTERN, any space after the tail with FREE_FILL_PATTERN */
+        size_t block_size = multi_heap_get_allocated_size_impl(heap, head);
+        memset((uint8_t *)p + orig_alloc_size, MALLOC_FILL_PATTERN, size - orig_alloc_size);
+        memset((uint8_t *)head + POISON_OVERHEAD + size, FREE_FILL_PATTERN, block_size - POISON_OVERHEAD - size);
+#endif
+        poison_allocated_region(head, size);
+        result = true;
+    }
+
+    multi_heap_internal_unlock(heap);
+    return result;
+}
+
 void *multi_heap_get_block_address(multi_heap_block_handle_t block)
 {
     char *head = multi_heap_get_block_address_impl(block);
@@ -0,0 +1,1045 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <multi_heap.h>
+#include "multi_heap_internal.h"
+
+/* Note: Keep platform-specific parts in this header, this source
+   file should depend on libc only */
+#include "multi_heap_platform.h"
+
+/* Defines compile-time configuration macros */
+#include "multi_heap_config.h"
+
+/* Alternative implementation of multi_heap.c, selected with CONFIG_HEAP_ALLOCATOR_TLSF.
+
+   Free blocks are kept in segregated lists, following the "Two-Level Segregated Fit" design: the first level
+   splits sizes into powers of two, the second level splits each power of two into SL_INDEX_COUNT linear ranges.
+   A bitmap of non-empty lists at each level finds a free block which is large enough with a few bit operations,
+   so malloc and free take constant time however fragmented the heap is.
+
+   The blocks themselves are laid out as in multi_heap.c, so the functions which walk the heap (multi_heap_check(),
+   multi_heap_get_info(), heap task tracking) work in the same way. In addition, a free block stores a pointer to
+   itself in its last word and the following block has the BLOCK_PREV_FREE_FLAG set, so that a block can be merged
+   with the free block before it without searching for it.
+*/
+
+#ifndef MULTI_HEAP_POISONING
+/* if no heap poisoning, public API aliases directly to these implementations */
+void *multi_heap_malloc(multi_heap_handle_t heap, size_t size)
+    __attribute__((alias("multi_heap_malloc_impl")));
+
+void *multi_heap_aligned_alloc(multi_heap_handle_t heap, size_t size, size_t alignment)
+    __attribute__((alias("multi_heap_aligned_alloc_impl")));
+
+void multi_heap_free(multi_heap_handle_t heap, void *p)
+    __attribute__((alias("multi_heap_free_impl")));
+
+void multi_heap_aligned_free(multi_heap_handle_t heap, void *p)
+    __attribute__((alias("multi_heap_aligned_free_impl")));
+
+void *multi_heap_realloc(multi_heap_handle_t heap, void *p, size_t size)
+    __attribute__((alias("multi_heap_realloc_impl")));
+
+bool multi_heap_try_expand(multi_heap_handle_t heap, void *p, size_t size)
+    __attribute__((alias("multi_heap_try_expand_impl")));
+
+size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void *p)
+    __attribute__((alias("multi_heap_get_allocated_size_impl")));
+
+multi_heap_handle_t multi_heap_register(void *start, size_t size)
+    __attribute__((alias("multi_heap_register_impl")));
+
+void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t *info)
+    __attribute__((alias("multi_heap_get_info_impl")));
+
+size_t multi_heap_free_size(multi_heap_handle_t heap)
+    __attribute__((alias("multi_heap_free_size_impl")));
+
+size_t multi_heap_minimum_free_size(multi_heap_handle_t heap)
+    __attribute__((alias("multi_heap_minimum_free_size_impl")));
+
+void *multi_heap_get_block_address(multi_heap_block_handle_t block)
+    __attribute__((alias("multi_heap_get_block_address_impl")));
+
+void *multi_heap_get_block_owner(multi_heap_block_handle_t block)
+{
+    return NULL;
+}
+
+#endif
+
+#define ALIGN(X) ((X) & ~(sizeof(void *)-1))
+#define ALIGN_UP(X) ALIGN((X)+sizeof(void *)-1)
+#define ALIGN_UP_BY(num, align) (((num) + ((align) - 1)) & ~((align) - 1))
+
+/* Number of second level lists for each power of two. Each list covers 1/8th of the range,
+   so a block found by a search is at most 12.5% larger than the request. */
+#define SL_INDEX_COUNT_LOG2 3
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+
+#define ALIGN_SIZE_LOG2 (sizeof(void *) == 8 ? 3 : 2)
+
+/* Sizes below SMALL_BLOCK_SIZE all go to first level list 0, in steps of the alignment */
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define SMALL_BLOCK_SIZE ((size_t)1 << FL_INDEX_SHIFT)
+#define FL_INDEX_COUNT_MAX (sizeof(size_t) * 8 - FL_INDEX_SHIFT + 1)
+
+struct heap_block;
+
+/* Block in the heap
+
+   'header' holds a pointer to the next block (used or free) ORed with the free flag of this block and the free flag
+   of the previous block.
+
+   'next_free' and 'prev_free' are valid if the block is free, and link it into the free list of its size class.
+   The last word of a free block points back to the block, see get_prev_free_block().
+*/
+typedef struct heap_block {
+    intptr_t header;                      /* Encodes next block in heap (used or unused) and free flags */
+    union {
+        uint8_t data[1];                  /* First byte of data, valid if block is used. Actual size of data is 'block_data_size(block)' */
+        struct {
+            struct heap_block *next_free; /* Pointer to next free block in the same list, valid if block is free */
+            struct heap_block *prev_free; /* Pointer to previous free block in the same list, valid if block is free */
+        };
+    };
+} heap_block_t;
+
+/* These masks apply to the 'header' field of heap_block_t */
+#define BLOCK_FREE_FLAG 0x1      /* If set, this block is free & free list pointers are valid */
+#define BLOCK_PREV_FREE_FLAG 0x2 /* If set, previous block is free & the word before this block points to it */
+#define NEXT_BLOCK_MASK (~3)     /* AND header with this mask to get pointer to next block (free or used) */
+
+/* A free block must hold the free list pointers and the pointer back to itself at its end */
+#define MIN_BLOCK_DATA_SIZE (3 * sizeof(void *))
+
+_Static_assert(SL_INDEX_COUNT <= 8, "sl_bitmap entries hold 8 bits");
+
+/* Metadata header for the heap, stored at the beginning of heap space.
+
+   'first_block' is a "fake" first block, used to provide a pointer to the first used & free block in
+   the heap. This block is never allocated or merged into an adjacent block, and is not in any free list.
+
+   'last_block' is a pointer to a final free block of length 0, which is added at the end of the heap when it is
+   registered. This block is also never allocated or merged into an adjacent block.
+
+   'free_lists' has SL_INDEX_COUNT entries for each of the 'fl_count' first level size classes, enough for the
+   largest block which fits in this heap. Bit 'fl' of 'fl_bitmap' and bit 'sl' of 'sl_bitmap[fl]' are set if
+   free list [fl][sl] is not empty.
+ */
+typedef struct multi_heap_info {
+    void *lock;
+    size_t free_bytes;
+    size_t minimum_free_bytes;
+    multi_heap_free_stats_t free_stats;
+    heap_block_t *last_block;
+    uint32_t fl_bitmap;
+    uint32_t fl_count;
+    uint8_t sl_bitmap[FL_INDEX_COUNT_MAX];
+    heap_block_t first_block; /* initial 'free block', never allocated */
+    heap_block_t *free_lists[];
+} heap_t;
+
+/* Given a pointer to the 'data' field of a block (ie the previous malloc/realloc result), return a pointer to the
+   containing block.
+*/
+static inline heap_block_t *get_block(const void *data_ptr)
+{
+    return (heap_block_t *)((char *)data_ptr - offsetof(heap_block_t, data));
+}
+
+/* Return the next sequential block in the heap.
+ */
+static inline heap_block_t *get_next_block(const heap_block_t *block)
+{
+    intptr_t next = block->header & NEXT_BLOCK_MASK;
+    if (next == 0) {
+        return NULL; /* last_block */
+    }
+    assert(next > (intptr_t)block);
+    return (heap_block_t *)next;
+}
+
+/* Return true if this block is free. */
+static inline bool is_free(const heap_block_t *block)
+{
+    return block->header & BLOCK_FREE_FLAG;
+}
+
+/* Return true if the block before this one is free, and not heap->first_block */
+static inline bool is_prev_free(const heap_block_t *block)
+{
+    return block->header & BLOCK_PREV_FREE_FLAG;
+}
+
+/* Return true if this block is the first in the heap */
+static inline bool is_first_block(const heap_t *heap, const heap_block_t *block)
+{
+    return (block == &heap->first_block);
+}
+
+/* Return true if this block is the last_block in the heap
+   (the only block with no next pointer) */
+static inline bool is_last_block(const heap_block_t *block)
+{
+    return (block->header & NEXT_BLOCK_MASK) == 0;
+}
+
+/* Data size of the block (excludes this block's header) */
+static inline size_t block_data_size(const heap_block_t *block)
+{
+    intptr_t next = (intptr_t)block->header & NEXT_BLOCK_MASK;
+    intptr_t this = (intptr_t)block;
+    if (next == 0) {
+        return 0; /* this is the last block in the heap */
+    }
+    return next - this - sizeof(block->header);
+}
+
+/* Pointer to the word before 'block', which holds the address of the previous block if it is free */
+static inline heap_block_t **prev_free_tag(const heap_block_t *block)
+{
+    return (heap_block_t **)block - 1;
+}
+
+/* Get the free block immediately before 'block', or NULL if that block is in use */
+static inline heap_block_t *get_prev_free_block(const heap_block_t *block)
+{
+    if (!is_prev_free(block)) {
+        return NULL;
+    }
+    heap_block_t *prev = *prev_free_tag(block);
+    MULTI_HEAP_ASSERT(prev < block && is_free(prev) && get_next_block(prev) == block, prev_free_tag(block)); // bad free block tag
+    return prev;
+}
+
+/* Index of the most significant bit set, 'x' must not be 0 */
+static inline int fls_size(size_t x)
+{
+    if (sizeof(size_t) > sizeof(unsigned)) {
+        return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x);
+    }
+    return sizeof(unsigned) * 8 - 1 - __builtin_clz(x);
+}
+
+/* Find the free list which holds blocks of data size 'size' */
+static inline void mapping_insert(size_t size, uint32_t *fl, uint32_t *sl)
+{
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = size >> ALIGN_SIZE_LOG2;
+    } else {
+        int bit = fls_size(size);
+        *sl = (size >> (bit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *fl = bit - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+/* Find the first free list where every block can hold 'size' bytes of data */
+static inline void mapping_search(size_t size, uint32_t *fl, uint32_t *sl)
+{
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (fls_size(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static inline heap_block_t **free_list(heap_t *heap, uint32_t fl, uint32_t sl)
+{
+    return &heap->free_lists[fl * SL_INDEX_COUNT + sl];
+}
+
+/* Check a block is valid for this heap. Used to verify parameters. */
+static void assert_valid_block(const heap_t *heap, const heap_block_t *block)
+{
+    MULTI_HEAP_ASSERT(block >= &heap->first_block && block <= heap->last_block,
+                      block); // block not in heap
+    if (heap < (const heap_t *)heap->last_block) {
+        const heap_block_t *next = get_next_block(block);
+        MULTI_HEAP_ASSERT(next >= &heap->first_block && next <= heap->last_block, block); // Next block not in heap
+        if (is_free(block) && !is_first_block(heap, block)) {
+            // Check block->next_free is valid
+            MULTI_HEAP_ASSERT(block->next_free == NULL ||
+                              (block->next_free > &heap->first_block && block->next_free < heap->last_block), &block->next_free);
+        }
+    }
+}
+
+/* Add a free block to the head of the free list for its size */
+static void insert_free_block(heap_t *heap, heap_block_t *block)
+{
+    uint32_t fl, sl;
+    mapping_insert(block_data_size(block), &fl, &sl);
+    assert(fl < heap->fl_count);
+    heap_block_t **head = free_list(heap, fl, sl);
+
+    block->prev_free = NULL;
+    block->next_free = *head;
+    if (*head != NULL) {
+        (*head)->prev_free = block;
+    }
+    *head = block;
+    heap->fl_bitmap |= 1U << fl;
+    heap->sl_bitmap[fl] |= 1U << sl;
+    multi_heap_internal_free_stats_add(&heap->free_stats, block_data_size(block));
+}
+
+/* Remove a free block from the free list for its size. The block's size must not have changed since it was inserted */
+static void remove_free_block(heap_t *heap, heap_block_t *block)
+{
+    uint32_t fl, sl;
+    mapping_insert(block_data_size(block), &fl, &sl);
+    heap_block_t **head = free_list(heap, fl, sl);
+
+    multi_heap_internal_free_stats_remove(&heap->free_stats, block_data_size(block));
+    if (block->next_free != NULL) {
+        MULTI_HEAP_ASSERT(block->next_free->prev_free == block, &block->next_free); // free list should be linked both ways
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (block->prev_free != NULL) {
+        MULTI_HEAP_ASSERT(block->prev_free->next_free == block, &block->prev_free); // free list should be linked both ways
+        block->prev_free->next_free = block->next_free;
+    } else {
+        MULTI_HEAP_ASSERT(*head == block, block); // free block should be in the list for its size
+        *head = block->next_free;
+        if (*head == NULL) {
+            heap->sl_bitmap[fl] &= ~(1U << sl);
+            if (heap->sl_bitmap[fl] == 0) {
+                heap->fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+}
+
+/* Set the free flag of 'block' and let the next block know that 'block' is free */
+static void mark_free(heap_block_t *block)
+{
+    heap_block_t *next = get_next_block(block);
+    block->header |= BLOCK_FREE_FLAG;
+    *prev_free_tag(next) = block;
+    next->header |= BLOCK_PREV_FREE_FLAG;
+}
+
+/* Clear the free flag of 'block' */
+static void mark_used(heap_block_t *block)
+{
+    heap_block_t *next = get_next_block(block);
+    block->header &= ~BLOCK_FREE_FLAG;
+    next->header &= ~BLOCK_PREV_FREE_FLAG;
+#ifdef MULTI_HEAP_POISONING_SLOW
+    /* free list pointers and the tag at the end of the block need to be replaced with a fill pattern */
+    multi_heap_internal_poison_fill_region(block->data, 2 * sizeof(void *), true);
+    multi_heap_internal_poison_fill_region(prev_free_tag(next), sizeof(void *), true);
+#endif
+}
+
+/* Find a free block which can hold 'size' bytes of data, or NULL. The block is not removed from its list. */
+static heap_block_t *find_free_block(heap_t *heap, size_t size)
+{
+    uint32_t fl, sl;
+    mapping_search(size, &fl, &sl);
+
+    if (fl < heap->fl_count) {
+        uint32_t sl_map = heap->sl_bitmap[fl] & (~0U << sl);
+        if (sl_map == 0) {
+            uint32_t fl_map = heap->fl_bitmap & (~0U << (fl + 1));
+            if (fl_map != 0) {
+                fl = __builtin_ctz(fl_map);
+                sl_map = heap->sl_bitmap[fl];
+            }
+        }
+        if (sl_map != 0) {
+            return *free_list(heap, fl, __builtin_ctz(sl_map));
+        }
+    }
+
+    /* The search above skips the list 'size' maps to, as it can also hold blocks which are too small.
+       Before failing, look for a block which is large enough in that list.
+    */
+    mapping_insert(size, &fl, &sl);
+    if (fl >= heap->fl_count) {
+        return NULL;
+    }
+    for (heap_block_t *b = *free_list(heap, fl, sl); b != NULL; b = b->next_free) {
+        if (block_data_size(b) >= size) {
+            return b;
+        }
+    }
+    return NULL;
+}
+
+/* Merge free block 'b' into the free block 'a' before it. Neither block should be in a free list. */
+static void merge_free_blocks(heap_t *heap, heap_block_t *a, heap_block_t *b)
+{
+    MULTI_HEAP_ASSERT(get_next_block(a) == b, a); // Blocks should be in order
+    a->header = (b->header & NEXT_BLOCK_MASK) | (a->header & ~NEXT_BLOCK_MASK);
+    /* b's header can be put into the pool of free bytes */
+    heap->free_bytes += sizeof(a->header);
+#ifdef MULTI_HEAP_POISONING_SLOW
+    /* a's tag and b's former block header need to be replaced with a fill pattern */
+    multi_heap_internal_poison_fill_region(prev_free_tag(b), sizeof(void *) + sizeof(heap_block_t), true);
+#endif
+}
+
+/* Split a block so it can hold at least 'size' bytes of data, making any spare
+   space into a new free block or adding it to a free block which follows.
+
+   'block' should be marked in-use when this function is called.
+*/
+static void split_if_necessary(heap_t *heap, heap_block_t *block, size_t size)
+{
+    const size_t block_size = block_data_size(block);
+    MULTI_HEAP_ASSERT(!is_free(block), block); // split block shouldn't be free
+    MULTI_HEAP_ASSERT(size <= block_size, block); // size should be valid
+
+    /* can't split the head or tail block */
+    assert(!is_first_block(heap, block));
+    assert(!is_last_block(block));
+
+    heap_block_t *new_block = (heap_block_t *)(block->data + size);
+    heap_block_t *next_block = get_next_block(block);
+
+    if (size == block_size) {
+        return;
+    }
+
+    if (is_free(next_block) && !is_last_block(next_block)) {
+        /* The next block is free, just extend it downwards. */
+        remove_free_block(heap, next_block);
+        intptr_t next_header = next_block->header;
+#ifdef MULTI_HEAP_POISONING_SLOW
+        /* next_block header needs to be replaced with a fill pattern */
+        multi_heap_internal_poison_fill_region(next_block, sizeof(heap_block_t), true /* free */);
+#endif
+        new_block->header = next_header;
+        /* Note: We have not introduced a new block header, hence the simple math. */
+        heap->free_bytes += block_size - size;
+    } else {
+        /* Insert a free block between the current and the next one. */
+        if (block_size < size + sizeof(new_block->header) + MIN_BLOCK_DATA_SIZE) {
+            /* Can't split 'block' if we're not going to get a usable free block afterwards */
+            return;
+        }
+        new_block->header = (intptr_t)next_block;
+        heap->free_bytes += block_data_size(new_block);
+    }
+    block->header = (intptr_t)new_block | (block->header & BLOCK_PREV_FREE_FLAG);
+    mark_free(new_block);
+    insert_free_block(heap, new_block);
+}
+
+/* Merge the free block after 'block' into 'block', which is in use. The caller checks that the next block is free
+   and not heap->last_block.
+*/
+static void absorb_next_free_block(heap_t *heap, heap_block_t *block)
+{
+    heap_block_t *next = get_next_block(block);
+    remove_free_block(heap, next);
+    mark_used(next);
+    heap->free_bytes -= block_data_size(next);
+    block->header = (next->header & NEXT_BLOCK_MASK) | (block->header & BLOCK_PREV_FREE_FLAG);
+}
+
+/* Data size to use for an allocation of 'size' bytes */
+static inline size_t adjust_request_size(size_t size)
+{
+    size = ALIGN_UP(size);
+    return (size < MIN_BLOCK_DATA_SIZE) ? MIN_BLOCK_DATA_SIZE : size;
+}
+
+void *multi_heap_get_block_address_impl(multi_heap_block_handle_t block)
+{
+    return ((char *)block + offsetof(heap_block_t, data));
+}
+
+size_t multi_heap_get_allocated_size_impl(multi_heap_handle_t heap, void *p)
+{
+    heap_block_t *pb = get_block(p);
+
+    assert_valid_block(heap, pb);
+    MULTI_HEAP_ASSERT(!is_free(pb), pb); // block shouldn't be free
+    return block_data_size(pb);
+}
+
+multi_heap_handle_t multi_heap_register_impl(void *start_ptr, size_t size)
+{
+    uintptr_t start = ALIGN_UP((uintptr_t)start_ptr);
+    uintptr_t end = ALIGN((uintptr_t)start_ptr + size);
+    heap_t *heap = (heap_t *)start;
+    size = end - start;
+
+    if (end < start || size < sizeof(heap_t) + 2*sizeof(heap_block_t)) {
+        return NULL; /* 'size' is too small to fit a heap here */
+    }
+
+    /* the free lists only need to go up to the size of the whole heap */
+    uint32_t fl, sl;
+    mapping_insert(size, &fl, &sl);
+    const size_t lists_size = (fl + 1) * SL_INDEX_COUNT * sizeof(heap_block_t *);
+    if (size < sizeof(heap_t) + lists_size + sizeof(intptr_t) + MIN_BLOCK_DATA_SIZE + sizeof(heap_block_t)) {
+        return NULL;
+    }
+
+    heap->lock = NULL;
+    heap->last_block = (heap_block_t *)(end - sizeof(heap_block_t));
+    heap->fl_bitmap = 0;
+    heap->fl_count = fl + 1;
+    memset(heap->sl_bitmap, 0, sizeof(heap->sl_bitmap));
+    memset(heap->free_lists, 0, lists_size);
+    memset(&heap->free_stats, 0, sizeof(heap->free_stats));
+
+    /* first 'real' (allocatable) free block goes after the heap structure and free lists */
+    heap_block_t *first_free_block = (heap_block_t *)(start + sizeof(heap_t) + lists_size);
+    first_free_block->header = (intptr_t)heap->last_block;
+
+    /* last block is 'free' but has a NULL next pointer */
+    heap->last_block->header = BLOCK_FREE_FLAG;
+
+    /* first block also 'free' but has legitimate length,
+       malloc will never allocate into this block. */
+    heap->first_block.header = (intptr_t)first_free_block | BLOCK_FREE_FLAG;
+    heap->first_block.next_free = NULL;
+    heap->first_block.prev_free = NULL;
+
+    mark_free(first_free_block);
+    insert_free_block(heap, first_free_block);
+
+    /* free bytes is:
+       - total bytes in heap
+       - minus heap_t header at top (includes heap->first_block) and the free lists
+       - minus header of first_free_block
+       - minus whole block at heap->last_block
+    */
+    heap->free_bytes = size - sizeof(heap_t) - lists_size - sizeof(first_free_block->header) - sizeof(heap_block_t);
+    heap->minimum_free_bytes = heap->free_bytes;
+    assert(heap->free_bytes == block_data_size(first_free_block));
+
+    return heap;
+}
+
+void multi_heap_set_lock(multi_heap_handle_t heap, void *lock)
+{
+    heap->lock = lock;
+}
+
+void inline multi_heap_internal_lock(multi_heap_handle_t heap)
+{
+    MULTI_HEAP_LOCK(heap->lock);
+}
+
+void inline multi_heap_internal_unlock(multi_heap_handle_t heap)
+{
+    MULTI_HEAP_UNLOCK(heap->lock);
+}
+
+multi_heap_block_handle_t multi_heap_get_first_block(multi_heap_handle_t heap)
+{
+    return &heap->first_block;
+}
+
+multi_heap_block_handle_t multi_heap_get_next_block(multi_heap_handle_t heap, multi_heap_block_handle_t block)
+{
+    heap_block_t *next = get_next_block(block);
+    /* check for valid free last block to avoid assert in assert_valid_block */
+    if (next == heap->last_block && is_last_block(next) && is_free(next)) {
+        return NULL;
+    }
+    assert_valid_block(heap, next);
+    return next;
+}
+
+bool multi_heap_is_free(multi_heap_block_handle_t block)
+{
+    return is_free(block);
+}
+
+void *multi_heap_malloc_impl(multi_heap_handle_t heap, size_t size)
+{
+    if (size == 0 || heap == NULL) {
+        return NULL;
+    }
+    size = adjust_request_size(size);
+
+    multi_heap_internal_lock(heap);
+
+    /* Note: this check must be done while holding the lock as both
+       malloc & realloc may temporarily shrink the free_bytes value
+       before they split a large block. This can result in false negatives,
+       especially if the heap is unfragmented.
+    */
+    if (heap->free_bytes < size) {
+        multi_heap_internal_unlock(heap);
+        return NULL;
+    }
+
+    heap_block_t *block = find_free_block(heap, size);
+    if (block == NULL) {
+        multi_heap_internal_unlock(heap);
+        return NULL; /* No room in heap */
+    }
+
+    remove_free_block(heap, block);
+    mark_used(block);
+
+    heap->free_bytes -= block_data_size(block);
+
+    split_if_necessary(heap, block, size);
+
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+
+    multi_heap_internal_unlock(heap);
+
+    return block->data;
+}
+
+void *multi_heap_aligned_alloc_impl(multi_heap_handle_t heap, size_t size, size_t alignment)
+{
+    if (heap == NULL) {
+        return NULL;
+    }
+
+    if (!size) {
+        return NULL;
+    }
+
+    if (!alignment) {
+        return NULL;
+    }
+
+    //Alignment must be a power of two...
+    if ((alignment & (alignment - 1)) != 0) {
+        return NULL;
+    }
+
+    uint32_t overhead = (sizeof(uint32_t) + (alignment - 1));
+
+    multi_heap_internal_lock(heap);
+    void *head = multi_heap_malloc_impl(heap, size + overhead);
+    if (head == NULL) {
+        multi_heap_internal_unlock(heap);
+        return NULL;
+    }
+
+    //Lets align our new obtained block address:
+    //and save information to recover original block pointer
+    //to allow us to deallocate the memory when needed
+    void *ptr = (void *)ALIGN_UP_BY((uintptr_t)head + sizeof(uint32_t), alignment);
+    *((uint32_t *)ptr - 1) = (uint32_t)((uintptr_t)ptr - (uintptr_t)head);
+
+    multi_heap_internal_unlock(heap);
+    return ptr;
+}
+
+void multi_heap_aligned_free_impl(multi_heap_handle_t heap, void *p)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+    uint32_t offset = *((uint32_t *)p - 1);
+    void *block_head = (void *)((uint8_t *)p - offset);
+
+#ifdef MULTI_HEAP_POISONING_SLOW
+        multi_heap_internal_poison_fill_region(block_head, multi_heap_get_allocated_size_impl(heap, block_head), true /* free */);
+#endif
+
+    multi_heap_free_impl(heap, block_head);
+    multi_heap_internal_unlock(heap);
+}
+
+void multi_heap_free_impl(multi_heap_handle_t heap, void *p)
+{
+    heap_block_t *pb = get_block(p);
+
+    if (heap == NULL || p == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+
+    assert_valid_block(heap, pb);
+    MULTI_HEAP_ASSERT(!is_free(pb), pb); // block should not be free
+    MULTI_HEAP_ASSERT(!is_last_block(pb), pb); // block should not be last block
+    MULTI_HEAP_ASSERT(!is_first_block(heap, pb), pb); // block should not be first block
+
+    heap->free_bytes += block_data_size(pb);
+
+    /* Try and merge previous free block into this one */
+    heap_block_t *prev = get_prev_free_block(pb);
+    if (prev != NULL) {
+        remove_free_block(heap, prev);
+        merge_free_blocks(heap, prev, pb);
+        pb = prev;
+    }
+
+    /* If next block is free, try to merge the two */
+    heap_block_t *next = get_next_block(pb);
+    if (is_free(next) && !is_last_block(next)) {
+        remove_free_block(heap, next);
+        merge_free_blocks(heap, pb, next);
+    }
+
+    mark_free(pb);
+    insert_free_block(heap, pb);
+
+    multi_heap_internal_unlock(heap);
+}
+
+
+void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size)
+{
+    heap_block_t *pb = get_block(p);
+    void *result;
+
+    assert(heap != NULL);
+
+    if (p == NULL) {
+        return multi_heap_malloc_impl(heap, size);
+    }
+
+    assert_valid_block(heap, pb);
+    // non-null realloc arg should be allocated
+    MULTI_HEAP_ASSERT(!is_free(pb), pb);
+
+    if (size == 0) {
+        /* note: calling multi_free_impl() here as we've already been
+           through any poison-unwrapping */
+        multi_heap_free_impl(heap, p);
+        return NULL;
+    }
+
+    if (heap == NULL) {
+        return NULL;
+    }
+
+    size = adjust_request_size(size);
+
+    multi_heap_internal_lock(heap);
+    result = NULL;
+
+    if (size <= block_data_size(pb)) {
+        // Shrinking....
+        split_if_necessary(heap, pb, size);
+        result = pb->data;
+    }
+    else if (heap->free_bytes < size - block_data_size(pb)) {
+        // Growing, but there's not enough total free space in the heap
+        multi_heap_internal_unlock(heap);
+        return NULL;
+    }
+
+    // New size is larger than existing block
+    if (result == NULL) {
+        // See if we can grow into one or both adjacent blocks
+        heap_block_t *orig_pb = pb;
+        size_t orig_size = block_data_size(orig_pb);
+        heap_block_t *next = get_next_block(pb);
+        heap_block_t *prev = get_prev_free_block(pb);
+
+        size_t next_grow_size = (is_free(next) && !is_last_block(next)) ? block_data_size(next) + sizeof(next->header) : 0;
+        size_t prev_grow_size = (prev != NULL) ? block_data_size(prev) + sizeof(pb->header) : 0;
+
+        if (orig_size + next_grow_size + prev_grow_size >= size) {
+            if (next_grow_size > 0) {
+                absorb_next_free_block(heap, pb);
+            }
+            if (orig_size + next_grow_size < size) {
+                // Also need the previous block, data has to move down
+                remove_free_block(heap, prev);
+                mark_used(prev);
+                heap->free_bytes -= block_data_size(prev);
+                prev->header = (pb->header & NEXT_BLOCK_MASK) | (prev->header & BLOCK_PREV_FREE_FLAG);
+                pb = prev;
+                memmove(pb->data, orig_pb->data, orig_size);
+            }
+            split_if_necessary(heap, pb, size);
+            result = pb->data;
+        }
+    }
+
+    if (result == NULL) {
+        // Need to allocate elsewhere and copy data over
+        //
+        // (Calling _impl versions here as we've already been through any
+        // unwrapping for heap poisoning features.)
+        result = multi_heap_malloc_impl(heap, size);
+        if (result != NULL) {
+            memcpy(result, pb->data, block_data_size(pb));
+            multi_heap_free_impl(heap, pb->data);
+        }
+    }
+
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+
+    multi_heap_internal_unlock(heap);
+    return result;
+}
+
+bool multi_heap_try_expand_impl(multi_heap_handle_t heap, void *p, size_t size)
+{
+    heap_block_t *pb = get_block(p);
+    bool result = false;
+
+    assert(heap != NULL);
+    assert(p != NULL);
+
+    assert_valid_block(heap, pb);
+    MULTI_HEAP_ASSERT(!is_free(pb), pb); // block should be allocated
+
+    size = adjust_request_size(size);
+
+    multi_heap_internal_lock(heap);
+
+    if (size <= block_data_size(pb)) {
+        result = true;
+    } else {
+        // Only the next block can be used, growing into the previous one would move the data
+        heap_block_t *next = get_next_block(pb);
+        if (is_free(next) && !is_last_block(next)
+            && block_data_size(pb) + sizeof(next->header) + block_data_size(next) >= size) {
+            absorb_next_free_block(heap, pb);
+            split_if_necessary(heap, pb, size);
+            result = true;
+        }
+    }
+
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+
+    multi_heap_internal_unlock(heap);
+    return result;
+}
+
+#define FAIL_PRINT(MSG, ...) do {                                       \
+        if (print_errors) {                                             \
+            MULTI_HEAP_STDERR_PRINTF(MSG, __VA_ARGS__);                 \
+        }                                                               \
+        valid = false;                                                  \
+    }                                                                   \
+    while(0)
+
+bool multi_heap_check(multi_heap_handle_t heap, bool print_errors)
+{
+    bool valid = true;
+    size_t total_free_bytes = 0;
+    size_t total_free_blocks = 0;
+    multi_heap_free_stats_t free_stats = { 0 };
+    assert(heap != NULL);
+
+    multi_heap_internal_lock(heap);
+
+    heap_block_t *prev = NULL;
+
+    /* note: not using get_next_block() in loop, so that assertions aren't checked here */
+    for(heap_block_t *b = &heap->first_block; b != NULL; b = (heap_block_t *)(b->header & NEXT_BLOCK_MASK)) {
+        if (b == prev) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p points to itself\n", b);
+            goto done;
+        }
+        if (b < prev) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p is before prev block %p\n", b, prev);
+            goto done;
+        }
+        if (b > heap->last_block || b < &heap->first_block) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p is outside heap (last valid block %p)\n", b, prev);
+            goto done;
+        }
+        if (prev != NULL) {
+            bool prev_free = is_free(prev) && !is_first_block(heap, prev);
+            if (is_prev_free(b) != prev_free) {
+                FAIL_PRINT("CORRUPT HEAP: Block %p has wrong previous free flag\n", b);
+            } else if (prev_free && *prev_free_tag(b) != prev) {
+                FAIL_PRINT("CORRUPT HEAP: Free block %p has bad tag %p\n", prev, *prev_free_tag(b));
+            }
+        }
+        if (is_free(b)) {
+            if (prev != NULL && is_free(prev) && !is_first_block(heap, prev) && !is_last_block(b)) {
+                FAIL_PRINT("CORRUPT HEAP: Two adjacent free blocks found, %p and %p\n", prev, b);
+            }
+            if (!is_first_block(heap, b) && !is_last_block(b)) {
+                total_free_bytes += block_data_size(b);
+                total_free_blocks++;
+                multi_heap_internal_free_stats_add(&free_stats, block_data_size(b));
+            }
+        }
+        prev = b;
+
+#ifdef MULTI_HEAP_POISONING
+        if (!is_last_block(b) && !is_first_block(heap, b)) {
+            /* For slow heap poisoning, any block should contain correct poisoning patterns and/or fills */
+            bool poison_ok;
+            if (is_free(b)) {
+                /* skip the free list pointers at the start, and the tag at the end */
+                poison_ok = multi_heap_internal_check_block_poisoning(&b->prev_free + 1, block_data_size(b) - MIN_BLOCK_DATA_SIZE,
+                                                                      true, print_errors);
+            }
+            else {
+                poison_ok = multi_heap_internal_check_block_poisoning(b->data, block_data_size(b), false, print_errors);
+            }
+            valid = poison_ok && valid;
+        }
+#endif
+
+    } /* for(heap_block_t b = ... */
+
+    if (prev != heap->last_block) {
+        FAIL_PRINT("CORRUPT HEAP: Last block %p not %p\n", prev, heap->last_block);
+    }
+    if (!is_free(heap->last_block)) {
+        FAIL_PRINT("CORRUPT HEAP: Expected prev block %p to be free\n", heap->last_block);
+    }
+
+    if (heap->free_bytes != total_free_bytes) {
+        FAIL_PRINT("CORRUPT HEAP: Expected %u free bytes counted %u\n", (unsigned)heap->free_bytes, (unsigned)total_free_bytes);
+    }
+
+    if (heap->free_stats.free_blocks != free_stats.free_blocks
+            || heap->free_stats.free_bytes_squared != free_stats.free_bytes_squared
+            || memcmp(heap->free_stats.free_blocks_by_size, free_stats.free_blocks_by_size, sizeof(free_stats.free_blocks_by_size)) != 0) {
+        FAIL_PRINT("CORRUPT HEAP: Free block statistics don't match the %u free blocks counted\n", (unsigned)free_stats.free_blocks);
+    }
+
+    /* every free block should be in the list for its size */
+    size_t listed_free_blocks = 0;
+    for (uint32_t fl = 0; fl < heap->fl_count; fl++) {
+        for (uint32_t sl = 0; sl < SL_INDEX_COUNT; sl++) {
+            heap_block_t *head = *free_list(heap, fl, sl);
+            bool bit = (heap->fl_bitmap & (1U << fl)) && (heap->sl_bitmap[fl] & (1U << sl));
+            if (bit != (head != NULL)) {
+                FAIL_PRINT("CORRUPT HEAP: Free list %u/%u bitmap does not match list head %p\n", fl, sl, head);
+            }
+            heap_block_t *prev_free = NULL;
+            for (heap_block_t *b = head; b != NULL; b = b->next_free) {
+                uint32_t block_fl, block_sl;
+                if (b <= &heap->first_block || b >= heap->last_block || !is_free(b) || b->prev_free != prev_free) {
+                    FAIL_PRINT("CORRUPT HEAP: Bad block %p in free list %u/%u\n", b, fl, sl);
+                    goto done;
+                }
+                mapping_insert(block_data_size(b), &block_fl, &block_sl);
+                if (block_fl != fl || block_sl != sl) {
+                    FAIL_PRINT("CORRUPT HEAP: Free block %p in list %u/%u, expected %u/%u\n", b, fl, sl, block_fl, block_sl);
+                }
+                if (++listed_free_blocks > total_free_blocks) {
+                    FAIL_PRINT("CORRUPT HEAP: More than %u blocks in free lists\n", (unsigned)total_free_blocks);
+                    goto done;
+                }
+                prev_free = b;
+            }
+        }
+    }
+    if (listed_free_blocks != total_free_blocks) {
+        FAIL_PRINT("CORRUPT HEAP: Expected %u blocks in free lists counted %u\n", (unsigned)total_free_blocks, (unsigned)listed_free_blocks);
+    }
+
+ done:
+    multi_heap_internal_unlock(heap);
+
+    return valid;
+}
+
+void multi_heap_dump(multi_heap_handle_t heap)
+{
+    assert(heap != NULL);
+
+    multi_heap_internal_lock(heap);
+    MULTI_HEAP_STDERR_PRINTF("Heap start %p end %p\nFree list bitmap 0x%08x\n", &heap->first_block, heap->last_block, heap->fl_bitmap);
+    for(heap_block_t *b = &heap->first_block; b != NULL; b = get_next_block(b)) {
+        MULTI_HEAP_STDERR_PRINTF("Block %p data size 0x%08x bytes next block %p", b, block_data_size(b), get_next_block(b));
+        if (is_free(b) && !is_first_block(heap, b) && !is_last_block(b)) {
+            MULTI_HEAP_STDERR_PRINTF(" FREE. Next free %p\n", b->next_free);
+        } else {
+            MULTI_HEAP_STDERR_PRINTF("%s", "\n"); /* C macros & optional __VA_ARGS__ */
+        }
+    }
+    multi_heap_internal_unlock(heap);
+}
+
+size_t multi_heap_free_size_impl(multi_heap_handle_t heap)
+{
+    if (heap == NULL) {
+        return 0;
+    }
+    return heap->free_bytes;
+}
+
+size_t multi_heap_minimum_free_size_impl(multi_heap_handle_t heap)
+{
+    if (heap == NULL) {
+        return 0;
+    }
+    return heap->minimum_free_bytes;
+}
+
+void multi_heap_get_fragmentation_info(multi_heap_handle_t heap, multi_heap_fragmentation_info_t *info)
+{
+    memset(info, 0, sizeof(multi_heap_fragmentation_info_t));
+
+    if (heap == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+    info->total_free_bytes = heap->free_bytes;
+    info->free_blocks = heap->free_stats.free_blocks;
+    memcpy(info->free_blocks_by_size, heap->free_stats.free_blocks_by_size, sizeof(info->free_blocks_by_size));
+    info->free_bytes_squared = heap->free_stats.free_bytes_squared;
+    multi_heap_internal_unlock(heap);
+
+    info->fragmentation = multi_heap_internal_fragmentation(info->total_free_bytes, info->free_bytes_squared);
+}
+
+void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info)
+{
+    memset(info, 0, sizeof(multi_heap_info_t));
+
+    if (heap == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+    for(heap_block_t *b = get_next_block(&heap->first_block); !is_last_block(b); b = get_next_block(b)) {
+        info->total_blocks++;
+        if (is_free(b)) {
+            size_t s = block_data_size(b);
+            info->total_free_bytes += s;
+            if (s > info->largest_free_block) {
+                info->largest_free_block = s;
+            }
+            info->free_blocks++;
+        } else {
+            info->total_allocated_bytes += block_data_size(b);
+            info->allocated_blocks++;
+        }
+    }
+
+    info->minimum_free_bytes = heap->minimum_free_bytes;
+    // heap has wrong total size (address printed here is not indicative of the real error)
+    MULTI_HEAP_ASSERT(info->total_free_bytes == heap->free_bytes, heap);
+
+    multi_heap_internal_unlock(heap);
+
+}
@@ -0,0 +1,44 @@
+/*
+ Tests for arenas created from the heaps
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_arena.h"
+#include "soc/soc_memory_layout.h"
+
+TEST_CASE("arena memory is allocated with the requested caps", "[heap][arena]")
+{
+    const size_t SIZE = 2048;
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
+    size_t arena_bytes = info.arena_bytes;
+    size_t arena_used_bytes = info.arena_used_bytes;
+
+    heap_arena_handle_t arena = heap_arena_create(SIZE, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(arena);
+    TEST_ASSERT_EQUAL(SIZE, heap_arena_get_free_size(arena));
+
+    void *p = heap_arena_alloc(arena, 100);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT(esp_ptr_dma_capable(p));
+    TEST_ASSERT_NOT_NULL(heap_arena_alloc(arena, 200));
+
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_EQUAL(arena_bytes + SIZE, info.arena_bytes);
+    TEST_ASSERT_EQUAL(arena_used_bytes + heap_arena_get_used_size(arena), info.arena_used_bytes);
+    heap_caps_get_info(&info, MALLOC_CAP_SPIRAM);
+    TEST_ASSERT_EQUAL(0, info.arena_bytes);
+
+    heap_arena_reset(arena);
+    TEST_ASSERT_EQUAL_PTR(p, heap_arena_alloc(arena, 100));
+    heap_arena_destroy(arena);
+
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_EQUAL(arena_bytes, info.arena_bytes);
+
+    TEST_ASSERT_NULL(heap_arena_create(SIZE, MALLOC_CAP_EXEC));
+    TEST_ASSERT_NULL(heap_arena_create(0, MALLOC_CAP_8BIT));
+}
@@ -0,0 +1,161 @@
+/*
+ Tests for fixed size block pools
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_utils.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_pool.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "soc/soc_memory_layout.h"
+
+TEST_CASE("pool blocks are allocated and freed", "[heap][pool]")
+{
+    const size_t COUNT = 10;
+    heap_pool_info_t info;
+
+    heap_pool_handle_t pool = heap_pool_create(13, COUNT, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(pool);
+    heap_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(16, info.block_size);
+    TEST_ASSERT_EQUAL(COUNT, info.total_blocks);
+    TEST_ASSERT_EQUAL(COUNT, info.free_blocks);
+
+    void *blocks[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        blocks[i] = heap_pool_alloc(pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT(esp_ptr_dma_capable(blocks[i]));
+        TEST_ASSERT(heap_pool_contains(pool, blocks[i]));
+        memset(blocks[i], i, info.block_size);
+    }
+    TEST_ASSERT_NULL(heap_pool_alloc(pool));
+    TEST_ASSERT_FALSE(heap_pool_contains(pool, (uint8_t *)blocks[0] + 1));
+    for (int i = 0; i < COUNT; i++) {
+        for (int j = 0; j < info.block_size; j++) {
+            TEST_ASSERT_EQUAL(i, ((uint8_t *)blocks[i])[j]);
+        }
+    }
+    TEST_ASSERT(heap_pool_check(pool, true));
+
+    heap_pool_free(pool, blocks[3]);
+    heap_pool_free(pool, blocks[7]);
+    heap_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(2, info.free_blocks);
+    TEST_ASSERT_EQUAL(0, info.minimum_free_blocks);
+    TEST_ASSERT_EQUAL_PTR(blocks[7], heap_pool_alloc(pool));
+    TEST_ASSERT_EQUAL_PTR(blocks[3], heap_pool_alloc(pool));
+
+    for (int i = 0; i < COUNT; i++) {
+        heap_pool_free(pool, blocks[i]);
+    }
+    TEST_ASSERT(heap_caps_check_integrity(MALLOC_CAP_INTERNAL, true));
+    heap_pool_delete(pool);
+
+    TEST_ASSERT_NULL(heap_pool_create(0, COUNT, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_pool_create(16, 0, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_pool_create(16, COUNT, MALLOC_CAP_EXEC));
+}
+
+#ifdef CONFIG_HEAP_POISONING_COMPREHENSIVE
+TEST_CASE("pool detects writes to free blocks", "[heap][pool]")
+{
+    heap_pool_handle_t pool = heap_pool_create(32, 4, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(pool);
+    uint8_t *block = heap_pool_alloc(pool);
+    heap_pool_free(pool, block);
+    TEST_ASSERT(heap_pool_check(pool, true));
+
+    block[20] = 0; // use after free
+    TEST_ASSERT_FALSE(heap_pool_check(pool, true));
+    TEST_ASSERT_FALSE(heap_caps_check_integrity_all(true));
+
+    block[20] = 0xfe;
+    TEST_ASSERT(heap_caps_check_integrity_all(true));
+    heap_pool_delete(pool);
+}
+#endif
+
+#if !CONFIG_FREERTOS_UNICORE
+#define STRESS_ITERATIONS 20000
+
+typedef struct {
+    heap_pool_handle_t pool;    // NULL to allocate the blocks with heap_caps_malloc() instead
+    uint8_t pattern;
+    SemaphoreHandle_t done;
+} pool_task_arg_t;
+
+static void pool_stress_task(void *param)
+{
+    pool_task_arg_t *arg = (pool_task_arg_t *)param;
+    for (int i = 0; i < STRESS_ITERATIONS; i++) {
+        uint8_t *a = arg->pool ? heap_pool_alloc(arg->pool) : heap_caps_malloc(16, MALLOC_CAP_INTERNAL);
+        uint8_t *b = arg->pool ? heap_pool_alloc(arg->pool) : heap_caps_malloc(16, MALLOC_CAP_INTERNAL);
+        TEST_ASSERT_NOT_NULL(a);
+        TEST_ASSERT_NOT_NULL(b);
+        // a block must not be handed to both CPUs at once
+        memset(a, arg->pattern, 16);
+        memset(b, arg->pattern, 16);
+        for (int j = 0; j < 16; j++) {
+            TEST_ASSERT_EQUAL_HEX8(arg->pattern, a[j]);
+            TEST_ASSERT_EQUAL_HEX8(arg->pattern, b[j]);
+        }
+        if (arg->pool) {
+            heap_pool_free(arg->pool, a);
+            heap_pool_free(arg->pool, b);
+        } else {
+            heap_caps_free(a);
+            heap_caps_free(b);
+        }
+    }
+    xSemaphoreGive(arg->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("pool can be used from both CPUs at the same time", "[heap][pool]")
+{
+    heap_pool_handle_t pool = heap_pool_create(16, 4, MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_NOT_NULL(pool);
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(2, 0);
+    pool_task_arg_t args[2] = {
+        { .pool = pool, .pattern = 0xaa, .done = done },
+        { .pool = pool, .pattern = 0x55, .done = done },
+    };
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < 2; i++) {
+        xTaskCreatePinnedToCore(pool_stress_task, "pool_stress", 2048, &args[i], UNITY_FREERTOS_PRIORITY - 1, NULL, i);
+    }
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(xSemaphoreTake(done, 10000 / portTICK_PERIOD_MS));
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    printf("%d pool alloc/free pairs on each CPU took %lld us\n", STRESS_ITERATIONS * 2, elapsed);
+
+    // Same with heap_caps_malloc(), for comparison
+    vTaskDelay(5);  // Allow idle to clean up
+    args[0].pool = NULL;
+    args[1].pool = NULL;
+    start = esp_timer_get_time();
+    for (int i = 0; i < 2; i++) {
+        xTaskCreatePinnedToCore(pool_stress_task, "pool_stress", 2048, &args[i], UNITY_FREERTOS_PRIORITY - 1, NULL, i);
+    }
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(xSemaphoreTake(done, 10000 / portTICK_PERIOD_MS));
+    }
+    elapsed = esp_timer_get_time() - start;
+    printf("%d heap_caps_malloc/free pairs on each CPU took %lld us\n", STRESS_ITERATIONS * 2, elapsed);
+
+    heap_pool_info_t info;
+    heap_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(4, info.free_blocks);
+    TEST_ASSERT(heap_pool_check(pool, true));
+    vSemaphoreDelete(done);
+    heap_pool_delete(pool);
+}
+#endif
@@ -10,6 +10,7 @@
 #include <string.h>
 #include "sdkconfig.h"
 #include "unity.h"
+#include "esp_heap_caps.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -59,9 +60,10 @@ TEST_CASE("heap trace leak check", "[heap]")
     heap_trace_get(0, &trace_b);
     TEST_ASSERT_EQUAL_PTR(b, trace_b.address);
 
-    /* buffer deletes trace_a when freed,
-       so trace_b at head of buffer */
-    TEST_ASSERT_EQUAL_PTR(recs[0].address, trace_b.address);
+    /* trace_a is removed when freed, trace_b stays
+       in the same place in the buffer */
+    TEST_ASSERT_NULL(recs[0].address);
+    TEST_ASSERT_EQUAL_PTR(recs[1].address, trace_b.address);
 
     heap_trace_stop();
 }
@@ -123,6 +125,70 @@ TEST_CASE("heap trace wrapped buffer check", "[heap]")
     heap_trace_stop();
 }
 
+TEST_CASE("heap trace sampling", "[heap]")
+{
+    const size_t N = 16;
+    heap_trace_record_t recs[N];
+    heap_trace_init_standalone(recs, N);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_trace_set_sampling(0, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, heap_trace_set_sampling(100, 2));
+    heap_trace_start(HEAP_TRACE_LEAKS);
+
+    void *small[4];
+    void *large[4];
+    for (int i = 0; i < 4; i++) {
+        small[i] = malloc(50);
+        large[i] = malloc(200);
+    }
+    heap_trace_stop();
+    heap_trace_set_sampling(0, 1);
+
+    // only every second large allocation is recorded
+    TEST_ASSERT_EQUAL(2, heap_trace_get_count());
+    heap_trace_record_t rec;
+    heap_trace_get(0, &rec);
+    TEST_ASSERT_EQUAL_PTR(large[1], rec.address);
+    heap_trace_get(1, &rec);
+    TEST_ASSERT_EQUAL_PTR(large[3], rec.address);
+
+    for (int i = 0; i < 4; i++) {
+        free(small[i]);
+        free(large[i]);
+    }
+}
+
+TEST_CASE("heap trace frees are fast with many records", "[heap]")
+{
+    const size_t N = 1000;
+    heap_trace_record_t *recs = heap_caps_malloc(N * sizeof(heap_trace_record_t), MALLOC_CAP_INTERNAL);
+    void **ptrs = calloc(N, sizeof(void *));
+    TEST_ASSERT_NOT_NULL(recs);
+    TEST_ASSERT_NOT_NULL(ptrs);
+    heap_trace_init_standalone(recs, N);
+
+    heap_trace_start(HEAP_TRACE_LEAKS);
+    for (int i = 0; i < N; i++) {
+        ptrs[i] = malloc(8);
+    }
+    TEST_ASSERT_EQUAL(N, heap_trace_get_count());
+
+    // the oldest allocations are the ones which were slowest to find before
+    uint32_t start = xthal_get_ccount();
+    for (int i = 0; i < N; i++) {
+        free(ptrs[i]);
+    }
+    uint32_t cycles = xthal_get_ccount() - start;
+    heap_trace_stop();
+
+    printf("%u cycles per traced free with %u records\n", cycles / N, N);
+    TEST_ASSERT_EQUAL(0, heap_trace_get_count());
+
+    free(ptrs);
+    heap_trace_init_standalone(NULL, 0);
+    free(recs);
+}
+
 static void print_floats_task(void *ignore)
 {
     heap_trace_start(HEAP_TRACE_ALL);
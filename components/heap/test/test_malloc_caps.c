@@ -132,6 +132,39 @@ TEST_CASE("heap_caps metadata test", "[heap]")
     TEST_ASSERT(after.minimum_free_bytes < original.total_free_bytes);
 }
 
+TEST_CASE("heap_caps fragmentation info", "[heap]")
+{
+    printf("heap_caps fragmentation info test\n");
+
+    multi_heap_info_t info;
+    multi_heap_fragmentation_info_t before, frag;
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
+    heap_caps_get_fragmentation_info(&before, MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_EQUAL(info.free_blocks, before.free_blocks);
+    TEST_ASSERT(before.fragmentation <= 100);
+
+    /* allocate blocks and free every other one, to leave many small free blocks behind */
+    const int N = 64;
+    void *p[N];
+    for (int i = 0; i < N; i++) {
+        p[i] = heap_caps_malloc(256, MALLOC_CAP_INTERNAL);
+        TEST_ASSERT_NOT_NULL(p[i]);
+    }
+    for (int i = 0; i < N; i += 2) {
+        heap_caps_free(p[i]);
+    }
+    heap_caps_get_fragmentation_info(&frag, MALLOC_CAP_INTERNAL);
+    printf("fragmentation %d%% with %d free blocks, was %d%% with %d free blocks\n",
+           frag.fragmentation, frag.free_blocks, before.fragmentation, before.free_blocks);
+    TEST_ASSERT(frag.free_blocks > before.free_blocks);
+    TEST_ASSERT(frag.free_blocks_by_size[4] > before.free_blocks_by_size[4]); // 256-511 bytes
+    TEST_ASSERT(frag.free_bytes_squared < before.free_bytes_squared);
+
+    for (int i = 1; i < N; i += 2) {
+        heap_caps_free(p[i]);
+    }
+}
+
 /* Small function runs from IRAM to check that malloc/free/realloc
    all work OK when cache is disabled...
 */
@@ -63,3 +63,29 @@ TEST_CASE("realloc move data to a new heap type", "[heap]")
 
     free(c);
 }
+
+TEST_CASE("heap_caps_try_expand grows buffer without moving it", "[heap]")
+{
+    uint8_t *x = heap_caps_malloc(64, MALLOC_CAP_8BIT);
+    uint8_t *y = heap_caps_malloc(64, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(x);
+    TEST_ASSERT_NOT_NULL(y);
+    memset(x, 0xA5, 64);
+
+    TEST_ASSERT(heap_caps_try_expand(x, 32));
+    TEST_ASSERT(heap_caps_get_allocated_size(x) >= 64);
+    TEST_ASSERT_FALSE(heap_caps_try_expand(x, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) + 128));
+
+    // 'y' usually follows 'x', so this gives 'x' room to grow
+    heap_caps_free(y);
+    if (heap_caps_try_expand(x, 128)) {
+        TEST_ASSERT(heap_caps_get_allocated_size(x) >= 128);
+    } else {
+        TEST_ASSERT(heap_caps_get_allocated_size(x) < 128);
+    }
+    TEST_ASSERT(heap_caps_check_integrity(MALLOC_CAP_INVALID, true));
+    for (int i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0xA5, x[i]);
+    }
+    heap_caps_free(x);
+}
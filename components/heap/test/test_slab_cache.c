@@ -0,0 +1,169 @@
+/*
+ Tests for the per-CPU small allocation caches (CONFIG_HEAP_SLAB_CACHE)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "test_utils.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_HEAP_SLAB_CACHE
+
+TEST_CASE("small allocations are served from the cache", "[heap][slab]")
+{
+    heap_caps_slab_cache_flush();
+
+    void *p = malloc(20);
+    TEST_ASSERT_NOT_NULL(p);
+    // rounded up to the 32 byte class
+    TEST_ASSERT_EQUAL(32, heap_caps_get_allocated_size(p));
+    free(p);
+
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(1, info.cached_blocks);
+    TEST_ASSERT_EQUAL(32, info.cached_bytes);
+
+    // any size of the same class gets the same block back
+    void *q = heap_caps_malloc(30, MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL_PTR(p, q);
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(0, info.cached_blocks);
+    free(q);
+
+    // requests for other capabilities don't use the caches
+    void *d = heap_caps_malloc(30, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(d);
+    TEST_ASSERT_NOT_EQUAL(q, d);
+    free(d);
+
+    size_t before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    heap_caps_slab_cache_flush();
+    TEST_ASSERT(heap_caps_get_free_size(MALLOC_CAP_8BIT) > before);
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(0, info.cached_blocks);
+    TEST_ASSERT_EQUAL(0, info.cached_bytes);
+}
+
+TEST_CASE("cached blocks are returned to the heap when it runs out of memory", "[heap][slab]")
+{
+    const int N = CONFIG_HEAP_SLAB_CACHE_DEPTH;
+    void *small[CONFIG_HEAP_SLAB_CACHE_DEPTH];
+    heap_caps_slab_cache_flush();
+
+    for (int i = 0; i < N; i++) {
+        small[i] = malloc(64);
+        TEST_ASSERT_NOT_NULL(small[i]);
+    }
+    for (int i = 0; i < N; i++) {
+        free(small[i]);
+    }
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(N, info.cached_blocks);
+
+    // fill the heaps with 1KB blocks until no allocation succeeds, even after flushing
+    const int MAX_BLOCKS = 1024;
+    void **big = heap_caps_malloc(MAX_BLOCKS * sizeof(void *), MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(big);
+    int count;
+    for (count = 0; count < MAX_BLOCKS; count++) {
+        big[count] = heap_caps_malloc(1024, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+        if (big[count] == NULL) {
+            break;
+        }
+    }
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(0, info.cached_blocks);
+
+    for (int i = 0; i < count; i++) {
+        free(big[i]);
+    }
+    free(big);
+}
+
+#endif // CONFIG_HEAP_SLAB_CACHE
+
+#ifndef CONFIG_FREERTOS_UNICORE
+
+#define CONTENTION_ITERATIONS 10000
+#define CONTENTION_BLOCKS 8
+
+typedef struct {
+    SemaphoreHandle_t done;
+    uint32_t caps;
+    size_t extra;       // added to the size of each block
+    int64_t time_us;
+} contention_task_arg_t;
+
+static void contention_task(void *arg)
+{
+    contention_task_arg_t *task_arg = (contention_task_arg_t *)arg;
+    void *blocks[CONTENTION_BLOCKS];
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CONTENTION_ITERATIONS; i++) {
+        for (int b = 0; b < CONTENTION_BLOCKS; b++) {
+            blocks[b] = heap_caps_malloc((16 << (b % 4)) + task_arg->extra, task_arg->caps);
+            assert(blocks[b] != NULL);
+        }
+        for (int b = 0; b < CONTENTION_BLOCKS; b++) {
+            free(blocks[b]);
+        }
+    }
+    task_arg->time_us = esp_timer_get_time() - start;
+
+    xSemaphoreGive(task_arg->done);
+    vTaskDelete(NULL);
+}
+
+/* Allocate and free small blocks in a task on each CPU, returns the average time of a malloc/free pair in ns */
+static int run_contention_tasks(uint32_t caps, size_t extra)
+{
+    contention_task_arg_t args[portNUM_PROCESSORS];
+    int64_t total_us = 0;
+
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        args[cpu].done = xSemaphoreCreateBinary();
+        TEST_ASSERT_NOT_NULL(args[cpu].done);
+        args[cpu].caps = caps;
+        args[cpu].extra = extra;
+    }
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        xTaskCreatePinnedToCore(contention_task, "contention", 2048, &args[cpu], UNITY_FREERTOS_PRIORITY - 1, NULL, cpu);
+    }
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        xSemaphoreTake(args[cpu].done, portMAX_DELAY);
+        vSemaphoreDelete(args[cpu].done);
+        total_us += args[cpu].time_us;
+    }
+    vTaskDelay(5);  // Allow idle to clean up
+    return total_us * 1000 / (portNUM_PROCESSORS * CONTENTION_ITERATIONS * CONTENTION_BLOCKS);
+}
+
+TEST_CASE("small allocation performance with both CPUs allocating", "[heap][slab]")
+{
+    /* DMA capable requests aren't served from the caches, and blocks which aren't a power of two in size aren't
+       put into them, so this measures the heaps alone. */
+    int uncached_ns = run_contention_tasks(MALLOC_CAP_8BIT | MALLOC_CAP_DMA, 4);
+#if CONFIG_HEAP_SLAB_CACHE
+    heap_caps_slab_cache_flush();
+#endif
+    int default_ns = run_contention_tasks(MALLOC_CAP_8BIT, 0);
+
+    printf("malloc/free pair with both CPUs allocating: %d ns from the heaps alone, %d ns for default allocations\n",
+           uncached_ns, default_ns);
+#if CONFIG_HEAP_SLAB_CACHE
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    printf("%d bytes cached in %d blocks\n", info.cached_bytes, info.cached_blocks);
+#endif
+}
+
+#endif // CONFIG_FREERTOS_UNICORE
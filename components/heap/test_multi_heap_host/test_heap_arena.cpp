@@ -0,0 +1,164 @@
+#include "catch.hpp"
+#include "multi_heap.h"
+#include "esp_heap_arena.h"
+
+#include "../multi_heap_config.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+
+TEST_CASE("arena allocations are aligned and don't overlap", "[heap_arena]")
+{
+    uint8_t buf[1024];
+    heap_arena_handle_t arena = heap_arena_create_with_buffer(buf + 1, sizeof(buf) - 1);
+    REQUIRE( arena != NULL );
+    size_t capacity = heap_arena_get_free_size(arena);
+    REQUIRE( capacity > sizeof(buf) - 64 );
+    REQUIRE( heap_arena_get_used_size(arena) == 0 );
+
+    REQUIRE( heap_arena_alloc(arena, 0) == NULL );
+
+    uint8_t *prev = NULL;
+    size_t prev_size = 0;
+    for (size_t size = 1; size < 32; size++) {
+        uint8_t *p = (uint8_t *)heap_arena_alloc(arena, size);
+        REQUIRE( p != NULL );
+        REQUIRE( ((uintptr_t)p % sizeof(void *)) == 0 );
+        REQUIRE( p >= buf );
+        REQUIRE( p + size <= buf + sizeof(buf) );
+        if (prev != NULL) {
+            REQUIRE( p >= prev + prev_size );
+        }
+        memset(p, size, size);
+        prev = p;
+        prev_size = size;
+    }
+    REQUIRE( heap_arena_get_used_size(arena) + heap_arena_get_free_size(arena) == capacity );
+
+    // allocations fail once the arena is full, then succeed again after a reset
+    REQUIRE( heap_arena_alloc(arena, capacity) == NULL );
+    heap_arena_reset(arena);
+    REQUIRE( heap_arena_get_used_size(arena) == 0 );
+    uint8_t *all = (uint8_t *)heap_arena_alloc(arena, capacity);
+    REQUIRE( all != NULL );
+    REQUIRE( heap_arena_get_free_size(arena) == 0 );
+    REQUIRE( heap_arena_alloc(arena, 1) == NULL );
+    REQUIRE( heap_arena_get_max_used_size(arena) == capacity );
+
+    REQUIRE( heap_arena_create_with_buffer(buf, 4) == NULL );
+}
+
+TEST_CASE("arena checkpoints nest", "[heap_arena]")
+{
+    uint8_t buf[512];
+    heap_arena_handle_t arena = heap_arena_create_with_buffer(buf, sizeof(buf));
+    REQUIRE( arena != NULL );
+
+    void *a = heap_arena_alloc(arena, 10);
+    heap_arena_checkpoint_t outer = heap_arena_checkpoint(arena);
+    void *b = heap_arena_alloc(arena, 20);
+    heap_arena_checkpoint_t inner = heap_arena_checkpoint(arena);
+    void *c = heap_arena_alloc(arena, 30);
+    REQUIRE( a != NULL );
+    REQUIRE( b != NULL );
+    REQUIRE( c != NULL );
+
+    heap_arena_rollback(arena, inner);
+    REQUIRE( heap_arena_alloc(arena, 30) == c );
+
+    heap_arena_rollback(arena, outer);
+    REQUIRE( heap_arena_get_used_size(arena) == outer );
+    REQUIRE( heap_arena_alloc(arena, 20) == b );
+
+    // zeroed memory from calloc, even after the memory was used before
+    heap_arena_rollback(arena, outer);
+    memset(b, 0xaa, 20);
+    uint8_t *z = (uint8_t *)heap_arena_calloc(arena, 4, 5);
+    REQUIRE( z == b );
+    for (int i = 0; i < 20; i++) {
+        REQUIRE( z[i] == 0 );
+    }
+    REQUIRE( heap_arena_calloc(arena, SIZE_MAX / 2, 4) == NULL );
+
+    heap_arena_reset(arena);
+    REQUIRE( heap_arena_alloc(arena, 10) == a );
+}
+
+/* Allocations of a request handler: many small blocks which are all freed at the end of the request */
+TEST_CASE("arena versus heap allocation time for request-scoped memory", "[heap_arena][bench]")
+{
+    const size_t HEAP_SIZE = 256 * 1024;
+    const size_t ALLOCS_PER_REQUEST = 300;
+    const size_t REQUESTS = 200;
+    uint8_t *heapdata = new uint8_t[HEAP_SIZE];
+    void **blocks = new void *[ALLOCS_PER_REQUEST];
+    size_t *sizes = new size_t[ALLOCS_PER_REQUEST];
+
+    srand(7);
+    for (size_t i = 0; i < ALLOCS_PER_REQUEST; i++) {
+        sizes[i] = 4 + rand() % 96;
+    }
+
+    multi_heap_handle_t heap = multi_heap_register(heapdata, HEAP_SIZE);
+    REQUIRE( heap != NULL );
+    /* some long lived blocks, as in a heap which has been in use for a while */
+    for (size_t i = 0; i < 200; i++) {
+        REQUIRE( multi_heap_malloc(heap, 8 + rand() % 200) != NULL );
+        void *gap = multi_heap_malloc(heap, 8 + rand() % 200);
+        REQUIRE( gap != NULL );
+        multi_heap_free(heap, gap);
+    }
+
+    /* REQUIRE is slow compared to the allocators, so failures are only counted in the timed loops */
+    size_t failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < REQUESTS; r++) {
+        for (size_t i = 0; i < ALLOCS_PER_REQUEST; i++) {
+            blocks[i] = multi_heap_malloc(heap, sizes[i]);
+            failed += (blocks[i] == NULL);
+        }
+        for (size_t i = 0; i < ALLOCS_PER_REQUEST; i++) {
+            multi_heap_free(heap, blocks[i]);
+        }
+    }
+    auto heap_time = std::chrono::steady_clock::now() - start;
+    REQUIRE( failed == 0 );
+    REQUIRE( multi_heap_check(heap, true) );
+
+    /* the arena memory itself comes from the same heap, once */
+    const size_t ARENA_SIZE = 32 * 1024;
+    void *arena_buf = multi_heap_malloc(heap, ARENA_SIZE);
+    REQUIRE( arena_buf != NULL );
+    heap_arena_handle_t arena = heap_arena_create_with_buffer(arena_buf, ARENA_SIZE);
+    REQUIRE( arena != NULL );
+
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < REQUESTS; r++) {
+        for (size_t i = 0; i < ALLOCS_PER_REQUEST; i++) {
+            blocks[i] = heap_arena_alloc(arena, sizes[i]);
+            failed += (blocks[i] == NULL);
+        }
+        heap_arena_reset(arena);
+    }
+    auto arena_time = std::chrono::steady_clock::now() - start;
+    REQUIRE( failed == 0 );
+    multi_heap_free(heap, arena_buf);
+
+    using std::chrono::nanoseconds;
+    using std::chrono::duration_cast;
+#ifdef MULTI_HEAP_TLSF
+    const char *allocator = "TLSF";
+#else
+    const char *allocator = "best fit";
+#endif
+    const long long pairs = REQUESTS * ALLOCS_PER_REQUEST;
+    printf("%s heap malloc/free: %lld ns per allocation, arena alloc/reset: %lld ns per allocation\n",
+           allocator,
+           (long long)duration_cast<nanoseconds>(heap_time).count() / pairs,
+           (long long)duration_cast<nanoseconds>(arena_time).count() / pairs);
+
+    delete[] sizes;
+    delete[] blocks;
+    delete[] heapdata;
+}
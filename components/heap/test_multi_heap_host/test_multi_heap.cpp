@@ -5,6 +5,8 @@
 
 #include <string.h>
 #include <assert.h>
+#include <algorithm>
+#include <chrono>
 
 /* Insurance against accidentally using libc heap functions in tests */
 #undef free
@@ -16,11 +18,40 @@
 #undef realloc
 #define realloc #error
 
+#ifdef MULTI_HEAP_TLSF
+/* The TLSF allocator keeps its free lists at the start of each heap, small test heaps need room for them */
+#define TEST_HEAP_EXTRA 1024
+#else
+/* Room for the free block statistics in the heap structure */
+#define TEST_HEAP_EXTRA 128
+#endif
+
+/* Register a heap in 'buf' which has as much free space as a heap of 'size - TEST_HEAP_EXTRA' bytes with only the
+   basic heap structure, so that tests which depend on the layout of small heaps work with both allocators */
+static multi_heap_handle_t register_test_heap(uint8_t *buf, size_t size)
+{
+    const size_t max_size = size;
+    size -= TEST_HEAP_EXTRA;
+    /* basic heap overhead: heap structure (6 words), first block header (1 word), last block (2 words) */
+    size_t basic_free = size - 9 * sizeof(void *);
+#ifdef MULTI_HEAP_POISONING
+    /* multi_heap_free_size() doesn't count the poison head (canary and size) and tail (canary) */
+    basic_free -= 2 * sizeof(size_t) + sizeof(uint32_t);
+#endif
+    multi_heap_handle_t heap = multi_heap_register(buf, size);
+    while (heap == NULL || multi_heap_free_size(heap) < basic_free) {
+        size += sizeof(void *);
+        REQUIRE( size <= max_size );
+        heap = multi_heap_register(buf, size);
+    }
+    return heap;
+}
+
 TEST_CASE("multi_heap simple allocations", "[multi_heap]")
 {
-    uint8_t small_heap[128];
+    uint8_t small_heap[128 + TEST_HEAP_EXTRA];
 
-    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
 
     size_t test_alloc_size = (multi_heap_free_size(heap) + 4) / 2;
 
@@ -59,8 +90,8 @@ TEST_CASE("multi_heap simple allocations", "[multi_heap]")
 
 TEST_CASE("multi_heap fragmentation", "[multi_heap]")
 {
-    uint8_t small_heap[256];
-    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    uint8_t small_heap[256 + TEST_HEAP_EXTRA];
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
 
     const size_t alloc_size = 24;
 
@@ -109,9 +140,9 @@ TEST_CASE("multi_heap fragmentation", "[multi_heap]")
 TEST_CASE("multi_heap defrag", "[multi_heap]")
 {
     void *p[4];
-    uint8_t small_heap[512];
+    uint8_t small_heap[512 + TEST_HEAP_EXTRA];
     multi_heap_info_t info, info2;
-    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
 
     printf("0 ---\n");
     multi_heap_dump(heap);
@@ -159,9 +190,9 @@ TEST_CASE("multi_heap defrag", "[multi_heap]")
 TEST_CASE("multi_heap defrag realloc", "[multi_heap]")
 {
     void *p[4];
-    uint8_t small_heap[512];
+    uint8_t small_heap[512 + TEST_HEAP_EXTRA];
     multi_heap_info_t info, info2;
-    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
 
     printf("0 ---\n");
     multi_heap_dump(heap);
@@ -296,8 +327,8 @@ TEST_CASE("multi_heap many random allocations", "[multi_heap]")
 
 TEST_CASE("multi_heap_get_info() function", "[multi_heap]")
 {
-    uint8_t heapdata[256];
-    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    uint8_t heapdata[256 + TEST_HEAP_EXTRA];
+    multi_heap_handle_t heap = register_test_heap(heapdata, sizeof(heapdata));
     multi_heap_info_t before, after, freed;
 
     multi_heap_get_info(heap, &before);
@@ -391,8 +422,8 @@ TEST_CASE("multi_heap minimum-size allocations", "[multi_heap]")
 TEST_CASE("multi_heap_realloc()", "[multi_heap]")
 {
     const uint32_t PATTERN = 0xABABDADA;
-    uint8_t small_heap[300];
-    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    uint8_t small_heap[300 + TEST_HEAP_EXTRA];
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
 
     uint32_t *a = (uint32_t *)multi_heap_malloc(heap, 64);
     uint32_t *b = (uint32_t *)multi_heap_malloc(heap, 32);
@@ -443,10 +474,77 @@ TEST_CASE("multi_heap_realloc()", "[multi_heap]")
 #endif
 }
 
+TEST_CASE("multi_heap_try_expand()", "[multi_heap]")
+{
+    uint8_t small_heap[700 + TEST_HEAP_EXTRA];
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
+
+    uint8_t *a = (uint8_t *)multi_heap_malloc(heap, 128);
+    uint8_t *b = (uint8_t *)multi_heap_malloc(heap, 32);
+    uint8_t *c = (uint8_t *)multi_heap_malloc(heap, 32);
+    uint8_t *d = (uint8_t *)multi_heap_malloc(heap, 32);
+    REQUIRE( a != NULL );
+    REQUIRE( b > a );
+    REQUIRE( c > b );
+    REQUIRE( d > c );
+    memset(b, 0xbb, 32);
+
+    /* already big enough */
+    REQUIRE( multi_heap_try_expand(heap, b, 16) );
+    REQUIRE( multi_heap_get_allocated_size(heap, b) >= 32 );
+
+    /* 'c' is in the way */
+    REQUIRE( !multi_heap_try_expand(heap, b, 64) );
+    REQUIRE( multi_heap_check(heap, true) );
+
+    /* grows into the space formerly held by 'c' */
+    multi_heap_free(heap, c);
+    REQUIRE( multi_heap_try_expand(heap, b, 64) );
+    REQUIRE( multi_heap_check(heap, true) );
+    REQUIRE( multi_heap_get_allocated_size(heap, b) >= 64 );
+    for (int i = 0; i < 32; i++) {
+        REQUIRE( b[i] == 0xbb );
+    }
+    memset(b, 0xbb, 64);
+    REQUIRE( multi_heap_check(heap, true) );
+
+    /* the free block before 'b' is never used, as that would move the data */
+    multi_heap_free(heap, a);
+    /* (more than the rest of the block formerly held by 'c') */
+    size_t grown_size = multi_heap_get_allocated_size(heap, b) + 64;
+    REQUIRE( !multi_heap_try_expand(heap, b, grown_size) );
+    REQUIRE( multi_heap_check(heap, true) );
+
+#ifndef MULTI_HEAP_POISONING_SLOW
+    /* ...but realloc() moves the data down into it */
+    uint8_t *e = (uint8_t *)multi_heap_realloc(heap, b, grown_size);
+    REQUIRE( e == a );
+    REQUIRE( multi_heap_check(heap, true) );
+    for (int i = 0; i < 64; i++) {
+        REQUIRE( e[i] == 0xbb );
+    }
+    b = e;
+#endif
+
+    /* 'd' is followed by the rest of the heap */
+    REQUIRE( multi_heap_try_expand(heap, d, 128) );
+    REQUIRE( multi_heap_check(heap, true) );
+    REQUIRE( !multi_heap_try_expand(heap, d, sizeof(small_heap)) );
+    REQUIRE( multi_heap_get_allocated_size(heap, d) >= 128 );
+
+    multi_heap_free(heap, b);
+    multi_heap_free(heap, d);
+    REQUIRE( multi_heap_check(heap, true) );
+    multi_heap_info_t info;
+    multi_heap_get_info(heap, &info);
+    REQUIRE( info.allocated_blocks == 0 );
+    REQUIRE( info.free_blocks == 1 );
+}
+
 TEST_CASE("corrupt heap block", "[multi_heap]")
 {
-    uint8_t small_heap[256];
-    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    uint8_t small_heap[256 + TEST_HEAP_EXTRA];
+    multi_heap_handle_t heap = register_test_heap(small_heap, sizeof(small_heap));
 
     void *a = multi_heap_malloc(heap, 32);
     REQUIRE( multi_heap_check(heap, true) );
@@ -459,16 +557,16 @@ TEST_CASE("unaligned heaps", "[multi_heap]")
     const size_t CHUNK_LEN = 256;
     const size_t CANARY_LEN = 16;
     const uint8_t CANARY_BYTE = 0x3E;
-    uint8_t heap_chunk[CHUNK_LEN + CANARY_LEN * 2];
+    uint8_t heap_chunk[CHUNK_LEN + TEST_HEAP_EXTRA + CANARY_LEN * 2];
 
     /* Put some canary bytes before and after the bytes we intend to use for
        the heap, make sure they aren't ever overwritten */
     memset(heap_chunk, CANARY_BYTE, CANARY_LEN);
-    memset(heap_chunk + CANARY_LEN + CHUNK_LEN, CANARY_BYTE, CANARY_LEN);
+    memset(heap_chunk + CANARY_LEN + CHUNK_LEN + TEST_HEAP_EXTRA, CANARY_BYTE, CANARY_LEN);
 
     for (int i = 0; i < 8; i++) {
         printf("Testing with offset %d\n", i);
-        multi_heap_handle_t heap = multi_heap_register(heap_chunk + CANARY_LEN + i, CHUNK_LEN - i);
+        multi_heap_handle_t heap = register_test_heap(heap_chunk + CANARY_LEN + i, CHUNK_LEN + TEST_HEAP_EXTRA - i);
         multi_heap_info_t info;
 
         REQUIRE( multi_heap_check(heap, true) );
@@ -490,7 +588,7 @@ TEST_CASE("unaligned heaps", "[multi_heap]")
 
         for (unsigned j = 0; j < CANARY_LEN; j++) { // check canaries
             REQUIRE( heap_chunk[j] == CANARY_BYTE );
-            REQUIRE( heap_chunk[CHUNK_LEN + CANARY_LEN + j] == CANARY_BYTE );
+            REQUIRE( heap_chunk[CHUNK_LEN + TEST_HEAP_EXTRA + CANARY_LEN + j] == CANARY_BYTE );
         }
     }
 }
@@ -544,4 +642,206 @@ TEST_CASE("multi_heap aligned allocations", "[multi_heap]")
 
     printf("[ALIGNED_ALLOC] heap_size after: %d \n", multi_heap_free_size(heap));
     REQUIRE((old_size - multi_heap_free_size(heap)) <= leakage);
-}
\ No newline at end of file
+}
+
+TEST_CASE("multi_heap fragmentation info", "[multi_heap]")
+{
+    uint8_t heapdata[16384];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    multi_heap_fragmentation_info_t frag;
+    multi_heap_info_t info;
+
+    /* a new heap is one free block */
+    multi_heap_get_fragmentation_info(heap, &frag);
+    REQUIRE( frag.free_blocks == 1 );
+    REQUIRE( frag.total_free_bytes >= multi_heap_free_size(heap) ); // poisoning overhead isn't subtracted
+    REQUIRE( frag.fragmentation == 0 );
+    REQUIRE( frag.free_blocks_by_size[9] == 1 ); // 8-16KB
+
+    /* fill the heap, then free every other block, so the free memory is in many small pieces */
+    void *p[200];
+    int count = 0;
+    while (count < 200 && (p[count] = multi_heap_malloc(heap, 100)) != NULL) {
+        count++;
+    }
+    REQUIRE( count > 64 );
+    for (int i = 0; i < count; i += 2) {
+        multi_heap_free(heap, p[i]);
+    }
+    REQUIRE( multi_heap_check(heap, true) );
+
+    multi_heap_get_fragmentation_info(heap, &frag);
+    multi_heap_get_info(heap, &info);
+    REQUIRE( frag.free_blocks == info.free_blocks );
+    REQUIRE( frag.free_blocks >= count / 2 );
+    REQUIRE( frag.free_blocks_by_size[2] + frag.free_blocks_by_size[3] >= count / 2 - 1 ); // 64-255 bytes
+    REQUIRE( frag.fragmentation > 90 );
+    size_t by_size = 0;
+    for (int i = 0; i < MULTI_HEAP_FREE_SIZE_CLASSES; i++) {
+        by_size += frag.free_blocks_by_size[i];
+    }
+    REQUIRE( by_size == frag.free_blocks );
+
+    /* freeing the rest merges everything back into one block */
+    for (int i = 1; i < count; i += 2) {
+        multi_heap_free(heap, p[i]);
+    }
+    REQUIRE( multi_heap_check(heap, true) );
+    multi_heap_get_fragmentation_info(heap, &frag);
+    REQUIRE( frag.free_blocks == 1 );
+    REQUIRE( frag.fragmentation == 0 );
+}
+
+/* Time malloc() and free() in a heap where a large number of small free blocks are left
+   between allocations, as happens after a while in applications with many short-lived buffers.
+   Run with both allocators (see test_all_configs.sh) to compare them.
+ */
+TEST_CASE("multi_heap fragmented heap allocation time", "[multi_heap][bench]")
+{
+    const size_t HEAP_SIZE = 512 * 1024;
+    const size_t NUM_BLOCKS = 4000;
+    const size_t ITERATIONS = 20000;
+    uint8_t *heapdata = new uint8_t[HEAP_SIZE];
+    void **blocks = new void *[NUM_BLOCKS];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, HEAP_SIZE);
+    REQUIRE( heap != NULL );
+
+    srand(42);
+    for (size_t i = 0; i < NUM_BLOCKS; i++) {
+        blocks[i] = multi_heap_malloc(heap, 8 + rand() % 64);
+        REQUIRE( blocks[i] != NULL );
+    }
+    /* every second block is freed, leaving NUM_BLOCKS / 2 free fragments which can't be merged */
+    for (size_t i = 0; i < NUM_BLOCKS; i += 2) {
+        multi_heap_free(heap, blocks[i]);
+        blocks[i] = NULL;
+    }
+    multi_heap_info_t info;
+    multi_heap_get_info(heap, &info);
+
+    std::chrono::steady_clock::duration malloc_time(0), free_time(0), malloc_max(0), free_max(0);
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        /* mostly requests which are larger than any fragment, so only the end of the heap can serve them */
+        size_t size = (i % 4 == 0) ? 8 + rand() % 64 : 100 + rand() % 400;
+        auto start = std::chrono::steady_clock::now();
+        void *p = multi_heap_malloc(heap, size);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        malloc_time += elapsed;
+        malloc_max = std::max(malloc_max, elapsed);
+        REQUIRE( p != NULL );
+
+        start = std::chrono::steady_clock::now();
+        multi_heap_free(heap, p);
+        elapsed = std::chrono::steady_clock::now() - start;
+        free_time += elapsed;
+        free_max = std::max(free_max, elapsed);
+    }
+    REQUIRE( multi_heap_check(heap, true) );
+
+    using std::chrono::nanoseconds;
+    using std::chrono::duration_cast;
+#ifdef MULTI_HEAP_TLSF
+    const char *allocator = "TLSF";
+#else
+    const char *allocator = "best fit";
+#endif
+    printf("%s allocator, %zu free blocks: malloc avg %lld ns max %lld ns, free avg %lld ns max %lld ns\n",
+           allocator, info.free_blocks,
+           (long long)duration_cast<nanoseconds>(malloc_time).count() / ITERATIONS,
+           (long long)duration_cast<nanoseconds>(malloc_max).count(),
+           (long long)duration_cast<nanoseconds>(free_time).count() / ITERATIONS,
+           (long long)duration_cast<nanoseconds>(free_max).count());
+
+    delete[] blocks;
+    delete[] heapdata;
+}
+
+/* Buffers which are grown by small steps while other blocks are allocated around them, as done by string builders,
+   cJSON printing and HTTP response assembly. Compares copying to a new block on every step with realloc() and with
+   trying multi_heap_try_expand() first.
+*/
+TEST_CASE("multi_heap repeated buffer growth", "[multi_heap][bench]")
+{
+    const size_t HEAP_SIZE = 128 * 1024;
+    const size_t FINAL_SIZE = 4096;
+    const size_t ROUNDS = 200;
+    const size_t MAX_OTHERS = FINAL_SIZE / 8 / 8 + 1;
+    const char *strategies[] = { "malloc/copy/free", "realloc", "try_expand, then realloc" };
+    uint8_t *heapdata = new uint8_t[HEAP_SIZE];
+    void **others = new void *[MAX_OTHERS];
+
+    for (int strategy = 0; strategy < 3; strategy++) {
+        multi_heap_handle_t heap = multi_heap_register(heapdata, HEAP_SIZE);
+        REQUIRE( heap != NULL );
+        srand(3);
+        /* some long lived blocks, as in a heap which has been in use for a while */
+        for (size_t i = 0; i < 100; i++) {
+            REQUIRE( multi_heap_malloc(heap, 8 + rand() % 200) != NULL );
+            void *gap = multi_heap_malloc(heap, 8 + rand() % 200);
+            REQUIRE( gap != NULL );
+            multi_heap_free(heap, gap);
+        }
+
+        /* REQUIRE is slow compared to the allocators, so failures are only counted in the timed loop */
+        size_t failed = 0;
+        size_t steps = 0;
+        size_t moves = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < ROUNDS; r++) {
+            uint8_t *buf = NULL;
+            size_t size = 0;
+            size_t num_others = 0;
+            while (size < FINAL_SIZE) {
+                size_t step = 8 + rand() % 64;
+                uint8_t *new_buf;
+                if (steps % 8 == 0 && num_others < MAX_OTHERS) {
+                    /* other code allocates meanwhile */
+                    others[num_others] = multi_heap_malloc(heap, 16 + rand() % 48);
+                    failed += (others[num_others] == NULL);
+                    num_others++;
+                }
+                if (strategy == 0) {
+                    new_buf = (uint8_t *)multi_heap_malloc(heap, size + step);
+                    if (new_buf != NULL && buf != NULL) {
+                        memcpy(new_buf, buf, size);
+                        multi_heap_free(heap, buf);
+                    }
+                } else if (strategy == 2 && buf != NULL && multi_heap_try_expand(heap, buf, size + step)) {
+                    new_buf = buf;
+                } else {
+                    new_buf = (uint8_t *)multi_heap_realloc(heap, buf, size + step);
+                }
+                if (new_buf == NULL) {
+                    failed++;
+                    break;
+                }
+                moves += (buf != NULL && new_buf != buf);
+                buf = new_buf;
+                memset(buf + size, r, step);
+                size += step;
+                steps++;
+            }
+            multi_heap_free(heap, buf);
+            for (size_t i = 0; i < num_others; i++) {
+                multi_heap_free(heap, others[i]);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE( failed == 0 );
+        REQUIRE( multi_heap_check(heap, true) );
+
+        using std::chrono::nanoseconds;
+        using std::chrono::duration_cast;
+#ifdef MULTI_HEAP_TLSF
+        const char *allocator = "TLSF";
+#else
+        const char *allocator = "best fit";
+#endif
+        printf("%s allocator, %s: %lld ns per growth step, buffer moved in %zu of %zu steps\n",
+               allocator, strategies[strategy],
+               (long long)duration_cast<nanoseconds>(elapsed).count() / steps, moves, steps);
+    }
+
+    delete[] others;
+    delete[] heapdata;
+}
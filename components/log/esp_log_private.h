@@ -1,6 +1,14 @@
 #pragma once
 #include <stdbool.h>
+#include <stdarg.h>
+#include "esp_log.h"
 
 void esp_log_impl_lock(void);
 bool esp_log_impl_lock_timeout(void);
 void esp_log_impl_unlock(void);
+
+vprintf_like_t esp_log_get_print_func(void);
+
+// Stores the message into the deferred log buffer, returns false if deferred logging isn't running
+bool esp_log_deferred_writev(const char *format, va_list args);
+
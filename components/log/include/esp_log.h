@@ -136,6 +136,34 @@ void esp_log_writev(esp_log_level_t level, const char* tag, const char* format,
 
 /** @cond */
 
+/**
+ * @brief Log level descriptor of a single ESP_LOGx call site
+ *
+ * Each ESP_LOGx statement has a static descriptor, placed into a .log_sites.*
+ * section. The first time the statement is executed, the descriptor is bound
+ * to the tag and stores the level set for it. After that, messages which are
+ * filtered out are discarded by the macro itself, without calling into the
+ * library or taking a lock. esp_log_level_set() updates the descriptors of
+ * the tag it is called for.
+ *
+ * Statements which are executed with different tags (e.g. in a function
+ * which gets the tag as an argument) use the descriptor for the first tag
+ * only, other tags are looked up as usual.
+ */
+typedef struct {
+    const char * volatile tag;  /*!< Tag the descriptor is bound to, NULL until the statement is executed */
+    volatile uint8_t level;     /*!< Level set for the tag, ESP_LOG_SITE_UNRESOLVED until the statement is executed */
+} esp_log_site_t;
+
+#define ESP_LOG_SITE_UNRESOLVED 0xFF
+
+/**
+ * @brief Write message into the log, using the call site descriptor to find the level for the tag
+ *
+ * This function is not intended to be used directly, it is called by ESP_LOGx macros.
+ */
+void esp_log_site_write(esp_log_site_t *site, esp_log_level_t level, const char* tag, const char* format, ...) __attribute__ ((format (printf, 4, 5)));
+
 #include "esp_log_internal.h"
 
 #ifndef LOG_LOCAL_LEVEL
@@ -269,6 +297,20 @@ void esp_log_writev(esp_log_level_t level, const char* tag, const char* format,
 #define LOG_RESET_COLOR
 #endif //CONFIG_LOG_COLORS
 
+#ifndef BOOTLOADER_BUILD
+/* Each descriptor gets a section of its own, as in C++ descriptors of inline functions are placed into COMDAT groups,
+   which can't share a section with other variables */
+#define ESP_LOG_SITE_SECTION(counter)   ESP_LOG_SITE_SECTION_(counter)
+#define ESP_LOG_SITE_SECTION_(counter)  ".log_sites." #counter
+#define ESP_LOG_SITE_DEFINE()   static esp_log_site_t _esp_log_site __attribute__((section(ESP_LOG_SITE_SECTION(__COUNTER__)))) = { NULL, ESP_LOG_SITE_UNRESOLVED }
+#define ESP_LOG_SITE_ENABLED(log_level, log_tag)    ((int) (log_level) <= (int) _esp_log_site.level || (const void *) _esp_log_site.tag != (const void *) (log_tag))
+#define ESP_LOG_SITE_WRITE(level, tag, format, ...) esp_log_site_write(&_esp_log_site, level, tag, format, ##__VA_ARGS__)
+#else
+#define ESP_LOG_SITE_DEFINE()   do {} while(0)
+#define ESP_LOG_SITE_ENABLED(log_level, log_tag)    1
+#define ESP_LOG_SITE_WRITE(level, tag, format, ...) esp_log_write(level, tag, format, ##__VA_ARGS__)
+#endif
+
 #define LOG_FORMAT(letter, format)  LOG_COLOR_ ## letter #letter " (%u) %s: " format LOG_RESET_COLOR "\n"
 #define LOG_SYSTEM_TIME_FORMAT(letter, format)  LOG_COLOR_ ## letter #letter " (%s) %s: " format LOG_RESET_COLOR "\n"
 
@@ -326,19 +368,23 @@ void esp_log_writev(esp_log_level_t level, const char* tag, const char* format,
  */
 #if CONFIG_LOG_TIMESTAMP_SOURCE_RTOS
 #define ESP_LOG_LEVEL(level, tag, format, ...) do {                     \
-        if (level==ESP_LOG_ERROR )          { esp_log_write(ESP_LOG_ERROR,      tag, LOG_FORMAT(E, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==ESP_LOG_WARN )      { esp_log_write(ESP_LOG_WARN,       tag, LOG_FORMAT(W, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==ESP_LOG_DEBUG )     { esp_log_write(ESP_LOG_DEBUG,      tag, LOG_FORMAT(D, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==ESP_LOG_VERBOSE )   { esp_log_write(ESP_LOG_VERBOSE,    tag, LOG_FORMAT(V, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
-        else                                { esp_log_write(ESP_LOG_INFO,       tag, LOG_FORMAT(I, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
+        ESP_LOG_SITE_DEFINE();                                          \
+        if (!ESP_LOG_SITE_ENABLED(level, tag))  { break; }              \
+        if (level==ESP_LOG_ERROR )          { ESP_LOG_SITE_WRITE(ESP_LOG_ERROR,      tag, LOG_FORMAT(E, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==ESP_LOG_WARN )      { ESP_LOG_SITE_WRITE(ESP_LOG_WARN,       tag, LOG_FORMAT(W, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==ESP_LOG_DEBUG )     { ESP_LOG_SITE_WRITE(ESP_LOG_DEBUG,      tag, LOG_FORMAT(D, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==ESP_LOG_VERBOSE )   { ESP_LOG_SITE_WRITE(ESP_LOG_VERBOSE,    tag, LOG_FORMAT(V, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
+        else                                { ESP_LOG_SITE_WRITE(ESP_LOG_INFO,       tag, LOG_FORMAT(I, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
     } while(0)
 #elif CONFIG_LOG_TIMESTAMP_SOURCE_SYSTEM
 #define ESP_LOG_LEVEL(level, tag, format, ...) do {                     \
-        if (level==ESP_LOG_ERROR )          { esp_log_write(ESP_LOG_ERROR,      tag, LOG_SYSTEM_TIME_FORMAT(E, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==ESP_LOG_WARN )      { esp_log_write(ESP_LOG_WARN,       tag, LOG_SYSTEM_TIME_FORMAT(W, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==ESP_LOG_DEBUG )     { esp_log_write(ESP_LOG_DEBUG,      tag, LOG_SYSTEM_TIME_FORMAT(D, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
-        else if (level==ESP_LOG_VERBOSE )   { esp_log_write(ESP_LOG_VERBOSE,    tag, LOG_SYSTEM_TIME_FORMAT(V, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
-        else                                { esp_log_write(ESP_LOG_INFO,       tag, LOG_SYSTEM_TIME_FORMAT(I, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
+        ESP_LOG_SITE_DEFINE();                                          \
+        if (!ESP_LOG_SITE_ENABLED(level, tag))  { break; }              \
+        if (level==ESP_LOG_ERROR )          { ESP_LOG_SITE_WRITE(ESP_LOG_ERROR,      tag, LOG_SYSTEM_TIME_FORMAT(E, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==ESP_LOG_WARN )      { ESP_LOG_SITE_WRITE(ESP_LOG_WARN,       tag, LOG_SYSTEM_TIME_FORMAT(W, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==ESP_LOG_DEBUG )     { ESP_LOG_SITE_WRITE(ESP_LOG_DEBUG,      tag, LOG_SYSTEM_TIME_FORMAT(D, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
+        else if (level==ESP_LOG_VERBOSE )   { ESP_LOG_SITE_WRITE(ESP_LOG_VERBOSE,    tag, LOG_SYSTEM_TIME_FORMAT(V, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
+        else                                { ESP_LOG_SITE_WRITE(ESP_LOG_INFO,       tag, LOG_SYSTEM_TIME_FORMAT(I, format), esp_log_system_timestamp(), tag, ##__VA_ARGS__); } \
     } while(0)
 #endif //CONFIG_LOG_TIMESTAMP_SOURCE_xxx
 
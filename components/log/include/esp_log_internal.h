@@ -20,5 +20,8 @@ void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t b
 void esp_log_buffer_char_internal(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level);
 void esp_log_buffer_hexdump_internal( const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t log_level);
 
+//starts the task which outputs deferred log messages (CONFIG_LOG_DEFERRED), called from startup code
+void esp_log_deferred_init(void);
+
 #endif
 
@@ -29,6 +29,15 @@
  * After that, bubble-down operation is performed to fix ordering in the
  * min-heap.
  *
+ * On top of that, each ESP_LOGx statement has an esp_log_site_t descriptor
+ * (see esp_log.h), which remembers the level of the first tag it has been
+ * used with. The descriptors are placed into .log_sites.* sections, which
+ * the linker puts together (discarding the ones of functions removed by
+ * --gc-sections), so esp_log_level_set can walk all of them and
+ * update the level of the ones bound to the tag being changed. This lets the
+ * macros discard filtered out messages without calling into this library,
+ * and messages which are output don't need to look up the level in the cache.
+ *
  * The potential problem with wrap-around of cache generation counter is
  * ignored for now. This will happen if someone happens to output more
  * than 4 billion log entries, at which point wrap-around will not be
@@ -80,6 +89,12 @@ static vprintf_like_t s_log_print_func = &vprintf;
 static uint32_t s_log_cache_misses = 0;
 #endif
 
+#ifndef BOOTLOADER_BUILD
+// Bounds of .log_sites.* sections, defined in the linker script
+extern esp_log_site_t _log_sites_start[];
+extern esp_log_site_t _log_sites_end[];
+#endif
+
 
 static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level);
 static inline bool get_uncached_log_level(const char *tag, esp_log_level_t *level);
@@ -88,6 +103,9 @@ static void heap_bubble_down(int index);
 static inline void heap_swap(int i, int j);
 static inline bool should_output(esp_log_level_t level_for_message, esp_log_level_t level_for_tag);
 static inline void clear_log_level_list(void);
+static void update_log_sites(const char *tag, esp_log_level_t level);
+static esp_log_level_t get_log_level(const char *tag);
+static void output_log(const char *format, va_list args);
 
 vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
 {
@@ -98,6 +116,11 @@ vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
     return orig_func;
 }
 
+vprintf_like_t esp_log_get_print_func(void)
+{
+    return s_log_print_func;
+}
+
 void esp_log_level_set(const char *tag, esp_log_level_t level)
 {
     esp_log_impl_lock();
@@ -106,6 +129,7 @@ void esp_log_level_set(const char *tag, esp_log_level_t level)
     if (strcmp(tag, "*") == 0) {
         s_log_default_level = level;
         clear_log_level_list();
+        update_log_sites(NULL, level);
         esp_log_impl_unlock();
         return;
     }
@@ -145,6 +169,7 @@ void esp_log_level_set(const char *tag, esp_log_level_t level)
             break;
         }
     }
+    update_log_sites(tag, level);
     esp_log_impl_unlock();
 }
 
@@ -170,24 +195,44 @@ void esp_log_writev(esp_log_level_t level,
     if (!esp_log_impl_lock_timeout()) {
         return;
     }
+    esp_log_level_t level_for_tag = get_log_level(tag);
+    esp_log_impl_unlock();
+    if (!should_output(level, level_for_tag)) {
+        return;
+    }
+
+    output_log(format, args);
+}
+
+void esp_log_site_write(esp_log_site_t *site,
+                        esp_log_level_t level,
+                        const char *tag,
+                        const char *format, ...)
+{
     esp_log_level_t level_for_tag;
-    // Look for the tag in cache first, then in the linked list of all tags
-    if (!get_cached_log_level(tag, &level_for_tag)) {
-        if (!get_uncached_log_level(tag, &level_for_tag)) {
-            level_for_tag = s_log_default_level;
+    uint8_t site_level = site->level;
+    if (site->tag == tag && site_level != ESP_LOG_SITE_UNRESOLVED) {
+        level_for_tag = (esp_log_level_t) site_level;
+    } else {
+        if (!esp_log_impl_lock_timeout()) {
+            return;
         }
-        add_to_cache(tag, level_for_tag);
-#ifdef LOG_BUILTIN_CHECKS
-        ++s_log_cache_misses;
-#endif
+        level_for_tag = get_log_level(tag);
+        // Bind the descriptor to the first tag it is used with
+        if (site->tag == NULL) {
+            site->tag = tag;
+            site->level = level_for_tag;
+        }
+        esp_log_impl_unlock();
     }
-    esp_log_impl_unlock();
     if (!should_output(level, level_for_tag)) {
         return;
     }
 
-    (*s_log_print_func)(format, args);
-
+    va_list list;
+    va_start(list, format);
+    output_log(format, list);
+    va_end(list);
 }
 
 void esp_log_write(esp_log_level_t level,
@@ -200,6 +245,47 @@ void esp_log_write(esp_log_level_t level,
     va_end(list);
 }
 
+// Returns the level for 'tag', must be called with the lock held
+static esp_log_level_t get_log_level(const char *tag)
+{
+    esp_log_level_t level_for_tag;
+    // Look for the tag in cache first, then in the linked list of all tags
+    if (!get_cached_log_level(tag, &level_for_tag)) {
+        if (!get_uncached_log_level(tag, &level_for_tag)) {
+            level_for_tag = s_log_default_level;
+        }
+        add_to_cache(tag, level_for_tag);
+#ifdef LOG_BUILTIN_CHECKS
+        ++s_log_cache_misses;
+#endif
+    }
+    return level_for_tag;
+}
+
+static void output_log(const char *format, va_list args)
+{
+#if CONFIG_LOG_DEFERRED && !defined(BOOTLOADER_BUILD)
+    if (esp_log_deferred_writev(format, args)) {
+        return;
+    }
+#endif
+    (*s_log_print_func)(format, args);
+}
+
+// Sets the level of call site descriptors bound to 'tag', or of all descriptors if 'tag' is NULL.
+// Must be called with the lock held.
+static void update_log_sites(const char *tag, esp_log_level_t level)
+{
+#ifndef BOOTLOADER_BUILD
+    for (esp_log_site_t *site = _log_sites_start; site < _log_sites_end; ++site) {
+        const char *site_tag = site->tag;
+        if (site_tag != NULL && (tag == NULL || strcmp(site_tag, tag) == 0)) {
+            site->level = level;
+        }
+    }
+#endif
+}
+
 static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level)
 {
     // Look for `tag` in cache
@@ -101,6 +101,9 @@ void esp_log_buffer_hexdump_internal(const char *tag, const void *buffer, uint16
     //format: field[length]
     // ADDR[10]+"   "+DATA_HEX[8*3]+" "+DATA_HEX[8*3]+"  |"+DATA_CHAR[8]+"|"
     char hd_buffer[10 + 3 + BYTES_PER_LINE * 3 + 3 + BYTES_PER_LINE + 1 + 1];
+#if CONFIG_LOG_DEFERRED
+    _Static_assert(sizeof(hd_buffer) <= CONFIG_LOG_DEFERRED_MAX_STRING_LEN + 1, "Deferred logging would truncate hex dump lines");
+#endif
     char *ptr_hd;
     int bytes_cur_line;
 
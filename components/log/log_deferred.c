@@ -0,0 +1,435 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Deferred logging implementation notes.
+ *
+ * Instead of formatting the message in the context of the caller,
+ * esp_log_deferred_writev stores a record into a ring buffer, and a low
+ * priority task formats and outputs the records later.
+ *
+ * A record consists of the format string pointer followed by the raw
+ * values of the arguments. va_list can't be copied into a buffer as is
+ * (its layout depends on the ABI, and on Xtensa arguments may live in
+ * registers saved in different places), so the format string is scanned
+ * to find out the type of each argument. Integers, floating point values
+ * and pointers are stored with memcpy, strings ("%s") are copied into the
+ * record because they may no longer be valid when the record is output.
+ * The format string itself is assumed to stay valid, which is the case for
+ * string literals passed to ESP_LOGx macros.
+ *
+ * When the record is output, the format string is scanned again and each
+ * conversion is formatted with snprintf using the stored value.
+ *
+ * Records are stored in a multi-producer ring buffer, so tasks on both
+ * cores can fill their records at the same time. Storing a record takes
+ * the ring buffer spinlock twice (to reserve the space and to commit it)
+ * and never blocks. If the record doesn't fit into the free space of the
+ * buffer, the message is dropped and the number of dropped messages is
+ * reported with the next message which is output.
+ */
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// Maximum length of a single conversion specification, e.g. "%-08.3llx"
+#define SPEC_MAX_LEN 24
+// Size of the buffer a record is formatted into, longer lines are truncated
+#define LINE_MAX_LEN 256
+
+typedef enum {
+    ARG_NONE,       // "%%" and unknown conversions, nothing is stored
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_PTR,
+    ARG_STR,
+} arg_type_t;
+
+typedef struct {
+    const char *start;      // points to '%'
+    const char *end;        // points past the conversion character
+    arg_type_t type;
+    bool width_arg;         // width is given by an int argument ('*')
+    bool precision_arg;     // precision is given by an int argument (".*")
+} conv_spec_t;
+
+typedef struct {
+    const char *format;
+    uint8_t args[0];
+} log_record_t;
+
+static const char *TAG = "log";
+
+static RingbufHandle_t s_log_ringbuf = NULL;
+static uint32_t s_log_dropped = 0;
+
+static const char *parse_spec(const char *p, conv_spec_t *spec);
+static size_t encode_args(uint8_t *dst, const char *format, va_list args);
+static void decode_record(const log_record_t *record, char *line, size_t line_size);
+static int print_line(vprintf_like_t func, const char *format, ...);
+static void log_deferred_task(void *arg);
+
+void esp_log_deferred_init(void)
+{
+    RingbufHandle_t ringbuf = xRingbufferCreate(CONFIG_LOG_DEFERRED_BUFFER_SIZE, RINGBUF_TYPE_MULTI_PRODUCER);
+    if (ringbuf == NULL) {
+        ESP_EARLY_LOGE(TAG, "Failed to create deferred log buffer, logging synchronously");
+        return;
+    }
+    if (xTaskCreatePinnedToCore(&log_deferred_task, "log", CONFIG_LOG_DEFERRED_TASK_STACK_SIZE, ringbuf,
+                                CONFIG_LOG_DEFERRED_TASK_PRIORITY, NULL, tskNO_AFFINITY) != pdTRUE) {
+        ESP_EARLY_LOGE(TAG, "Failed to create deferred log task, logging synchronously");
+        vRingbufferDelete(ringbuf);
+        return;
+    }
+    s_log_ringbuf = ringbuf;
+}
+
+bool esp_log_deferred_writev(const char *format, va_list args)
+{
+    if (s_log_ringbuf == NULL) {
+        return false;
+    }
+    va_list args_copy;
+    va_copy(args_copy, args);
+    size_t size = offsetof(log_record_t, args) + encode_args(NULL, format, args_copy);
+    va_end(args_copy);
+
+    // The FromISR variants only take the ring buffer spinlock. The task variants would also take the
+    // semaphore which serializes the writers, and with no timeout to wait for it, a message would be
+    // dropped whenever another task is storing its record, even if the buffer is almost empty.
+    BaseType_t woken = pdFALSE;
+    log_record_t *record;
+    if (xRingbufferSendAcquireFromISR(s_log_ringbuf, (void **) &record, size, &woken) != pdTRUE) {
+        __atomic_fetch_add(&s_log_dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+    record->format = format;
+    va_copy(args_copy, args);
+    encode_args(record->args, format, args_copy);
+    va_end(args_copy);
+    xRingbufferSendCompleteFromISR(s_log_ringbuf, record, &woken);
+    if (woken == pdTRUE && !xPortInIsrContext()) {
+        portYIELD();
+    }
+    return true;
+}
+
+static void log_deferred_task(void *arg)
+{
+    RingbufHandle_t ringbuf = (RingbufHandle_t) arg;
+    static char line[LINE_MAX_LEN];
+
+    while (true) {
+        size_t size;
+        log_record_t *record = (log_record_t *) xRingbufferReceive(ringbuf, &size, portMAX_DELAY);
+        if (record == NULL) {
+            continue;
+        }
+        decode_record(record, line, sizeof(line));
+        vRingbufferReturnItem(ringbuf, record);
+
+        vprintf_like_t func = esp_log_get_print_func();
+        uint32_t dropped = __atomic_exchange_n(&s_log_dropped, 0, __ATOMIC_RELAXED);
+        if (dropped != 0) {
+            print_line(func, LOG_FORMAT(W, "%u messages dropped"), esp_log_timestamp(), TAG, dropped);
+        }
+        print_line(func, "%s", line);
+    }
+}
+
+static int print_line(vprintf_like_t func, const char *format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    int ret = (*func)(format, list);
+    va_end(list);
+    return ret;
+}
+
+static const char *parse_spec(const char *p, conv_spec_t *spec)
+{
+    spec->start = p++;
+    spec->width_arg = false;
+    spec->precision_arg = false;
+
+    // flags
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+        ++p;
+    }
+    // width
+    if (*p == '*') {
+        spec->width_arg = true;
+        ++p;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            ++p;
+        }
+    }
+    // precision
+    if (*p == '.') {
+        ++p;
+        if (*p == '*') {
+            spec->precision_arg = true;
+            ++p;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                ++p;
+            }
+        }
+    }
+    // length modifier
+    arg_type_t int_type = ARG_INT;
+    bool long_double = false;
+    if (*p == 'h') {
+        p += (p[1] == 'h') ? 2 : 1;
+    } else if (*p == 'l') {
+        if (p[1] == 'l') {
+            int_type = ARG_LLONG;
+            p += 2;
+        } else {
+            int_type = ARG_LONG;
+            p += 1;
+        }
+    } else if (*p == 'j') {
+        int_type = ARG_INTMAX;
+        ++p;
+    } else if (*p == 'z') {
+        int_type = ARG_SIZE;
+        ++p;
+    } else if (*p == 't') {
+        int_type = ARG_PTRDIFF;
+        ++p;
+    } else if (*p == 'L') {
+        long_double = true;
+        ++p;
+    }
+    // conversion
+    switch (*p) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+        spec->type = int_type;
+        break;
+    case 'c':
+        spec->type = ARG_INT;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        spec->type = long_double ? ARG_LDOUBLE : ARG_DOUBLE;
+        break;
+    case 'p':
+        spec->type = ARG_PTR;
+        break;
+    case 's':
+        spec->type = ARG_STR;
+        break;
+    case 'n':
+        // consumes a pointer argument, but nothing gets written back
+        spec->type = ARG_PTR;
+        break;
+    case '\0':
+        // incomplete specification at the end of the format string
+        spec->type = ARG_NONE;
+        spec->end = p;
+        return p;
+    default:
+        spec->type = ARG_NONE;
+        break;
+    }
+    spec->end = p + 1;
+    return spec->end;
+}
+
+#define ENCODE_ARG(type) do {                       \
+        type value = va_arg(args, type);            \
+        if (dst != NULL) {                          \
+            memcpy(dst + size, &value, sizeof(value)); \
+        }                                           \
+        size += sizeof(value);                      \
+    } while(0)
+
+/* Stores the arguments described by 'format' at 'dst', or only counts the
+ * number of bytes needed if 'dst' is NULL. Returns the number of bytes.
+ */
+static size_t encode_args(uint8_t *dst, const char *format, va_list args)
+{
+    size_t size = 0;
+    const char *p = format;
+    while ((p = strchr(p, '%')) != NULL) {
+        conv_spec_t spec;
+        p = parse_spec(p, &spec);
+        if (spec.width_arg) {
+            ENCODE_ARG(int);
+        }
+        if (spec.precision_arg) {
+            ENCODE_ARG(int);
+        }
+        switch (spec.type) {
+        case ARG_NONE:
+            break;
+        case ARG_INT:
+            ENCODE_ARG(int);
+            break;
+        case ARG_LONG:
+            ENCODE_ARG(long);
+            break;
+        case ARG_LLONG:
+            ENCODE_ARG(long long);
+            break;
+        case ARG_INTMAX:
+            ENCODE_ARG(intmax_t);
+            break;
+        case ARG_SIZE:
+            ENCODE_ARG(size_t);
+            break;
+        case ARG_PTRDIFF:
+            ENCODE_ARG(ptrdiff_t);
+            break;
+        case ARG_DOUBLE:
+            ENCODE_ARG(double);
+            break;
+        case ARG_LDOUBLE:
+            ENCODE_ARG(long double);
+            break;
+        case ARG_PTR:
+            ENCODE_ARG(void *);
+            break;
+        case ARG_STR: {
+            const char *str = va_arg(args, const char *);
+            if (str == NULL) {
+                str = "(null)";
+            }
+            size_t len = strnlen(str, CONFIG_LOG_DEFERRED_MAX_STRING_LEN);
+            if (dst != NULL) {
+                memcpy(dst + size, str, len);
+                dst[size + len] = '\0';
+            }
+            size += len + 1;
+            break;
+        }
+        }
+    }
+    return size;
+}
+
+#define DECODE_ARG(type) do {                       \
+        type value;                                 \
+        memcpy(&value, args, sizeof(value));        \
+        args += sizeof(value);                      \
+        len = snprintf(out, out_end - out, conv, value); \
+    } while(0)
+
+static void decode_record(const log_record_t *record, char *line, size_t line_size)
+{
+    const uint8_t *args = record->args;
+    char *out = line;
+    char *out_end = line + line_size;
+    const char *p = record->format;
+
+    while (*p != '\0' && out < out_end - 1) {
+        const char *next = strchr(p, '%');
+        size_t literal_len = (next != NULL) ? (size_t) (next - p) : strlen(p);
+        if (literal_len > 0) {
+            if (literal_len > (size_t) (out_end - out - 1)) {
+                literal_len = out_end - out - 1;
+            }
+            memcpy(out, p, literal_len);
+            out += literal_len;
+            p += literal_len;
+            continue;
+        }
+
+        conv_spec_t spec;
+        p = parse_spec(p, &spec);
+        // Copy the specification, replacing '*' with the stored width or precision
+        char conv[SPEC_MAX_LEN];
+        size_t conv_len = 0;
+        for (const char *c = spec.start; c < spec.end && conv_len < sizeof(conv) - 12; ++c) {
+            if (*c == '*') {
+                int value;
+                memcpy(&value, args, sizeof(value));
+                args += sizeof(value);
+                conv_len += snprintf(conv + conv_len, sizeof(conv) - conv_len, "%d", value);
+            } else {
+                conv[conv_len++] = *c;
+            }
+        }
+        conv[conv_len] = '\0';
+
+        int len = 0;
+        switch (spec.type) {
+        case ARG_NONE:
+            if (spec.end[-1] == '%') {
+                len = snprintf(out, out_end - out, "%%");
+            }
+            break;
+        case ARG_INT:
+            DECODE_ARG(int);
+            break;
+        case ARG_LONG:
+            DECODE_ARG(long);
+            break;
+        case ARG_LLONG:
+            DECODE_ARG(long long);
+            break;
+        case ARG_INTMAX:
+            DECODE_ARG(intmax_t);
+            break;
+        case ARG_SIZE:
+            DECODE_ARG(size_t);
+            break;
+        case ARG_PTRDIFF:
+            DECODE_ARG(ptrdiff_t);
+            break;
+        case ARG_DOUBLE:
+            DECODE_ARG(double);
+            break;
+        case ARG_LDOUBLE:
+            DECODE_ARG(long double);
+            break;
+        case ARG_PTR:
+            if (spec.end[-1] == 'n') {
+                args += sizeof(void *);
+            } else {
+                DECODE_ARG(void *);
+            }
+            break;
+        case ARG_STR:
+            len = snprintf(out, out_end - out, conv, (const char *) args);
+            args += strlen((const char *) args) + 1;
+            break;
+        }
+        if (len > 0) {
+            out += (len < out_end - out) ? len : out_end - out - 1;
+        }
+    }
+    *out = '\0';
+    // Keep the line terminated if it had to be truncated
+    if (*p != '\0' && out > line) {
+        out[-1] = '\n';
+    }
+}
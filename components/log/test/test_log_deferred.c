@@ -0,0 +1,287 @@
+/*
+ Tests for deferred logging
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <string.h>
+#include "unity.h"
+#include "test_utils.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define LINE_LEN    256
+
+static const char *TAG = "log_deferred";
+
+#if CONFIG_LOG_DEFERRED
+
+static QueueHandle_t s_lines;
+static vprintf_like_t s_orig_func;
+
+/*
+ * Output function which passes each line to the test through a queue.
+ * With deferred logging, it is called by the log task, which blocks here
+ * while the queue is full.
+ */
+static int capture_line(const char *format, va_list args)
+{
+    char line[LINE_LEN];
+    int len = vsnprintf(line, sizeof(line), format, args);
+    xQueueSend(s_lines, line, portMAX_DELAY);
+    return len;
+}
+
+// Returns false if the log task hasn't output a line within the timeout
+static bool receive_line(char *line, TickType_t timeout)
+{
+    return xQueueReceive(s_lines, line, timeout) == pdTRUE;
+}
+
+static void start_capture(size_t queue_len)
+{
+    s_lines = xQueueCreate(queue_len, LINE_LEN);
+    TEST_ASSERT_NOT_NULL(s_lines);
+    esp_log_level_set(TAG, ESP_LOG_VERBOSE);
+    s_orig_func = esp_log_set_vprintf(capture_line);
+
+    // Skip the lines of earlier messages which were still in the buffer
+    char line[LINE_LEN];
+    esp_log_write(ESP_LOG_INFO, TAG, "start");
+    do {
+        TEST_ASSERT(receive_line(line, 1000 / portTICK_PERIOD_MS));
+    } while (strcmp(line, "start") != 0);
+}
+
+static void stop_capture(void)
+{
+    // Let the log task finish the line it may be blocked on
+    char line[LINE_LEN];
+    esp_log_write(ESP_LOG_INFO, TAG, "stop");
+    do {
+        TEST_ASSERT(receive_line(line, 1000 / portTICK_PERIOD_MS));
+    } while (strcmp(line, "stop") != 0);
+    esp_log_set_vprintf(s_orig_func);
+    vQueueDelete(s_lines);
+}
+
+// Returns the number of dropped messages if 'line' reports them, or -1
+static int parse_dropped_line(const char *line)
+{
+    unsigned dropped;
+    const char *p = strstr(line, "log: ");
+    if (p == NULL || sscanf(p, "log: %u messages dropped", &dropped) != 1) {
+        return -1;
+    }
+    return dropped;
+}
+
+/*
+ * Check that a message output by the log task is the same as the message
+ * formatted by vsnprintf.
+ */
+static void check_format(const char *format, ...)
+{
+    char expected[LINE_LEN];
+    char line[LINE_LEN];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(expected, sizeof(expected), format, args);
+    va_end(args);
+    va_start(args, format);
+    esp_log_writev(ESP_LOG_INFO, TAG, format, args);
+    va_end(args);
+    TEST_ASSERT(receive_line(line, 1000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_EQUAL_STRING(expected, line);
+}
+
+TEST_CASE("deferred log messages are formatted like vsnprintf", "[log]")
+{
+    start_capture(1);
+    check_format("no conversions");
+    check_format("%d %i %u %x %X %o %c", -42, 42, 42u, 0xbeef, 0xbeef, 8, 'z');
+    check_format("flags %-6d| %+d %05d % d %#x %#o", 7, 7, -7, 7, 255, 8);
+    check_format("width %*d precision %.*d both %*.*d", 8, 1, 4, 2, -6, 3, 5);
+    check_format("%% and %d%% and %%%s", 50, "done");
+    check_format("%hhd %hd %ld %lu", (signed char) -1, (short) -300, -100000L, 4000000000UL);
+    check_format("%lld %llu %llx", -1234567890123LL, 18446744073709551615ULL, 0x123456789abcdefULL);
+    check_format("%zu %zd %jd %ju %td", (size_t) 12345, (ssize_t) -5, (intmax_t) -99, (uintmax_t) 99, (ptrdiff_t) -3);
+    check_format("%f %.2f %e %g %10.3f %-8.1f|", 3.14159, 2.5, 12345.678, 0.0001, -1.5, 1.25);
+    check_format("%p %s", (void *) 0x3ffb0000, "after pointer");
+    check_format("%s|%10s|%-10s|%.3s", "str", "right", "left", "truncated");
+    check_format("null %s end", (const char *) NULL);
+    check_format("mixed %s %lld %f %s %zu", "a", 1LL << 40, 0.5, "b", (size_t) 7);
+    stop_capture();
+}
+
+TEST_CASE("deferred log keeps hex dump lines", "[log]")
+{
+    // Longest line output by ESP_LOG_BUFFER_HEXDUMP()
+    char hd_line[81];
+    memset(hd_line, 'x', sizeof(hd_line) - 1);
+    hd_line[sizeof(hd_line) - 1] = '\0';
+    start_capture(1);
+    check_format("%s", hd_line);
+    stop_capture();
+}
+
+TEST_CASE("deferred log reports dropped messages", "[log]")
+{
+    // Every record takes at least 16 bytes, so this is twice what fits into the buffer
+    const int count = CONFIG_LOG_DEFERRED_BUFFER_SIZE / 8;
+    // The log task blocks on the second line until the test starts reading
+    start_capture(1);
+    for (int i = 0; i < count; i++) {
+        esp_log_write(ESP_LOG_INFO, TAG, "msg %d", i);
+    }
+
+    char line[LINE_LEN];
+    int received = 0;
+    int dropped = -1;
+    int received_after_report = 0;
+    while (receive_line(line, 100 / portTICK_PERIOD_MS)) {
+        int n = parse_dropped_line(line);
+        if (n >= 0) {
+            // All messages were dropped while the log task was blocked, so they are reported once
+            TEST_ASSERT_EQUAL(-1, dropped);
+            dropped = n;
+            continue;
+        }
+        // Messages which were stored are output in order, the ones which didn't fit are missing at the end
+        int index = -1;
+        sscanf(line, "msg %d", &index);
+        TEST_ASSERT_EQUAL(received, index);
+        received++;
+        if (dropped >= 0) {
+            received_after_report++;
+        }
+    }
+    printf("%d messages output, %d dropped\n", received, dropped);
+    TEST_ASSERT_GREATER_THAN(0, dropped);
+    TEST_ASSERT_EQUAL(count, received + dropped);
+    // The number of dropped messages is output before the next message
+    TEST_ASSERT_GREATER_THAN(0, received_after_report);
+    stop_capture();
+}
+
+#if !CONFIG_FREERTOS_UNICORE
+#define CPU_MESSAGES 20
+
+typedef struct {
+    int cpu;
+    SemaphoreHandle_t start;
+    SemaphoreHandle_t done;
+} log_task_arg_t;
+
+static void log_from_cpu_task(void *param)
+{
+    log_task_arg_t *arg = (log_task_arg_t *)param;
+    xSemaphoreTake(arg->start, portMAX_DELAY);
+    for (int i = 0; i < CPU_MESSAGES; i++) {
+        esp_log_write(ESP_LOG_INFO, TAG, "cpu%d %d", arg->cpu, i);
+    }
+    xSemaphoreGive(arg->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("deferred log doesn't drop messages logged from both CPUs", "[log]")
+{
+    // The records of both tasks take less than 1 kB, so they fit into the buffer even while the log task is blocked
+    start_capture(1);
+    SemaphoreHandle_t start = xSemaphoreCreateCounting(2, 0);
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(2, 0);
+    log_task_arg_t args[2] = {
+        { .cpu = 0, .start = start, .done = done },
+        { .cpu = 1, .start = start, .done = done },
+    };
+    for (int i = 0; i < 2; i++) {
+        xTaskCreatePinnedToCore(log_from_cpu_task, "log_from_cpu", 2048, &args[i], UNITY_FREERTOS_PRIORITY + 1, NULL, i);
+    }
+    xSemaphoreGive(start);
+    xSemaphoreGive(start);
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(xSemaphoreTake(done, 1000 / portTICK_PERIOD_MS));
+    }
+
+    char line[LINE_LEN];
+    int next[2] = { 0, 0 };
+    while (receive_line(line, 100 / portTICK_PERIOD_MS)) {
+        TEST_ASSERT_EQUAL_MESSAGE(-1, parse_dropped_line(line), line);
+        int cpu = -1;
+        int index = -1;
+        TEST_ASSERT_EQUAL(2, sscanf(line, "cpu%d %d", &cpu, &index));
+        TEST_ASSERT(cpu == 0 || cpu == 1);
+        TEST_ASSERT_EQUAL(next[cpu], index);
+        next[cpu]++;
+    }
+    TEST_ASSERT_EQUAL(CPU_MESSAGES, next[0]);
+    TEST_ASSERT_EQUAL(CPU_MESSAGES, next[1]);
+    vSemaphoreDelete(start);
+    vSemaphoreDelete(done);
+    stop_capture();
+}
+#endif // !CONFIG_FREERTOS_UNICORE
+
+#endif // CONFIG_LOG_DEFERRED
+
+#define BENCH_BURSTS 40
+#define BENCH_BURST_LEN 16
+
+// Output function for the benchmark, formats the line like vprintf would but doesn't output it
+static int format_line(const char *format, va_list args)
+{
+    char line[LINE_LEN];
+    return vsnprintf(line, sizeof(line), format, args);
+}
+
+static int call_format_line(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int ret = format_line(format, args);
+    va_end(args);
+    return ret;
+}
+
+TEST_CASE("performance test - esp_log_write", "[log]")
+{
+    esp_log_level_set(TAG, ESP_LOG_VERBOSE);
+    vprintf_like_t orig_func = esp_log_set_vprintf(format_line);
+
+    // Log in bursts which fit into the deferred log buffer, so that no message is dropped
+    int64_t log_time = 0;
+    int64_t format_time = 0;
+    for (int burst = 0; burst < BENCH_BURSTS; burst++) {
+        vTaskDelay(2);  // Let the log task output the previous burst
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < BENCH_BURST_LEN; i++) {
+            esp_log_write(ESP_LOG_INFO, TAG, "I (%d) %s: value %08x\n", i, TAG, i * 7);
+        }
+        log_time += esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < BENCH_BURST_LEN; i++) {
+            call_format_line("I (%d) %s: value %08x\n", i, TAG, i * 7);
+        }
+        format_time += esp_timer_get_time() - start;
+    }
+    vTaskDelay(2);
+    esp_log_set_vprintf(orig_func);
+
+    const int calls = BENCH_BURSTS * BENCH_BURST_LEN;
+#if CONFIG_LOG_DEFERRED
+    const char *mode = "deferred";
+#else
+    const char *mode = "text";
+#endif
+    printf("esp_log_write (%s mode): %lld ns per call, formatting the line: %lld ns per call\n",
+           mode, log_time * 1000 / calls, format_time * 1000 / calls);
+}
@@ -0,0 +1,147 @@
+/*
+ Tests for ESP_LOGx call site descriptors
+*/
+
+#define LOG_LOCAL_LEVEL ESP_LOG_VERBOSE
+
+#include <stdio.h>
+#include <stdarg.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+static const char *TAG_A = "log_sites_a";
+static const char *TAG_B = "log_sites_b";
+
+static volatile int s_output_count;
+
+// Implemented in test_log_sites_cxx.cpp, logs once from an inline function and once from a normal one
+void test_log_sites_cxx(const char *tag);
+
+static int count_output(const char *format, va_list args)
+{
+    s_output_count++;
+    return 0;
+}
+
+// Returns the number of messages output since the last call
+static int take_output_count(void)
+{
+#if CONFIG_LOG_DEFERRED
+    vTaskDelay(10);     // Let the log task output the messages
+#endif
+    int count = s_output_count;
+    s_output_count = 0;
+    return count;
+}
+
+// Each of these functions is a single call site
+static void log_info(const char *tag)
+{
+    ESP_LOGI(tag, "info");
+}
+
+static void log_debug(const char *tag)
+{
+    ESP_LOGD(tag, "debug");
+}
+
+static void log_info_shared(const char *tag)
+{
+    ESP_LOGI(tag, "shared");
+}
+
+static vprintf_like_t start_counting(void)
+{
+    take_output_count();
+    vprintf_like_t orig_func = esp_log_set_vprintf(&count_output);
+    s_output_count = 0;
+    return orig_func;
+}
+
+static void stop_counting(vprintf_like_t orig_func)
+{
+    take_output_count();
+    esp_log_set_vprintf(orig_func);
+    esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+}
+
+TEST_CASE("log call site filters out messages once bound", "[log]")
+{
+    vprintf_like_t orig_func = start_counting();
+    esp_log_level_set(TAG_A, ESP_LOG_INFO);
+
+    for (int i = 0; i < 3; i++) {
+        log_debug(TAG_A);
+        TEST_ASSERT_EQUAL(0, take_output_count());
+        log_info(TAG_A);
+        TEST_ASSERT_EQUAL(1, take_output_count());
+    }
+    stop_counting(orig_func);
+}
+
+TEST_CASE("log level changes update bound call sites", "[log]")
+{
+    vprintf_like_t orig_func = start_counting();
+    esp_log_level_set(TAG_A, ESP_LOG_INFO);
+    log_debug(TAG_A);
+    log_info(TAG_A);
+    TEST_ASSERT_EQUAL(1, take_output_count());
+
+    esp_log_level_set(TAG_A, ESP_LOG_DEBUG);
+    log_debug(TAG_A);
+    TEST_ASSERT_EQUAL(1, take_output_count());
+
+    esp_log_level_set(TAG_A, ESP_LOG_WARN);
+    log_debug(TAG_A);
+    log_info(TAG_A);
+    TEST_ASSERT_EQUAL(0, take_output_count());
+
+    esp_log_level_set("*", ESP_LOG_VERBOSE);
+    log_debug(TAG_A);
+    log_info(TAG_A);
+    TEST_ASSERT_EQUAL(2, take_output_count());
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    log_debug(TAG_A);
+    log_info(TAG_A);
+    TEST_ASSERT_EQUAL(0, take_output_count());
+    stop_counting(orig_func);
+}
+
+TEST_CASE("log call site used with two tags", "[log]")
+{
+    vprintf_like_t orig_func = start_counting();
+    esp_log_level_set(TAG_A, ESP_LOG_WARN);
+    esp_log_level_set(TAG_B, ESP_LOG_INFO);
+
+    log_info_shared(TAG_A);     // binds the call site to TAG_A
+    TEST_ASSERT_EQUAL(0, take_output_count());
+    log_info_shared(TAG_B);
+    TEST_ASSERT_EQUAL(1, take_output_count());
+    log_info_shared(TAG_A);
+    TEST_ASSERT_EQUAL(0, take_output_count());
+
+    esp_log_level_set(TAG_A, ESP_LOG_INFO);
+    esp_log_level_set(TAG_B, ESP_LOG_WARN);
+    log_info_shared(TAG_A);
+    TEST_ASSERT_EQUAL(1, take_output_count());
+    log_info_shared(TAG_B);
+    TEST_ASSERT_EQUAL(0, take_output_count());
+    stop_counting(orig_func);
+}
+
+TEST_CASE("log call sites in C++ inline functions", "[log]")
+{
+    vprintf_like_t orig_func = start_counting();
+    esp_log_level_set(TAG_A, ESP_LOG_INFO);
+    test_log_sites_cxx(TAG_A);
+    TEST_ASSERT_EQUAL(2, take_output_count());
+
+    esp_log_level_set(TAG_A, ESP_LOG_WARN);
+    test_log_sites_cxx(TAG_A);
+    TEST_ASSERT_EQUAL(0, take_output_count());
+    stop_counting(orig_func);
+}
@@ -0,0 +1,17 @@
+/*
+ Tests for ESP_LOGx call site descriptors in C++ code
+*/
+
+#include "esp_log.h"
+
+// The call site descriptor of an inline function is placed into a COMDAT group
+inline void log_from_inline(const char *tag)
+{
+    ESP_LOGI(tag, "inline");
+}
+
+extern "C" void test_log_sites_cxx(const char *tag)
+{
+    ESP_LOGI(tag, "cxx");
+    log_from_inline(tag);
+}
@@ -752,3 +752,81 @@ int esp_aes_crypt_xts( esp_aes_xts_context *ctx,
 
     return( 0 );
 }
+
+/* Data units whose tweaks are computed in one go, limits the stack usage
+ * and the time spent with interrupts disabled. */
+#define XTS_UNITS_PER_GROUP 8
+
+int esp_aes_crypt_xts_units( esp_aes_xts_context *ctx,
+                             int mode,
+                             size_t unit_size,
+                             size_t unit_step,
+                             size_t length,
+                             const unsigned char data_unit[16],
+                             const unsigned char *input,
+                             unsigned char *output )
+{
+    int ret = 0;
+    unsigned char tweaks[XTS_UNITS_PER_GROUP][16];
+    unsigned char unit[16];
+    unsigned char tmp[16];
+    uint64_t unit_number;
+
+    if( unit_size < 16 || unit_size % 16 != 0 || length % unit_size != 0 )
+        return MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH;
+
+    memcpy( unit, data_unit, sizeof( unit ) );
+    GET_UINT64_LE( unit_number, unit, 0 );
+
+    while( length > 0 )
+    {
+        size_t units = length / unit_size;
+        if( units > XTS_UNITS_PER_GROUP )
+            units = XTS_UNITS_PER_GROUP;
+
+        esp_aes_acquire_hardware();
+
+        /* The tweak is always computed with the encryption of the tweak key. */
+        esp_aes_setkey_hardware( &ctx->tweak, ESP_AES_ENCRYPT );
+        for( size_t u = 0; u < units && ret == 0; u++ )
+        {
+            PUT_UINT64_LE( unit_number, unit, 0 );
+            ret = esp_aes_block( &ctx->tweak, unit, tweaks[u] );
+            unit_number += unit_step;
+        }
+
+        if( ret == 0 )
+            esp_aes_setkey_hardware( &ctx->crypt, mode );
+        for( size_t u = 0; u < units && ret == 0; u++ )
+        {
+            unsigned char *tweak = tweaks[u];
+            for( size_t blocks = unit_size / 16; blocks > 0 && ret == 0; blocks-- )
+            {
+                size_t i;
+
+                for( i = 0; i < 16; i++ )
+                    tmp[i] = input[i] ^ tweak[i];
+
+                ret = esp_aes_block( &ctx->crypt, tmp, tmp );
+
+                for( i = 0; i < 16; i++ )
+                    output[i] = tmp[i] ^ tweak[i];
+
+                esp_gf128mul_x_ble( tweak, tweak );
+
+                output += 16;
+                input += 16;
+            }
+        }
+
+        esp_aes_release_hardware();
+
+        if( ret != 0 )
+            break;
+        length -= units * unit_size;
+    }
+
+    mbedtls_platform_zeroize( tweaks, sizeof( tweaks ) );
+    mbedtls_platform_zeroize( tmp, sizeof( tmp ) );
+    return( ret );
+}
@@ -346,6 +346,29 @@ int esp_internal_aes_decrypt( esp_aes_context *ctx, const unsigned char input[16
 /** AES-XTS buffer encryption/decryption */
 int esp_aes_crypt_xts( esp_aes_xts_context *ctx, int mode, size_t length, const unsigned char data_unit[16], const unsigned char *input, unsigned char *output );
 
+/**
+ * \brief           AES-XTS encryption/decryption of consecutive data units
+ *
+ * Equivalent to calling esp_aes_crypt_xts() for each unit_size bytes of the input,
+ * with the data unit number increased by unit_step for every following data unit.
+ * The AES hardware is acquired and loaded with each of the two keys once for a group
+ * of data units rather than once per block.
+ *
+ * \param ctx        AES XTS context
+ * \param mode       ESP_AES_ENCRYPT or ESP_AES_DECRYPT
+ * \param unit_size  Size of each data unit in bytes, a multiple of 16
+ * \param unit_step  Difference between the numbers of consecutive data units
+ * \param length     Length of the input data, a multiple of unit_size
+ * \param data_unit  Number of the first data unit, as a 128-bit little-endian value.
+ *                   Only the lower 64 bits are increased.
+ * \param input      Buffer holding the input data
+ * \param output     Buffer holding the output data, may be the same as input
+ *
+ * \return           0 if successful, MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH if a length is not
+ *                   a multiple of the block or unit size.
+ */
+int esp_aes_crypt_xts_units( esp_aes_xts_context *ctx, int mode, size_t unit_size, size_t unit_step, size_t length, const unsigned char data_unit[16], const unsigned char *input, unsigned char *output );
+
 #ifdef __cplusplus
 }
 #endif
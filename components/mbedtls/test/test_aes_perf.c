@@ -69,3 +69,67 @@ TEST_CASE("mbedtls AES performance", "[aes]")
 }
 
 
+
+#if CONFIG_IDF_TARGET_ESP32 && CONFIG_MBEDTLS_HARDWARE_AES
+#include "esp32/aes.h"
+
+TEST_CASE("mbedtls AES XTS of consecutive data units", "[aes]")
+{
+    /* NVS encrypts every 32 byte entry as its own data unit, numbered by its address */
+    const unsigned UNIT_SZ = 32;
+    const unsigned LEN = 4000 / UNIT_SZ * UNIT_SZ;
+    const unsigned CALLS = 64;
+    esp_aes_xts_context ctx;
+    uint8_t key[64];
+    uint8_t data_unit[16] = { 0 };
+    int64_t start, per_unit_time, batched_time;
+
+    for (unsigned i = 0; i < sizeof(key); i++) {
+        key[i] = i;
+    }
+    uint8_t *plain = heap_caps_malloc(LEN, MALLOC_CAP_8BIT|MALLOC_CAP_INTERNAL);
+    uint8_t *per_unit = heap_caps_malloc(LEN, MALLOC_CAP_8BIT|MALLOC_CAP_INTERNAL);
+    uint8_t *batched = heap_caps_malloc(LEN, MALLOC_CAP_8BIT|MALLOC_CAP_INTERNAL);
+    TEST_ASSERT_NOT_NULL(plain);
+    TEST_ASSERT_NOT_NULL(per_unit);
+    TEST_ASSERT_NOT_NULL(batched);
+    for (unsigned i = 0; i < LEN; i++) {
+        plain[i] = i * 13;
+    }
+    esp_aes_xts_init(&ctx);
+    TEST_ASSERT_EQUAL(0, esp_aes_xts_setkey_enc(&ctx, key, 512));
+
+    start = esp_timer_get_time();
+    for (int c = 0; c < CALLS; c++) {
+        for (uint32_t offset = 0; offset < LEN; offset += UNIT_SZ) {
+            uint32_t unit = 0x1000 + offset;
+            memcpy(data_unit, &unit, sizeof(unit));
+            TEST_ASSERT_EQUAL(0, esp_aes_crypt_xts(&ctx, ESP_AES_ENCRYPT, UNIT_SZ, data_unit, plain + offset, per_unit + offset));
+        }
+    }
+    per_unit_time = esp_timer_get_time() - start;
+
+    uint32_t first_unit = 0x1000;
+    memset(data_unit, 0, sizeof(data_unit));
+    memcpy(data_unit, &first_unit, sizeof(first_unit));
+    start = esp_timer_get_time();
+    for (int c = 0; c < CALLS; c++) {
+        TEST_ASSERT_EQUAL(0, esp_aes_crypt_xts_units(&ctx, ESP_AES_ENCRYPT, UNIT_SZ, UNIT_SZ, LEN, data_unit, plain, batched));
+    }
+    batched_time = esp_timer_get_time() - start;
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(per_unit, batched, LEN);
+
+    TEST_ASSERT_EQUAL(0, esp_aes_xts_setkey_dec(&ctx, key, 512));
+    TEST_ASSERT_EQUAL(0, esp_aes_crypt_xts_units(&ctx, ESP_AES_DECRYPT, UNIT_SZ, UNIT_SZ, LEN, data_unit, batched, batched));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(plain, batched, LEN);
+
+    esp_aes_xts_free(&ctx);
+    free(plain);
+    free(per_unit);
+    free(batched);
+
+    printf("XTS of %u byte units: one call per unit %.3fMB/sec, batched %.3fMB/sec\n", UNIT_SZ,
+           (float)(LEN * CALLS) / per_unit_time, (float)(LEN * CALLS) / batched_time);
+    TEST_ASSERT_LESS_THAN(per_unit_time, batched_time);
+}
+#endif
@@ -452,6 +452,111 @@ esp_err_t nvs_get_str (nvs_handle_t handle, const char* key, char* out_value, si
 esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length);
 /**@}*/
 
+/**
+ * @brief      Read part of a blob value
+ *
+ * Reads up to \c *length bytes of the blob starting at \c offset. Only the chunks of the
+ * blob which overlap the requested range are read from flash, so large blobs can be
+ * processed piece by piece with a small buffer. The size of the blob can be queried with
+ * nvs_get_blob with \c out_value set to NULL.
+ *
+ * @param[in]     handle     Handle obtained from nvs_open function.
+ * @param[in]     key        Key name. Maximal length is (NVS_KEY_NAME_MAX_SIZE-1) characters.
+ * @param[in]     offset     Offset of the first byte to read.
+ * @param[out]    out_value  Pointer to the output buffer.
+ * @param[inout]  length     Size of out_value. Set to the number of bytes read, which is
+ *                           smaller than requested if the blob ends earlier.
+ *
+ * @return
+ *             - ESP_OK if the data was read
+ *             - ESP_ERR_NVS_NOT_FOUND if the requested key doesn't exist
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_LENGTH if offset is beyond the end of the blob
+ */
+esp_err_t nvs_get_blob_at(nvs_handle_t handle, const char* key, size_t offset, void* out_value, size_t* length);
+
+/**
+ * @brief      Start writing a blob value in pieces
+ *
+ * Data passed to \c nvs_blob_write is collected in a buffer of
+ * CONFIG_NVS_BLOB_WRITE_BUFFER_SIZE bytes and written as blob chunks, so the
+ * value never has to be held in RAM completely. Until \c nvs_blob_write_end is called,
+ * reads return the previous value of the key, and after a power loss the previous value
+ * is kept. Setting or erasing the key by other means, or starting another blob write
+ * for it, cancels this write. Only one blob write can be open per handle.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *                     Handles that were opened read only cannot be used.
+ * @param[in]  key     Key name. Maximal length is (NVS_KEY_NAME_MAX_SIZE-1) characters.
+ *
+ * @return
+ *             - ESP_OK if the blob write was started
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if handle was opened as read only
+ *             - ESP_ERR_NVS_INVALID_STATE if a blob write is already open on this handle
+ *             - ESP_ERR_NVS_KEY_TOO_LONG if the key name is too long
+ *             - ESP_ERR_NO_MEM if memory for the write buffer couldn't be allocated
+ */
+esp_err_t nvs_blob_write_begin(nvs_handle_t handle, const char* key);
+
+/**
+ * @brief      Append data to the blob started with nvs_blob_write_begin
+ *
+ * If an error is returned, the data written so far is dropped and the blob write
+ * has to be closed with \c nvs_blob_write_abort.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ * @param[in]  value   The data to append.
+ * @param[in]  length  Length of the data, in bytes.
+ *
+ * @return
+ *             - ESP_OK if the data was written or buffered
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no blob write is open on this handle, or it
+ *               was cancelled
+ *             - ESP_ERR_NVS_VALUE_TOO_LONG if the blob gets larger than the maximum blob
+ *               size, see \c nvs_set_blob
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the partition
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_blob_write(nvs_handle_t handle, const void* value, size_t length);
+
+/**
+ * @brief      Finish the blob started with nvs_blob_write_begin
+ *
+ * Writes the buffered data and the blob index, which makes the new value visible,
+ * then erases the previous value. The blob write is closed, even if an error is returned.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if the blob was written
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no blob write is open on this handle, or it
+ *               was cancelled
+ *             - ESP_ERR_NVS_REMOVE_FAILED if the previous value wasn't erased because flash
+ *               write operation has failed. The new value was written however, and the
+ *               previous one will be erased after re-initialization of nvs.
+ *             - other error codes from the underlying storage driver; the previous
+ *               value is kept in this case
+ */
+esp_err_t nvs_blob_write_end(nvs_handle_t handle);
+
+/**
+ * @brief      Drop the blob started with nvs_blob_write_begin
+ *
+ * Erases the chunks written so far and closes the blob write. The previous value
+ * of the key is not changed.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if the blob write was dropped
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no blob write is open on this handle
+ */
+esp_err_t nvs_blob_write_abort(nvs_handle_t handle);
+
 /**
  * @brief      Erase key-value pair with given key name.
  *
@@ -506,6 +611,67 @@ esp_err_t nvs_erase_all(nvs_handle_t handle);
  */
 esp_err_t nvs_commit(nvs_handle_t handle);
 
+/**
+ * @brief      Start staging set and erase operations of a handle as one transaction
+ *
+ * Until \c nvs_transaction_commit or \c nvs_transaction_abort is called, nvs_set_*,
+ * nvs_set_str, nvs_set_blob and nvs_erase_key calls with this handle only record the
+ * operation in RAM. Argument errors such as a too long key are still reported by these calls.
+ * Reads return the values stored in flash, staged operations are not visible to them.
+ * nvs_erase_all returns ESP_ERR_NVS_INVALID_STATE while a transaction is open.
+ *
+ * Committing a transaction writes all new items into consecutive entries, which needs far
+ * fewer flash writes than setting the keys one by one.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *                     Handles that were opened read only cannot be used.
+ *
+ * @return
+ *             - ESP_OK if the transaction was started
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if handle was opened as read only
+ *             - ESP_ERR_NVS_INVALID_STATE if a transaction is already open on this handle
+ *             - ESP_ERR_NO_MEM if memory for the transaction couldn't be allocated
+ */
+esp_err_t nvs_transaction_begin(nvs_handle_t handle);
+
+/**
+ * @brief      Write all operations staged since nvs_transaction_begin as one unit
+ *
+ * The operations are applied in the order they were staged. If power is lost during the
+ * commit, either none or all of them are visible after nvs_flash_init. The transaction
+ * is closed, even if an error is returned.
+ *
+ * Staged operations are first written to a journal item, which is removed again once
+ * all operations have been applied. The partition needs room for the journal in addition
+ * to the new values.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if all operations have been written successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no transaction is open on this handle
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space for the
+ *               transaction; none of the operations has been applied in this case
+ *             - other error codes from the underlying storage driver; if the journal
+ *               had been written already, the remaining operations are applied by the
+ *               next commit or by nvs_flash_init
+ */
+esp_err_t nvs_transaction_commit(nvs_handle_t handle);
+
+/**
+ * @brief      Drop all operations staged since nvs_transaction_begin
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if the transaction has been dropped
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no transaction is open on this handle
+ */
+esp_err_t nvs_transaction_abort(nvs_handle_t handle);
+
 /**
  * @brief      Close the storage handle and free any allocated resources
  *
@@ -604,6 +770,82 @@ esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats);
  */
 esp_err_t nvs_get_used_entry_count(nvs_handle_t handle, size_t* used_entries);
 
+/**
+ * @note Info about the RAM value cache of an NVS partition.
+ */
+typedef struct {
+    uint32_t hits;            /**< Reads served from the cache. */
+    uint32_t misses;          /**< Reads of cached namespaces which had to go to flash. */
+    uint32_t evictions;       /**< Values dropped to make room for more recently read ones. */
+    size_t entry_count;       /**< Amount of values currently cached. */
+    size_t used_bytes;        /**< RAM used by the cached values, including bookkeeping. */
+    size_t capacity;          /**< Maximum amount of RAM used by the cache. */
+} nvs_value_cache_stats_t;
+
+/**
+ * @brief      Enable or disable caching of values read through the handle's namespace
+ *
+ * While enabled, values of the namespace which have been read once are kept in a bounded
+ * RAM cache of the partition (CONFIG_NVS_VALUE_CACHE_SIZE bytes, least recently used values
+ * are dropped first), so that further reads of integers and of strings and blobs of up to
+ * CONFIG_NVS_VALUE_CACHE_MAX_VALUE_SIZE bytes don't access flash.
+ * Writing or erasing a key drops its cached value. The setting applies to all handles
+ * of the namespace and lasts until the partition is deinitialized.
+ *
+ * @param[in]  handle  Handle obtained from nvs_open function.
+ * @param[in]  enable  true to cache values of the namespace, false to stop caching them
+ *                     and drop the values cached so far.
+ *
+ * @return
+ *             - ESP_OK if the setting was changed
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NOT_SUPPORTED if CONFIG_NVS_VALUE_CACHE is not enabled
+ */
+esp_err_t nvs_set_value_cache(nvs_handle_t handle, bool enable);
+
+/**
+ * @brief      Get hit and miss counters and size of the RAM value cache of a partition
+ *
+ * @param[in]   part_name   Partition name NVS in the partition table.
+ *                          If pass a NULL than will use NVS_DEFAULT_PART_NAME ("nvs").
+ * @param[out]  stats       Returns filled structure nvs_value_cache_stats_t.
+ *
+ * @return
+ *             - ESP_OK if stats have been filled
+ *             - ESP_ERR_NVS_NOT_INITIALIZED if the storage driver is not initialized
+ *             - ESP_ERR_INVALID_ARG if stats is NULL
+ *             - ESP_ERR_NOT_SUPPORTED if CONFIG_NVS_VALUE_CACHE is not enabled
+ */
+esp_err_t nvs_get_value_cache_stats(const char *part_name, nvs_value_cache_stats_t *stats);
+
+/**
+ * @brief      Reclaim erased entries of a partition in a small step
+ *
+ * When a partition runs out of free pages, the next write copies all items of a page
+ * to another one and erases it, which can take tens of milliseconds. With
+ * CONFIG_NVS_INCREMENTAL_GC enabled, this work can be done ahead of time in small steps,
+ * e.g. by a low priority task, until the partition has CONFIG_NVS_GC_RESERVE_PAGES free pages.
+ * Writes never have to wait for a page to be copied while free pages are left.
+ *
+ * Each call either moves items of at most about \c budget entries (at least one item,
+ * up to 126 entries for a large blob chunk) out of the page with the most erased entries,
+ * or erases one page which has been emptied this way. Like any other write, a step holds
+ * the partition while it accesses flash.
+ *
+ * @param[in]   part_name   Partition name NVS in the partition table.
+ *                          If pass a NULL than will use NVS_DEFAULT_PART_NAME ("nvs").
+ * @param[in]   budget      Amount of 32-byte entries to move in this step.
+ * @param[out]  done        If not NULL, set to true when no more work is needed for now:
+ *                          the reserve of free pages is complete or nothing can be reclaimed.
+ *
+ * @return
+ *             - ESP_OK if the step succeeded
+ *             - ESP_ERR_NVS_NOT_INITIALIZED if the storage driver is not initialized
+ *             - ESP_ERR_NOT_SUPPORTED if CONFIG_NVS_INCREMENTAL_GC is not enabled
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_gc_step(const char *part_name, size_t budget, bool *done);
+
 /**
  * @brief       Create an iterator to enumerate NVS entries based on one or more parameters
  *
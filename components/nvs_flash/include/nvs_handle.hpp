@@ -185,6 +185,111 @@ public:
      */
     virtual esp_err_t commit() = 0;
 
+    /**
+     * @brief Starts staging all following set and erase operations of this handle in RAM.
+     *
+     * The staged operations are written by \ref commit_transaction as a single unit: after a power loss,
+     * either all or none of them are visible. Reads through this handle return the values stored in flash,
+     * i.e. they do not see staged operations. erase_all can't be staged.
+     *
+     * @return
+     *             - ESP_OK if the transaction was started
+     *             - ESP_ERR_NVS_READ_ONLY if the handle was opened as read only
+     *             - ESP_ERR_NVS_INVALID_STATE if a transaction is already open on this handle
+     *             - ESP_ERR_NO_MEM if memory for the transaction couldn't be allocated
+     */
+    virtual esp_err_t begin_transaction() = 0;
+
+    /**
+     * @brief Writes all operations staged since \ref begin_transaction and closes the transaction.
+     *
+     * The transaction is closed even if writing fails. If the failure happened after the commit point,
+     * the remaining operations are applied by the next commit or when the partition is initialized again.
+     *
+     * @return
+     *             - ESP_OK if all operations were written
+     *             - ESP_ERR_NVS_INVALID_STATE if no transaction is open on this handle
+     *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if the partition can't hold the transaction;
+     *               nothing was written in this case
+     *             - other error codes from the underlying storage driver
+     */
+    virtual esp_err_t commit_transaction() = 0;
+
+    /**
+     * @brief Drops all operations staged since \ref begin_transaction and closes the transaction.
+     *
+     * @return
+     *             - ESP_OK if the transaction was dropped
+     *             - ESP_ERR_NVS_INVALID_STATE if no transaction is open on this handle
+     */
+    virtual esp_err_t abort_transaction() = 0;
+
+    /**
+     * @brief Starts writing the blob key in pieces with \ref write_blob_data, without a buffer for the whole value.
+     *
+     * The previous value of the key stays readable until \ref end_blob_write. Setting or erasing the key
+     * by other means before that cancels the write. Only one blob can be written at a time per handle.
+     *
+     * @return
+     *             - ESP_OK if the write was started
+     *             - ESP_ERR_NVS_READ_ONLY if the handle was opened as read only
+     *             - ESP_ERR_NVS_INVALID_STATE if a blob write is already open on this handle
+     *             - ESP_ERR_NVS_KEY_TOO_LONG if the key is too long
+     *             - ESP_ERR_NO_MEM if memory for the write buffer couldn't be allocated
+     */
+    virtual esp_err_t begin_blob_write(const char *key) = 0;
+
+    /**
+     * @brief Appends data to the blob started with \ref begin_blob_write.
+     *
+     * If an error is returned, the data written so far is dropped and the write has to be closed
+     * with \ref abort_blob_write.
+     *
+     * @return
+     *             - ESP_OK if the data was written or buffered
+     *             - ESP_ERR_NVS_INVALID_STATE if no blob write is open, or it was cancelled
+     *             - ESP_ERR_NVS_VALUE_TOO_LONG if the blob exceeds the maximum blob size
+     *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the partition
+     */
+    virtual esp_err_t write_blob_data(const void *data, size_t len) = 0;
+
+    /**
+     * @brief Writes the remaining data and makes the new blob value visible. The blob write is closed,
+     *        even if an error is returned.
+     *
+     * @return
+     *             - ESP_OK if the blob was written
+     *             - ESP_ERR_NVS_INVALID_STATE if no blob write is open, or it was cancelled
+     *             - ESP_ERR_NVS_REMOVE_FAILED if the previous value couldn't be erased; the new value
+     *               was written however
+     *             - other error codes from the underlying storage driver; the previous value is kept
+     */
+    virtual esp_err_t end_blob_write() = 0;
+
+    /**
+     * @brief Drops the data written since \ref begin_blob_write and closes the blob write.
+     *
+     * @return
+     *             - ESP_OK if the blob write was dropped
+     *             - ESP_ERR_NVS_INVALID_STATE if no blob write is open on this handle
+     */
+    virtual esp_err_t abort_blob_write() = 0;
+
+    /**
+     * @brief Reads up to len bytes of the blob key starting at offset.
+     *
+     * Only the parts of the blob which overlap the requested range are read from flash.
+     *
+     * @param[inout] len  Number of bytes to read; set to the number of bytes read, which is less
+     *                    than requested if the blob ends before.
+     *
+     * @return
+     *             - ESP_OK if the data was read
+     *             - ESP_ERR_NVS_NOT_FOUND if the blob doesn't exist
+     *             - ESP_ERR_NVS_INVALID_LENGTH if offset is beyond the end of the blob
+     */
+    virtual esp_err_t get_blob_at(const char *key, size_t offset, void *out_blob, size_t &len) = 0;
+
     /**
      * @brief      Calculate all entries in the scope of the handle.
      *
@@ -19,6 +19,7 @@
 #include "nvs_partition_manager.hpp"
 #include "esp_partition.h"
 #include "sdkconfig.h"
+#include "esp_crc.h"
 #include <functional>
 #include "nvs_handle_simple.hpp"
 #ifdef CONFIG_NVS_ENCRYPTION
@@ -26,14 +27,11 @@
 #endif
 
 #ifdef ESP_PLATFORM
-#include <esp32/rom/crc.h>
-
 // Uncomment this line to force output from this module
 // #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 #include "esp_log.h"
 static const char* TAG = "nvs";
 #else
-#include "crc.h"
 #define ESP_LOGD(...)
 #endif
 
@@ -64,9 +62,7 @@ extern "C" esp_err_t nvs_flash_init_custom(const char *partName, uint32_t baseSe
 extern "C" esp_err_t nvs_flash_secure_init_custom(const char *partName, uint32_t baseSector, uint32_t sectorCount, nvs_sec_cfg_t* cfg);
 #endif
 
-#ifdef ESP_PLATFORM
-SemaphoreHandle_t nvs::Lock::mSemaphore = NULL;
-#endif
+nvs::RWLock nvs::Lock::mLock;
 
 using namespace std;
 using namespace nvs;
@@ -80,13 +76,14 @@ static nvs::Storage* lookup_storage_from_name(const char *name)
 
 extern "C" void nvs_dump(const char *partName)
 {
-    Lock lock;
+    SharedLock lock;
     nvs::Storage* pStorage;
 
     pStorage = lookup_storage_from_name(partName);
     if (pStorage == NULL) {
         return;
     }
+    StorageLock storageLock(pStorage);
 
     pStorage->debugDump();
     return;
@@ -308,26 +305,28 @@ extern "C" void nvs_close(nvs_handle_t handle)
 
 extern "C" esp_err_t nvs_erase_key(nvs_handle_t c_handle, const char* key)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s %s\r\n", __func__, key);
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
 
     return handle->erase_item(key);
 }
 
 extern "C" esp_err_t nvs_erase_all(nvs_handle_t c_handle)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s\r\n", __func__);
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
 
     return handle->erase_all();
 }
@@ -335,13 +334,14 @@ extern "C" esp_err_t nvs_erase_all(nvs_handle_t c_handle)
 template<typename T>
 static esp_err_t nvs_set(nvs_handle_t c_handle, const char* key, T value)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s %s %d %d", __func__, key, sizeof(T), (uint32_t) value);
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
 
     return handle->set_item(key, value);
 }
@@ -388,37 +388,79 @@ extern "C" esp_err_t nvs_set_u64 (nvs_handle_t handle, const char* key, uint64_t
 
 extern "C" esp_err_t nvs_commit(nvs_handle_t c_handle)
 {
-    Lock lock;
+    SharedLock lock;
     // no-op for now, to be used when intermediate cache is added
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
     return handle->commit();
 }
 
+extern "C" esp_err_t nvs_transaction_begin(nvs_handle_t c_handle)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s\r\n", __func__);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->begin_transaction();
+}
+
+extern "C" esp_err_t nvs_transaction_commit(nvs_handle_t c_handle)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s\r\n", __func__);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->commit_transaction();
+}
+
+extern "C" esp_err_t nvs_transaction_abort(nvs_handle_t c_handle)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s\r\n", __func__);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->abort_transaction();
+}
+
 extern "C" esp_err_t nvs_set_str(nvs_handle_t c_handle, const char* key, const char* value)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s %s %s", __func__, key, value);
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
     return handle->set_string(key, value);
 }
 
 extern "C" esp_err_t nvs_set_blob(nvs_handle_t c_handle, const char* key, const void* value, size_t length)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s %s %d", __func__, key, length);
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
     return handle->set_blob(key, value, length);
 }
 
@@ -426,13 +468,14 @@ extern "C" esp_err_t nvs_set_blob(nvs_handle_t c_handle, const char* key, const
 template<typename T>
 static esp_err_t nvs_get(nvs_handle_t c_handle, const char* key, T* out_value)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s %s %d", __func__, key, sizeof(T));
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
     return handle->get_item(key, *out_value);
 }
 
@@ -478,13 +521,14 @@ extern "C" esp_err_t nvs_get_u64 (nvs_handle_t c_handle, const char* key, uint64
 
 static esp_err_t nvs_get_str_or_blob(nvs_handle_t c_handle, nvs::ItemType type, const char* key, void* out_value, size_t* length)
 {
-    Lock lock;
+    SharedLock lock;
     ESP_LOGD(TAG, "%s %s", __func__, key);
     NVSHandleSimple *handle;
     auto err = nvs_find_ns_handle(c_handle, &handle);
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
 
     size_t dataSize;
     err = handle->get_item_size(type, key, dataSize);
@@ -516,9 +560,77 @@ extern "C" esp_err_t nvs_get_blob(nvs_handle_t c_handle, const char* key, void*
     return nvs_get_str_or_blob(c_handle, nvs::ItemType::BLOB, key, out_value, length);
 }
 
+extern "C" esp_err_t nvs_get_blob_at(nvs_handle_t c_handle, const char* key, size_t offset, void* out_value, size_t* length)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s %s %d", __func__, key, offset);
+    if (length == nullptr || (out_value == nullptr && *length > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->get_blob_at(key, offset, out_value, *length);
+}
+
+extern "C" esp_err_t nvs_blob_write_begin(nvs_handle_t c_handle, const char* key)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s %s", __func__, key);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->begin_blob_write(key);
+}
+
+extern "C" esp_err_t nvs_blob_write(nvs_handle_t c_handle, const void* value, size_t length)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, length);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->write_blob_data(value, length);
+}
+
+extern "C" esp_err_t nvs_blob_write_end(nvs_handle_t c_handle)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s\r\n", __func__);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->end_blob_write();
+}
+
+extern "C" esp_err_t nvs_blob_write_abort(nvs_handle_t c_handle)
+{
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s\r\n", __func__);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->abort_blob_write();
+}
+
 extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats)
 {
-    Lock lock;
+    SharedLock lock;
     nvs::Storage* pStorage;
 
     if (nvs_stats == NULL) {
@@ -533,6 +645,7 @@ extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats
     if (pStorage == NULL) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
+    StorageLock storageLock(pStorage);
 
     if(!pStorage->isValid()){
         return ESP_ERR_NVS_INVALID_STATE;
@@ -543,7 +656,7 @@ extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats
 
 extern "C" esp_err_t nvs_get_used_entry_count(nvs_handle_t c_handle, size_t* used_entries)
 {
-    Lock lock;
+    SharedLock lock;
     if(used_entries == NULL){
         return ESP_ERR_INVALID_ARG;
     }
@@ -554,6 +667,7 @@ extern "C" esp_err_t nvs_get_used_entry_count(nvs_handle_t c_handle, size_t* use
     if (err != ESP_OK) {
         return err;
     }
+    StorageLock storageLock(handle->get_storage());
 
     size_t used_entry_count;
     err = handle->get_used_entry_count(used_entry_count);
@@ -563,6 +677,69 @@ extern "C" esp_err_t nvs_get_used_entry_count(nvs_handle_t c_handle, size_t* use
     return err;
 }
 
+extern "C" esp_err_t nvs_set_value_cache(nvs_handle_t c_handle, bool enable)
+{
+#ifdef CONFIG_NVS_VALUE_CACHE
+    SharedLock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, enable);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    StorageLock storageLock(handle->get_storage());
+    return handle->setValueCacheEnabled(enable);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+extern "C" esp_err_t nvs_get_value_cache_stats(const char* part_name, nvs_value_cache_stats_t* stats)
+{
+#ifdef CONFIG_NVS_VALUE_CACHE
+    SharedLock lock;
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs::Storage* pStorage = lookup_storage_from_name((part_name == NULL) ? NVS_DEFAULT_PART_NAME : part_name);
+    if (pStorage == NULL) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    StorageLock storageLock(pStorage);
+
+    pStorage->fillValueCacheStats(*stats);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+extern "C" esp_err_t nvs_gc_step(const char* part_name, size_t budget, bool* done)
+{
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+    SharedLock lock;
+    nvs::Storage* pStorage = lookup_storage_from_name((part_name == NULL) ? NVS_DEFAULT_PART_NAME : part_name);
+    if (pStorage == NULL) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    StorageLock storageLock(pStorage);
+
+    if (!pStorage->isValid()) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    bool finished;
+    auto err = pStorage->collectStep(budget, finished);
+    if (done) {
+        *done = finished;
+    }
+    return err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
 #if (defined CONFIG_NVS_ENCRYPTION) && (defined ESP_PLATFORM)
 
 extern "C" esp_err_t nvs_flash_generate_keys(const esp_partition_t* partition, nvs_sec_cfg_t* cfg)
@@ -597,8 +774,8 @@ extern "C" esp_err_t nvs_flash_generate_keys(const esp_partition_t* partition, n
         return err;
     }
 
-    uint32_t crc_calc = crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
-    crc_calc = crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
+    uint32_t crc_calc = esp_crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
+    crc_calc = esp_crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
 
     uint8_t crc_wr[16];
     memset(crc_wr, 0xff, sizeof(crc_wr));
@@ -666,8 +843,8 @@ extern "C" esp_err_t nvs_flash_read_security_cfg(const esp_partition_t* partitio
         return err;
     }
 
-    crc_calc = crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
-    crc_calc = crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
+    crc_calc = esp_crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
+    crc_calc = esp_crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
 
     if(crc_calc != crc_read) {
         if(!check_if_initialized(cfg->eky, cfg->tky, crc_read)) {
@@ -697,13 +874,14 @@ static nvs_iterator_t create_iterator(nvs::Storage *storage, nvs_type_t type)
 
 extern "C" nvs_iterator_t nvs_entry_find(const char *part_name, const char *namespace_name, nvs_type_t type)
 {
-    Lock lock;
+    SharedLock lock;
     nvs::Storage *pStorage;
 
     pStorage = lookup_storage_from_name(part_name);
     if (pStorage == NULL) {
         return NULL;
     }
+    StorageLock storageLock(pStorage);
 
     nvs_iterator_t it = create_iterator(pStorage, type);
     if (it == NULL) {
@@ -721,8 +899,9 @@ extern "C" nvs_iterator_t nvs_entry_find(const char *part_name, const char *name
 
 extern "C" nvs_iterator_t nvs_entry_next(nvs_iterator_t it)
 {
-    Lock lock;
+    SharedLock lock;
     assert(it);
+    StorageLock storageLock(it->storage);
 
     bool entryFound = it->storage->nextEntry(it);
     if (!entryFound) {
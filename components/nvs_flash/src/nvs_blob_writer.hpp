@@ -0,0 +1,76 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_blob_writer_hpp
+#define nvs_blob_writer_hpp
+
+#include <cstdlib>
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "intrusive_list.h"
+#include "sdkconfig.h"
+
+namespace nvs
+{
+
+/**
+ * State of a blob which is written in pieces, see Storage::beginBlobWrite.
+ *
+ * Data is collected in a fixed-size buffer and written as BLOB_DATA chunks of the version which the
+ * blob index does not use. Only Storage::endBlobWrite writes the new index, so until then readers see
+ * the previous value, and after a power loss the chunks written so far are erased as orphans by init().
+ */
+class BlobWriter : public intrusive_list_node<BlobWriter>
+{
+    friend class Storage;
+public:
+    static const size_t BUFFER_SIZE = CONFIG_NVS_BLOB_WRITE_BUFFER_SIZE;
+
+    BlobWriter(uint8_t nsIndex) : mNsIndex(nsIndex)
+    {
+    }
+
+    ~BlobWriter()
+    {
+        free(mBuffer);
+    }
+
+    /**
+     * False once the stream was cancelled, because writing failed or the key was written or
+     * erased by other means. Storage no longer tracks the writer in this case.
+     */
+    bool isActive() const
+    {
+        return mActive;
+    }
+
+private:
+    BlobWriter(const BlobWriter& other);
+    const BlobWriter& operator= (const BlobWriter& rhs);
+
+protected:
+    uint8_t mNsIndex;
+    char mKey[Item::MAX_KEY_LENGTH + 1];
+    VerOffset mChunkStart = VerOffset::VER_0_OFFSET;
+    VerOffset mPrevStart = VerOffset::VER_ANY;
+    uint8_t mChunkCount = 0;
+    bool mActive = false;
+    size_t mDataSize = 0;
+    uint8_t* mBuffer = nullptr;
+    size_t mBufferUsed = 0;
+}; // class BlobWriter
+
+} // namespace nvs
+
+#endif /* nvs_blob_writer_hpp */
@@ -98,51 +98,52 @@ namespace nvs
     }
 
 
-    esp_err_t EncrMgr::encryptNvsData(uint8_t* ptxt, uint32_t addr, uint32_t ptxtLen, XtsCtxt* xtsCtxt) {
-
-        uint8_t entrySize = sizeof(Item);
+    int EncrMgr::cryptEntries(mbedtls_aes_xts_context* ctx, int mode, uint8_t* buf, uint32_t relAddr, uint32_t len)
+    {
+        const uint32_t entrySize = sizeof(Item);
 
-        //sector num required as an arr by mbedtls. Should have been just uint64/32.
+        /* Every entry is a separate XTS data unit, numbered by its address relative to the
+         * partition, so a run of entries needs one tweak per entry. */
         uint8_t data_unit[16];
+        memset(data_unit, 0, sizeof(data_unit));
+
+        assert(len % entrySize == 0);
+
+#if defined(CONFIG_IDF_TARGET_ESP32) && defined(CONFIG_MBEDTLS_HARDWARE_AES)
+        /* The accelerator is acquired and loaded with each key once for a group of entries,
+         * instead of once per AES block. */
+        memcpy(data_unit, &relAddr, sizeof(relAddr));
+        return esp_aes_crypt_xts_units(ctx, mode, entrySize, entrySize, len, data_unit, buf, buf);
+#else
+        for (uint32_t offset = 0; offset < len; offset += entrySize) {
+            uint32_t unit = relAddr + offset;
+            memcpy(data_unit, &unit, sizeof(unit));
+            int ret = mbedtls_aes_crypt_xts(ctx, mode, entrySize, data_unit, buf + offset, buf + offset);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        return 0;
+#endif
+    }
 
-        assert(ptxtLen % entrySize == 0);
+    esp_err_t EncrMgr::encryptNvsData(uint8_t* ptxt, uint32_t addr, uint32_t ptxtLen, XtsCtxt* xtsCtxt) {
 
         /* Use relative address instead of absolute address (relocatable), so that host-generated
          * encrypted nvs images can be used*/
         uint32_t relAddr = addr - (xtsCtxt->baseSector * SPI_FLASH_SEC_SIZE);
 
-        memset(data_unit, 0, sizeof(data_unit));
-
-        for(uint8_t entry = 0; entry < (ptxtLen/entrySize); entry++)
-        {
-            uint32_t offset = entry * entrySize;
-            uint32_t *addr_loc = (uint32_t*) &data_unit[0];
-
-            *addr_loc = relAddr + offset;
-            if(mbedtls_aes_crypt_xts(xtsCtxt->ectxt, MBEDTLS_AES_ENCRYPT, entrySize, data_unit, ptxt + offset, ptxt + offset))  {
-                return ESP_ERR_NVS_XTS_ENCR_FAILED;
-            }
+        if (cryptEntries(xtsCtxt->ectxt, MBEDTLS_AES_ENCRYPT, ptxt, relAddr, ptxtLen) != 0) {
+            return ESP_ERR_NVS_XTS_ENCR_FAILED;
         }
         return ESP_OK;
     }
 
     esp_err_t EncrMgr::decryptNvsData(uint8_t* ctxt, uint32_t addr, uint32_t ctxtLen, XtsCtxt* xtsCtxt) {
 
-        //sector num required as an arr by mbedtls. Should have been just uint64/32.
-        uint8_t data_unit[16];
-
-
-        /** Currently upper layer of NVS reads entries one by one even for variable size
-        * multi-entry data types. So length should always be equal to size of an entry.*/
-        assert(ctxtLen == sizeof(Item));
-
         uint32_t relAddr = addr - (xtsCtxt->baseSector * SPI_FLASH_SEC_SIZE);
 
-        memset(data_unit, 0, sizeof(data_unit));
-
-        memcpy(data_unit, &relAddr, sizeof(relAddr));
-
-        if(mbedtls_aes_crypt_xts(xtsCtxt->dctxt, MBEDTLS_AES_DECRYPT, ctxtLen, data_unit, ctxt, ctxt))  {
+        if (cryptEntries(xtsCtxt->dctxt, MBEDTLS_AES_DECRYPT, ctxt, relAddr, ctxtLen) != 0) {
             return ESP_ERR_NVS_XTS_DECR_FAILED;
         }
         return ESP_OK;
@@ -15,7 +15,11 @@
 #define nvs_encr_hpp
 
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include "mbedtls/aes.h"
+#if defined(CONFIG_IDF_TARGET_ESP32) && defined(CONFIG_MBEDTLS_HARDWARE_AES)
+#include "esp32/aes.h"
+#endif
 #include "intrusive_list.h"
 #include "nvs_flash.h"
 
@@ -51,6 +55,9 @@ class EncrMgr
         intrusive_list<XtsCtxt> xtsCtxtList;
         EncrMgr() {}
 
+        /* Encrypts or decrypts a run of whole entries in place, starting at relAddr. */
+        static int cryptEntries(mbedtls_aes_xts_context* ctx, int mode, uint8_t* buf, uint32_t relAddr, uint32_t len);
+
 }; // class EncrMgr
 
 esp_err_t nvs_flash_write(size_t destAddr, const void *srcAddr, size_t size);
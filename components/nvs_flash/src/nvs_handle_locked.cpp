@@ -25,57 +25,116 @@ NVSHandleLocked::~NVSHandleLocked() {
 }
 
 esp_err_t NVSHandleLocked::set_string(const char *key, const char* str) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->set_string(key, str);
 }
 
 esp_err_t NVSHandleLocked::set_blob(const char *key, const void* blob, size_t len) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->set_blob(key, blob, len);
 }
 
 esp_err_t NVSHandleLocked::get_string(const char *key, char* out_str, size_t len) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->get_string(key, out_str, len);
 }
 
 esp_err_t NVSHandleLocked::get_blob(const char *key, void* out_blob, size_t len) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->get_blob(key, out_blob, len);
 }
 
 esp_err_t NVSHandleLocked::get_item_size(ItemType datatype, const char *key, size_t &size) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->get_item_size(datatype, key, size);
 }
 
 esp_err_t NVSHandleLocked::erase_item(const char* key) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->erase_item(key);
 }
 
 esp_err_t NVSHandleLocked::erase_all() {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->erase_all();
 }
 
 esp_err_t NVSHandleLocked::commit() {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->commit();
 }
 
+esp_err_t NVSHandleLocked::begin_transaction() {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->begin_transaction();
+}
+
+esp_err_t NVSHandleLocked::commit_transaction() {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->commit_transaction();
+}
+
+esp_err_t NVSHandleLocked::abort_transaction() {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->abort_transaction();
+}
+
+esp_err_t NVSHandleLocked::begin_blob_write(const char *key) {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->begin_blob_write(key);
+}
+
+esp_err_t NVSHandleLocked::write_blob_data(const void *data, size_t len) {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->write_blob_data(data, len);
+}
+
+esp_err_t NVSHandleLocked::end_blob_write() {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->end_blob_write();
+}
+
+esp_err_t NVSHandleLocked::abort_blob_write() {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->abort_blob_write();
+}
+
+esp_err_t NVSHandleLocked::get_blob_at(const char *key, size_t offset, void *out_blob, size_t &len) {
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
+    return handle->get_blob_at(key, offset, out_blob, len);
+}
+
 esp_err_t NVSHandleLocked::get_used_entry_count(size_t& usedEntries) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->get_used_entry_count(usedEntries);
 }
 
 esp_err_t NVSHandleLocked::set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->set_typed_item(datatype, key, data, dataSize);
 }
 
 esp_err_t NVSHandleLocked::get_typed_item(ItemType datatype, const char *key, void* data, size_t dataSize) {
-    Lock lock;
+    SharedLock lock;
+    StorageLock storageLock(handle->get_storage());
     return handle->get_typed_item(datatype, key, data, dataSize);
 }
 
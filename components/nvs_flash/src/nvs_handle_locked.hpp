@@ -50,6 +50,22 @@ public:
 
     esp_err_t commit() override;
 
+    esp_err_t begin_transaction() override;
+
+    esp_err_t commit_transaction() override;
+
+    esp_err_t abort_transaction() override;
+
+    esp_err_t begin_blob_write(const char *key) override;
+
+    esp_err_t write_blob_data(const void *data, size_t len) override;
+
+    esp_err_t end_blob_write() override;
+
+    esp_err_t abort_blob_write() override;
+
+    esp_err_t get_blob_at(const char *key, size_t offset, void *out_blob, size_t &len) override;
+
     esp_err_t get_used_entry_count(size_t& usedEntries) override;
 
 protected:
@@ -12,12 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <cstdlib>
+#include <new>
+#include <algorithm>
 #include "nvs_handle.hpp"
 #include "nvs_partition_manager.hpp"
 
 namespace nvs {
 
 NVSHandleSimple::~NVSHandleSimple() {
+    delete mTransaction;
+    if (mBlobWriter) {
+        if (valid) {
+            mStoragePtr->abortBlobWrite(*mBlobWriter);
+        }
+        delete mBlobWriter;
+    }
     NVSPartitionManager::get_instance()->close_handle(this);
 }
 
@@ -26,6 +35,8 @@ esp_err_t NVSHandleSimple::set_typed_item(ItemType datatype, const char *key, co
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransaction) return mTransaction->stageWrite(datatype, key, data, dataSize);
+
     return mStoragePtr->writeItem(mNsIndex, datatype, key, data, dataSize);
 }
 
@@ -41,6 +52,8 @@ esp_err_t NVSHandleSimple::set_string(const char *key, const char* str)
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransaction) return mTransaction->stageWrite(nvs::ItemType::SZ, key, str, strlen(str) + 1);
+
     return mStoragePtr->writeItem(mNsIndex, nvs::ItemType::SZ, key, str, strlen(str) + 1);
 }
 
@@ -49,6 +62,8 @@ esp_err_t NVSHandleSimple::set_blob(const char *key, const void* blob, size_t le
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransaction) return mTransaction->stageWrite(nvs::ItemType::BLOB, key, blob, len);
+
     return mStoragePtr->writeItem(mNsIndex, nvs::ItemType::BLOB, key, blob, len);
 }
 
@@ -78,6 +93,8 @@ esp_err_t NVSHandleSimple::erase_item(const char* key)
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransaction) return mTransaction->stageErase(key);
+
     return mStoragePtr->eraseItem(mNsIndex, key);
 }
 
@@ -85,6 +102,7 @@ esp_err_t NVSHandleSimple::erase_all()
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (mTransaction) return ESP_ERR_NVS_INVALID_STATE;
 
     return mStoragePtr->eraseNamespace(mNsIndex);
 }
@@ -96,6 +114,99 @@ esp_err_t NVSHandleSimple::commit()
     return ESP_OK;
 }
 
+esp_err_t NVSHandleSimple::begin_transaction()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (mTransaction) return ESP_ERR_NVS_INVALID_STATE;
+
+    mTransaction = new (std::nothrow) Transaction(mNsIndex);
+    if (!mTransaction) return ESP_ERR_NO_MEM;
+
+    return ESP_OK;
+}
+
+esp_err_t NVSHandleSimple::commit_transaction()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mTransaction) return ESP_ERR_NVS_INVALID_STATE;
+
+    esp_err_t err = mStoragePtr->commitTransaction(*mTransaction);
+    delete mTransaction;
+    mTransaction = nullptr;
+    return err;
+}
+
+esp_err_t NVSHandleSimple::abort_transaction()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mTransaction) return ESP_ERR_NVS_INVALID_STATE;
+
+    delete mTransaction;
+    mTransaction = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t NVSHandleSimple::begin_blob_write(const char *key)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (mBlobWriter) return ESP_ERR_NVS_INVALID_STATE;
+
+    mBlobWriter = new (std::nothrow) BlobWriter(mNsIndex);
+    if (!mBlobWriter) return ESP_ERR_NO_MEM;
+
+    esp_err_t err = mStoragePtr->beginBlobWrite(*mBlobWriter, key);
+    if (err != ESP_OK) {
+        delete mBlobWriter;
+        mBlobWriter = nullptr;
+    }
+    return err;
+}
+
+esp_err_t NVSHandleSimple::write_blob_data(const void *data, size_t len)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mBlobWriter) return ESP_ERR_NVS_INVALID_STATE;
+
+    return mStoragePtr->writeBlobData(*mBlobWriter, data, len);
+}
+
+esp_err_t NVSHandleSimple::end_blob_write()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mBlobWriter) return ESP_ERR_NVS_INVALID_STATE;
+
+    esp_err_t err = mStoragePtr->endBlobWrite(*mBlobWriter);
+    delete mBlobWriter;
+    mBlobWriter = nullptr;
+    return err;
+}
+
+esp_err_t NVSHandleSimple::abort_blob_write()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mBlobWriter) return ESP_ERR_NVS_INVALID_STATE;
+
+    mStoragePtr->abortBlobWrite(*mBlobWriter);
+    delete mBlobWriter;
+    mBlobWriter = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t NVSHandleSimple::get_blob_at(const char *key, size_t offset, void *out_blob, size_t &len)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    size_t dataSize;
+    esp_err_t err = mStoragePtr->getItemDataSize(mNsIndex, ItemType::BLOB, key, dataSize);
+    if (err != ESP_OK) return err;
+    if (offset > dataSize) return ESP_ERR_NVS_INVALID_LENGTH;
+
+    len = std::min(len, dataSize - offset);
+    return mStoragePtr->readBlobRange(mNsIndex, key, offset, out_blob, len);
+}
+
 esp_err_t NVSHandleSimple::get_used_entry_count(size_t& used_entries)
 {
     used_entries = 0;
@@ -122,6 +233,15 @@ esp_err_t NVSHandleSimple::calcEntriesInNamespace(size_t& usedEntries) {
     return mStoragePtr->calcEntriesInNamespace(mNsIndex, usedEntries);
 }
 
+#ifdef CONFIG_NVS_VALUE_CACHE
+esp_err_t NVSHandleSimple::setValueCacheEnabled(bool enable) {
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    mStoragePtr->setValueCacheEnabled(mNsIndex, enable);
+    return ESP_OK;
+}
+#endif
+
 bool NVSHandleSimple::findEntry(nvs_opaque_iterator_t* it, const char* name) {
     return mStoragePtr->findEntry(it, name);
 }
@@ -134,4 +254,8 @@ const char *NVSHandleSimple::get_partition_name() const {
     return mStoragePtr->getPartName();
 }
 
+Storage *NVSHandleSimple::get_storage() const {
+    return valid ? mStoragePtr : nullptr;
+}
+
 }
@@ -62,6 +62,22 @@ public:
 
     esp_err_t commit() override;
 
+    esp_err_t begin_transaction() override;
+
+    esp_err_t commit_transaction() override;
+
+    esp_err_t abort_transaction() override;
+
+    esp_err_t begin_blob_write(const char *key) override;
+
+    esp_err_t write_blob_data(const void *data, size_t len) override;
+
+    esp_err_t end_blob_write() override;
+
+    esp_err_t abort_blob_write() override;
+
+    esp_err_t get_blob_at(const char *key, size_t offset, void *out_blob, size_t &len) override;
+
     esp_err_t get_used_entry_count(size_t &usedEntries) override;
 
     esp_err_t getItemDataSize(ItemType datatype, const char *key, size_t &dataSize);
@@ -72,12 +88,22 @@ public:
 
     esp_err_t calcEntriesInNamespace(size_t &usedEntries);
 
+#ifdef CONFIG_NVS_VALUE_CACHE
+    esp_err_t setValueCacheEnabled(bool enable);
+#endif
+
     bool findEntry(nvs_opaque_iterator_t *it, const char *name);
 
     bool nextEntry(nvs_opaque_iterator_t *it);
 
     const char *get_partition_name() const;
 
+    /**
+     * Storage the handle operates on, nullptr if the handle was invalidated by de-initialization.
+     * Operations through the handle have to hold the StorageLock of this storage.
+     */
+    Storage *get_storage() const;
+
 private:
     /**
      * The underlying storage's object.
@@ -100,6 +126,16 @@ private:
      * Upon opening, a handle is valid. It becomes invalid if the underlying storage is de-initialized.
      */
     uint8_t valid;
+
+    /**
+     * Operations staged since begin_transaction(), nullptr if no transaction is open.
+     */
+    Transaction *mTransaction = nullptr;
+
+    /**
+     * Blob written in pieces since begin_blob_write(), nullptr if no blob write is open.
+     */
+    BlobWriter *mBlobWriter = nullptr;
 };
 
 } // nvs
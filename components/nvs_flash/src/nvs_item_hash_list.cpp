@@ -44,7 +44,11 @@ HashList::HashListBlock::HashListBlock()
 
 void HashList::insert(const Item& item, size_t index)
 {
-    const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
+    insertHash(item.calculateCrc32WithoutValue() & 0xffffff, index);
+}
+
+void HashList::insertHash(uint32_t hash_24, size_t index)
+{
     // add entry to the end of last block if possible
     if (mBlockList.size()) {
         auto& block = mBlockList.back();
@@ -0,0 +1,114 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nvs_item_hash_table.hpp"
+
+namespace nvs
+{
+
+HashTable::HashTable()
+{
+    clear();
+}
+
+void HashTable::clear()
+{
+    for (size_t i = 0; i < SLOT_COUNT; ++i) {
+        mNodes[i].mIndex = EMPTY_INDEX;
+        mNodes[i].mHash = 0;
+    }
+    std::fill_n(mPresent, sizeof(mPresent) / sizeof(mPresent[0]), 0);
+    mSize = 0;
+}
+
+void HashTable::insert(const Item& item, size_t index)
+{
+    insertHash(item.calculateCrc32WithoutValue() & 0xffffff, index);
+}
+
+void HashTable::insertHash(uint32_t hash_24, size_t index)
+{
+    assert(index < MAX_ENTRIES);
+    // an entry index identifies at most one item, replace a stale hash left by a failed write
+    if (hasIndex(index)) {
+        erase(index);
+    }
+
+    size_t slot = homeSlot(hash_24);
+    while (mNodes[slot].mIndex != EMPTY_INDEX) {
+        slot = (slot + 1) & (SLOT_COUNT - 1);
+    }
+    mNodes[slot].mIndex = index;
+    mNodes[slot].mHash = hash_24;
+    setIndex(index, true);
+    ++mSize;
+}
+
+void HashTable::removeSlot(size_t slot)
+{
+    // backward shift deletion, so that lookups can stop at the first empty slot
+    size_t hole = slot;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & (SLOT_COUNT - 1);
+        if (mNodes[next].mIndex == EMPTY_INDEX) {
+            break;
+        }
+        size_t home = homeSlot(mNodes[next].mHash);
+        bool canMove = (hole <= next) ? (home <= hole || home > next)
+                                      : (home <= hole && home > next);
+        if (canMove) {
+            mNodes[hole] = mNodes[next];
+            hole = next;
+        }
+    }
+    mNodes[hole].mIndex = EMPTY_INDEX;
+    mNodes[hole].mHash = 0;
+}
+
+void HashTable::erase(size_t index, bool itemShouldExist)
+{
+    if (index >= MAX_ENTRIES || !hasIndex(index)) {
+        if (itemShouldExist) {
+            assert(false && "item should have been present in cache");
+        }
+        return;
+    }
+
+    for (size_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        if (mNodes[slot].mIndex == index) {
+            removeSlot(slot);
+            setIndex(index, false);
+            --mSize;
+            return;
+        }
+    }
+    assert(false && "hash table is inconsistent with its index bitmap");
+}
+
+size_t HashTable::find(size_t start, const Item& item)
+{
+    const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
+    size_t found = SIZE_MAX;
+    // several items may share the hash, return the first one at or after start
+    for (size_t slot = homeSlot(hash_24); mNodes[slot].mIndex != EMPTY_INDEX; slot = (slot + 1) & (SLOT_COUNT - 1)) {
+        const HashTableNode& e = mNodes[slot];
+        if (e.mHash == hash_24 && e.mIndex >= start && e.mIndex < found) {
+            found = e.mIndex;
+        }
+    }
+    return found;
+}
+
+} // namespace nvs
@@ -0,0 +1,95 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_item_hash_table_h
+#define nvs_item_hash_table_h
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+/**
+ * Drop-in replacement for HashList which lives entirely inside the Page object.
+ *
+ * Hashes are kept in an open-addressed table with linear probing. A page has at most
+ * MAX_ENTRIES items, so the table never needs to grow and no memory is allocated.
+ * A bitmap of the entry indices present in the table makes erasing a missing index cheap.
+ */
+class HashTable
+{
+public:
+    static const size_t MAX_ENTRIES = 126;
+    static const size_t SLOT_COUNT = 128;
+
+    HashTable();
+
+    void insert(const Item& item, size_t index);
+    void insertHash(uint32_t hash_24, size_t index);
+    void erase(const size_t index, bool itemShouldExist=true);
+    size_t find(size_t start, const Item& item);
+    void clear();
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+private:
+    HashTable(const HashTable& other);
+    const HashTable& operator= (const HashTable& rhs);
+
+protected:
+
+    struct HashTableNode {
+        uint32_t mIndex : 8;
+        uint32_t mHash  : 24;
+    };
+
+    static const uint32_t EMPTY_INDEX = 0xff;
+
+    static size_t homeSlot(uint32_t hash)
+    {
+        return hash & (SLOT_COUNT - 1);
+    }
+
+    bool hasIndex(size_t index) const
+    {
+        return (mPresent[index / 32] >> (index % 32)) & 1;
+    }
+
+    void setIndex(size_t index, bool present)
+    {
+        if (present) {
+            mPresent[index / 32] |= 1U << (index % 32);
+        } else {
+            mPresent[index / 32] &= ~(1U << (index % 32));
+        }
+    }
+
+    void removeSlot(size_t slot);
+
+    static_assert(SLOT_COUNT > MAX_ENTRIES, "there must always be a free slot to terminate the probe sequence");
+    static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0, "slot count must be a power of two");
+
+    HashTableNode mNodes[SLOT_COUNT];
+    uint32_t mPresent[(MAX_ENTRIES + 31) / 32];
+    uint16_t mSize;
+}; // class HashTable
+
+} // namespace nvs
+
+
+#endif /* nvs_item_hash_table_h */
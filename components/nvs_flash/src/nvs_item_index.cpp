@@ -0,0 +1,193 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <new>
+#include "nvs_item_index.hpp"
+
+namespace nvs
+{
+
+ItemIndex::ItemIndex(size_t maxEntries) : mMaxEntries(maxEntries)
+{
+}
+
+ItemIndex::~ItemIndex()
+{
+    delete[] mTable;
+}
+
+void ItemIndex::clear()
+{
+    delete[] mTable;
+    mTable = nullptr;
+    mCapacity = 0;
+    mSize = 0;
+    mOverflow = false;
+}
+
+bool ItemIndex::grow()
+{
+    size_t newCapacity = (mCapacity == 0) ? INITIAL_CAPACITY : mCapacity * 2;
+    IndexEntry* newTable = new (std::nothrow) IndexEntry[newCapacity]();
+    if (!newTable) {
+        return false;
+    }
+
+    IndexEntry* oldTable = mTable;
+    size_t oldCapacity = mCapacity;
+    mTable = newTable;
+    mCapacity = newCapacity;
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldTable[i].mPage == nullptr) {
+            continue;
+        }
+        size_t slot = slotOf(oldTable[i].mHash);
+        while (mTable[slot].mPage != nullptr) {
+            slot = (slot + 1) & (mCapacity - 1);
+        }
+        mTable[slot] = oldTable[i];
+    }
+    delete[] oldTable;
+    return true;
+}
+
+void ItemIndex::insert(const Item& item, Page* page)
+{
+    insertHash(hashOf(item), page);
+}
+
+void ItemIndex::insertHash(uint32_t hash, Page* page)
+{
+    if (mOverflow) {
+        return;
+    }
+
+    if (mCapacity) {
+        for (size_t slot = slotOf(hash); mTable[slot].mPage != nullptr; slot = (slot + 1) & (mCapacity - 1)) {
+            IndexEntry& e = mTable[slot];
+            if (e.mHash == hash && e.mPage == page) {
+                // once saturated, the counter is never decremented again, so the entry
+                // stays until the page is erased
+                if (e.mCount < COUNT_MAX) {
+                    ++e.mCount;
+                }
+                return;
+            }
+        }
+    }
+
+    if (mSize + 1 > mMaxEntries ||
+            ((mSize + 1) * 4 > mCapacity * 3 && !grow())) {
+        // Out of RAM budget. Lookups fall back to scanning all pages until the index is rebuilt.
+        delete[] mTable;
+        mTable = nullptr;
+        mCapacity = 0;
+        mSize = 0;
+        mOverflow = true;
+        return;
+    }
+
+    size_t slot = slotOf(hash);
+    while (mTable[slot].mPage != nullptr) {
+        slot = (slot + 1) & (mCapacity - 1);
+    }
+    mTable[slot].mPage = page;
+    mTable[slot].mHash = hash;
+    mTable[slot].mCount = 1;
+    ++mSize;
+}
+
+void ItemIndex::removeSlot(size_t slot)
+{
+    // backward shift deletion keeps probe sequences intact without tombstones
+    const size_t mask = mCapacity - 1;
+    size_t hole = slot;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & mask;
+        if (mTable[next].mPage == nullptr) {
+            break;
+        }
+        size_t home = slotOf(mTable[next].mHash);
+        bool canMove = (hole <= next) ? (home <= hole || home > next)
+                                      : (home <= hole && home > next);
+        if (canMove) {
+            mTable[hole] = mTable[next];
+            hole = next;
+        }
+    }
+    mTable[hole] = IndexEntry();
+    --mSize;
+}
+
+void ItemIndex::erase(const Item& item, Page* page)
+{
+    if (mOverflow || mCapacity == 0) {
+        return;
+    }
+
+    const uint32_t hash = hashOf(item);
+    for (size_t slot = slotOf(hash); mTable[slot].mPage != nullptr; slot = (slot + 1) & (mCapacity - 1)) {
+        IndexEntry& e = mTable[slot];
+        if (e.mHash == hash && e.mPage == page) {
+            if (e.mCount == COUNT_MAX) {
+                return;
+            }
+            if (--e.mCount == 0) {
+                removeSlot(slot);
+            }
+            return;
+        }
+    }
+}
+
+void ItemIndex::erasePage(const Page* page)
+{
+    if (mOverflow) {
+        return;
+    }
+
+    size_t slot = 0;
+    while (slot < mCapacity) {
+        if (mTable[slot].mPage == page) {
+            // an entry from further down the probe sequence may be shifted into this slot,
+            // so check it again
+            removeSlot(slot);
+        } else {
+            ++slot;
+        }
+    }
+}
+
+size_t ItemIndex::find(const Item& item, Page** pages, size_t maxCount) const
+{
+    if (mCapacity == 0) {
+        return 0;
+    }
+
+    const uint32_t hash = hashOf(item);
+    size_t count = 0;
+    for (size_t slot = slotOf(hash); mTable[slot].mPage != nullptr; slot = (slot + 1) & (mCapacity - 1)) {
+        const IndexEntry& e = mTable[slot];
+        if (e.mHash == hash) {
+            if (count < maxCount) {
+                pages[count] = e.mPage;
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace nvs
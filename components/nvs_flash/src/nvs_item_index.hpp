@@ -0,0 +1,106 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_item_index_hpp
+#define nvs_item_index_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+class Page;
+
+/**
+ * Partition-wide index which maps the hash of <namespace, key, chunk index> to the pages
+ * holding items with that hash. It is an over-approximation of the per-page HashLists:
+ * a page which may contain an item is always present in the index, but the index may
+ * also point to pages which no longer hold the item (e.g. after a CRC error).
+ * Lookups therefore still have to be confirmed with Page::findItem.
+ *
+ * The table grows up to maxEntries. If more (hash, page) pairs need to be stored, the index
+ * is dropped and marks itself as invalid; callers then fall back to scanning all pages.
+ */
+class ItemIndex
+{
+public:
+    ItemIndex(size_t maxEntries);
+    ~ItemIndex();
+
+    void clear();
+
+    void insert(const Item& item, Page* page);
+    void insertHash(uint32_t hash, Page* page);
+    void erase(const Item& item, Page* page);
+    void erasePage(const Page* page);
+
+    /**
+     * Collects up to maxCount pages which may contain the item, returns the total number
+     * of candidate pages (which can be larger than maxCount).
+     */
+    size_t find(const Item& item, Page** pages, size_t maxCount) const;
+
+    bool isValid() const
+    {
+        return !mOverflow;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+private:
+    ItemIndex(const ItemIndex& other);
+    const ItemIndex& operator= (const ItemIndex& rhs);
+
+protected:
+    struct IndexEntry {
+        Page* mPage;
+        uint32_t mHash  : 24;
+        uint32_t mCount : 8;
+    };
+
+    static const size_t INITIAL_CAPACITY = 64;
+    static const uint32_t COUNT_MAX = 0xff;
+
+    static uint32_t hashOf(const Item& item)
+    {
+        return item.calculateCrc32WithoutValue() & 0xffffff;
+    }
+
+    size_t slotOf(uint32_t hash) const
+    {
+        return (hash * 2654435761U) & (mCapacity - 1);
+    }
+
+    bool grow();
+    void removeSlot(size_t slot);
+
+    IndexEntry* mTable = nullptr;
+    size_t mCapacity = 0;
+    size_t mSize = 0;
+    size_t mMaxEntries;
+    bool mOverflow = false;
+}; // class ItemIndex
+
+} // namespace nvs
+
+#endif /* nvs_item_index_hpp */
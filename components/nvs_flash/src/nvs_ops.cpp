@@ -16,6 +16,8 @@
 #include "nvs_ops.hpp"
 #ifdef CONFIG_NVS_ENCRYPTION
 #include "nvs_encr.hpp"
+#include "nvs_types.hpp"
+#include <stdlib.h>
 #include <string.h>
 #endif
 
@@ -29,14 +31,23 @@ esp_err_t nvs_flash_write(size_t destAddr, const void *srcAddr, size_t size) {
         auto xtsCtxt = encrMgr->findXtsCtxtFromAddr(destAddr);
 
         if(xtsCtxt) {
-            uint8_t* buf = static_cast<uint8_t*>(malloc(size));
+            /* single entries and short runs, the most common writes, don't need the heap */
+            uint8_t stackBuf[4 * sizeof(Item)];
+            uint8_t* buf = stackBuf;
+            if (size > sizeof(stackBuf)) {
+                buf = static_cast<uint8_t*>(malloc(size));
+                if (!buf) {
+                    return ESP_ERR_NO_MEM;
+                }
+            }
             memcpy(buf, srcAddr, size);
             auto err = encrMgr->encryptNvsData(buf, destAddr, size, xtsCtxt);
-            if( err != ESP_OK) {
-                return err;
+            if (err == ESP_OK) {
+                err = spi_flash_write(destAddr, buf, size);
+            }
+            if (buf != stackBuf) {
+                free(buf);
             }
-            err = spi_flash_write(destAddr, buf, size);
-            delete buf;
             return err;
         }
     }
@@ -4,13 +4,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "nvs_page.hpp"
-#if defined(ESP_PLATFORM)
-#include <esp32/rom/crc.h>
-#else
-#include "crc.h"
-#endif
+#include "esp_crc.h"
 #include <cstdio>
 #include <cstring>
+#include <new>
 
 #include "nvs_ops.hpp"
 
@@ -19,12 +16,21 @@ namespace nvs
 
 uint32_t Page::Header::calculateCrc32()
 {
-    return crc32_le(0xffffffff,
-                    reinterpret_cast<uint8_t*>(this) + offsetof(Header, mSeqNumber),
-                    offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
+    return esp_crc32_le(0xffffffff,
+                        reinterpret_cast<uint8_t*>(this) + offsetof(Header, mSeqNumber),
+                        offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
 }
 
 esp_err_t Page::load(uint32_t sectorNumber)
+{
+    auto rc = loadHeader(sectorNumber);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    return loadEntries();
+}
+
+esp_err_t Page::loadHeader(uint32_t sectorNumber)
 {
     mBaseAddress = sectorNumber * SEC_SIZE;
     mUsedEntryCount = 0;
@@ -67,7 +73,11 @@ esp_err_t Page::load(uint32_t sectorNumber)
             mVersion = header.mVersion;
         }
     }
+    return ESP_OK;
+}
 
+esp_err_t Page::loadEntries()
+{
     switch (mState) {
     case PageState::UNINITIALIZED:
         break;
@@ -211,7 +221,7 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     // write first item
     size_t span = (totalSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
     item = Item(nsIndex, datatype, span, key, chunkIdx);
-    mHashList.insert(item, mNextFreeEntry);
+    insertIntoHashList(item, mNextFreeEntry);
 
     if (!isVariableLengthType(datatype)) {
         memcpy(item.data, data, dataSize);
@@ -254,6 +264,97 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     return ESP_OK;
 }
 
+esp_err_t Page::writeItems(const ItemData* items, size_t count)
+{
+    esp_err_t err;
+
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (mState == PageState::UNINITIALIZED) {
+        err = initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (mState == PageState::FULL) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    size_t entriesCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const ItemData& src = items[i];
+        if (strlen(src.key) > Item::MAX_KEY_LENGTH) {
+            return ESP_ERR_NVS_KEY_TOO_LONG;
+        }
+        if (src.datatype == ItemType::BLOB || src.datatype == ItemType::BLOB_DATA || src.datatype == ItemType::BLOB_IDX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (src.dataSize > Page::CHUNK_MAX_SIZE) {
+            return ESP_ERR_NVS_VALUE_TOO_LONG;
+        }
+        if ((!isVariableLengthType(src.datatype)) && src.dataSize > 8) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        entriesCount += getItemEntryCount(src.datatype, src.dataSize);
+    }
+
+    if (entriesCount == 0) {
+        return ESP_OK;
+    }
+
+    if (mNextFreeEntry == INVALID_ENTRY || mNextFreeEntry + entriesCount > ENTRY_COUNT) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    Item* entries = new (std::nothrow) Item[entriesCount];
+    if (!entries) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t index = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const ItemData& src = items[i];
+        size_t span = getItemEntryCount(src.datatype, src.dataSize);
+        Item& item = entries[index];
+        item = Item(src.nsIndex, src.datatype, span, src.key);
+        if (!isVariableLengthType(src.datatype)) {
+            memcpy(item.data, src.data, src.dataSize);
+        } else {
+            item.varLength.dataCrc32 = Item::calculateCrc32(static_cast<const uint8_t*>(src.data), src.dataSize);
+            item.varLength.dataSize = src.dataSize;
+            item.varLength.reserved = 0xffff;
+            uint8_t* dst = entries[index + 1].rawData;
+            std::fill_n(dst, (span - 1) * ENTRY_SIZE, 0xff);
+            memcpy(dst, src.data, src.dataSize);
+        }
+        item.crc32 = item.calculateCrc32();
+        insertIntoHashList(item, mNextFreeEntry + index);
+        index += span;
+    }
+
+    auto rc = nvs_flash_write(getEntryAddress(mNextFreeEntry), entries, entriesCount * ENTRY_SIZE);
+    delete[] entries;
+    if (rc != ESP_OK) {
+        mState = PageState::INVALID;
+        return rc;
+    }
+
+    err = alterEntryRangeState(mNextFreeEntry, mNextFreeEntry + entriesCount, EntryState::WRITTEN);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        mFirstUsedEntry = mNextFreeEntry;
+    }
+    mUsedEntryCount += entriesCount;
+    mNextFreeEntry += entriesCount;
+    return ESP_OK;
+}
+
 esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -283,17 +384,27 @@ esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, vo
 
     uint8_t* dst = reinterpret_cast<uint8_t*>(data);
     size_t left = item.varLength.dataSize;
-    for (size_t i = index + 1; i < index + item.span; ++i) {
+    if (index + 1 + (left + ENTRY_SIZE - 1) / ENTRY_SIZE > ENTRY_COUNT) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    // whole entries are read straight into the destination with a single flash read,
+    // only the last, partially used entry needs a bounce buffer
+    const size_t wholeSize = left & ~(ENTRY_SIZE - 1);
+    if (wholeSize > 0) {
+        rc = nvs_flash_read(getEntryAddress(index + 1), dst, wholeSize);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        left -= wholeSize;
+        dst += wholeSize;
+    }
+    if (left > 0) {
         Item ditem;
-        rc = readEntry(i, ditem);
+        rc = readEntry(index + 1 + wholeSize / ENTRY_SIZE, ditem);
         if (rc != ESP_OK) {
             return rc;
         }
-        size_t willCopy = ENTRY_SIZE;
-        willCopy = (left < willCopy)?left:willCopy;
-        memcpy(dst, ditem.rawData, willCopy);
-        left -= willCopy;
-        dst += willCopy;
+        memcpy(dst, ditem.rawData, left);
     }
     if (Item::calculateCrc32(reinterpret_cast<uint8_t*>(data), item.varLength.dataSize) != item.varLength.dataCrc32) {
         rc = eraseEntryAndSpan(index);
@@ -305,6 +416,77 @@ esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, vo
     return ESP_OK;
 }
 
+esp_err_t Page::readItemRange(uint8_t nsIndex, ItemType datatype, const char* key, size_t offset, void* data, size_t size, uint8_t chunkIdx)
+{
+    size_t index = 0;
+    Item item;
+
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (!isVariableLengthType(datatype)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t rc = findItem(nsIndex, datatype, key, index, item, chunkIdx);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    const size_t dataSize = item.varLength.dataSize;
+    if (offset > dataSize || size > dataSize - offset) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    const size_t paddedSize = (dataSize + ENTRY_SIZE - 1) & ~(ENTRY_SIZE - 1);
+    if (index + 1 + paddedSize / ENTRY_SIZE > ENTRY_COUNT) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    // whole entries inside the range are read straight into the destination
+    const size_t end = offset + size;
+    const size_t directBegin = (offset + ENTRY_SIZE - 1) & ~(ENTRY_SIZE - 1);
+    const size_t directEnd = (directBegin < (end & ~(ENTRY_SIZE - 1))) ? (end & ~(ENTRY_SIZE - 1)) : directBegin;
+    uint8_t* dst = static_cast<uint8_t*>(data);
+    uint8_t buf[ENTRY_SIZE * 4];
+    uint32_t crc = 0xffffffff;
+    for (size_t pos = 0; pos < paddedSize; ) {
+        size_t len;
+        const uint8_t* readData;
+        if (pos >= directBegin && pos < directEnd) {
+            len = directEnd - pos;
+            rc = nvs_flash_read(getEntryAddress(index + 1) + pos, dst + (pos - offset), len);
+            readData = dst + (pos - offset);
+        } else {
+            len = std::min(sizeof(buf), paddedSize - pos);
+            if (pos < directBegin && directBegin < directEnd) {
+                len = std::min(len, directBegin - pos);
+            }
+            rc = nvs_flash_read(getEntryAddress(index + 1) + pos, buf, len);
+            const size_t copyBegin = std::max(pos, offset);
+            const size_t copyEnd = std::min(pos + len, end);
+            if (copyBegin < copyEnd) {
+                memcpy(dst + (copyBegin - offset), buf + (copyBegin - pos), copyEnd - copyBegin);
+            }
+            readData = buf;
+        }
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        crc = Item::calculateCrc32(readData, std::min(len, dataSize - std::min(pos, dataSize)), crc);
+        pos += len;
+    }
+
+    if (crc != item.varLength.dataCrc32) {
+        rc = eraseEntryAndSpan(index);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
 esp_err_t Page::cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -368,6 +550,52 @@ esp_err_t Page::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, u
     return eraseEntryAndSpan(index);
 }
 
+esp_err_t Page::eraseItems(const ItemData* items, size_t count)
+{
+    static_assert(TEntryTable::byteSize() / 4 <= 32, "dirty words must fit into the mask");
+    uint32_t dirtyWords = 0;
+    esp_err_t rc = ESP_OK;
+    for (size_t i = 0; i < count; ++i) {
+        size_t index = 0;
+        Item item;
+        rc = findItem(items[i].nsIndex, items[i].datatype, items[i].key, index, item);
+        if (rc != ESP_OK) {
+            break;
+        }
+        mHashList.erase(index);
+        if (mItemIndex) {
+            mItemIndex->erase(item, this);
+        }
+        size_t span = item.span;
+        for (size_t j = index; j < index + span; ++j) {
+            if (mEntryTable.get(j) == EntryState::WRITTEN) {
+                --mUsedEntryCount;
+            }
+            ++mErasedEntryCount;
+            mEntryTable.set(j, EntryState::ERASED);
+            dirtyWords |= 1U << mEntryTable.getWordIndex(j);
+        }
+        if (index == mFirstUsedEntry) {
+            updateFirstUsedEntry(index, span);
+        }
+    }
+
+    // entries already marked in RAM have to reach flash even if an item was not found
+    for (size_t wordIndex = 0; wordIndex < TEntryTable::byteSize() / 4; ++wordIndex) {
+        if (!(dirtyWords & (1U << wordIndex))) {
+            continue;
+        }
+        uint32_t word = mEntryTable.data()[wordIndex];
+        auto err = spi_flash_write(mBaseAddress + ENTRY_TABLE_OFFSET + static_cast<uint32_t>(wordIndex) * 4,
+                &word, sizeof(word));
+        if (err != ESP_OK) {
+            mState = PageState::INVALID;
+            return err;
+        }
+    }
+    return rc;
+}
+
 esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -397,6 +625,9 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
             }
         } else {
             mHashList.erase(index);
+            if (mItemIndex) {
+                mItemIndex->erase(item, this);
+            }
             span = item.span;
             for (ptrdiff_t i = index + span - 1; i >= static_cast<ptrdiff_t>(index); --i) {
                 if (mEntryTable.get(i) == EntryState::WRITTEN) {
@@ -431,6 +662,14 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
     return ESP_OK;
 }
 
+void Page::insertIntoHashList(const Item& item, size_t index)
+{
+    mHashList.insert(item, index);
+    if (mItemIndex) {
+        mItemIndex->insert(item, this);
+    }
+}
+
 void Page::updateFirstUsedEntry(size_t index, size_t span)
 {
     assert(index == mFirstUsedEntry);
@@ -475,7 +714,7 @@ esp_err_t Page::copyItems(Page& other)
             return err;
         }
 
-        other.mHashList.insert(entry, other.mNextFreeEntry);
+        other.insertIntoHashList(entry, other.mNextFreeEntry);
         err = other.writeEntry(entry);
         if (err != ESP_OK) {
             return err;
@@ -498,7 +737,62 @@ esp_err_t Page::copyItems(Page& other)
     return ESP_OK;
 }
 
-esp_err_t Page::mLoadEntryTable()
+esp_err_t Page::moveFirstItem(Page& other, size_t& span)
+{
+    span = 0;
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    const size_t index = mFirstUsedEntry;
+    assert(mEntryTable.get(index) == EntryState::WRITTEN);
+    Item entry;
+    auto err = readEntry(index, entry);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // a damaged header is dropped, its data entries are then treated as damaged headers too,
+    // just like load() does it
+    if (entry.calculateCrc32() != entry.crc32 || entry.span == 0 || index + entry.span > ENTRY_COUNT) {
+        span = 1;
+        return eraseEntryAndSpan(index);
+    }
+
+    if (other.mState == PageState::UNINITIALIZED) {
+        err = other.initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (other.getFreeEntryCount() < entry.span) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    // the copy is written before the original is erased, like any other update, so that
+    // load() removes the duplicate if power goes out in between
+    other.insertIntoHashList(entry, other.mNextFreeEntry);
+    err = other.writeEntry(entry);
+    if (err != ESP_OK) {
+        return err;
+    }
+    for (size_t i = index + 1; i < index + entry.span; ++i) {
+        Item data;
+        err = readEntry(i, data);
+        if (err != ESP_OK) {
+            return err;
+        }
+        err = other.writeEntry(data);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    span = entry.span;
+    return eraseEntryAndSpan(index);
+}
+
+esp_err_t Page::readEntryTable()
 {
     // for states where we actually care about data in the page, read entry state table
     if (mState == PageState::ACTIVE ||
@@ -512,6 +806,7 @@ esp_err_t Page::mLoadEntryTable()
         }
     }
 
+    mFirstUsedEntry = INVALID_ENTRY;
     mErasedEntryCount = 0;
     mUsedEntryCount = 0;
     for (size_t i = 0; i < ENTRY_COUNT; ++i) {
@@ -525,6 +820,15 @@ esp_err_t Page::mLoadEntryTable()
             ++mErasedEntryCount;
         }
     }
+    return ESP_OK;
+}
+
+esp_err_t Page::mLoadEntryTable()
+{
+    auto rc = readEntryTable();
+    if (rc != ESP_OK) {
+        return rc;
+    }
 
     // for PageState::ACTIVE, we may have more data written to this page
     // as such, we need to figure out where the first unused entry is
@@ -598,7 +902,7 @@ esp_err_t Page::mLoadEntryTable()
                 continue;
             }
 
-            mHashList.insert(item, i);
+            insertIntoHashList(item, i);
 
             // search for potential duplicate item
             size_t duplicateIndex = mHashList.find(0, item);
@@ -668,7 +972,7 @@ esp_err_t Page::mLoadEntryTable()
 
             assert(item.span > 0);
 
-            mHashList.insert(item, i);
+            insertIntoHashList(item, i);
 
             size_t span = item.span;
 
@@ -689,6 +993,120 @@ esp_err_t Page::mLoadEntryTable()
     return ESP_OK;
 }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+esp_err_t Page::loadEntries(const uint8_t* summary, size_t summarySize)
+{
+    if (mState == PageState::FULL && summary != nullptr) {
+        auto rc = loadSummary(summary, summarySize);
+        if (rc == ESP_OK || mState == PageState::INVALID) {
+            return rc;
+        }
+    }
+    return loadEntries();
+}
+
+esp_err_t Page::loadSummary(const uint8_t* summary, size_t summarySize)
+{
+    auto header = reinterpret_cast<const SummaryHeader*>(summary);
+    if (summarySize < sizeof(SummaryHeader) || header->seqNumber != mSeqNumber ||
+            summarySize != sizeof(SummaryHeader) + header->recordCount * sizeof(uint32_t)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    auto rc = readEntryTable();
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    // A full page only changes by erasing items, so every record has to point to an entry
+    // which is either still written or has been erased since the summary was built.
+    auto records = reinterpret_cast<const uint32_t*>(summary + sizeof(SummaryHeader));
+    bool firstUsedFound = (mFirstUsedEntry == INVALID_ENTRY);
+    for (size_t i = 0; i < header->recordCount; ++i) {
+        size_t index = records[i] & (SUMMARY_SPECIAL - 1);
+        if (index >= ENTRY_COUNT || mEntryTable.get(index) == EntryState::EMPTY ||
+                (i > 0 && index <= (records[i - 1] & (SUMMARY_SPECIAL - 1)))) {
+            return ESP_ERR_NVS_INVALID_STATE;
+        }
+        if (index == mFirstUsedEntry) {
+            firstUsedFound = true;
+        }
+    }
+    if (!firstUsedFound) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    std::fill_n(mSpecialEntries, sizeof(mSpecialEntries) / sizeof(mSpecialEntries[0]), 0);
+    for (size_t i = 0; i < header->recordCount; ++i) {
+        size_t index = records[i] & (SUMMARY_SPECIAL - 1);
+        if (mEntryTable.get(index) != EntryState::WRITTEN) {
+            continue;
+        }
+        const uint32_t hash_24 = records[i] >> 8;
+        mHashList.insertHash(hash_24, index);
+        if (mItemIndex) {
+            mItemIndex->insertHash(hash_24, this);
+        }
+        if (records[i] & SUMMARY_SPECIAL) {
+            mSpecialEntries[index / 32] |= 1U << (index % 32);
+        }
+    }
+    mLoadedFromSummary = true;
+    return ESP_OK;
+}
+
+esp_err_t Page::getSummary(uint8_t* summary, size_t& summarySize)
+{
+    if (mState != PageState::FULL) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    auto header = reinterpret_cast<SummaryHeader*>(summary);
+    auto records = reinterpret_cast<uint32_t*>(summary + sizeof(SummaryHeader));
+    size_t count = 0;
+    Item item;
+    size_t span;
+    for (size_t i = mFirstUsedEntry; i < ENTRY_COUNT; i += span) {
+        span = 1;
+        if (mEntryTable.get(i) != EntryState::WRITTEN) {
+            continue;
+        }
+
+        auto rc = readEntry(i, item);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        if (item.crc32 != item.calculateCrc32()) {
+            // leave it to the next full scan of the page to get rid of the entry
+            return ESP_ERR_NVS_INVALID_STATE;
+        }
+
+        uint32_t record = i | ((item.calculateCrc32WithoutValue() & 0xffffff) << 8);
+        if (isSpecialItem(item.nsIndex, item.datatype)) {
+            record |= SUMMARY_SPECIAL;
+        }
+        records[count++] = record;
+        span = item.span;
+        assert(span > 0);
+    }
+
+    header->seqNumber = mSeqNumber;
+    header->recordCount = count;
+    header->reserved = 0xffff;
+    summarySize = sizeof(SummaryHeader) + count * sizeof(uint32_t);
+    return ESP_OK;
+}
+
+void Page::getSummaryKey(uint32_t seqNumber, char* key, size_t keySize)
+{
+    snprintf(key, keySize, "sum.%08x", seqNumber);
+}
+
+bool Page::isSummaryKey(const char* key)
+{
+    return strncmp(key, "sum.", 4) == 0;
+}
+#endif // CONFIG_NVS_FAST_MOUNT
 
 esp_err_t Page::initialize()
 {
@@ -803,6 +1221,14 @@ esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
         }
     }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+    // Scans which can only match special items don't need to read the other entries of a page
+    // loaded from its summary. Skipping them does not change the result of such a scan.
+    const bool specialOnly = mLoadedFromSummary && key == nullptr &&
+            (nsIndex == NS_INDEX || nsIndex == NS_INTERNAL || (nsIndex == NS_ANY && chunkIdx == CHUNK_ANY &&
+                    (datatype == ItemType::BLOB_IDX || datatype == ItemType::BLOB_DATA)));
+#endif
+
     size_t next;
     for (size_t i = start; i < end; i = next) {
         next = i + 1;
@@ -810,6 +1236,12 @@ esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
             continue;
         }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+        if (specialOnly && !isSpecialEntry(i)) {
+            continue;
+        }
+#endif
+
         auto rc = readEntry(i, item);
         if (rc != ESP_OK) {
             mState = PageState::INVALID;
@@ -915,6 +1347,12 @@ esp_err_t Page::erase()
     mNextFreeEntry = INVALID_ENTRY;
     mState = PageState::UNINITIALIZED;
     mHashList.clear();
+    if (mItemIndex) {
+        mItemIndex->erasePage(this);
+    }
+#ifdef CONFIG_NVS_FAST_MOUNT
+    mLoadedFromSummary = false;
+#endif
     return ESP_OK;
 }
 
@@ -945,6 +1383,16 @@ size_t Page::getVarDataTailroom() const
     return ((mNextFreeEntry < (ENTRY_COUNT-1)) ? ((ENTRY_COUNT - mNextFreeEntry - 1) * ENTRY_SIZE): 0);
 }
 
+size_t Page::getFreeEntryCount() const
+{
+    if (mState == PageState::UNINITIALIZED) {
+        return ENTRY_COUNT;
+    } else if (mState != PageState::ACTIVE || mNextFreeEntry == INVALID_ENTRY) {
+        return 0;
+    }
+    return ENTRY_COUNT - mNextFreeEntry;
+}
+
 const char* Page::pageStateToName(PageState ps)
 {
     switch (ps) {
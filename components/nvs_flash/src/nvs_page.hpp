@@ -24,6 +24,8 @@
 #include "compressed_enum_table.hpp"
 #include "intrusive_list.h"
 #include "nvs_item_hash_list.hpp"
+#include "nvs_item_hash_table.hpp"
+#include "nvs_item_index.hpp"
 
 namespace nvs
 {
@@ -49,12 +51,24 @@ public:
     static const size_t CHUNK_MAX_SIZE = ENTRY_SIZE * (ENTRY_COUNT - 1);
 
     static const uint8_t NS_INDEX = 0;
+    static const uint8_t NS_INTERNAL = 254;
     static const uint8_t NS_ANY = 255;
 
     static const uint8_t CHUNK_ANY = Item::CHUNK_ANY;
 
     static const uint8_t NVS_VERSION = 0xfe; // Decrement to upgrade
 
+    /**
+     * One item of a batch written by writeItems()
+     */
+    struct ItemData {
+        uint8_t nsIndex;
+        ItemType datatype;
+        const char* key;
+        const void* data;
+        size_t dataSize;
+    };
+
     enum class PageState : uint32_t {
         // All bits set, default state after flash erase. Page has not been initialized yet.
         UNINITIALIZED = 0xffffffff,
@@ -84,6 +98,61 @@ public:
 
     esp_err_t load(uint32_t sectorNumber);
 
+    /**
+     * First and second half of load(). Loading headers of all pages first allows to order them
+     * by sequence number before their entries are loaded.
+     */
+    esp_err_t loadHeader(uint32_t sectorNumber);
+
+    esp_err_t loadEntries();
+
+#ifdef CONFIG_NVS_FAST_MOUNT
+    /**
+     * Summary of a full page, stored as an item of another page. It lists the key hash of every
+     * item of the page, so that loading the page only needs to read its entry state table.
+     *
+     *   SummaryHeader, then recordCount times: uint32_t record
+     *
+     * A record holds the entry index in bits 0..6, SUMMARY_SPECIAL in bit 7 and the 24-bit hash
+     * of the item in bits 8..31. Special items (namespace entries, internal items, blob indices
+     * and blob chunks) are the ones scanned by Storage::init and writePageSummaries, only their
+     * entries are read later on.
+     */
+    struct SummaryHeader {
+        uint32_t seqNumber;
+        uint16_t recordCount;
+        uint16_t reserved;
+    };
+
+    static const uint32_t SUMMARY_SPECIAL = 0x80;
+    static const size_t SUMMARY_MAX_SIZE = sizeof(SummaryHeader) + ENTRY_COUNT * sizeof(uint32_t);
+
+    /**
+     * Loads the entries of a full page from its summary. Falls back to reading all item headers
+     * if the summary does not match the page. summary may be nullptr.
+     */
+    esp_err_t loadEntries(const uint8_t* summary, size_t summarySize);
+
+    /**
+     * Builds the summary of this page from its item headers, summary must be able to hold
+     * SUMMARY_MAX_SIZE bytes. Only full pages have a summary.
+     */
+    esp_err_t getSummary(uint8_t* summary, size_t& summarySize);
+
+    /**
+     * Key of the summary item of the page with the given sequence number, in namespace NS_INTERNAL.
+     */
+    static void getSummaryKey(uint32_t seqNumber, char* key, size_t keySize);
+
+    static bool isSummaryKey(const char* key);
+
+    bool isLoadedFromSummary() const
+    {
+        return mLoadedFromSummary;
+    }
+#endif
+
+
     esp_err_t getSeqNumber(uint32_t& seqNumber) const;
 
     esp_err_t setSeqNumber(uint32_t seqNumber);
@@ -92,12 +161,31 @@ public:
 
     esp_err_t writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY);
 
+    /**
+     * Writes several primitive or string items into consecutive entries with a single flash write
+     * and one entry state table update. Either all items fit into the page or ESP_ERR_NVS_PAGE_FULL
+     * is returned and nothing is written.
+     */
+    esp_err_t writeItems(const ItemData* items, size_t count);
+
     esp_err_t readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    /**
+     * Reads size bytes starting at offset of a variable length item. The CRC of the whole item is
+     * still checked, the bytes outside of the range are read into a small buffer on the stack.
+     */
+    esp_err_t readItemRange(uint8_t nsIndex, ItemType datatype, const char* key, size_t offset, void* data, size_t size, uint8_t chunkIdx = CHUNK_ANY);
+
     esp_err_t cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     esp_err_t eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    /**
+     * Erases the first item matching each of items[i].nsIndex, datatype and key. Every word
+     * of the entry state table is written at most once. Data and dataSize are not used.
+     */
+    esp_err_t eraseItems(const ItemData* items, size_t count);
+
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, size_t &itemIndex, Item& item, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
@@ -137,18 +225,41 @@ public:
     }
     size_t getVarDataTailroom() const ;
 
+    size_t getFreeEntryCount() const;
+
+    static size_t getItemEntryCount(ItemType datatype, size_t dataSize)
+    {
+        if (!isVariableLengthType(datatype)) {
+            return 1;
+        }
+        return 1 + (dataSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
+    }
+
     esp_err_t markFull();
 
     esp_err_t markFreeing();
 
     esp_err_t copyItems(Page& other);
 
+    /**
+     * Copies the first item of this page to other, which must be active, then erases it here.
+     * span is set to the amount of entries freed on this page.
+     * Returns ESP_ERR_NVS_NOT_FOUND if the page is empty and ESP_ERR_NVS_PAGE_FULL if
+     * the item does not fit into other.
+     */
+    esp_err_t moveFirstItem(Page& other, size_t& span);
+
     esp_err_t erase();
 
     void debugDump() const;
 
     esp_err_t calcEntries(nvs_stats_t &nvsStats);
 
+    void setItemIndex(ItemIndex* itemIndex)
+    {
+        mItemIndex = itemIndex;
+    }
+
 protected:
 
     class Header
@@ -177,6 +288,23 @@ protected:
 
     esp_err_t mLoadEntryTable();
 
+    esp_err_t readEntryTable();
+
+#ifdef CONFIG_NVS_FAST_MOUNT
+    esp_err_t loadSummary(const uint8_t* summary, size_t summarySize);
+
+    static bool isSpecialItem(uint8_t nsIndex, ItemType datatype)
+    {
+        return nsIndex == NS_INDEX || nsIndex == NS_INTERNAL ||
+                datatype == ItemType::BLOB_IDX || datatype == ItemType::BLOB_DATA;
+    }
+
+    bool isSpecialEntry(size_t index) const
+    {
+        return (mSpecialEntries[index / 32] >> (index % 32)) & 1;
+    }
+#endif
+
     esp_err_t initialize();
 
     esp_err_t alterEntryState(size_t index, EntryState state);
@@ -195,6 +323,8 @@ protected:
 
     void updateFirstUsedEntry(size_t index, size_t span);
 
+    void insertIntoHashList(const Item& item, size_t index);
+
     static constexpr size_t getAlignmentForType(ItemType type)
     {
         return static_cast<uint8_t>(type) & 0x0f;
@@ -221,7 +351,17 @@ protected:
     uint16_t mUsedEntryCount = 0;
     uint16_t mErasedEntryCount = 0;
 
-    HashList mHashList;
+#ifdef CONFIG_NVS_HASH_LIST_INLINE
+    typedef HashTable THashList;
+#else
+    typedef HashList THashList;
+#endif
+    THashList mHashList;
+    ItemIndex* mItemIndex = nullptr;
+#ifdef CONFIG_NVS_FAST_MOUNT
+    bool mLoadedFromSummary = false;
+    uint32_t mSpecialEntries[(ENTRY_COUNT + 31) / 32];
+#endif
 
     static const uint32_t HEADER_OFFSET = 0;
     static const uint32_t ENTRY_TABLE_OFFSET = HEADER_OFFSET + 32;
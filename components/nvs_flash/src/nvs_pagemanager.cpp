@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "nvs_pagemanager.hpp"
+#include <new>
 
 namespace nvs
 {
@@ -21,10 +22,20 @@ esp_err_t PageManager::load(uint32_t baseSector, uint32_t sectorCount)
     mPageCount = sectorCount;
     mPageList.clear();
     mFreePageList.clear();
+#ifdef CONFIG_NVS_ITEM_INDEX
+    mItemIndex.clear();
+#endif
     mPages.reset(new Page[sectorCount]);
 
     for (uint32_t i = 0; i < sectorCount; ++i) {
+#ifdef CONFIG_NVS_ITEM_INDEX
+        mPages[i].setItemIndex(&mItemIndex);
+#endif
+#ifdef CONFIG_NVS_FAST_MOUNT
+        auto err = mPages[i].loadHeader(baseSector + i);
+#else
         auto err = mPages[i].load(baseSector + i);
+#endif
         if (err != ESP_OK) {
             return err;
         }
@@ -44,6 +55,13 @@ esp_err_t PageManager::load(uint32_t baseSector, uint32_t sectorCount)
         }
     }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+    auto err = loadEntries();
+    if (err != ESP_OK) {
+        return err;
+    }
+#endif
+
     if (mPageList.empty()) {
         mSeqNumber = 0;
         return activatePage();
@@ -131,6 +149,61 @@ esp_err_t PageManager::load(uint32_t baseSector, uint32_t sectorCount)
     return ESP_OK;
 }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+esp_err_t PageManager::loadEntries()
+{
+    for (auto it = mFreePageList.begin(); it != mFreePageList.end(); ++it) {
+        auto err = it->loadEntries();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (mPageList.empty()) {
+        return ESP_OK;
+    }
+
+    // Summaries of full pages are written to pages with a higher sequence number,
+    // so loading pages from the newest to the oldest one makes them available in time.
+    std::unique_ptr<uint8_t[]> summary(new (std::nothrow) uint8_t[Page::SUMMARY_MAX_SIZE]);
+    for (auto it = TPageListIterator(&mPageList.back()); it != mPageList.end(); --it) {
+        size_t summarySize = 0;
+        bool haveSummary = summary && it->state() == Page::PageState::FULL &&
+                readSummary(it, summary.get(), summarySize) == ESP_OK;
+        auto err = it->loadEntries(haveSummary ? summary.get() : nullptr, summarySize);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t PageManager::readSummary(TPageListIterator page, uint8_t* summary, size_t& summarySize)
+{
+    uint32_t seqNumber;
+    auto err = page->getSeqNumber(seqNumber);
+    if (err != ESP_OK) {
+        return err;
+    }
+    char key[Item::MAX_KEY_LENGTH + 1];
+    Page::getSummaryKey(seqNumber, key, sizeof(key));
+
+    for (auto it = ++page; it != mPageList.end(); ++it) {
+        size_t itemIndex = 0;
+        Item item;
+        if (it->findItem(Page::NS_INTERNAL, ItemType::BLOB, key, itemIndex, item) != ESP_OK) {
+            continue;
+        }
+        if (item.varLength.dataSize > Page::SUMMARY_MAX_SIZE) {
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        summarySize = item.varLength.dataSize;
+        return it->readItem(Page::NS_INTERNAL, ItemType::BLOB, key, summary, summarySize);
+    }
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+#endif // CONFIG_NVS_FAST_MOUNT
+
 esp_err_t PageManager::requestNewPage()
 {
     if (mFreePageList.empty()) {
@@ -194,6 +267,79 @@ esp_err_t PageManager::requestNewPage()
     return ESP_OK;
 }
 
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+esp_err_t PageManager::collectStep(size_t maxEntries, bool& done)
+{
+    done = false;
+    if (mFreePageList.size() >= CONFIG_NVS_GC_RESERVE_PAGES) {
+        done = true;
+        return ESP_OK;
+    }
+
+    // same victim as in requestNewPage, but the active page is where the items go
+    Page* victim = nullptr;
+    size_t maxUnusedItems = 0;
+    size_t totalUnused = 0;
+    for (auto it = begin(); it != end(); ++it) {
+        auto unused = Page::ENTRY_COUNT - it->getUsedEntryCount();
+        totalUnused += unused;
+        if (it->state() == Page::PageState::FULL && unused > maxUnusedItems) {
+            victim = it;
+            maxUnusedItems = unused;
+        }
+    }
+
+    // items don't pack perfectly, so compacting less than two pages worth of unused entries
+    // may not free a page at all
+    if (victim == nullptr || (victim->getUsedEntryCount() != 0 && totalUnused < 2 * Page::ENTRY_COUNT)) {
+        done = true;
+        return ESP_OK;
+    }
+
+    if (victim->getUsedEntryCount() == 0) {
+        auto err = victim->erase();
+        if (err != ESP_OK) {
+            return err;
+        }
+        mPageList.erase(victim);
+        mFreePageList.push_back(victim);
+        return ESP_OK;
+    }
+
+    size_t movedEntries = 0;
+    do {
+        Page& activePage = back();
+        size_t span;
+        auto err = victim->moveFirstItem(activePage, span);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            break;
+        } else if (err == ESP_ERR_NVS_PAGE_FULL) {
+            if (activePage.state() != Page::PageState::FULL) {
+                err = activePage.markFull();
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            err = requestNewPage();
+            if (err != ESP_OK) {
+                return err;
+            }
+            // without spare free pages requestNewPage had to reclaim a page itself,
+            // possibly the victim, so start over with the next step
+            if (victim->state() != Page::PageState::FULL) {
+                break;
+            }
+            continue;
+        } else if (err != ESP_OK) {
+            return err;
+        }
+        movedEntries += span;
+    } while (movedEntries < maxEntries);
+
+    return ESP_OK;
+}
+#endif // CONFIG_NVS_INCREMENTAL_GC
+
 esp_err_t PageManager::activatePage()
 {
     if (mFreePageList.empty()) {
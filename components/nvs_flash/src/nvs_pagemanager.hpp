@@ -19,6 +19,7 @@
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
+#include "nvs_item_index.hpp"
 #include "intrusive_list.h"
 
 namespace nvs
@@ -29,7 +30,11 @@ class PageManager
     using TPageListIterator = TPageList::iterator;
 public:
 
-    PageManager() {}
+    PageManager()
+#ifdef CONFIG_NVS_ITEM_INDEX
+        : mItemIndex(CONFIG_NVS_ITEM_INDEX_MAX_ENTRIES)
+#endif
+    {}
 
     esp_err_t load(uint32_t baseSector, uint32_t sectorCount);
 
@@ -54,6 +59,23 @@ public:
 
     esp_err_t requestNewPage();
 
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+    /**
+     * Does a bounded amount of the work requestNewPage() does when it runs out of free pages:
+     * moves the items of the full page with the most unused entries into the active page,
+     * at least one item and at most about maxEntries entries per call, or erases that page
+     * once it is empty and returns it to the free list.
+     * done is set if the partition has CONFIG_NVS_GC_RESERVE_PAGES free pages, or if not
+     * enough space can be reclaimed to free another page.
+     */
+    esp_err_t collectStep(size_t maxEntries, bool& done);
+#endif
+
+    size_t getFreePageCount() const
+    {
+        return mFreePageList.size();
+    }
+
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
     uint32_t getBaseSector()
@@ -61,17 +83,33 @@ public:
         return mBaseSector;
     }
 
+#ifdef CONFIG_NVS_ITEM_INDEX
+    const ItemIndex& getItemIndex() const
+    {
+        return mItemIndex;
+    }
+#endif
+
 protected:
     friend class Iterator;
 
     esp_err_t activatePage();
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+    esp_err_t loadEntries();
+
+    esp_err_t readSummary(TPageListIterator page, uint8_t* summary, size_t& summarySize);
+#endif
+
     TPageList mPageList;
     TPageList mFreePageList;
     std::unique_ptr<Page[]> mPages;
     uint32_t mBaseSector;
     uint32_t mPageCount;
     uint32_t mSeqNumber;
+#ifdef CONFIG_NVS_ITEM_INDEX
+    ItemIndex mItemIndex;
+#endif
 }; // class PageManager
 
 
@@ -115,6 +115,11 @@ esp_err_t NVSPartitionManager::deinit_partition(const char *partition_label)
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+    /* Failing to write summaries only makes the next mount slower */
+    storage->writePageSummaries();
+#endif
+
 #ifdef CONFIG_NVS_ENCRYPTION
     if(EncrMgr::isEncrActive()) {
         auto encrMgr = EncrMgr::getInstance();
@@ -14,6 +14,18 @@
 #ifndef nvs_platform_h
 #define nvs_platform_h
 
+/**
+ * Locking in NVS has two levels:
+ *
+ * - Lock and SharedLock guard the list of initialized partitions and the list of open handles.
+ *   Initializing, deinitializing and erasing partitions and opening and closing handles take
+ *   Lock, which is exclusive. Everything else takes SharedLock.
+ * - Each Storage has a Mutex serializing the operations on that partition. It is taken while
+ *   holding SharedLock, so operations on different partitions run concurrently, and Lock
+ *   holders know that no partition operation is in progress.
+ */
+
+#include "esp_err.h"
 
 #ifdef ESP_PLATFORM
 #include "freertos/FreeRTOS.h"
@@ -22,60 +34,291 @@
 namespace nvs
 {
 
-class Lock
+class Mutex
 {
 public:
-    Lock()
+    ~Mutex()
+    {
+        if (mSemaphore) {
+            vSemaphoreDelete(mSemaphore);
+        }
+    }
+
+    esp_err_t init()
+    {
+        if (mSemaphore) {
+            return ESP_OK;
+        }
+        mSemaphore = xSemaphoreCreateMutex();
+        if (!mSemaphore) {
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    }
+
+    void lock()
     {
         if (mSemaphore) {
             xSemaphoreTake(mSemaphore, portMAX_DELAY);
         }
     }
 
-    ~Lock()
+    void unlock()
     {
         if (mSemaphore) {
             xSemaphoreGive(mSemaphore);
         }
     }
 
-    static esp_err_t init()
+protected:
+    SemaphoreHandle_t mSemaphore = nullptr;
+};
+
+/**
+ * A writer holds mMutex for as long as it holds the lock, so tasks blocking on it raise the
+ * writer's priority. Readers only hold mMutex while counting themselves in, and a writer waits
+ * for the count to drop to zero on mReadersDone. Readers are not owners of anything, so a low
+ * priority task in the middle of a partition operation can still delay a high priority task
+ * which wants the lock exclusively, for as long as that one operation takes.
+ *
+ * lock() and lockShared() return false if init() has not been called yet, the caller must only
+ * unlock the lock if it was taken.
+ */
+class RWLock
+{
+public:
+    esp_err_t init()
     {
-        if (mSemaphore) {
+        if (mMutex) {
             return ESP_OK;
         }
-        mSemaphore = xSemaphoreCreateMutex();
-        if (!mSemaphore) {
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+        if (!mutex) {
+            return ESP_ERR_NO_MEM;
+        }
+        mReadersDone = xSemaphoreCreateBinary();
+        if (!mReadersDone) {
+            vSemaphoreDelete(mutex);
             return ESP_ERR_NO_MEM;
         }
+        mMutex = mutex;
         return ESP_OK;
     }
 
-    static void uninit()
+    void uninit()
     {
-        if (mSemaphore) {
-            vSemaphoreDelete(mSemaphore);
+        if (mMutex) {
+            vSemaphoreDelete(mMutex);
+            vSemaphoreDelete(mReadersDone);
         }
-        mSemaphore = nullptr;
+        mMutex = nullptr;
+        mReadersDone = nullptr;
     }
 
-    static SemaphoreHandle_t mSemaphore;
+    bool lock()
+    {
+        if (!mMutex) {
+            return false;
+        }
+        xSemaphoreTake(mMutex, portMAX_DELAY);
+        // new readers block on mMutex, wait for the ones already in to leave
+        while (true) {
+            portENTER_CRITICAL(&mSpinlock);
+            const bool idle = (mReaders == 0);
+            mWriterWaiting = !idle;
+            portEXIT_CRITICAL(&mSpinlock);
+            if (idle) {
+                return true;
+            }
+            xSemaphoreTake(mReadersDone, portMAX_DELAY);
+        }
+    }
+
+    void unlock()
+    {
+        xSemaphoreGive(mMutex);
+    }
+
+    bool lockShared()
+    {
+        if (!mMutex) {
+            return false;
+        }
+        xSemaphoreTake(mMutex, portMAX_DELAY);
+        portENTER_CRITICAL(&mSpinlock);
+        ++mReaders;
+        portEXIT_CRITICAL(&mSpinlock);
+        xSemaphoreGive(mMutex);
+        return true;
+    }
+
+    void unlockShared()
+    {
+        portENTER_CRITICAL(&mSpinlock);
+        const bool wakeWriter = (--mReaders == 0 && mWriterWaiting);
+        if (wakeWriter) {
+            mWriterWaiting = false;
+        }
+        portEXIT_CRITICAL(&mSpinlock);
+        if (wakeWriter) {
+            xSemaphoreGive(mReadersDone);
+        }
+    }
+
+protected:
+    SemaphoreHandle_t mMutex = nullptr;
+    SemaphoreHandle_t mReadersDone = nullptr;
+    portMUX_TYPE mSpinlock = portMUX_INITIALIZER_UNLOCKED;
+    size_t mReaders = 0;
+    bool mWriterWaiting = false;
+};
+
+class Lock
+{
+public:
+    Lock() : mLocked(mLock.lock())
+    {
+    }
+
+    ~Lock()
+    {
+        if (mLocked) {
+            mLock.unlock();
+        }
+    }
+
+    static esp_err_t init()
+    {
+        return mLock.init();
+    }
+
+    static void uninit()
+    {
+        mLock.uninit();
+    }
+
+    static RWLock mLock;
+
+protected:
+    const bool mLocked;
 };
 } // namespace nvs
 
 #else // ESP_PLATFORM
+#include <mutex>
+#include <condition_variable>
+
 namespace nvs
 {
+class Mutex
+{
+public:
+    esp_err_t init()
+    {
+        return ESP_OK;
+    }
+
+    void lock()
+    {
+        mMutex.lock();
+    }
+
+    void unlock()
+    {
+        mMutex.unlock();
+    }
+
+protected:
+    std::mutex mMutex;
+};
+
+class RWLock
+{
+public:
+    bool lock()
+    {
+        std::unique_lock<std::mutex> guard(mMutex);
+        mCondition.wait(guard, [this] { return !mWriter && mReaders == 0; });
+        mWriter = true;
+        return true;
+    }
+
+    void unlock()
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mWriter = false;
+        mCondition.notify_all();
+    }
+
+    bool lockShared()
+    {
+        std::unique_lock<std::mutex> guard(mMutex);
+        mCondition.wait(guard, [this] { return !mWriter; });
+        ++mReaders;
+        return true;
+    }
+
+    void unlockShared()
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (--mReaders == 0) {
+            mCondition.notify_all();
+        }
+    }
+
+protected:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    size_t mReaders = 0;
+    bool mWriter = false;
+};
+
 class Lock
 {
 public:
-    Lock() { }
-    ~Lock() { }
+    Lock() : mLocked(mLock.lock())
+    {
+    }
+
+    ~Lock()
+    {
+        if (mLocked) {
+            mLock.unlock();
+        }
+    }
+
     static void init() {}
     static void uninit() {}
+
+    static RWLock mLock;
+
+protected:
+    const bool mLocked;
 };
 } // namespace nvs
 #endif // ESP_PLATFORM
 
+namespace nvs
+{
+
+class SharedLock
+{
+public:
+    SharedLock() : mLocked(Lock::mLock.lockShared())
+    {
+    }
+
+    ~SharedLock()
+    {
+        if (mLocked) {
+            Lock::mLock.unlockShared();
+        }
+    }
+
+protected:
+    const bool mLocked;
+};
+
+} // namespace nvs
 
 #endif /* nvs_platform_h */
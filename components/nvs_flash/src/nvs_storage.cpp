@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "nvs_storage.hpp"
+#include <cstdlib>
+#include <new>
 
 #ifndef ESP_PLATFORM
 #include <map>
@@ -13,8 +15,18 @@
 namespace nvs
 {
 
+// Items NVS keeps for itself are stored in namespace Page::NS_INTERNAL. It is reserved by an
+// entry in NS_INDEX under this name, so that firmware which doesn't know about it never hands
+// the index out to a user namespace. The name can't be opened through the user API.
+static const char* const INTERNAL_NAMESPACE = "nvs.internal";
+
+// Journal of the transaction being committed. It only exists between the commit point
+// and the moment all operations of the transaction have been applied.
+static const char* const TRANSACTION_KEY = "journal";
+
 Storage::~Storage()
 {
+    detachBlobWriters();
     clearNamespaces();
 }
 
@@ -78,7 +90,16 @@ void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
 
 esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 {
-    auto err = mPageManager.load(baseSector, sectorCount);
+    auto err = mMutex.init();
+    if (err != ESP_OK) {
+        mState = StorageState::INVALID;
+        return err;
+    }
+    detachBlobWriters();
+#ifdef CONFIG_NVS_VALUE_CACHE
+    mValueCache.clear();
+#endif
+    err = mPageManager.load(baseSector, sectorCount);
     if (err != ESP_OK) {
         mState = StorageState::INVALID;
         return err;
@@ -87,17 +108,28 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
     // load namespaces list
     clearNamespaces();
     std::fill_n(mNamespaceUsage.data(), mNamespaceUsage.byteSize() / 4, 0);
+    mInternalNamespaceReserved = false;
     for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
         size_t itemIndex = 0;
         Item item;
-        while (p.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item) == ESP_OK) {
+        while (p.findItem(Page::NS_INDEX, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
+            itemIndex += item.span;
+            // skip anything but namespace entries instead of ending the scan of this page
+            if (item.datatype != ItemType::U8) {
+                continue;
+            }
+            uint8_t nsIndex;
+            item.getValue(nsIndex);
+            if (nsIndex == Page::NS_INTERNAL && strncmp(item.key, INTERNAL_NAMESPACE, Item::MAX_KEY_LENGTH) == 0) {
+                mInternalNamespaceReserved = true;
+                continue;
+            }
             NamespaceEntry* entry = new NamespaceEntry;
             item.getKey(entry->mName, sizeof(entry->mName));
-            item.getValue(entry->mIndex);
+            entry->mIndex = nsIndex;
             mNamespaces.push_back(entry);
             mNamespaceUsage.set(entry->mIndex, true);
-            itemIndex += item.span;
         }
     }
     mNamespaceUsage.set(0, true);
@@ -114,6 +146,13 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
     // Purge the blob index list
     blobIdxList.clearAndFreeNodes();
 
+    // Complete a transaction which was interrupted after its commit point.
+    err = recoverTransaction();
+    if (err != ESP_OK) {
+        mState = StorageState::INVALID;
+        return err;
+    }
+
 #ifndef ESP_PLATFORM
     debugCheck();
 #endif
@@ -127,6 +166,31 @@ bool Storage::isValid() const
 
 esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
 {
+#ifdef CONFIG_NVS_ITEM_INDEX
+    const ItemIndex& itemIndex = mPageManager.getItemIndex();
+    // The index hash covers <namespace, key, chunk index> but not the type, so ANY lookups
+    // (e.g. from nvs_erase_key) use it as well. They only find items whose chunk index
+    // is CHUNK_ANY, i.e. everything but the data chunks of blobs, which always come with
+    // a blob index entry.
+    if (itemIndex.isValid() && nsIndex != Page::NS_ANY && key != nullptr &&
+            (datatype != ItemType::ANY || chunkIdx == Page::CHUNK_ANY)) {
+        Page* candidate;
+        size_t candidateCount = itemIndex.find(Item(nsIndex, datatype, 0, key, chunkIdx), &candidate, 1);
+        if (candidateCount == 0) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        if (candidateCount == 1) {
+            size_t entryIndex = 0;
+            auto err = candidate->findItem(nsIndex, datatype, key, entryIndex, item, chunkIdx, chunkStart);
+            if (err != ESP_OK) {
+                return ESP_ERR_NVS_NOT_FOUND;
+            }
+            page = candidate;
+            return ESP_OK;
+        }
+        // several pages hold items with the same hash, search them in page order below
+    }
+#endif // CONFIG_NVS_ITEM_INDEX
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         size_t itemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart);
@@ -138,6 +202,17 @@ esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key,
     return ESP_ERR_NVS_NOT_FOUND;
 }
 
+size_t Storage::getMaxBlobSize()
+{
+    /* Check how much maximum data can be accommodated**/
+    size_t max_pages = mPageManager.getPageCount() - 1;
+
+    if (max_pages > MAX_BLOB_CHUNKS) {
+        max_pages = MAX_BLOB_CHUNKS;
+    }
+    return max_pages * Page::CHUNK_MAX_SIZE;
+}
+
 esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart)
 {
     uint8_t chunkCount = 0;
@@ -146,14 +221,7 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
     size_t offset=0;
     esp_err_t err = ESP_OK;
 
-    /* Check how much maximum data can be accommodated**/
-    uint32_t max_pages = mPageManager.getPageCount() - 1;
-
-    if(max_pages > (Page::CHUNK_ANY-1)/2) {
-       max_pages = (Page::CHUNK_ANY-1)/2;
-    }
-
-    if (dataSize > max_pages * Page::CHUNK_MAX_SIZE) {
+    if (dataSize > getMaxBlobSize()) {
         return ESP_ERR_NVS_VALUE_TOO_LONG;
     }
 
@@ -243,6 +311,11 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    invalidateCachedValue(nsIndex, key);
+    if (datatype == ItemType::BLOB) {
+        cancelBlobWriters(nsIndex, key);
+    }
+
     Page* findPage = nullptr;
     Item item;
 
@@ -368,6 +441,9 @@ esp_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uin
     if (mState != StorageState::ACTIVE) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
+    if (strncmp(nsName, INTERNAL_NAMESPACE, Item::MAX_KEY_LENGTH) == 0) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
     auto it = std::find_if(mNamespaces.begin(), mNamespaces.end(), [=] (const NamespaceEntry& e) -> bool {
         return strncmp(nsName, e.mName, sizeof(e.mName) - 1) == 0;
     });
@@ -377,13 +453,13 @@ esp_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uin
         }
 
         uint8_t ns;
-        for (ns = 1; ns < 255; ++ns) {
+        for (ns = 1; ns < Page::NS_INTERNAL; ++ns) {
             if (mNamespaceUsage.get(ns) == false) {
                 break;
             }
         }
 
-        if (ns == 255) {
+        if (ns == Page::NS_INTERNAL) {
             return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
         }
 
@@ -501,11 +577,23 @@ esp_err_t Storage::readItem(uint8_t nsIndex, ItemType datatype, const char* key,
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+#ifdef CONFIG_NVS_VALUE_CACHE
+    const bool cacheValue = mCachedNamespaces.get(nsIndex);
+    if (cacheValue && mValueCache.read(nsIndex, datatype, key, data, dataSize)) {
+        return ESP_OK;
+    }
+#endif
+
     Item item;
     Page* findPage = nullptr;
     if (datatype == ItemType::BLOB) {
         auto err = readMultiPageBlob(nsIndex, key, data, dataSize);
         if (err != ESP_ERR_NVS_NOT_FOUND) {
+#ifdef CONFIG_NVS_VALUE_CACHE
+            if (err == ESP_OK && cacheValue) {
+                mValueCache.insert(nsIndex, datatype, key, data, dataSize);
+            }
+#endif
             return err;
         } // else check if the blob is stored with earlier version format without index
     }
@@ -514,15 +602,34 @@ esp_err_t Storage::readItem(uint8_t nsIndex, ItemType datatype, const char* key,
     if (err != ESP_OK) {
         return err;
     }
-    return findPage->readItem(nsIndex, datatype, key, data, dataSize);
+    err = findPage->readItem(nsIndex, datatype, key, data, dataSize);
+#ifdef CONFIG_NVS_VALUE_CACHE
+    if (err == ESP_OK && cacheValue) {
+        mValueCache.insert(nsIndex, datatype, key, data,
+                isVariableLengthType(datatype) ? item.varLength.dataSize : dataSize);
+    }
+#endif
+    return err;
+}
 
+#ifdef CONFIG_NVS_VALUE_CACHE
+void Storage::setValueCacheEnabled(uint8_t nsIndex, bool enable)
+{
+    mCachedNamespaces.set(nsIndex, enable);
+    if (!enable) {
+        mValueCache.invalidateNamespace(nsIndex);
+    }
 }
+#endif
 
 esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffset chunkStart)
 {
     if (mState != StorageState::ACTIVE) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
+
+    invalidateCachedValue(nsIndex, key);
+    cancelBlobWriters(nsIndex, key);
     Item item;
     Page* findPage = nullptr;
 
@@ -545,8 +652,15 @@ esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffse
     }
 
     /* Now erase corresponding chunks*/
+    return eraseBlobChunks(nsIndex, key, chunkStart, chunkCount);
+}
+
+esp_err_t Storage::eraseBlobChunks(uint8_t nsIndex, const char* key, VerOffset chunkStart, uint8_t chunkCount)
+{
+    Item item;
+    Page* findPage = nullptr;
     for (uint8_t chunkNum = 0; chunkNum < chunkCount; chunkNum++) {
-        err = findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, static_cast<uint8_t> (chunkStart) + chunkNum);
+        auto err = findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, static_cast<uint8_t> (chunkStart) + chunkNum);
 
         if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
             return err;
@@ -569,6 +683,9 @@ esp_err_t Storage::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    invalidateCachedValue(nsIndex, key);
+    cancelBlobWriters(nsIndex, key);
+
     if (datatype == ItemType::BLOB) {
         return eraseMultiPageBlob(nsIndex, key);
     }
@@ -593,6 +710,11 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+#ifdef CONFIG_NVS_VALUE_CACHE
+    mValueCache.invalidateNamespace(nsIndex);
+#endif
+    cancelBlobWriters(nsIndex, nullptr);
+
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         while (true) {
             auto err = it->eraseItem(nsIndex, ItemType::ANY, nullptr);
@@ -608,12 +730,579 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
 
 }
 
+esp_err_t Storage::writeItemBatch(const Page::ItemData* items, Page* const* oldPages, size_t count)
+{
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    auto err = getCurrentPage().writeItems(items, count);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Erase the old values page by page, so that each entry state word is written once.
+    // An old value on the current page precedes the new one, so it is found first.
+    assert(count <= TRANSACTION_BATCH_SIZE);
+    Page::ItemData pageItems[TRANSACTION_BATCH_SIZE];
+    bool erased[TRANSACTION_BATCH_SIZE];
+    std::fill_n(erased, count, false);
+    for (size_t i = 0; i < count; ++i) {
+        if (oldPages[i] == nullptr || erased[i]) {
+            continue;
+        }
+        size_t pageItemCount = 0;
+        for (size_t j = i; j < count; ++j) {
+            if (oldPages[j] == oldPages[i]) {
+                pageItems[pageItemCount++] = items[j];
+                erased[j] = true;
+            }
+        }
+        err = oldPages[i]->eraseItems(pageItems, pageItemCount);
+        if (err == ESP_ERR_FLASH_OP_FAIL) {
+            return ESP_ERR_NVS_REMOVE_FAILED;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t Storage::applyTransaction(const uint8_t* journal, size_t size, bool recovery)
+{
+    Page::ItemData batch[TRANSACTION_BATCH_SIZE];
+    Page* oldPages[TRANSACTION_BATCH_SIZE];
+    size_t batchCount = 0;
+    size_t batchEntries = 0;
+
+    size_t offset = 0;
+    const Transaction::JournalOp* op;
+    const uint8_t* data;
+    esp_err_t err;
+    while ((err = Transaction::nextOp(journal, size, offset, op, data)) == ESP_OK) {
+        invalidateCachedValue(op->nsIndex, op->key);
+
+        // a key has to be written before it is looked up again
+        bool flush = std::any_of(batch, batch + batchCount, [op] (const Page::ItemData& e) -> bool {
+            return e.nsIndex == op->nsIndex && e.datatype == op->datatype && strcmp(e.key, op->key) == 0;
+        });
+        // erasures and blobs are applied one by one, in order with the batched writes
+        flush |= (op->datatype == ItemType::ANY || op->datatype == ItemType::BLOB);
+        if (flush) {
+            err = writeItemBatch(batch, oldPages, batchCount);
+            if (err != ESP_OK) {
+                return err;
+            }
+            batchCount = 0;
+            batchEntries = 0;
+        }
+
+        if (op->datatype == ItemType::ANY) {
+            err = eraseItem(op->nsIndex, op->key);
+            if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+                return err;
+            }
+            continue;
+        }
+
+        if (op->datatype == ItemType::BLOB) {
+            err = writeItem(op->nsIndex, ItemType::BLOB, op->key, data, op->dataSize);
+            if (err != ESP_OK) {
+                return err;
+            }
+            continue;
+        }
+
+        Page* findPage = nullptr;
+        Item item;
+        if (recovery) {
+            // Power may have been lost between writing a batch and erasing the old values, so
+            // there can be several copies of the key. The journal has the final value, drop them all.
+            while (findItem(op->nsIndex, op->datatype, op->key, findPage, item) == ESP_OK) {
+                err = findPage->eraseItem(op->nsIndex, op->datatype, op->key);
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            findPage = nullptr;
+        } else {
+            err = findItem(op->nsIndex, op->datatype, op->key, findPage, item);
+            if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+                return err;
+            }
+            if (findPage != nullptr &&
+                    findPage->cmpItem(op->nsIndex, op->datatype, op->key, data, op->dataSize) == ESP_OK) {
+                continue;
+            }
+        }
+
+        size_t entries = Page::getItemEntryCount(op->datatype, op->dataSize);
+        if (batchCount == TRANSACTION_BATCH_SIZE || batchEntries + entries > getCurrentPage().getFreeEntryCount()) {
+            err = writeItemBatch(batch, oldPages, batchCount);
+            if (err != ESP_OK) {
+                return err;
+            }
+            batchCount = 0;
+            batchEntries = 0;
+        }
+
+        if (entries > getCurrentPage().getFreeEntryCount()) {
+            Page& page = getCurrentPage();
+            if (page.state() != Page::PageState::FULL) {
+                err = page.markFull();
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            err = mPageManager.requestNewPage();
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (entries > getCurrentPage().getFreeEntryCount()) {
+                return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+            }
+            if (findPage != nullptr && (findPage->state() == Page::PageState::UNINITIALIZED ||
+                    findPage->state() == Page::PageState::INVALID)) {
+                ESP_ERROR_CHECK(findItem(op->nsIndex, op->datatype, op->key, findPage, item));
+            }
+        }
+
+        batch[batchCount].nsIndex = op->nsIndex;
+        batch[batchCount].datatype = op->datatype;
+        batch[batchCount].key = op->key;
+        batch[batchCount].data = data;
+        batch[batchCount].dataSize = op->dataSize;
+        oldPages[batchCount] = findPage;
+        ++batchCount;
+        batchEntries += entries;
+    }
+
+    if (err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+    return writeItemBatch(batch, oldPages, batchCount);
+}
+
+esp_err_t Storage::reserveInternalNamespace()
+{
+    if (mInternalNamespaceReserved) {
+        return ESP_OK;
+    }
+    // taken by a user namespace, created by firmware which didn't reserve the index
+    if (mNamespaceUsage.get(Page::NS_INTERNAL)) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    uint8_t ns = Page::NS_INTERNAL;
+    auto err = writeItem(Page::NS_INDEX, ItemType::U8, INTERNAL_NAMESPACE, &ns, sizeof(ns));
+    if (err != ESP_OK) {
+        return err;
+    }
+    mInternalNamespaceReserved = true;
+    return ESP_OK;
+}
+
+esp_err_t Storage::recoverTransaction()
+{
+    if (!mInternalNamespaceReserved) {
+        return ESP_OK;
+    }
+
+    size_t size;
+    auto err = getItemDataSize(Page::NS_INTERNAL, ItemType::BLOB, TRANSACTION_KEY, size);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t* journal = static_cast<uint8_t*>(malloc(size));
+    if (!journal) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = readItem(Page::NS_INTERNAL, ItemType::BLOB, TRANSACTION_KEY, journal, size);
+    if (err == ESP_OK) {
+        err = applyTransaction(journal, size, true);
+    }
+    free(journal);
+    // a malformed journal can never be applied, drop it
+    if (err != ESP_OK && err != ESP_ERR_NVS_INVALID_LENGTH) {
+        return err;
+    }
+    return eraseItem(Page::NS_INTERNAL, ItemType::BLOB, TRANSACTION_KEY);
+}
+
+esp_err_t Storage::commitTransaction(const Transaction& transaction)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    if (transaction.getOpCount() == 0) {
+        return ESP_OK;
+    }
+
+    // the journal of a commit which failed half-way is about to be replaced, finish that commit first
+    auto err = recoverTransaction();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Once the journal is on flash, the transaction has to be applied completely. Make sure the journal
+    // and the new items fit, keeping one page in reserve for garbage collection.
+    nvs_stats_t stats;
+    err = fillStats(stats);
+    if (err != ESP_OK) {
+        return err;
+    }
+    size_t journalEntries = (transaction.size() + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE
+            + transaction.size() / Page::CHUNK_MAX_SIZE + 2;
+    if (stats.free_entries < journalEntries + transaction.getEntryCount() + Page::ENTRY_COUNT) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    err = reserveInternalNamespace();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Writing the journal is the commit point. If power is lost before it is complete, none of
+    // the operations is visible after init(). If power is lost later, init() applies the rest.
+    err = writeItem(Page::NS_INTERNAL, ItemType::BLOB, TRANSACTION_KEY, transaction.data(), transaction.size());
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // If this fails, the journal is kept and applied again by the next commit or on the next init().
+    err = applyTransaction(transaction.data(), transaction.size(), false);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // all operations are on flash, the journal is only needed if power is lost before it is erased
+    err = eraseItem(Page::NS_INTERNAL, ItemType::BLOB, TRANSACTION_KEY);
+    if (err == ESP_ERR_FLASH_OP_FAIL) {
+        return ESP_ERR_NVS_REMOVE_FAILED;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+#ifndef ESP_PLATFORM
+    debugCheck();
+#endif
+    return ESP_OK;
+}
+
+esp_err_t Storage::beginBlobWrite(BlobWriter& writer, const char* key)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    if (strlen(key) > Item::MAX_KEY_LENGTH) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    if (writer.mActive) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (!writer.mBuffer) {
+        writer.mBuffer = static_cast<uint8_t*>(malloc(BlobWriter::BUFFER_SIZE));
+        if (!writer.mBuffer) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    cancelBlobWriters(writer.mNsIndex, key);
+
+    /* The chunks are written with the version which the current index does not use */
+    Item item;
+    Page* findPage = nullptr;
+    auto err = findItem(writer.mNsIndex, ItemType::BLOB_IDX, key, findPage, item);
+    if (err == ESP_OK) {
+        writer.mPrevStart = item.blobIndex.chunkStart;
+        writer.mChunkStart = (writer.mPrevStart == VerOffset::VER_1_OFFSET) ? VerOffset::VER_0_OFFSET : VerOffset::VER_1_OFFSET;
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        writer.mPrevStart = VerOffset::VER_ANY;
+        writer.mChunkStart = VerOffset::VER_0_OFFSET;
+    } else {
+        return err;
+    }
+
+    strncpy(writer.mKey, key, sizeof(writer.mKey) - 1);
+    writer.mKey[sizeof(writer.mKey) - 1] = 0;
+    writer.mChunkCount = 0;
+    writer.mDataSize = 0;
+    writer.mBufferUsed = 0;
+    writer.mActive = true;
+    mBlobWriters.push_back(&writer);
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeBlobChunk(BlobWriter& writer, const uint8_t* data, size_t dataSize, size_t& written)
+{
+    if (writer.mChunkCount == MAX_BLOB_CHUNKS) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    size_t tailroom;
+    while (true) {
+        tailroom = getCurrentPage().getVarDataTailroom();
+        /* Like writeMultiPageBlob, don't start a chunk in the little space left at the end of a page */
+        if ((tailroom >= dataSize && tailroom > 0) || tailroom >= Page::CHUNK_MAX_SIZE / 10) {
+            break;
+        }
+        Page& page = getCurrentPage();
+        if (page.state() != Page::PageState::FULL) {
+            auto err = page.markFull();
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        auto err = mPageManager.requestNewPage();
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (getCurrentPage().getVarDataTailroom() == tailroom) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+    }
+
+    size_t chunkSize = std::min(dataSize, tailroom);
+    auto err = getCurrentPage().writeItem(writer.mNsIndex, ItemType::BLOB_DATA, writer.mKey, data, chunkSize,
+            static_cast<uint8_t> (writer.mChunkStart) + writer.mChunkCount);
+    assert(err != ESP_ERR_NVS_PAGE_FULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    writer.mChunkCount++;
+    written = chunkSize;
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeBlobData(BlobWriter& writer, const void* data, size_t dataSize)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    if (!writer.mActive) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (dataSize > getMaxBlobSize() - writer.mDataSize) {
+        cancelBlobWriter(writer);
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while (dataSize > 0) {
+        size_t written = 0;
+        esp_err_t err = ESP_OK;
+        if (writer.mBufferUsed == 0 && dataSize >= BlobWriter::BUFFER_SIZE) {
+            /* Large pieces are written straight from the caller's memory */
+            err = writeBlobChunk(writer, src, dataSize, written);
+            src += written;
+            dataSize -= written;
+            writer.mDataSize += written;
+        } else {
+            size_t copySize = std::min(dataSize, BlobWriter::BUFFER_SIZE - writer.mBufferUsed);
+            memcpy(writer.mBuffer + writer.mBufferUsed, src, copySize);
+            writer.mBufferUsed += copySize;
+            src += copySize;
+            dataSize -= copySize;
+            writer.mDataSize += copySize;
+            if (writer.mBufferUsed == BlobWriter::BUFFER_SIZE) {
+                err = writeBlobChunk(writer, writer.mBuffer, writer.mBufferUsed, written);
+                writer.mBufferUsed -= written;
+                memmove(writer.mBuffer, writer.mBuffer + written, writer.mBufferUsed);
+            }
+        }
+        if (err != ESP_OK) {
+            cancelBlobWriter(writer);
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t Storage::endBlobWrite(BlobWriter& writer)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    if (!writer.mActive) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    /* An empty blob still has one chunk, as written by writeMultiPageBlob */
+    while (writer.mBufferUsed > 0 || writer.mChunkCount == 0) {
+        size_t written = 0;
+        auto err = writeBlobChunk(writer, writer.mBuffer, writer.mBufferUsed, written);
+        if (err != ESP_OK) {
+            cancelBlobWriter(writer);
+            return err;
+        }
+        writer.mBufferUsed -= written;
+        memmove(writer.mBuffer, writer.mBuffer + written, writer.mBufferUsed);
+    }
+
+    Item item;
+    std::fill_n(item.data, sizeof(item.data), 0xff);
+    item.blobIndex.dataSize = writer.mDataSize;
+    item.blobIndex.chunkCount = writer.mChunkCount;
+    item.blobIndex.chunkStart = writer.mChunkStart;
+
+    auto err = getCurrentPage().writeItem(writer.mNsIndex, ItemType::BLOB_IDX, writer.mKey, item.data, sizeof(item.data));
+    if (err == ESP_ERR_NVS_PAGE_FULL) {
+        Page& page = getCurrentPage();
+        if (page.state() != Page::PageState::FULL) {
+            err = page.markFull();
+        } else {
+            err = ESP_OK;
+        }
+        if (err == ESP_OK) {
+            err = mPageManager.requestNewPage();
+        }
+        if (err == ESP_OK) {
+            err = getCurrentPage().writeItem(writer.mNsIndex, ItemType::BLOB_IDX, writer.mKey, item.data, sizeof(item.data));
+        }
+        if (err == ESP_ERR_NVS_PAGE_FULL) {
+            err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+    }
+    if (err != ESP_OK) {
+        cancelBlobWriter(writer);
+        return err;
+    }
+
+    /* The new value is complete, the writer must not be cancelled by erasing the previous one */
+    mBlobWriters.erase(&writer);
+    writer.mActive = false;
+    invalidateCachedValue(writer.mNsIndex, writer.mKey);
+
+    if (writer.mPrevStart != VerOffset::VER_ANY) {
+        err = eraseMultiPageBlob(writer.mNsIndex, writer.mKey, writer.mPrevStart);
+    } else {
+        /* Support for earlier versions where BLOBS were stored without index */
+        Page* findPage = nullptr;
+        err = findItem(writer.mNsIndex, ItemType::BLOB, writer.mKey, findPage, item);
+        if (err == ESP_OK) {
+            err = findPage->eraseItem(writer.mNsIndex, ItemType::BLOB, writer.mKey);
+        } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    if (err == ESP_ERR_FLASH_OP_FAIL) {
+        return ESP_ERR_NVS_REMOVE_FAILED;
+    }
+    return err;
+}
+
+void Storage::abortBlobWrite(BlobWriter& writer)
+{
+    if (writer.mActive) {
+        cancelBlobWriter(writer);
+    }
+}
+
+void Storage::cancelBlobWriter(BlobWriter& writer)
+{
+    mBlobWriters.erase(&writer);
+    writer.mActive = false;
+    writer.mBufferUsed = 0;
+    /* If this fails, init() erases the remaining chunks as orphans */
+    eraseBlobChunks(writer.mNsIndex, writer.mKey, writer.mChunkStart, writer.mChunkCount);
+}
+
+void Storage::cancelBlobWriters(uint8_t nsIndex, const char* key)
+{
+    for (auto it = std::begin(mBlobWriters); it != std::end(mBlobWriters); ) {
+        auto writer = it++;
+        if (writer->mNsIndex == nsIndex && (key == nullptr || strncmp(writer->mKey, key, sizeof(writer->mKey)) == 0)) {
+            cancelBlobWriter(*writer);
+        }
+    }
+}
+
+void Storage::detachBlobWriters()
+{
+    while (!mBlobWriters.empty()) {
+        BlobWriter& writer = mBlobWriters.front();
+        mBlobWriters.erase(&writer);
+        writer.mActive = false;
+    }
+}
+
+esp_err_t Storage::readBlobRange(uint8_t nsIndex, const char* key, size_t offset, void* data, size_t dataSize)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    Item item;
+    Page* findPage = nullptr;
+    auto err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        /* Support for earlier versions where BLOBS were stored without index */
+        err = findItem(nsIndex, ItemType::BLOB, key, findPage, item);
+        if (err != ESP_OK) {
+            return err;
+        }
+        return findPage->readItemRange(nsIndex, ItemType::BLOB, key, offset, data, dataSize);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (offset > item.blobIndex.dataSize || dataSize > item.blobIndex.dataSize - offset) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    const uint8_t chunkCount = item.blobIndex.chunkCount;
+    const VerOffset chunkStart = item.blobIndex.chunkStart;
+    uint8_t* dst = static_cast<uint8_t*>(data);
+    size_t chunkOffset = 0;
+    for (uint8_t chunkNum = 0; chunkNum < chunkCount && dataSize > 0; chunkNum++) {
+        const uint8_t chunkIdx = static_cast<uint8_t> (chunkStart) + chunkNum;
+        err = findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, chunkIdx);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            eraseMultiPageBlob(nsIndex, key); // cleanup if a chunk is not found
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        const size_t chunkSize = item.varLength.dataSize;
+        if (offset < chunkOffset + chunkSize) {
+            const size_t readSize = std::min(dataSize, chunkOffset + chunkSize - offset);
+            err = findPage->readItemRange(nsIndex, ItemType::BLOB_DATA, key, offset - chunkOffset, dst, readSize, chunkIdx);
+            if (err != ESP_OK) {
+                return err;
+            }
+            dst += readSize;
+            offset += readSize;
+            dataSize -= readSize;
+        }
+        chunkOffset += chunkSize;
+    }
+    return (dataSize == 0) ? ESP_OK : ESP_ERR_NVS_INVALID_LENGTH;
+}
+
 esp_err_t Storage::getItemDataSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize)
 {
     if (mState != StorageState::ACTIVE) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+#ifdef CONFIG_NVS_VALUE_CACHE
+    if (mCachedNamespaces.get(nsIndex) && mValueCache.getSize(nsIndex, datatype, key, dataSize)) {
+        return ESP_OK;
+    }
+#endif
+
     Item item;
     Page* findPage = nullptr;
     auto err = findItem(nsIndex, datatype, key, findPage, item);
@@ -640,6 +1329,97 @@ void Storage::debugDump()
     }
 }
 
+#ifdef CONFIG_NVS_FAST_MOUNT
+static bool hasFullPage(PageManager& pageManager, uint32_t seqNumber)
+{
+    for (auto it = pageManager.begin(); it != pageManager.end(); ++it) {
+        uint32_t pageSeqNumber;
+        if (it->state() == Page::PageState::FULL &&
+                it->getSeqNumber(pageSeqNumber) == ESP_OK && pageSeqNumber == seqNumber) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t Storage::writePageSummaries()
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    // Erase the summaries of pages which have been freed since the summaries were written.
+    // They are kept in the internal namespace, so there are none before it is reserved.
+    for (auto it = mPageManager.begin(); mInternalNamespaceReserved && it != mPageManager.end(); ++it) {
+        size_t itemIndex = 0;
+        Item item;
+        while (it->findItem(Page::NS_INTERNAL, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
+            if (item.datatype == ItemType::BLOB && Page::isSummaryKey(item.key) &&
+                    !hasFullPage(mPageManager, strtoul(item.key + 4, nullptr, 16))) {
+                auto err = it->eraseItem(Page::NS_INTERNAL, ItemType::BLOB, item.key);
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            itemIndex += item.span;
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> summary(new (std::nothrow) uint8_t[Page::SUMMARY_MAX_SIZE]);
+    if (!summary) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
+        uint32_t seqNumber;
+        if (it->state() != Page::PageState::FULL || it->getSeqNumber(seqNumber) != ESP_OK) {
+            continue;
+        }
+        char key[Item::MAX_KEY_LENGTH + 1];
+        Page::getSummaryKey(seqNumber, key, sizeof(key));
+        Page* findPage;
+        Item item;
+        if (findItem(Page::NS_INTERNAL, ItemType::BLOB, key, findPage, item) == ESP_OK) {
+            continue;
+        }
+
+        size_t summarySize;
+        if (it->getSummary(summary.get(), summarySize) != ESP_OK) {
+            continue;
+        }
+        // If an older version of NVS gave the internal index to a user namespace, no summaries
+        // are written and pages are always loaded by reading all item headers.
+        auto err = reserveInternalNamespace();
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (getCurrentPage().getVarDataTailroom() < summarySize) {
+            // Summaries only speed up the next mount, they must not cause garbage collection
+            // or take the last free pages.
+            if (mPageManager.getFreePageCount() < SUMMARY_MIN_FREE_PAGES) {
+                break;
+            }
+            Page& page = getCurrentPage();
+            if (page.state() != Page::PageState::FULL) {
+                err = page.markFull();
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            err = mPageManager.requestNewPage();
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        err = getCurrentPage().writeItem(Page::NS_INTERNAL, ItemType::BLOB, key, summary.get(), summarySize);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_NVS_FAST_MOUNT
+
 #ifndef ESP_PLATFORM
 void Storage::debugCheck()
 {
@@ -659,6 +1439,19 @@ void Storage::debugCheck()
                 assert(0);
             }
             keys.insert(std::make_pair(keystr, static_cast<Page*>(p)));
+#ifdef CONFIG_NVS_ITEM_INDEX
+            const ItemIndex& keyIndex = mPageManager.getItemIndex();
+            if (keyIndex.isValid()) {
+                const size_t MAX_CANDIDATES = 8;
+                Page* candidates[MAX_CANDIDATES];
+                size_t candidateCount = keyIndex.find(item, candidates, MAX_CANDIDATES);
+                if (candidateCount <= MAX_CANDIDATES &&
+                        std::find(candidates, candidates + candidateCount, static_cast<Page*>(p)) == candidates + candidateCount) {
+                    printf("Key missing from item index: %s\n", keystr.c_str());
+                    assert(0);
+                }
+            }
+#endif
             itemIndex += item.span;
             usedCount += item.span;
         }
@@ -733,6 +1526,7 @@ bool Storage::findEntry(nvs_opaque_iterator_t* it, const char* namespace_name)
 inline bool isIterableItem(Item& item)
 {
     return (item.nsIndex != 0 &&
+            item.nsIndex != Page::NS_INTERNAL &&
             item.datatype != ItemType::BLOB &&
             item.datatype != ItemType::BLOB_IDX);
 }
@@ -20,6 +20,10 @@
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
+#include "nvs_transaction.hpp"
+#include "nvs_blob_writer.hpp"
+#include "nvs_value_cache.hpp"
+#include "nvs_platform.hpp"
 
 //extern void dumpBytes(const uint8_t* data, size_t count);
 
@@ -61,8 +65,14 @@ public:
     ~Storage();
 
     Storage(const char *pName = NVS_DEFAULT_PART_NAME)
+#ifdef CONFIG_NVS_VALUE_CACHE
+        : mValueCache(CONFIG_NVS_VALUE_CACHE_SIZE, CONFIG_NVS_VALUE_CACHE_MAX_VALUE_SIZE)
+#endif
     {
         strncpy(mPartitionName, pName, NVS_PART_NAME_MAX_SIZE);
+#ifdef CONFIG_NVS_VALUE_CACHE
+        std::fill_n(mCachedNamespaces.data(), mCachedNamespaces.byteSize() / 4, 0);
+#endif
     };
 
     esp_err_t init(uint32_t baseSector, uint32_t sectorCount);
@@ -98,6 +108,62 @@ public:
 
     esp_err_t eraseNamespace(uint8_t nsIndex);
 
+    /**
+     * Applies all operations of the transaction, or none of them if power is lost before
+     * the journal of the transaction has been written.
+     */
+    esp_err_t commitTransaction(const Transaction& transaction);
+
+    /**
+     * Starts writing the blob key in pieces. The previous value of the key stays readable until
+     * endBlobWrite. Writing or erasing the key by other means, or starting another writer for it,
+     * cancels the writer and erases the chunks it has written.
+     */
+    esp_err_t beginBlobWrite(BlobWriter& writer, const char* key);
+
+    esp_err_t writeBlobData(BlobWriter& writer, const void* data, size_t dataSize);
+
+    /**
+     * Writes the buffered data and the blob index, then erases the previous value.
+     * The writer is closed, even if an error is returned.
+     */
+    esp_err_t endBlobWrite(BlobWriter& writer);
+
+    void abortBlobWrite(BlobWriter& writer);
+
+    /**
+     * Reads dataSize bytes starting at offset of a blob. Only the chunks which overlap the range are read.
+     */
+    esp_err_t readBlobRange(uint8_t nsIndex, const char* key, size_t offset, void* data, size_t dataSize);
+
+#ifdef CONFIG_NVS_VALUE_CACHE
+    /**
+     * Starts or stops caching the values of a namespace in RAM when they are read.
+     */
+    void setValueCacheEnabled(uint8_t nsIndex, bool enable);
+
+    void fillValueCacheStats(nvs_value_cache_stats_t& stats) const
+    {
+        mValueCache.fillStats(stats);
+    }
+#endif
+
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+    esp_err_t collectStep(size_t maxEntries, bool& done)
+    {
+        return mPageManager.collectStep(maxEntries, done);
+    }
+#endif
+
+#ifdef CONFIG_NVS_FAST_MOUNT
+    /**
+     * Writes the summary of every full page which does not have one yet, and erases
+     * the summaries of pages which no longer exist.
+     * Called when the partition is deinitialized, so that the next mount is fast.
+     */
+    esp_err_t writePageSummaries();
+#endif
+
     const char *getPartName() const
     {
         return mPartitionName;
@@ -127,13 +193,62 @@ public:
 
     bool nextEntry(nvs_opaque_iterator_t* it);
 
+    /**
+     * Serializes operations on this partition, see nvs_platform.hpp.
+     * Callers hold SharedLock and use StorageLock rather than calling these directly.
+     */
+    void lock()
+    {
+        mMutex.lock();
+    }
+
+    void unlock()
+    {
+        mMutex.unlock();
+    }
+
 protected:
 
+    // number of items written by a single Page::writeItems call while applying a transaction
+    static const size_t TRANSACTION_BATCH_SIZE = 16;
+
+    // free pages which writePageSummaries leaves untouched
+    static const size_t SUMMARY_MIN_FREE_PAGES = 3;
+
     Page& getCurrentPage()
     {
         return mPageManager.back();
     }
 
+    void invalidateCachedValue(uint8_t nsIndex, const char* key)
+    {
+#ifdef CONFIG_NVS_VALUE_CACHE
+        mValueCache.invalidate(nsIndex, key);
+#endif
+    }
+
+    // chunk indices of a blob version have to stay below the next version and Page::CHUNK_ANY
+    static const uint8_t MAX_BLOB_CHUNKS = (Page::CHUNK_ANY - 1) / 2;
+
+    size_t getMaxBlobSize();
+
+    esp_err_t writeBlobChunk(BlobWriter& writer, const uint8_t* data, size_t dataSize, size_t& written);
+
+    esp_err_t eraseBlobChunks(uint8_t nsIndex, const char* key, VerOffset chunkStart, uint8_t chunkCount);
+
+    /**
+     * Cancels the blob writers of key, or of the whole namespace if key is nullptr,
+     * before the key is written or erased by other means.
+     */
+    void cancelBlobWriters(uint8_t nsIndex, const char* key);
+
+    void cancelBlobWriter(BlobWriter& writer);
+
+    /**
+     * Stops tracking all blob writers without erasing their chunks, which are orphans for init().
+     */
+    void detachBlobWriters();
+
     void clearNamespaces();
 
     void populateBlobIndices(TBlobIndexList&);
@@ -144,13 +259,53 @@ protected:
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    esp_err_t applyTransaction(const uint8_t* journal, size_t size, bool recovery);
+
+    esp_err_t writeItemBatch(const Page::ItemData* items, Page* const* oldPages, size_t count);
+
+    esp_err_t recoverTransaction();
+
+    esp_err_t reserveInternalNamespace();
+
 protected:
     char mPartitionName [NVS_PART_NAME_MAX_SIZE + 1];
     size_t mPageCount;
     PageManager mPageManager;
     TNamespaces mNamespaces;
     CompressedEnumTable<bool, 1, 256> mNamespaceUsage;
+    bool mInternalNamespaceReserved = false;
     StorageState mState = StorageState::INVALID;
+    Mutex mMutex;
+    intrusive_list<BlobWriter> mBlobWriters;
+#ifdef CONFIG_NVS_VALUE_CACHE
+    ValueCache mValueCache;
+    CompressedEnumTable<bool, 1, 256> mCachedNamespaces;
+#endif
+};
+
+class StorageLock
+{
+public:
+    explicit StorageLock(Storage* storage) : mStorage(storage)
+    {
+        if (mStorage) {
+            mStorage->lock();
+        }
+    }
+
+    ~StorageLock()
+    {
+        if (mStorage) {
+            mStorage->unlock();
+        }
+    }
+
+private:
+    StorageLock(const StorageLock& other);
+    const StorageLock& operator= (const StorageLock& rhs);
+
+protected:
+    Storage* mStorage;
 };
 
 } // namespace nvs
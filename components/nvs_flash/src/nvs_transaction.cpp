@@ -0,0 +1,139 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <cstring>
+#include "nvs_transaction.hpp"
+#include "nvs_page.hpp"
+
+namespace nvs
+{
+
+Transaction::Transaction(uint8_t nsIndex) : mNsIndex(nsIndex)
+{
+}
+
+Transaction::~Transaction()
+{
+    free(mBuffer);
+}
+
+bool Transaction::reserve(size_t size)
+{
+    if (size <= mCapacity) {
+        return true;
+    }
+    size_t newCapacity = (mCapacity == 0) ? INITIAL_CAPACITY : mCapacity;
+    while (newCapacity < size) {
+        newCapacity *= 2;
+    }
+    uint8_t* newBuffer = static_cast<uint8_t*>(realloc(mBuffer, newCapacity));
+    if (!newBuffer) {
+        return false;
+    }
+    mBuffer = newBuffer;
+    mCapacity = newCapacity;
+    return true;
+}
+
+esp_err_t Transaction::stage(ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    if (strlen(key) > Item::MAX_KEY_LENGTH) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    const size_t opSize = sizeof(JournalOp) + paddedSize(dataSize);
+    const size_t headerSize = (mSize == 0) ? sizeof(JournalHeader) : 0;
+    if (!reserve(mSize + headerSize + opSize)) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (headerSize) {
+        JournalHeader* h = header();
+        h->magic = JOURNAL_MAGIC;
+        h->opCount = 0;
+        h->entryCount = 0;
+        mSize = headerSize;
+    }
+
+    JournalOp* op = reinterpret_cast<JournalOp*>(mBuffer + mSize);
+    op->nsIndex = mNsIndex;
+    op->datatype = datatype;
+    op->reserved = 0xffff;
+    std::fill_n(op->key, sizeof(op->key), 0);
+    strncpy(op->key, key, sizeof(op->key) - 1);
+    op->dataSize = dataSize;
+    uint8_t* dst = mBuffer + mSize + sizeof(JournalOp);
+    if (dataSize) {
+        memcpy(dst, data, dataSize);
+    }
+    std::fill(dst + dataSize, dst + paddedSize(dataSize), 0xff);
+    mSize += opSize;
+
+    size_t entries = 0;
+    if (datatype == ItemType::BLOB) {
+        // each chunk needs a header, and the index needs one more entry
+        entries = (dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE + dataSize / Page::CHUNK_MAX_SIZE + 2;
+    } else if (datatype != ItemType::ANY) {
+        entries = Page::getItemEntryCount(datatype, dataSize);
+    }
+    header()->opCount++;
+    header()->entryCount += entries;
+    return ESP_OK;
+}
+
+esp_err_t Transaction::stageWrite(ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    if (datatype == ItemType::ANY || datatype == ItemType::BLOB_DATA || datatype == ItemType::BLOB_IDX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!isVariableLengthType(datatype) && dataSize > 8) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (datatype == ItemType::SZ && dataSize > Page::CHUNK_MAX_SIZE) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+    return stage(datatype, key, data, dataSize);
+}
+
+esp_err_t Transaction::stageErase(const char* key)
+{
+    return stage(ItemType::ANY, key, nullptr, 0);
+}
+
+esp_err_t Transaction::nextOp(const uint8_t* journal, size_t size, size_t& offset, const JournalOp*& op, const uint8_t*& data)
+{
+    if (offset == 0) {
+        if (size < sizeof(JournalHeader) ||
+                reinterpret_cast<const JournalHeader*>(journal)->magic != JOURNAL_MAGIC) {
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        offset = sizeof(JournalHeader);
+    }
+    if (offset == size) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (size - offset < sizeof(JournalOp)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    op = reinterpret_cast<const JournalOp*>(journal + offset);
+    if (op->key[sizeof(op->key) - 1] != 0 || op->dataSize > size ||
+            size - offset - sizeof(JournalOp) < paddedSize(op->dataSize)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    data = journal + offset + sizeof(JournalOp);
+    offset += sizeof(JournalOp) + paddedSize(op->dataSize);
+    return ESP_OK;
+}
+
+} // namespace nvs
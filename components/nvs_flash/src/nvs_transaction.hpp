@@ -0,0 +1,116 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_transaction_hpp
+#define nvs_transaction_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+/**
+ * Set and erase operations staged in RAM until they are committed together.
+ *
+ * The operations are serialized in the format of the journal which Storage::commitTransaction
+ * writes to flash, so committing does not need another copy of the data:
+ *
+ *   JournalHeader, then opCount times: JournalOp, data padded to a multiple of 4 bytes
+ *
+ * An erase operation has datatype ItemType::ANY and no data.
+ */
+class Transaction
+{
+public:
+    struct JournalHeader {
+        uint32_t magic;
+        uint32_t opCount;
+        uint32_t entryCount;  // estimate of the entries needed to apply all operations
+    };
+
+    struct JournalOp {
+        uint8_t nsIndex;
+        ItemType datatype;
+        uint16_t reserved;
+        char key[Item::MAX_KEY_LENGTH + 1];
+        uint32_t dataSize;
+    };
+
+    static const uint32_t JOURNAL_MAGIC = 0x5458534e; // "NSXT"
+
+    Transaction(uint8_t nsIndex);
+    ~Transaction();
+
+    esp_err_t stageWrite(ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    esp_err_t stageErase(const char* key);
+
+    const uint8_t* data() const
+    {
+        return mBuffer;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    size_t getOpCount() const
+    {
+        return (mBuffer) ? header()->opCount : 0;
+    }
+
+    size_t getEntryCount() const
+    {
+        return (mBuffer) ? header()->entryCount : 0;
+    }
+
+    /**
+     * Steps through the operations of a journal. offset should be 0 for the first call.
+     * Returns ESP_ERR_NVS_NOT_FOUND after the last operation and ESP_ERR_NVS_INVALID_LENGTH
+     * if the journal is malformed.
+     */
+    static esp_err_t nextOp(const uint8_t* journal, size_t size, size_t& offset, const JournalOp*& op, const uint8_t*& data);
+
+private:
+    Transaction(const Transaction& other);
+    const Transaction& operator= (const Transaction& rhs);
+
+protected:
+    static const size_t INITIAL_CAPACITY = 256;
+
+    JournalHeader* header() const
+    {
+        return reinterpret_cast<JournalHeader*>(mBuffer);
+    }
+
+    static size_t paddedSize(size_t size)
+    {
+        return (size + 3) & ~3;
+    }
+
+    esp_err_t stage(ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    bool reserve(size_t size);
+
+    uint8_t* mBuffer = nullptr;
+    size_t mSize = 0;
+    size_t mCapacity = 0;
+    uint8_t mNsIndex;
+}; // class Transaction
+
+} // namespace nvs
+
+#endif /* nvs_transaction_hpp */
@@ -0,0 +1,148 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "nvs_value_cache.hpp"
+
+namespace nvs
+{
+
+ValueCache::ValueCache(size_t capacity, size_t maxValueSize) :
+    mCapacity(capacity), mMaxValueSize(maxValueSize)
+{
+}
+
+ValueCache::~ValueCache()
+{
+    clear();
+}
+
+ValueCache::CacheEntry* ValueCache::find(uint8_t nsIndex, ItemType datatype, const char* key)
+{
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if (it->mNsIndex == nsIndex && it->mDatatype == datatype &&
+                strncmp(it->mKey, key, Item::MAX_KEY_LENGTH) == 0) {
+            return it;
+        }
+    }
+    return nullptr;
+}
+
+void ValueCache::remove(CacheEntry* entry)
+{
+    mEntries.erase(entry);
+    mUsedBytes -= entry->byteSize();
+    entry->~CacheEntry();
+    free(entry);
+}
+
+bool ValueCache::read(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize)
+{
+    CacheEntry* entry = find(nsIndex, datatype, key);
+    // mirror the size checks of Page::readItem, mismatches are reported by the flash path
+    if (entry == nullptr ||
+            (isVariableLengthType(datatype) ? dataSize < entry->mDataSize : dataSize != entry->mDataSize)) {
+        ++mMisses;
+        return false;
+    }
+    memcpy(data, entry->data(), entry->mDataSize);
+    if (&mEntries.front() != entry) {
+        mEntries.erase(entry);
+        mEntries.push_front(entry);
+    }
+    ++mHits;
+    return true;
+}
+
+bool ValueCache::getSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize)
+{
+    CacheEntry* entry = find(nsIndex, datatype, key);
+    if (entry == nullptr) {
+        return false;
+    }
+    dataSize = entry->mDataSize;
+    return true;
+}
+
+void ValueCache::insert(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    const size_t byteSize = sizeof(CacheEntry) + dataSize;
+    if (dataSize > mMaxValueSize || byteSize > mCapacity) {
+        return;
+    }
+
+    CacheEntry* entry = find(nsIndex, datatype, key);
+    if (entry) {
+        remove(entry);
+    }
+    while (mUsedBytes + byteSize > mCapacity) {
+        remove(&mEntries.back());
+        ++mEvictions;
+    }
+
+    void* mem = malloc(byteSize);
+    if (mem == nullptr) {
+        return;
+    }
+    entry = new (mem) CacheEntry;
+    entry->mNsIndex = nsIndex;
+    entry->mDatatype = datatype;
+    entry->mDataSize = dataSize;
+    std::fill_n(entry->mKey, sizeof(entry->mKey), 0);
+    strncpy(entry->mKey, key, sizeof(entry->mKey) - 1);
+    memcpy(entry->data(), data, dataSize);
+    mEntries.push_front(entry);
+    mUsedBytes += byteSize;
+}
+
+void ValueCache::invalidate(uint8_t nsIndex, const char* key)
+{
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        CacheEntry* entry = it++;
+        if (entry->mNsIndex == nsIndex && strncmp(entry->mKey, key, Item::MAX_KEY_LENGTH) == 0) {
+            remove(entry);
+        }
+    }
+}
+
+void ValueCache::invalidateNamespace(uint8_t nsIndex)
+{
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        CacheEntry* entry = it++;
+        if (entry->mNsIndex == nsIndex) {
+            remove(entry);
+        }
+    }
+}
+
+void ValueCache::clear()
+{
+    while (!mEntries.empty()) {
+        remove(&mEntries.front());
+    }
+}
+
+void ValueCache::fillStats(nvs_value_cache_stats_t& stats) const
+{
+    stats.hits = mHits;
+    stats.misses = mMisses;
+    stats.evictions = mEvictions;
+    stats.entry_count = mEntries.size();
+    stats.used_bytes = mUsedBytes;
+    stats.capacity = mCapacity;
+}
+
+} // namespace nvs
@@ -0,0 +1,102 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_value_cache_hpp
+#define nvs_value_cache_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "intrusive_list.h"
+
+namespace nvs
+{
+
+/**
+ * Bounded RAM cache of recently read values, so that repeated reads of the same keys
+ * do not go to flash.
+ *
+ * Entries are kept in least recently used order and evicted from the tail once the total
+ * size of the entries (including their bookkeeping) would exceed the capacity. The cache is
+ * meant to hold a few dozen small values, so lookups simply walk the list.
+ *
+ * Storage is responsible for invalidating the entries of a key whenever the key is written
+ * or erased.
+ */
+class ValueCache
+{
+public:
+    ValueCache(size_t capacity, size_t maxValueSize);
+    ~ValueCache();
+
+    /**
+     * Copies the cached value into data. Fails (and counts a miss) if the value is not cached
+     * or if dataSize would not be accepted by Storage::readItem for this value.
+     */
+    bool read(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize);
+
+    bool getSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize);
+
+    void insert(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    /**
+     * Drops the entries of the key, for all data types.
+     */
+    void invalidate(uint8_t nsIndex, const char* key);
+
+    void invalidateNamespace(uint8_t nsIndex);
+
+    void clear();
+
+    void fillStats(nvs_value_cache_stats_t& stats) const;
+
+private:
+    ValueCache(const ValueCache& other);
+    const ValueCache& operator= (const ValueCache& rhs);
+
+protected:
+    struct CacheEntry : public intrusive_list_node<CacheEntry> {
+        uint8_t mNsIndex;
+        ItemType mDatatype;
+        uint16_t mDataSize;
+        char mKey[Item::MAX_KEY_LENGTH + 1];
+
+        uint8_t* data()
+        {
+            return reinterpret_cast<uint8_t*>(this + 1);
+        }
+
+        size_t byteSize() const
+        {
+            return sizeof(CacheEntry) + mDataSize;
+        }
+    };
+
+    typedef intrusive_list<CacheEntry> TEntryList;
+
+    CacheEntry* find(uint8_t nsIndex, ItemType datatype, const char* key);
+
+    void remove(CacheEntry* entry);
+
+    TEntryList mEntries;
+    size_t mCapacity;
+    size_t mMaxValueSize;
+    size_t mUsedBytes = 0;
+    uint32_t mHits = 0;
+    uint32_t mMisses = 0;
+    uint32_t mEvictions = 0;
+}; // class ValueCache
+
+} // namespace nvs
+
+#endif /* nvs_value_cache_hpp */
@@ -0,0 +1,282 @@
+// Copyright 2015-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Benchmarks of the NVS engine on the flash emulator, built as a separate program
+ * with "make bench".
+ *
+ * Every workload uses a fixed random seed, so the emulated figures (flash time, erase
+ * and write counts) are reproducible and can be compared between revisions.
+ * CPU time is the host process time spent in the workload and varies between machines.
+ */
+
+#include "catch.hpp"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "nvs_test_api.h"
+#include "sdkconfig.h"
+#include "spi_flash_emulation.h"
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+#define TEST_ESP_OK(rc) CHECK((rc) == ESP_OK)
+
+namespace {
+
+const uint32_t SECTORS = 16;
+
+class Benchmark
+{
+public:
+    Benchmark(const char* name) : mName(name), mEmu(SECTORS)
+    {
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+    }
+
+    ~Benchmark()
+    {
+        nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME);
+    }
+
+    /* Measurement starts here, so that setup work is not counted. */
+    void start()
+    {
+        mEmu.clearStats();
+        mLogicalBytes = 0;
+        mOperations = 0;
+        mStartClock = clock();
+    }
+
+    /* Called for every value written, with the size of the value as passed to nvs_set_*. */
+    void count(size_t logicalBytes)
+    {
+        mLogicalBytes += logicalBytes;
+        ++mOperations;
+    }
+
+    void report()
+    {
+        const double cpuMs = 1000.0 * (clock() - mStartClock) / CLOCKS_PER_SEC;
+        size_t minErase = SIZE_MAX;
+        size_t maxErase = 0;
+        for (uint32_t i = 0; i < SECTORS; ++i) {
+            minErase = std::min(minErase, mEmu.getSectorEraseOps(i));
+            maxErase = std::max(maxErase, mEmu.getSectorEraseOps(i));
+        }
+
+        cout << mName << ": " << mOperations << " writes, " << mLogicalBytes << " bytes" << endl;
+        cout << "    flash time " << mEmu.getTotalTime() / 1000 << " ms, cpu time "
+             << fixed << setprecision(1) << cpuMs << " ms" << endl;
+        cout << "    " << mEmu.getReadOps() << " reads (" << mEmu.getReadBytes() << " bytes), "
+             << mEmu.getWriteOps() << " writes (" << mEmu.getWriteBytes() << " bytes), "
+             << mEmu.getEraseOps() << " erases" << endl;
+        cout << "    write amplification " << setprecision(2)
+             << ((mLogicalBytes) ? static_cast<double>(mEmu.getWriteBytes()) / mLogicalBytes : 0.0) << endl;
+        cout << "    erases per sector: min " << minErase << ", max " << maxErase << ",";
+        for (uint32_t i = 0; i < SECTORS; ++i) {
+            cout << " " << mEmu.getSectorEraseOps(i);
+        }
+        cout << endl;
+    }
+
+protected:
+    const char* mName;
+    SpiFlashEmulator mEmu;
+    size_t mLogicalBytes = 0;
+    size_t mOperations = 0;
+    clock_t mStartClock = 0;
+};
+
+void makeKey(char* key, size_t size, const char* prefix, size_t index)
+{
+    snprintf(key, size, "%s%d", prefix, static_cast<int>(index));
+}
+
+} // namespace
+
+TEST_CASE("random small sets", "[bench]")
+{
+    const size_t NS_COUNT = 4;
+    const size_t KEY_COUNT = 64;
+    const size_t WRITE_COUNT = 10000;
+
+    Benchmark bench("random small sets");
+    nvs_handle_t handles[NS_COUNT];
+    for (size_t i = 0; i < NS_COUNT; ++i) {
+        char ns[16];
+        makeKey(ns, sizeof(ns), "ns", i);
+        TEST_ESP_OK(nvs_open(ns, NVS_READWRITE, &handles[i]));
+    }
+
+    std::mt19937 gen(1);
+    bench.start();
+    for (size_t i = 0; i < WRITE_COUNT; ++i) {
+        nvs_handle_t handle = handles[gen() % NS_COUNT];
+        size_t index = gen() % KEY_COUNT;
+        char key[16];
+        // the type of a key stays the same, like in real applications
+        switch (index % 4) {
+        case 0:
+            makeKey(key, sizeof(key), "u8_", index);
+            TEST_ESP_OK(nvs_set_u8(handle, key, static_cast<uint8_t>(gen())));
+            bench.count(sizeof(uint8_t));
+            break;
+        case 1:
+            makeKey(key, sizeof(key), "u32_", index);
+            TEST_ESP_OK(nvs_set_u32(handle, key, gen()));
+            bench.count(sizeof(uint32_t));
+            break;
+        case 2:
+            makeKey(key, sizeof(key), "i64_", index);
+            TEST_ESP_OK(nvs_set_i64(handle, key, static_cast<int64_t>(gen()) << 16));
+            bench.count(sizeof(int64_t));
+            break;
+        default: {
+            makeKey(key, sizeof(key), "str", index);
+            char value[24];
+            snprintf(value, sizeof(value), "value %u", static_cast<unsigned>(gen() % 100000));
+            TEST_ESP_OK(nvs_set_str(handle, key, value));
+            bench.count(strlen(value) + 1);
+            break;
+        }
+        }
+    }
+    bench.report();
+
+    for (size_t i = 0; i < NS_COUNT; ++i) {
+        nvs_close(handles[i]);
+    }
+}
+
+TEST_CASE("blob churn", "[bench]")
+{
+    const size_t KEY_COUNT = 6;
+    const size_t WRITE_COUNT = 600;
+    const size_t MAX_BLOB_SIZE = 6000;
+
+    Benchmark bench("blob churn");
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("blobs", NVS_READWRITE, &handle));
+    vector<uint8_t> blob(MAX_BLOB_SIZE);
+    vector<uint8_t> readBack(MAX_BLOB_SIZE);
+    vector<size_t> sizes(KEY_COUNT, 0);
+
+    std::mt19937 gen(2);
+    bench.start();
+    for (size_t i = 0; i < WRITE_COUNT; ++i) {
+        size_t index = gen() % KEY_COUNT;
+        size_t size = 16 + gen() % (MAX_BLOB_SIZE - 16);
+        std::fill_n(blob.begin(), size, static_cast<uint8_t>(i));
+        char key[16];
+        makeKey(key, sizeof(key), "blob", index);
+        TEST_ESP_OK(nvs_set_blob(handle, key, blob.data(), size));
+        sizes[index] = size;
+        bench.count(size);
+    }
+    bench.report();
+
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        if (!sizes[i]) {
+            continue;
+        }
+        char key[16];
+        makeKey(key, sizeof(key), "blob", i);
+        size_t size = readBack.size();
+        TEST_ESP_OK(nvs_get_blob(handle, key, readBack.data(), &size));
+        CHECK(size == sizes[i]);
+    }
+    nvs_close(handle);
+}
+
+TEST_CASE("namespace-heavy layout", "[bench]")
+{
+    const size_t NS_COUNT = 100;
+    const size_t KEYS_PER_NS = 4;
+    const size_t ROUNDS = 10;
+
+    Benchmark bench("namespace-heavy layout");
+    std::mt19937 gen(3);
+    bench.start();
+    // every round opens each namespace, updates a few keys and closes it again
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < NS_COUNT; ++i) {
+            char ns[16];
+            makeKey(ns, sizeof(ns), "comp", i);
+            nvs_handle_t handle;
+            TEST_ESP_OK(nvs_open(ns, NVS_READWRITE, &handle));
+            for (size_t k = 0; k < KEYS_PER_NS; ++k) {
+                if (round > 0 && gen() % 2) {
+                    continue;
+                }
+                char key[16];
+                makeKey(key, sizeof(key), "param", k);
+                TEST_ESP_OK(nvs_set_u32(handle, key, gen()));
+                bench.count(sizeof(uint32_t));
+            }
+            TEST_ESP_OK(nvs_commit(handle));
+            nvs_close(handle);
+        }
+    }
+    bench.report();
+}
+
+static void fullPartitionGc(bool incremental)
+{
+    // live data takes most of the partition, so that every new page has to be reclaimed
+    const size_t KEY_COUNT = 110;
+    const size_t VALUE_SIZE = 200;
+    const size_t WRITE_COUNT = 3000;
+
+    Benchmark bench(incremental ? "full partition gc, incremental" : "full partition gc");
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("full", NVS_READWRITE, &handle));
+    vector<uint8_t> value(VALUE_SIZE, 0x5a);
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        char key[16];
+        makeKey(key, sizeof(key), "item", i);
+        TEST_ESP_OK(nvs_set_blob(handle, key, value.data(), value.size()));
+    }
+
+    std::mt19937 gen(4);
+    bench.start();
+    for (size_t i = 0; i < WRITE_COUNT; ++i) {
+        char key[16];
+        makeKey(key, sizeof(key), "item", gen() % KEY_COUNT);
+        value[0] = static_cast<uint8_t>(i);
+        TEST_ESP_OK(nvs_set_blob(handle, key, value.data(), value.size()));
+        bench.count(value.size());
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+        if (incremental) {
+            TEST_ESP_OK(nvs_gc_step(NULL, 16, NULL));
+        }
+#endif
+    }
+    bench.report();
+    nvs_close(handle);
+}
+
+TEST_CASE("full partition gc", "[bench]")
+{
+    fullPartitionGc(false);
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+    fullPartitionGc(true);
+#endif
+}
@@ -1,3 +1,24 @@
 #define CONFIG_NVS_ENCRYPTION 1
 //currently use the legacy implementation, since the stubs for new HAL are not done yet
 #define CONFIG_SPI_FLASH_USE_LEGACY_IMPL 1
+#define CONFIG_IDF_TARGET_ESP32 1
+
+#ifdef NVS_HOST_TEST_DEFAULT_CONFIG
+// test_nvs_default: optional features left at their Kconfig defaults
+#define CONFIG_NVS_HASH_LIST_BLOCKS 1
+#define CONFIG_NVS_BLOB_WRITE_BUFFER_SIZE 512
+#define CONFIG_ESP_CRC32_TABLE_SLICES 8
+#else
+// test_nvs: every optional feature enabled
+#define CONFIG_NVS_HASH_LIST_INLINE 1
+#define CONFIG_NVS_ITEM_INDEX 1
+#define CONFIG_NVS_ITEM_INDEX_MAX_ENTRIES 4096
+#define CONFIG_NVS_FAST_MOUNT 1
+#define CONFIG_NVS_VALUE_CACHE 1
+#define CONFIG_NVS_VALUE_CACHE_SIZE 1024
+#define CONFIG_NVS_VALUE_CACHE_MAX_VALUE_SIZE 64
+#define CONFIG_NVS_BLOB_WRITE_BUFFER_SIZE 256
+#define CONFIG_NVS_INCREMENTAL_GC 1
+#define CONFIG_NVS_GC_RESERVE_PAGES 3
+#define CONFIG_ESP_CRC32_TABLE_SLICES 4
+#endif
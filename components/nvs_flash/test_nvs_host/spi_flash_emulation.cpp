@@ -13,10 +13,14 @@
 // limitations under the License.
 #include "esp_spi_flash.h"
 #include "spi_flash_emulation.h"
+#include <mutex>
 
 
 static SpiFlashEmulator* s_emulator = nullptr;
 
+// serializes flash operations from several threads, like the flash driver does on the chip
+static std::mutex s_emulator_mutex;
+
 void spi_flash_emulator_set(SpiFlashEmulator* e)
 {
     s_emulator = e;
@@ -24,6 +28,7 @@ void spi_flash_emulator_set(SpiFlashEmulator* e)
 
 esp_err_t spi_flash_erase_sector(size_t sec)
 {
+    std::lock_guard<std::mutex> lock(s_emulator_mutex);
     if (!s_emulator) {
         return ESP_ERR_FLASH_OP_TIMEOUT;
     }
@@ -37,6 +42,7 @@ esp_err_t spi_flash_erase_sector(size_t sec)
 
 esp_err_t spi_flash_write(size_t des_addr, const void *src_addr, size_t size)
 {
+    std::lock_guard<std::mutex> lock(s_emulator_mutex);
     if (!s_emulator) {
         return ESP_ERR_FLASH_OP_TIMEOUT;
     }
@@ -50,6 +56,7 @@ esp_err_t spi_flash_write(size_t des_addr, const void *src_addr, size_t size)
 
 esp_err_t spi_flash_read(size_t src_addr, void *des_addr, size_t size)
 {
+    std::lock_guard<std::mutex> lock(s_emulator_mutex);
     if (!s_emulator) {
         return ESP_ERR_FLASH_OP_TIMEOUT;
     }
@@ -36,6 +36,7 @@ public:
     SpiFlashEmulator(size_t sectorCount) : mUpperSectorBound(sectorCount)
     {
         mData.resize(sectorCount * SPI_FLASH_SEC_SIZE / 4, 0xffffffff);
+        mSectorEraseOps.resize(sectorCount, 0);
         spi_flash_emulator_set(this);
     }
 
@@ -45,6 +46,7 @@ public:
         // Atleast one page should be free, hence we create mData of size of 2 sectors.
         mData.resize(mData.size() + SPI_FLASH_SEC_SIZE / 4, 0xffffffff);
         mUpperSectorBound = mData.size() * 4 / SPI_FLASH_SEC_SIZE;
+        mSectorEraseOps.resize(mUpperSectorBound, 0);
         spi_flash_emulator_set(this);
     }
 
@@ -124,6 +126,7 @@ public:
         std::fill_n(begin(mData) + offset, SPI_FLASH_SEC_SIZE / 4, 0xffffffff);
 
         ++mEraseOps;
+        ++mSectorEraseOps[sectorNumber];
         mTotalTime += getEraseOpTime();
         return true;
     }
@@ -181,6 +184,7 @@ public:
         mReadOps = 0;
         mWriteOps = 0;
         mTotalTime = 0;
+        std::fill(mSectorEraseOps.begin(), mSectorEraseOps.end(), 0);
     }
 
     size_t getReadOps() const
@@ -195,6 +199,10 @@ public:
     {
         return mEraseOps;
     }
+    size_t getSectorEraseOps(size_t sectorNumber) const
+    {
+        return (sectorNumber < mSectorEraseOps.size()) ? mSectorEraseOps[sectorNumber] : 0;
+    }
     size_t getReadBytes() const
     {
         return mReadBytes;
@@ -231,6 +239,7 @@ protected:
     mutable size_t mWriteBytes = 0;
     mutable size_t mEraseOps = 0;
     mutable size_t mTotalTime = 0;
+    std::vector<size_t> mSectorEraseOps;
     size_t mLowerSectorBound = 0;
     size_t mUpperSectorBound = 0;
     
@@ -19,6 +19,7 @@
 #include "nvs_encr.hpp"
 #endif
 #include "spi_flash_emulation.h"
+#include "esp_crc.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -27,6 +28,11 @@
 #include <sys/wait.h>
 #include <string.h>
 #include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <vector>
 
 #define TEST_ESP_ERR(rc, res) CHECK((rc) == (res))
 #define TEST_ESP_OK(rc) CHECK((rc) == ESP_OK)
@@ -79,6 +85,71 @@ TEST_CASE("crc32 behaves as expected", "[nvs]")
     CHECK(crc32_1 != item2.calculateCrc32());
 }
 
+static uint32_t bitwiseCrc32(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+TEST_CASE("esp_crc32_le matches bitwise CRC32 for all lengths and alignments", "[nvs]")
+{
+    std::mt19937 gen(42);
+    uint8_t buf[100 + 8];
+    for (auto& b : buf) {
+        b = static_cast<uint8_t>(gen());
+    }
+    CHECK(esp_crc32_le(0, reinterpret_cast<const uint8_t*>("123456789"), 9) == 0xcbf43926);
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t len = 0; len <= 100; ++len) {
+            uint32_t init = gen();
+            REQUIRE(esp_crc32_le(init, buf + offset, len) == bitwiseCrc32(init, buf + offset, len));
+        }
+    }
+}
+
+TEST_CASE("benchmark esp_crc32_le vs bytewise table", "[nvs]")
+{
+    const size_t SIZE = Page::ENTRY_SIZE * Page::ENTRY_COUNT;
+    const size_t ROUNDS = 2000;
+    uint32_t table[256];
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint8_t byte = static_cast<uint8_t>(i);
+        table[i] = ~bitwiseCrc32(~0U, &byte, 1);
+    }
+    vector<uint8_t> data(SIZE, 0xa5);
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t bytewise = 0;
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        uint32_t crc = ~bytewise;
+        for (size_t i = 0; i < SIZE; ++i) {
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+        bytewise = ~crc;
+    }
+    auto bytewiseTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    uint32_t sliced = 0;
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        sliced = esp_crc32_le(sliced, data.data(), SIZE);
+    }
+    auto slicedTime = std::chrono::steady_clock::now() - start;
+    CHECK(sliced == bytewise);
+
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    const double bytes = static_cast<double>(SIZE) * ROUNDS;
+    s_perf << "CRC32 over " << SIZE << " bytes: bytewise " << bytes / duration_cast<nanoseconds>(bytewiseTime).count() * 1000
+           << " MB/s, esp_crc32_le " << bytes / duration_cast<nanoseconds>(slicedTime).count() * 1000 << " MB/s" << std::endl;
+}
+
 TEST_CASE("starting with empty flash, page is in uninitialized state", "[nvs]")
 {
     SpiFlashEmulator emu(1);
@@ -329,6 +400,276 @@ TEST_CASE("HashList is cleaned up as soon as items are erased", "[nvs]")
     CHECK(hashlist.getBlockCount() == 0);
 }
 
+TEST_CASE("HashTable finds items by hash and entry index", "[nvs]")
+{
+    HashTable table;
+    const size_t count = HashTable::MAX_ENTRIES;
+    for (size_t i = 0; i < count; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "i%ld", (long int)i);
+        table.insert(Item(1, ItemType::U32, 1, key), i);
+    }
+    CHECK(table.size() == count);
+    for (size_t i = 0; i < count; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "i%ld", (long int)i);
+        CHECK(table.find(0, Item(1, ItemType::U32, 1, key)) == i);
+        CHECK(table.find(i + 1, Item(1, ItemType::U32, 1, key)) == SIZE_MAX);
+    }
+    CHECK(table.find(0, Item(1, ItemType::U32, 1, "missing")) == SIZE_MAX);
+
+    // erase every other item, the rest must still be reachable
+    for (size_t i = 0; i < count; i += 2) {
+        table.erase(i, true);
+    }
+    table.erase(0, false);
+    CHECK(table.size() == count / 2);
+    for (size_t i = 0; i < count; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "i%ld", (long int)i);
+        CHECK(table.find(0, Item(1, ItemType::U32, 1, key)) == ((i % 2) ? i : SIZE_MAX));
+    }
+
+    // duplicate key, the first one at or after the start index is returned
+    table.insert(Item(1, ItemType::U32, 1, "i1"), 4);
+    CHECK(table.find(0, Item(1, ItemType::U32, 1, "i1")) == 1);
+    CHECK(table.find(2, Item(1, ItemType::U32, 1, "i1")) == 4);
+
+    // re-inserting an index replaces the old hash
+    table.insert(Item(1, ItemType::U32, 1, "other"), 4);
+    CHECK(table.find(2, Item(1, ItemType::U32, 1, "i1")) == SIZE_MAX);
+    CHECK(table.find(0, Item(1, ItemType::U32, 1, "other")) == 4);
+
+    table.clear();
+    CHECK(table.size() == 0);
+    CHECK(table.find(0, Item(1, ItemType::U32, 1, "i1")) == SIZE_MAX);
+}
+
+template<typename T>
+static size_t hashListBlockCount(T& list)
+{
+    return 0;
+}
+
+template<>
+size_t hashListBlockCount<HashListTestHelper>(HashListTestHelper& list)
+{
+    return list.getBlockCount();
+}
+
+template<typename T>
+static void benchmarkHashList(const char* name)
+{
+    const size_t rounds = 200;
+    const size_t count = HashTable::MAX_ENTRIES;
+    std::vector<Item> items;
+    for (size_t i = 0; i < count; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%ld", (long int)i);
+        items.push_back(Item(1, ItemType::U32, 1, key));
+    }
+    Item missing(1, ItemType::U32, 1, "missing");
+
+    std::chrono::steady_clock::duration insertTime(0), findTime(0), eraseTime(0);
+    size_t allocations = 0;
+    size_t maxBlocks = 0;
+    size_t failures = 0;
+    T* list = new T;
+    for (size_t round = 0; round < rounds; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            size_t blocks = hashListBlockCount(*list);
+            list->insert(items[i], i);
+            allocations += hashListBlockCount(*list) - blocks;
+        }
+        insertTime += std::chrono::steady_clock::now() - start;
+        maxBlocks = std::max(maxBlocks, hashListBlockCount(*list));
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            failures += list->find(0, items[i]) != i;
+            failures += list->find(0, missing) != SIZE_MAX;
+        }
+        findTime += std::chrono::steady_clock::now() - start;
+
+        // erase in the order in which items become obsolete on a page which is being rewritten
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            list->erase((i * 5) % count, true);
+        }
+        eraseTime += std::chrono::steady_clock::now() - start;
+    }
+    delete list;
+    CHECK(failures == 0);
+
+    using std::chrono::nanoseconds;
+    using std::chrono::duration_cast;
+    const size_t ops = rounds * count;
+    s_perf << name << ": insert " << duration_cast<nanoseconds>(insertTime).count() / ops
+           << " ns, find (hit+miss) " << duration_cast<nanoseconds>(findTime).count() / ops
+           << " ns, erase " << duration_cast<nanoseconds>(eraseTime).count() / ops
+           << " ns, heap allocations " << allocations << " (" << allocations / rounds << " per page load), peak "
+           << maxBlocks << " blocks, object size " << sizeof(T) << " bytes" << std::endl;
+}
+
+TEST_CASE("benchmark HashList vs HashTable", "[nvs]")
+{
+    benchmarkHashList<HashListTestHelper>("HashList (blocks)");
+    benchmarkHashList<HashTable>("HashTable (inline)");
+}
+
+TEST_CASE("ItemIndex tracks pages holding each key", "[nvs]")
+{
+    ItemIndex index(16);
+    Page pages[2];
+    Page* found[2];
+    Item item(1, ItemType::U32, 1, "key");
+    Item other(2, ItemType::U32, 1, "key");
+
+    CHECK(index.find(item, found, 2) == 0);
+    index.insert(item, &pages[0]);
+    index.insert(item, &pages[1]);
+    index.insert(other, &pages[1]);
+    CHECK(index.size() == 3);
+    REQUIRE(index.find(item, found, 2) == 2);
+    CHECK(((found[0] == &pages[0] && found[1] == &pages[1]) || (found[0] == &pages[1] && found[1] == &pages[0])));
+
+    // same key written twice to one page, it stays indexed until both copies are erased
+    index.insert(item, &pages[0]);
+    index.erase(item, &pages[0]);
+    REQUIRE(index.find(item, found, 2) == 2);
+    index.erase(item, &pages[0]);
+    REQUIRE(index.find(item, found, 2) == 1);
+    CHECK(found[0] == &pages[1]);
+
+    index.erasePage(&pages[1]);
+    CHECK(index.find(item, found, 2) == 0);
+    CHECK(index.find(other, found, 2) == 0);
+    CHECK(index.size() == 0);
+    CHECK(index.isValid());
+}
+
+TEST_CASE("ItemIndex is dropped when it runs out of budget", "[nvs]")
+{
+    const size_t maxEntries = 100;
+    ItemIndex index(maxEntries);
+    Page page;
+    Page* found;
+    for (size_t i = 0; i < maxEntries; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "i%ld", (long int)i);
+        index.insert(Item(1, ItemType::U32, 1, key), &page);
+    }
+    CHECK(index.isValid());
+    CHECK(index.size() == maxEntries);
+    CHECK(index.find(Item(1, ItemType::U32, 1, "i42"), &found, 1) == 1);
+    index.insert(Item(1, ItemType::U32, 1, "one too many"), &page);
+    CHECK_FALSE(index.isValid());
+    CHECK(index.size() == 0);
+    index.clear();
+    CHECK(index.isValid());
+}
+
+class StorageScanHelper : public Storage
+{
+public:
+    // per-page search, as done without the item index
+    esp_err_t scanForItem(uint8_t nsIndex, ItemType datatype, const char* key)
+    {
+        for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
+            if (it->findItem(nsIndex, datatype, key) == ESP_OK) {
+                return ESP_OK;
+            }
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+};
+
+TEST_CASE("benchmark key lookup cost vs. page count", "[nvs]")
+{
+    const size_t lookups = 20000;
+    const size_t pageCounts[] = {4, 8, 16, 32};
+    for (size_t pageCount : pageCounts) {
+        SpiFlashEmulator emu(pageCount);
+        StorageScanHelper storage;
+        REQUIRE(storage.init(0, pageCount) == ESP_OK);
+        const size_t keyCount = (pageCount - 2) * (Page::ENTRY_COUNT - 6);
+        char key[16];
+        for (size_t i = 0; i < keyCount; ++i) {
+            snprintf(key, sizeof(key), "k%ld", (long int)i);
+            REQUIRE(storage.writeItem(1, key, static_cast<uint32_t>(i)) == ESP_OK);
+        }
+
+        // keep Catch assertions out of the timed loops
+        size_t failures = 0;
+        uint32_t value;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            snprintf(key, sizeof(key), "k%ld", (long int)(i % keyCount));
+            failures += storage.readItem(1, key, value) != ESP_OK;
+        }
+        auto hitTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            snprintf(key, sizeof(key), "missing%ld", (long int)i);
+            failures += storage.readItem(1, key, value) != ESP_ERR_NVS_NOT_FOUND;
+        }
+        auto missTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            snprintf(key, sizeof(key), "missing%ld", (long int)i);
+            failures += storage.scanForItem(1, ItemType::U32, key) != ESP_ERR_NVS_NOT_FOUND;
+        }
+        auto scanTime = std::chrono::steady_clock::now() - start;
+        CHECK(failures == 0);
+
+        using std::chrono::nanoseconds;
+        using std::chrono::duration_cast;
+        s_perf << "Key lookup, " << pageCount << " pages, " << keyCount << " keys: hit "
+               << duration_cast<nanoseconds>(hitTime).count() / lookups << " ns, miss "
+               << duration_cast<nanoseconds>(missTime).count() / lookups << " ns, per-page scan miss "
+               << duration_cast<nanoseconds>(scanTime).count() / lookups << " ns" << std::endl;
+    }
+}
+
+#ifdef CONFIG_NVS_ITEM_INDEX
+TEST_CASE("erase by key looks up the item index", "[nvs]")
+{
+    const size_t pageCount = 8;
+    SpiFlashEmulator emu(pageCount);
+    Storage storage;
+    REQUIRE(storage.init(0, pageCount) == ESP_OK);
+    char key[16];
+    for (size_t i = 0; i < 300; ++i) {
+        snprintf(key, sizeof(key), "k%ld", (long int)i);
+        REQUIRE(storage.writeItem(1, key, static_cast<uint32_t>(i)) == ESP_OK);
+    }
+    uint8_t blob[3000];
+    memset(blob, 0x5a, sizeof(blob));
+    REQUIRE(storage.writeItem(1, ItemType::BLOB, "blob", blob, sizeof(blob)) == ESP_OK);
+    REQUIRE(storage.writeItem(1, ItemType::SZ, "str", "value", 6) == ESP_OK);
+
+    // a missing key is rejected by the index without reading flash
+    emu.clearStats();
+    CHECK(storage.eraseItem(1, "missing") == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(emu.getReadOps() == 0);
+
+    uint32_t value;
+    TEST_ESP_OK(storage.eraseItem(1, "k0"));
+    TEST_ESP_OK(storage.eraseItem(1, "k299"));
+    TEST_ESP_OK(storage.eraseItem(1, "blob"));
+    TEST_ESP_OK(storage.eraseItem(1, "str"));
+    CHECK(storage.readItem(1, "k0", value) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(storage.readItem(1, "k299", value) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(storage.readItem(1, ItemType::BLOB, "blob", blob, sizeof(blob)) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(storage.eraseItem(1, "blob") == ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(storage.readItem(1, "k150", value));
+    CHECK(value == 150);
+}
+#endif // CONFIG_NVS_ITEM_INDEX
+
 TEST_CASE("can init PageManager in empty flash", "[nvs]")
 {
     SpiFlashEmulator emu(4);
@@ -1759,6 +2100,84 @@ TEST_CASE("multiple partitions access check", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition("nvs2"));
 }
 
+TEST_CASE("concurrent access to multiple partitions from several threads", "[nvs]")
+{
+    const size_t partitions = 3;
+    const size_t threadsPerPartition = 3;
+    const size_t iterations = 300;
+    SpiFlashEmulator emu(partitions * 4);
+    const char* names[partitions] = {"nvs1", "nvs2", "nvs3"};
+    for (size_t p = 0; p < partitions; ++p) {
+        TEST_ESP_OK( nvs_flash_init_custom(names[p], p * 4, 4) );
+    }
+
+    // Catch assertions are not thread safe, so the threads only count failures
+    std::atomic<int> failures(0);
+    auto worker = [&](const char* partName, size_t id) {
+        char ns[16];
+        snprintf(ns, sizeof(ns), "ns%d", (int) id);
+        nvs_handle_t handle;
+        if (nvs_open_from_partition(partName, ns, NVS_READWRITE, &handle) != ESP_OK) {
+            ++failures;
+            return;
+        }
+        for (size_t i = 0; i < iterations; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", (int) (i % 8));
+            uint32_t value = id * 0x10000 + i;
+            char str[32];
+            snprintf(str, sizeof(str), "%s %d", partName, (int) value);
+            if (nvs_set_u32(handle, key, value) != ESP_OK || nvs_set_str(handle, "str", str) != ESP_OK) {
+                ++failures;
+                continue;
+            }
+            uint32_t readValue;
+            char readStr[32];
+            size_t len = sizeof(readStr);
+            if (nvs_get_u32(handle, key, &readValue) != ESP_OK || readValue != value ||
+                    nvs_get_str(handle, "str", readStr, &len) != ESP_OK || strcmp(str, readStr) != 0) {
+                ++failures;
+            }
+            if (i % 50 == 0) {
+                nvs_stats_t stats;
+                if (nvs_get_stats(partName, &stats) != ESP_OK) {
+                    ++failures;
+                }
+            }
+        }
+        nvs_close(handle);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < partitions; ++p) {
+        for (size_t t = 0; t < threadsPerPartition; ++t) {
+            threads.emplace_back(worker, names[p], p * threadsPerPartition + t);
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(failures == 0);
+
+    // everything written must also be found after loading the partitions again
+    for (size_t p = 0; p < partitions; ++p) {
+        TEST_ESP_OK( nvs_flash_deinit_partition(names[p]) );
+        TEST_ESP_OK( nvs_flash_init_custom(names[p], p * 4, 4) );
+        for (size_t t = 0; t < threadsPerPartition; ++t) {
+            size_t id = p * threadsPerPartition + t;
+            char ns[16];
+            snprintf(ns, sizeof(ns), "ns%d", (int) id);
+            nvs_handle_t handle;
+            TEST_ESP_OK( nvs_open_from_partition(names[p], ns, NVS_READONLY, &handle) );
+            uint32_t value;
+            TEST_ESP_OK( nvs_get_u32(handle, "key3", &value) );
+            CHECK(value == id * 0x10000 + iterations - 1);
+            nvs_close(handle);
+        }
+        TEST_ESP_OK( nvs_flash_deinit_partition(names[p]) );
+    }
+}
+
 TEST_CASE("nvs page selection takes into account free entries also not just erased entries", "[nvs]")
 {
     const size_t blob_size = Page::CHUNK_MAX_SIZE/2;
@@ -1992,6 +2411,626 @@ TEST_CASE("Recovery from power-off when page is being freed.", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
 }
 
+TEST_CASE("transaction applies staged operations on commit only", "[nvs]")
+{
+    SpiFlashEmulator emu(5);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 5));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 1));
+    TEST_ESP_OK(nvs_set_str(handle, "name", "old"));
+    TEST_ESP_OK(nvs_set_u8(handle, "obsolete", 1));
+
+    TEST_ESP_ERR(nvs_transaction_commit(handle), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_transaction_abort(handle), ESP_ERR_NVS_INVALID_STATE);
+
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_ERR(nvs_transaction_begin(handle), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 2));
+    TEST_ESP_OK(nvs_transaction_abort(handle));
+
+    uint32_t counter;
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &counter));
+    CHECK(counter == 1);
+
+    uint8_t blob[Page::CHUNK_MAX_SIZE + 100];
+    std::fill_n(blob, sizeof(blob), 0x5a);
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 2));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 3));
+    TEST_ESP_OK(nvs_set_str(handle, "name", "new"));
+    TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, sizeof(blob)));
+    TEST_ESP_OK(nvs_erase_key(handle, "obsolete"));
+    TEST_ESP_OK(nvs_set_i16(handle, "fresh", -5));
+    TEST_ESP_ERR(nvs_set_u8(handle, "key_name_too_long", 1), ESP_ERR_NVS_KEY_TOO_LONG);
+    TEST_ESP_ERR(nvs_erase_all(handle), ESP_ERR_NVS_INVALID_STATE);
+
+    // staged operations are not visible before commit
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &counter));
+    CHECK(counter == 1);
+    int16_t fresh;
+    TEST_ESP_ERR(nvs_get_i16(handle, "fresh", &fresh), ESP_ERR_NVS_NOT_FOUND);
+
+    TEST_ESP_OK(nvs_transaction_commit(handle));
+    TEST_ESP_ERR(nvs_transaction_commit(handle), ESP_ERR_NVS_INVALID_STATE);
+
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &counter));
+    CHECK(counter == 3);
+    char name[8];
+    size_t nameSize = sizeof(name);
+    TEST_ESP_OK(nvs_get_str(handle, "name", name, &nameSize));
+    CHECK(strcmp(name, "new") == 0);
+    uint8_t readBlob[sizeof(blob)];
+    size_t blobSize = sizeof(readBlob);
+    TEST_ESP_OK(nvs_get_blob(handle, "blob", readBlob, &blobSize));
+    CHECK(memcmp(blob, readBlob, sizeof(blob)) == 0);
+    uint8_t obsolete;
+    TEST_ESP_ERR(nvs_get_u8(handle, "obsolete", &obsolete), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_get_i16(handle, "fresh", &fresh));
+    CHECK(fresh == -5);
+    nvs_close(handle);
+
+    nvs_handle_t readOnly;
+    TEST_ESP_OK(nvs_open("test", NVS_READONLY, &readOnly));
+    TEST_ESP_ERR(nvs_transaction_begin(readOnly), ESP_ERR_NVS_READ_ONLY);
+    nvs_close(readOnly);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("transaction journal is kept in a namespace applications can't see", "[nvs]")
+{
+    SpiFlashEmulator emu(5);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 5));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 1));
+    TEST_ESP_OK(nvs_transaction_commit(handle));
+    nvs_close(handle);
+    TEST_ESP_ERR(nvs_open("nvs.internal", NVS_READONLY, &handle), ESP_ERR_NVS_INVALID_NAME);
+    TEST_ESP_ERR(nvs_open("nvs.internal", NVS_READWRITE, &handle), ESP_ERR_NVS_INVALID_NAME);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+
+    // leave an item in the internal namespace, as an interrupted commit does
+    {
+        Storage storage;
+        TEST_ESP_OK(storage.init(0, 5));
+        TEST_ESP_OK(storage.writeItem(Page::NS_INTERNAL, "hidden", static_cast<uint32_t>(1)));
+    }
+
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 5));
+    nvs_stats_t stats;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.namespace_count == 1);
+    size_t count = 0;
+    for (nvs_iterator_t it = nvs_entry_find(NVS_DEFAULT_PART_NAME, NULL, NVS_TYPE_ANY); it != NULL; it = nvs_entry_next(it)) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        CHECK(strcmp(info.namespace_name, "test") == 0);
+        CHECK(strcmp(info.key, "counter") == 0);
+        ++count;
+    }
+    CHECK(count == 1);
+
+    // new namespaces never get the internal index
+    for (int i = 0; i < 252; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "ns%d", i);
+        TEST_ESP_OK(nvs_open(name, NVS_READWRITE, &handle));
+        nvs_close(handle);
+    }
+    TEST_ESP_ERR(nvs_open("one too many", NVS_READWRITE, &handle), ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 2));
+    TEST_ESP_OK(nvs_transaction_commit(handle));
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("transaction is refused if an older version gave the internal index to a namespace", "[nvs]")
+{
+    SpiFlashEmulator emu(5);
+    {
+        Storage storage;
+        TEST_ESP_OK(storage.init(0, 5));
+        const uint8_t nsIndex = Page::NS_INTERNAL;
+        TEST_ESP_OK(storage.writeItem(Page::NS_INDEX, "legacy", nsIndex));
+    }
+
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 5));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("legacy", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 1));
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 2));
+    TEST_ESP_ERR(nvs_transaction_commit(handle), ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    uint32_t counter;
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &counter));
+    CHECK(counter == 1);
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("transaction is applied completely or not at all after power-off", "[nvs]")
+{
+    const size_t KEY_COUNT = 30;
+    const uint32_t SECTORS = 5;
+
+    auto prepare = [&](SpiFlashEmulator& emu, nvs_handle_t& handle) {
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        // leave some items on the first page, so that old values end up on several pages
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+            TEST_ESP_OK(nvs_set_u32(handle, key, 1));
+            for (int j = 0; j < 3; ++j) {
+                TEST_ESP_OK(nvs_set_u32(handle, "filler", j + i * 3));
+            }
+        }
+        TEST_ESP_OK(nvs_set_str(handle, "str", "generation 1"));
+        TEST_ESP_OK(nvs_transaction_begin(handle));
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+            TEST_ESP_OK(nvs_set_u32(handle, key, 2));
+        }
+        TEST_ESP_OK(nvs_set_str(handle, "str", "generation 2"));
+        TEST_ESP_OK(nvs_erase_key(handle, "filler"));
+        emu.clearStats();
+    };
+
+    // count the words written by a successful commit
+    size_t totalWords;
+    {
+        SpiFlashEmulator emu(SECTORS);
+        nvs_handle_t handle;
+        prepare(emu, handle);
+        TEST_ESP_OK(nvs_transaction_commit(handle));
+        totalWords = emu.getWriteBytes() / 4 + emu.getEraseOps();
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+
+    size_t appliedCount = 0;
+    for (size_t failAfter = 0; failAfter < totalWords; ++failAfter) {
+        SpiFlashEmulator emu(SECTORS);
+        nvs_handle_t handle;
+        prepare(emu, handle);
+        emu.failAfter(failAfter);
+        CHECK(nvs_transaction_commit(handle) != ESP_OK);
+        nvs_close(handle);
+
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        uint32_t first;
+        TEST_ESP_OK(nvs_get_u32(handle, "key0", &first));
+        REQUIRE((first == 1 || first == 2));
+        bool applied = (first == 2);
+        appliedCount += applied;
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+            uint32_t value;
+            TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+            CHECK(value == (applied ? 2 : 1));
+        }
+        char str[16];
+        size_t strSize = sizeof(str);
+        TEST_ESP_OK(nvs_get_str(handle, "str", str, &strSize));
+        CHECK(strcmp(str, applied ? "generation 2" : "generation 1") == 0);
+        uint32_t filler;
+        CHECK(nvs_get_u32(handle, "filler", &filler) == (applied ? ESP_ERR_NVS_NOT_FOUND : ESP_OK));
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+    // power-off happened both before and after the commit point
+    CHECK(appliedCount > 0);
+    CHECK(appliedCount < totalWords);
+}
+
+TEST_CASE("benchmark transaction vs. individual writes", "[nvs]")
+{
+    for (size_t keyCount : {20, 50}) {
+        size_t individual[3];
+        size_t batched[3];
+        for (int useTransaction = 0; useTransaction < 2; ++useTransaction) {
+            SpiFlashEmulator emu(10);
+            TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 10));
+            nvs_handle_t handle;
+            TEST_ESP_OK(nvs_open("config", NVS_READWRITE, &handle));
+            for (size_t i = 0; i < keyCount; ++i) {
+                char key[16];
+                snprintf(key, sizeof(key), "cfg%d", static_cast<int>(i));
+                TEST_ESP_OK(nvs_set_u32(handle, key, 0));
+            }
+
+            emu.clearStats();
+            if (useTransaction) {
+                TEST_ESP_OK(nvs_transaction_begin(handle));
+            }
+            for (size_t i = 0; i < keyCount; ++i) {
+                char key[16];
+                snprintf(key, sizeof(key), "cfg%d", static_cast<int>(i));
+                TEST_ESP_OK(nvs_set_u32(handle, key, i + 1));
+            }
+            if (useTransaction) {
+                TEST_ESP_OK(nvs_transaction_commit(handle));
+            }
+            size_t* result = useTransaction ? batched : individual;
+            result[0] = emu.getWriteOps();
+            result[1] = emu.getWriteBytes();
+            result[2] = emu.getTotalTime();
+            nvs_close(handle);
+            TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+        }
+        CHECK(batched[0] < individual[0]);
+        s_perf << "Update of " << keyCount << " u32 keys: individual " << individual[0] << " writes, "
+               << individual[1] << " bytes, " << individual[2] << " us; transaction "
+               << batched[0] << " writes, " << batched[1] << " bytes, " << batched[2] << " us" << std::endl;
+    }
+}
+
+TEST_CASE("namespace entries stored after other items of namespace 0 are loaded", "[nvs]")
+{
+    SpiFlashEmulator emu(5);
+    {
+        Storage storage;
+        TEST_ESP_OK(storage.init(0, 5));
+        const uint8_t ns1 = 1, ns2 = 2;
+        const uint8_t blob[40] = {0};
+        TEST_ESP_OK(storage.writeItem(Page::NS_INDEX, "first", ns1));
+        TEST_ESP_OK(storage.writeItem(Page::NS_INDEX, ItemType::BLOB, "sum.00000000", blob, sizeof(blob)));
+        TEST_ESP_OK(storage.writeItem(Page::NS_INDEX, "second", ns2));
+    }
+
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 5));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("first", NVS_READONLY, &handle));
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_open("second", NVS_READONLY, &handle));
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_open("third", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_u8(handle, "key", 3));
+    nvs_close(handle);
+    nvs_stats_t stats;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.namespace_count == 3);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+#ifdef CONFIG_NVS_FAST_MOUNT
+TEST_CASE("page loaded from its summary matches a fully loaded page", "[nvs]")
+{
+    SpiFlashEmulator emu(3);
+    Page page;
+    TEST_ESP_OK(page.load(0));
+    TEST_ESP_OK(page.writeItem(Page::NS_INDEX, "config", static_cast<uint8_t>(1)));
+    char key[16];
+    char str[] = "some string value";
+    size_t count = 0;
+    esp_err_t err = ESP_OK;
+    while (err == ESP_OK) {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(count));
+        if (count % 5 == 0) {
+            err = page.writeItem(1, ItemType::SZ, key, str, strlen(str) + 1);
+        } else {
+            err = page.writeItem(1, key, static_cast<uint32_t>(count));
+        }
+        count += (err == ESP_OK) ? 1 : 0;
+    }
+    CHECK(err == ESP_ERR_NVS_PAGE_FULL);
+    TEST_ESP_OK(page.markFull());
+
+    uint8_t summary[Page::SUMMARY_MAX_SIZE];
+    size_t summarySize;
+    TEST_ESP_OK(page.getSummary(summary, summarySize));
+    CHECK(summarySize == sizeof(Page::SummaryHeader) + (count + 1) * sizeof(uint32_t));
+
+    // items erased after the summary was built must stay erased
+    TEST_ESP_OK(page.eraseItem<uint32_t>(1, "key1"));
+    TEST_ESP_OK(page.eraseItem(1, ItemType::SZ, "key5"));
+
+    Page fromSummary;
+    TEST_ESP_OK(fromSummary.loadHeader(0));
+    emu.clearStats();
+    TEST_ESP_OK(fromSummary.loadEntries(summary, summarySize));
+    CHECK(fromSummary.isLoadedFromSummary());
+    CHECK(emu.getReadOps() == 1);
+
+    Page full;
+    TEST_ESP_OK(full.load(0));
+    CHECK(!full.isLoadedFromSummary());
+    CHECK(fromSummary.getUsedEntryCount() == full.getUsedEntryCount());
+    CHECK(fromSummary.getErasedEntryCount() == full.getErasedEntryCount());
+    for (size_t i = 0; i < count; ++i) {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+        ItemType type = (i % 5 == 0) ? ItemType::SZ : ItemType::U32;
+        esp_err_t expected = (i == 1 || i == 5) ? ESP_ERR_NVS_NOT_FOUND : ESP_OK;
+        CHECK(fromSummary.findItem(1, type, key) == expected);
+        CHECK(full.findItem(1, type, key) == expected);
+    }
+
+    // scans for namespace entries only read special entries
+    size_t itemIndex = 0;
+    Item item;
+    emu.clearStats();
+    TEST_ESP_OK(fromSummary.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item));
+    CHECK(emu.getReadOps() == 1);
+    CHECK(strcmp(item.key, "config") == 0);
+    itemIndex += item.span;
+    CHECK(fromSummary.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item) == ESP_ERR_NVS_NOT_FOUND);
+
+    // a summary of another page is not used
+    reinterpret_cast<Page::SummaryHeader*>(summary)->seqNumber += 1;
+    Page mismatch;
+    TEST_ESP_OK(mismatch.loadHeader(0));
+    TEST_ESP_OK(mismatch.loadEntries(summary, summarySize));
+    CHECK(!mismatch.isLoadedFromSummary());
+    CHECK(mismatch.getUsedEntryCount() == full.getUsedEntryCount());
+    TEST_ESP_OK(mismatch.findItem(1, ItemType::U32, "key2"));
+}
+
+static void check_fast_mount_keys(size_t count)
+{
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("config", NVS_READONLY, &handle));
+    for (size_t i = 0; i < count; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", static_cast<int>(i));
+        uint32_t value;
+        TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+        CHECK(value == i);
+    }
+    size_t size = 0;
+    TEST_ESP_OK(nvs_get_blob(handle, "blob", nullptr, &size));
+    CHECK(size == Page::CHUNK_MAX_SIZE * 2);
+    nvs_close(handle);
+}
+
+TEST_CASE("fast mount uses page summaries written on deinit", "[nvs]")
+{
+    const size_t sectors = 64;
+    const size_t keyCount = 3000;
+    SpiFlashEmulator emu(sectors);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("config", NVS_READWRITE, &handle));
+    for (size_t i = 0; i < keyCount; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", static_cast<int>(i));
+        TEST_ESP_OK(nvs_set_u32(handle, key, i));
+    }
+    uint8_t* blob = new uint8_t[Page::CHUNK_MAX_SIZE * 2];
+    std::fill_n(blob, Page::CHUNK_MAX_SIZE * 2, 0x5a);
+    TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, Page::CHUNK_MAX_SIZE * 2));
+    nvs_close(handle);
+
+    // mounting again without deinit finds no summaries
+    emu.clearStats();
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    const size_t fullReads = emu.getReadOps();
+    const size_t fullTime = emu.getTotalTime();
+    nvs_stats_t fullStats;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &fullStats));
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    emu.clearStats();
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    const size_t fastReads = emu.getReadOps();
+    const size_t fastTime = emu.getTotalTime();
+    CHECK(fastReads * 3 < fullReads);
+    check_fast_mount_keys(keyCount);
+
+    nvs_stats_t fastStats;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &fastStats));
+    CHECK(fastStats.namespace_count == fullStats.namespace_count);
+    CHECK(fastStats.used_entries > fullStats.used_entries); // the summaries
+
+    // pages filled after the last deinit are scanned in full, as after a power loss
+    TEST_ESP_OK(nvs_open("config", NVS_READWRITE, &handle));
+    for (size_t i = 0; i < keyCount / 2; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", static_cast<int>(i));
+        TEST_ESP_OK(nvs_set_u32(handle, key, i + 1));
+        TEST_ESP_OK(nvs_set_u32(handle, key, i));
+    }
+    nvs_close(handle);
+    emu.clearStats();
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    const size_t uncleanReads = emu.getReadOps();
+    CHECK(uncleanReads > fastReads);
+    check_fast_mount_keys(keyCount);
+
+    // deinit drops the summaries of pages freed in the meantime
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    check_fast_mount_keys(keyCount);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    delete[] blob;
+
+    s_perf << "Mount of " << sectors << " sectors with " << keyCount << " keys: full scan "
+           << fullReads << " reads, " << fullTime << " us; from summaries "
+           << fastReads << " reads, " << fastTime << " us; after unclean shutdown "
+           << uncleanReads << " reads" << std::endl;
+}
+
+TEST_CASE("namespaces created after page summaries were written are found on remount", "[nvs]")
+{
+    const size_t sectors = 8;
+    SpiFlashEmulator emu(sectors);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("first", NVS_READWRITE, &handle));
+    // fill two pages, so that deinit writes their summaries into the active page
+    for (size_t i = 0; i < Page::ENTRY_COUNT * 2; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", static_cast<int>(i));
+        TEST_ESP_OK(nvs_set_u32(handle, key, i));
+    }
+    nvs_close(handle);
+    emu.clearStats();
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    CHECK(emu.getWriteOps() > 0);
+
+    // the new namespace entry follows the summaries in the active page
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    TEST_ESP_OK(nvs_open("second", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_u8(handle, "value", 2));
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, sectors));
+    TEST_ESP_OK(nvs_open("second", NVS_READONLY, &handle));
+    uint8_t value;
+    TEST_ESP_OK(nvs_get_u8(handle, "value", &value));
+    CHECK(value == 2);
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_open("first", NVS_READONLY, &handle));
+    uint32_t k0;
+    TEST_ESP_OK(nvs_get_u32(handle, "k0", &k0));
+    CHECK(k0 == 0);
+    nvs_close(handle);
+    nvs_stats_t stats;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.namespace_count == 2);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+#endif // CONFIG_NVS_FAST_MOUNT
+
+#ifdef CONFIG_NVS_VALUE_CACHE
+TEST_CASE("value cache serves repeated reads from RAM", "[nvs]")
+{
+    SpiFlashEmulator emu(5);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 5));
+    nvs_handle_t handle, other;
+    TEST_ESP_OK(nvs_open("flags", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_open("other", NVS_READWRITE, &other));
+    TEST_ESP_OK(nvs_set_value_cache(handle, true));
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 42));
+    TEST_ESP_OK(nvs_set_u32(other, "counter", 7));
+    TEST_ESP_OK(nvs_set_str(handle, "mode", "eco"));
+    const uint8_t blob[] = {1, 2, 3, 4, 5};
+    TEST_ESP_OK(nvs_set_blob(handle, "calib", blob, sizeof(blob)));
+
+    uint32_t value;
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &value));
+    emu.clearStats();
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &value));
+    CHECK(value == 42);
+    CHECK(emu.getReadOps() == 0);
+
+    // other namespaces are not cached
+    TEST_ESP_OK(nvs_get_u32(other, "counter", &value));
+    TEST_ESP_OK(nvs_get_u32(other, "counter", &value));
+    CHECK(value == 7);
+    CHECK(emu.getReadOps() > 0);
+
+    char str[16];
+    size_t len = sizeof(str);
+    TEST_ESP_OK(nvs_get_str(handle, "mode", str, &len));
+    uint8_t blobOut[sizeof(blob)];
+    len = sizeof(blobOut);
+    TEST_ESP_OK(nvs_get_blob(handle, "calib", blobOut, &len));
+    emu.clearStats();
+    len = sizeof(str);
+    TEST_ESP_OK(nvs_get_str(handle, "mode", str, &len));
+    CHECK(strcmp(str, "eco") == 0);
+    CHECK(len == 4);
+    len = sizeof(blobOut);
+    TEST_ESP_OK(nvs_get_blob(handle, "calib", blobOut, &len));
+    CHECK(memcmp(blob, blobOut, sizeof(blob)) == 0);
+    CHECK(emu.getReadOps() == 0);
+
+    nvs_value_cache_stats_t stats;
+    TEST_ESP_OK(nvs_get_value_cache_stats(NULL, &stats));
+    CHECK(stats.hits == 3);
+    CHECK(stats.misses == 3);
+    CHECK(stats.entry_count == 3);
+
+    // writes and erasures drop the cached value
+    TEST_ESP_OK(nvs_set_u32(handle, "counter", 43));
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &value));
+    CHECK(value == 43);
+    TEST_ESP_OK(nvs_erase_key(handle, "counter"));
+    TEST_ESP_ERR(nvs_get_u32(handle, "counter", &value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_str(handle, "mode", "boost"));
+    TEST_ESP_OK(nvs_transaction_commit(handle));
+    len = sizeof(str);
+    TEST_ESP_OK(nvs_get_str(handle, "mode", str, &len));
+    CHECK(strcmp(str, "boost") == 0);
+    TEST_ESP_OK(nvs_erase_all(handle));
+    len = sizeof(blobOut);
+    TEST_ESP_ERR(nvs_get_blob(handle, "calib", blobOut, &len), ESP_ERR_NVS_NOT_FOUND);
+
+    // the least recently used values are evicted to stay within the configured size
+    for (int i = 0; i < 100; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%d", i);
+        TEST_ESP_OK(nvs_set_i32(handle, key, i));
+        int32_t v;
+        TEST_ESP_OK(nvs_get_i32(handle, key, &v));
+    }
+    TEST_ESP_OK(nvs_get_value_cache_stats(NULL, &stats));
+    CHECK(stats.evictions > 0);
+    CHECK(stats.used_bytes <= stats.capacity);
+    CHECK(stats.capacity == CONFIG_NVS_VALUE_CACHE_SIZE);
+
+    TEST_ESP_OK(nvs_set_value_cache(handle, false));
+    TEST_ESP_OK(nvs_get_value_cache_stats(NULL, &stats));
+    CHECK(stats.entry_count == 0);
+
+    nvs_close(handle);
+    nvs_close(other);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("benchmark polling a key with and without value cache", "[nvs]")
+{
+    const int pollCount = 1000;
+    size_t readOps[2];
+    size_t totalTime[2];
+    for (int useCache = 0; useCache < 2; ++useCache) {
+        SpiFlashEmulator emu(10);
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 10));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("flags", NVS_READWRITE, &handle));
+        if (useCache) {
+            TEST_ESP_OK(nvs_set_value_cache(handle, true));
+        }
+        for (int i = 0; i < 200; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "filler%d", i);
+            TEST_ESP_OK(nvs_set_i32(handle, key, i));
+        }
+        TEST_ESP_OK(nvs_set_u32(handle, "feature", 1));
+        TEST_ESP_OK(nvs_set_str(handle, "region", "eu-868"));
+
+        emu.clearStats();
+        for (int i = 0; i < pollCount; ++i) {
+            uint32_t value;
+            TEST_ESP_OK(nvs_get_u32(handle, "feature", &value));
+            char str[16];
+            size_t len = sizeof(str);
+            TEST_ESP_OK(nvs_get_str(handle, "region", str, &len));
+        }
+        readOps[useCache] = emu.getReadOps();
+        totalTime[useCache] = emu.getTotalTime();
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+    CHECK(readOps[1] < readOps[0]);
+    s_perf << "Polling a u32 and a string " << pollCount << " times: " << readOps[0] << " reads, "
+           << totalTime[0] << " us; with value cache " << readOps[1] << " reads, "
+           << totalTime[1] << " us" << std::endl;
+}
+
+#endif // CONFIG_NVS_VALUE_CACHE
+
 TEST_CASE("Multi-page blobs are supported", "[nvs]")
 {
     const size_t blob_size = Page::CHUNK_MAX_SIZE *2;
@@ -2044,6 +3083,303 @@ TEST_CASE("Reading multi-page blobs", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
 }
 
+TEST_CASE("blobs can be written in pieces and read at an offset", "[nvs]")
+{
+    const size_t blob_size = 20000;
+    uint8_t* blob = new uint8_t[blob_size];
+    uint8_t* blob_read = new uint8_t[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 7 + i / 256);
+    }
+    SpiFlashEmulator emu(10);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 10));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("stream", NVS_READWRITE, &handle));
+    uint8_t old_value[4] = {1, 2, 3, 4};
+    TEST_ESP_OK(nvs_set_blob(handle, "cert", old_value, sizeof(old_value)));
+
+    TEST_ESP_ERR(nvs_blob_write(handle, blob, 10), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_OK(nvs_blob_write_begin(handle, "cert"));
+    TEST_ESP_ERR(nvs_blob_write_begin(handle, "other"), ESP_ERR_NVS_INVALID_STATE);
+    // small pieces go through the buffer, large ones straight to flash
+    size_t offset = 0;
+    for (size_t piece = 1; offset < blob_size; piece = (piece * 3) % 1500 + 1) {
+        size_t len = std::min(piece, blob_size - offset);
+        TEST_ESP_OK(nvs_blob_write(handle, blob + offset, len));
+        offset += len;
+    }
+    // the previous value is visible until the write is finished
+    size_t read_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "cert", blob_read, &read_size));
+    CHECK(read_size == sizeof(old_value));
+    TEST_ESP_OK(nvs_blob_write_end(handle));
+    TEST_ESP_ERR(nvs_blob_write_end(handle), ESP_ERR_NVS_INVALID_STATE);
+
+    read_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "cert", blob_read, &read_size));
+    CHECK(read_size == blob_size);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+
+    const size_t offsets[] = {0, 1, 31, 32, 255, 3999, 4000, 12345, blob_size - 33, blob_size - 1};
+    const size_t lengths[] = {1, 31, 32, 33, 100, 4096, 8000};
+    for (size_t o : offsets) {
+        for (size_t l : lengths) {
+            memset(blob_read, 0xee, blob_size);
+            size_t len = l;
+            TEST_ESP_OK(nvs_get_blob_at(handle, "cert", o, blob_read, &len));
+            CHECK(len == std::min(l, blob_size - o));
+            CHECK(memcmp(blob + o, blob_read, len) == 0);
+            CHECK(blob_read[len] == 0xee);
+        }
+    }
+    size_t len = 10;
+    TEST_ESP_OK(nvs_get_blob_at(handle, "cert", blob_size, blob_read, &len));
+    CHECK(len == 0);
+    len = 10;
+    TEST_ESP_ERR(nvs_get_blob_at(handle, "cert", blob_size + 1, blob_read, &len), ESP_ERR_NVS_INVALID_LENGTH);
+    TEST_ESP_ERR(nvs_get_blob_at(handle, "missing", 0, blob_read, &len), ESP_ERR_NVS_NOT_FOUND);
+
+    // an aborted write leaves the value and the used entries as they were
+    nvs_stats_t before, after;
+    TEST_ESP_OK(nvs_get_stats(NULL, &before));
+    TEST_ESP_OK(nvs_blob_write_begin(handle, "cert"));
+    TEST_ESP_OK(nvs_blob_write(handle, blob, 5000));
+    TEST_ESP_OK(nvs_blob_write_abort(handle));
+    TEST_ESP_OK(nvs_get_stats(NULL, &after));
+    CHECK(after.used_entries == before.used_entries);
+    len = blob_size;
+    TEST_ESP_OK(nvs_get_blob_at(handle, "cert", 0, blob_read, &len));
+    CHECK(len == blob_size);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+
+    // setting the key by other means cancels the write
+    TEST_ESP_OK(nvs_blob_write_begin(handle, "cert"));
+    TEST_ESP_OK(nvs_blob_write(handle, blob, 3000));
+    TEST_ESP_OK(nvs_set_blob(handle, "cert", old_value, sizeof(old_value)));
+    TEST_ESP_ERR(nvs_blob_write(handle, blob, 10), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_blob_write_end(handle), ESP_ERR_NVS_INVALID_STATE);
+    read_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "cert", blob_read, &read_size));
+    CHECK(read_size == sizeof(old_value));
+
+    // chunks of an unfinished write are dropped on the next init
+    TEST_ESP_OK(nvs_get_stats(NULL, &before));
+    TEST_ESP_OK(nvs_blob_write_begin(handle, "cert"));
+    TEST_ESP_OK(nvs_blob_write(handle, blob, 9000));
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 10));
+    TEST_ESP_OK(nvs_get_stats(NULL, &after));
+    CHECK(after.used_entries == before.used_entries);
+    TEST_ESP_ERR(nvs_blob_write_end(handle), ESP_ERR_NVS_INVALID_STATE);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_open("stream", NVS_READWRITE, &handle));
+    read_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "cert", blob_read, &read_size));
+    CHECK(read_size == sizeof(old_value));
+    // an empty blob
+    TEST_ESP_OK(nvs_blob_write_begin(handle, "empty"));
+    TEST_ESP_OK(nvs_blob_write_end(handle));
+    read_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "empty", blob_read, &read_size));
+    CHECK(read_size == 0);
+    TEST_ESP_ERR(nvs_blob_write(handle, blob, 10), ESP_ERR_NVS_INVALID_STATE);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    delete[] blob;
+    delete[] blob_read;
+}
+
+TEST_CASE("reading part of a blob only reads the chunks it overlaps", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 6;
+    uint8_t* blob = new uint8_t[blob_size];
+    std::fill_n(blob, blob_size, 0x3c);
+    SpiFlashEmulator emu(10);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 10));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("stream", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "table", blob, blob_size));
+
+    emu.clearStats();
+    size_t len = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "table", blob, &len));
+    const size_t fullBytes = emu.getReadBytes();
+    const size_t fullTime = emu.getTotalTime();
+
+    uint8_t part[64];
+    emu.clearStats();
+    len = sizeof(part);
+    TEST_ESP_OK(nvs_get_blob_at(handle, "table", blob_size - 1000, part, &len));
+    const size_t partBytes = emu.getReadBytes();
+    const size_t partTime = emu.getTotalTime();
+    CHECK(len == sizeof(part));
+    CHECK(partBytes * 4 < fullBytes);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    delete[] blob;
+
+    s_perf << "Reading 64 bytes of a " << blob_size << " byte blob: " << partBytes << " bytes read, "
+           << partTime << " us; whole blob: " << fullBytes << " bytes read, " << fullTime << " us" << std::endl;
+}
+
+#ifdef CONFIG_NVS_INCREMENTAL_GC
+TEST_CASE("incremental gc keeps writes from copying pages", "[nvs]")
+{
+    const uint32_t SECTORS = 8;
+    const size_t KEY_COUNT = 40;
+    const size_t WRITE_COUNT = 3000;
+    // buckets of emulated write time: below 100 us, 1 ms, 10 ms and above
+    const size_t bucketLimits[] = {100, 1000, 10000};
+    const size_t BUCKET_COUNT = sizeof(bucketLimits) / sizeof(bucketLimits[0]) + 1;
+
+    for (int useGc = 0; useGc < 2; ++useGc) {
+        SpiFlashEmulator emu(SECTORS);
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("gc", NVS_READWRITE, &handle));
+
+        std::mt19937 gen(42);
+        std::vector<uint32_t> values(KEY_COUNT);
+        size_t histogram[BUCKET_COUNT] = {};
+        size_t maxTime = 0;
+        size_t erasingWrites = 0;
+        size_t gcTime = 0;
+        for (size_t i = 0; i < WRITE_COUNT; ++i) {
+            size_t index = gen() % KEY_COUNT;
+            uint32_t value = gen();
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(index));
+
+            const size_t eraseOps = emu.getEraseOps();
+            const size_t startTime = emu.getTotalTime();
+            TEST_ESP_OK(nvs_set_u32(handle, key, value));
+            const size_t elapsed = emu.getTotalTime() - startTime;
+            values[index] = value;
+
+            erasingWrites += (emu.getEraseOps() != eraseOps);
+            maxTime = std::max(maxTime, elapsed);
+            size_t bucket = 0;
+            while (bucket < BUCKET_COUNT - 1 && elapsed >= bucketLimits[bucket]) {
+                ++bucket;
+            }
+            ++histogram[bucket];
+
+            if (useGc) {
+                const size_t gcStartTime = emu.getTotalTime();
+                TEST_ESP_OK(nvs_gc_step(NULL, 8, NULL));
+                gcTime += emu.getTotalTime() - gcStartTime;
+            }
+        }
+
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+            uint32_t value;
+            TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+            CHECK(value == values[i]);
+        }
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+
+        if (useGc) {
+            CHECK(erasingWrites == 0);
+            CHECK(maxTime < bucketLimits[1]);
+        } else {
+            CHECK(erasingWrites > 0);
+        }
+
+        s_perf << "Latency of " << WRITE_COUNT << " u32 writes " << (useGc ? "with" : "without")
+               << " incremental gc: <100 us " << histogram[0] << ", <1 ms " << histogram[1]
+               << ", <10 ms " << histogram[2] << ", >=10 ms " << histogram[3]
+               << "; max " << maxTime << " us, " << erasingWrites << " writes erased a sector";
+        if (useGc) {
+            s_perf << ", " << gcTime << " us spent in gc steps";
+        }
+        s_perf << std::endl;
+    }
+}
+
+TEST_CASE("incremental gc keeps all values if power goes out during a step", "[nvs]")
+{
+    const uint32_t SECTORS = 5;
+    const size_t KEY_COUNT = 20;
+    const size_t WRITE_COUNT = 3 * Page::ENTRY_COUNT;
+
+    auto prepare = [&](SpiFlashEmulator& emu) {
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("gc", NVS_READWRITE, &handle));
+        // fill all but the last free page, keeping the latest value of every key on several pages
+        for (size_t i = 0; i < WRITE_COUNT; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(i % KEY_COUNT));
+            TEST_ESP_OK(nvs_set_u32(handle, key, i));
+        }
+        TEST_ESP_OK(nvs_set_str(handle, "str", "some string value"));
+        nvs_close(handle);
+        emu.clearStats();
+    };
+
+    auto runGc = [&]() -> esp_err_t {
+        bool done = false;
+        while (!done) {
+            auto err = nvs_gc_step(NULL, 4, &done);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        return ESP_OK;
+    };
+
+    auto verify = [&]() {
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("gc", NVS_READONLY, &handle));
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+            uint32_t value;
+            TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+            CHECK(value == WRITE_COUNT - 1 - (WRITE_COUNT - 1 - i) % KEY_COUNT);
+        }
+        char str[32];
+        size_t strSize = sizeof(str);
+        TEST_ESP_OK(nvs_get_str(handle, "str", str, &strSize));
+        CHECK(strcmp(str, "some string value") == 0);
+        nvs_close(handle);
+    };
+
+    size_t totalWords;
+    {
+        SpiFlashEmulator emu(SECTORS);
+        prepare(emu);
+        TEST_ESP_OK(runGc());
+        totalWords = emu.getWriteBytes() / 4 + emu.getEraseOps();
+        CHECK(emu.getEraseOps() > 0);
+        nvs_stats_t stats;
+        TEST_ESP_OK(nvs_get_stats(NULL, &stats));
+        CHECK(stats.free_entries >= CONFIG_NVS_GC_RESERVE_PAGES * Page::ENTRY_COUNT);
+        verify();
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+
+    for (size_t failAfter = 0; failAfter < totalWords; failAfter += 3) {
+        SpiFlashEmulator emu(SECTORS);
+        prepare(emu);
+        emu.failAfter(failAfter);
+        CHECK(runGc() != ESP_OK);
+
+        TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+        verify();
+        TEST_ESP_OK(runGc());
+        verify();
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+}
+
+#endif // CONFIG_NVS_INCREMENTAL_GC
+
 TEST_CASE("Modification of values for Multi-page blobs are supported", "[nvs]")
 {
     const size_t blob_size = Page::CHUNK_MAX_SIZE *2;
@@ -2945,6 +4281,114 @@ TEST_CASE("test nvs apis with encryption enabled", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit());
 }
 
+TEST_CASE("encrypted values spanning many entries are read and written in one go", "[nvs]")
+{
+    const uint32_t SECTORS = 6;
+    SpiFlashEmulator emu(SECTORS);
+    nvs_sec_cfg_t xts_cfg;
+    for (int count = 0; count < NVS_KEY_SIZE; count++) {
+        xts_cfg.eky[count] = 0x33;
+        xts_cfg.tky[count] = 0x44;
+    }
+    TEST_ESP_OK(nvs_flash_secure_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS, &xts_cfg));
+
+    const size_t blob_size = Page::CHUNK_MAX_SIZE + 1000;
+    uint8_t* blob = new uint8_t[blob_size];
+    uint8_t* blob_read = new uint8_t[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 7);
+    }
+    char str[500];
+    for (size_t i = 0; i < sizeof(str) - 1; ++i) {
+        str[i] = 'a' + i % 26;
+    }
+    str[sizeof(str) - 1] = 0;
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("secure", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, blob_size));
+    TEST_ESP_OK(nvs_set_str(handle, "str", str));
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+
+    // nothing of the values is stored in plain text
+    CHECK(std::search(emu.bytes(), emu.bytes() + emu.size(), str, str + 32) == emu.bytes() + emu.size());
+
+    TEST_ESP_OK(nvs_flash_secure_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS, &xts_cfg));
+    TEST_ESP_OK(nvs_open("secure", NVS_READONLY, &handle));
+    size_t len = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "blob", blob_read, &len));
+    CHECK(len == blob_size);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+    len = 300;
+    TEST_ESP_OK(nvs_get_blob_at(handle, "blob", 1000, blob_read, &len));
+    CHECK(memcmp(blob + 1000, blob_read, 300) == 0);
+    char str_read[sizeof(str)];
+    len = sizeof(str_read);
+    TEST_ESP_OK(nvs_get_str(handle, "str", str_read, &len));
+    CHECK(strcmp(str, str_read) == 0);
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+
+    delete[] blob;
+    delete[] blob_read;
+}
+
+TEST_CASE("benchmark encrypted vs. plain text blob throughput", "[nvs]")
+{
+    const uint32_t SECTORS = 10;
+    const size_t blob_size = 8192;
+    const int rounds = 20;
+    uint8_t* blob = new uint8_t[blob_size];
+    std::fill_n(blob, blob_size, 0x5a);
+
+    nvs_sec_cfg_t xts_cfg;
+    for (int count = 0; count < NVS_KEY_SIZE; count++) {
+        xts_cfg.eky[count] = 0x55;
+        xts_cfg.tky[count] = 0x66;
+    }
+
+    double throughput[2][2]; // [encrypted][write, read], in kB/s of CPU time
+    for (int encrypted = 0; encrypted < 2; ++encrypted) {
+        SpiFlashEmulator emu(SECTORS);
+        if (encrypted) {
+            TEST_ESP_OK(nvs_flash_secure_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS, &xts_cfg));
+        } else {
+            TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, SECTORS));
+        }
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("bench", NVS_READWRITE, &handle));
+
+        std::chrono::steady_clock::duration writeTime(0), readTime(0);
+        for (int i = 0; i < rounds; ++i) {
+            blob[0] = static_cast<uint8_t>(i);
+            auto start = std::chrono::steady_clock::now();
+            TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, blob_size));
+            writeTime += std::chrono::steady_clock::now() - start;
+
+            size_t len = blob_size;
+            start = std::chrono::steady_clock::now();
+            TEST_ESP_OK(nvs_get_blob(handle, "blob", blob, &len));
+            readTime += std::chrono::steady_clock::now() - start;
+            CHECK(blob[0] == static_cast<uint8_t>(i));
+        }
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+
+        using std::chrono::microseconds;
+        using std::chrono::duration_cast;
+        const double kBytes = rounds * blob_size / 1024.0;
+        throughput[encrypted][0] = kBytes * 1e6 / std::max<long>(1, duration_cast<microseconds>(writeTime).count());
+        throughput[encrypted][1] = kBytes * 1e6 / std::max<long>(1, duration_cast<microseconds>(readTime).count());
+    }
+    delete[] blob;
+
+    s_perf << "Blob throughput (" << blob_size << " bytes, host CPU time): plain text write "
+           << static_cast<int>(throughput[0][0]) << " kB/s, read " << static_cast<int>(throughput[0][1])
+           << " kB/s; encrypted write " << static_cast<int>(throughput[1][0]) << " kB/s, read "
+           << static_cast<int>(throughput[1][1]) << " kB/s" << std::endl;
+}
+
 TEST_CASE("test nvs apis for nvs partition generator utility with encryption enabled", "[nvs_part_gen]")
 {
     int status;
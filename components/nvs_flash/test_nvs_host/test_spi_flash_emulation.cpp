@@ -154,3 +154,17 @@ TEST_CASE("data is randomized predictably", "[spi_flash_emu]")
     CHECK(std::equal(emu1.bytes(), emu1.bytes() + emu1.size(), emu2.bytes()));
 }
 
+
+TEST_CASE("erase operations are counted per sector", "[spi_flash_emu]")
+{
+    SpiFlashEmulator emu(4);
+    spi_flash_erase_sector(1);
+    spi_flash_erase_sector(3);
+    spi_flash_erase_sector(3);
+    CHECK(emu.getEraseOps() == 3);
+    CHECK(emu.getSectorEraseOps(0) == 0);
+    CHECK(emu.getSectorEraseOps(1) == 1);
+    CHECK(emu.getSectorEraseOps(3) == 2);
+    emu.clearStats();
+    CHECK(emu.getSectorEraseOps(3) == 0);
+}
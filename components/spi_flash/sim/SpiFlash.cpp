@@ -29,6 +29,31 @@ using namespace std;
 
 #define DIV_AND_CEIL(x, y)              ((x) / (y) + ((x) % (y) > 0))
 
+// Timing data for 80MHz flash frequency, the same as used by the NVS flash emulator.
+// All values are in microseconds, for block sizes starting at 4 bytes and going up to 4096 bytes.
+static const uint32_t s_read_times[] = {7, 5, 6, 7, 11, 18, 32, 60, 118, 231, 459};
+static const uint32_t s_write_times[] = {19, 23, 35, 57, 106, 205, 417, 814, 1622, 3200, 6367};
+static const uint32_t s_sector_erase_time = 37142;
+
+static uint32_t time_interp(uint32_t bytes, const uint32_t *lut)
+{
+    if (bytes < 8) {
+        return lut[0];
+    }
+    if (bytes > 4096) {
+        return bytes / 4096 * lut[10] + time_interp(bytes % 4096, lut);
+    }
+    int log_size = 32 - __builtin_clz(bytes / 4);
+    if (log_size > 10) {
+        return lut[10];
+    }
+    uint32_t x2 = 1 << (log_size + 2);
+    uint32_t y2 = lut[log_size];
+    uint32_t x1 = 1 << (log_size + 1);
+    uint32_t y1 = lut[log_size - 1];
+    return (bytes - x1) * (y2 - y1) / (x2 - x1) + y1;
+}
+
 SpiFlash::SpiFlash()
 {
     return;
@@ -62,6 +87,7 @@ void SpiFlash::init(uint32_t chip_size, uint32_t block_size, uint32_t sector_siz
     this->erase_cycles_limit = 0;
 
     this->total_erase_cycles = 0;
+    this->total_time = 0;
 
     // Load partitions table bin
     this->memory = (uint8_t *) malloc(this->chip_size);
@@ -136,6 +162,8 @@ esp_rom_spiflash_result_t SpiFlash::erase_sector(uint32_t sector)
     uint32_t pages_per_sector = (this->sector_size / this->page_size);
     uint32_t start_page = sector * pages_per_sector;
 
+    this->total_time += s_sector_erase_time;
+
     if (this->erase_states[sector]) {
         goto out;
     }
@@ -183,6 +211,7 @@ esp_rom_spiflash_result_t SpiFlash::write(uint32_t dest_addr, const void *src, u
     }
 
     // Do the write
+    this->total_time += time_interp(size, s_write_times);
     for(uint32_t ctr = 0; ctr < size; ctr++)
     {
         uint8_t data = ((uint8_t*)src)[ctr];
@@ -219,6 +248,7 @@ esp_rom_spiflash_result_t SpiFlash::read(uint32_t src_addr, void *dest, uint32_t
     }
 
     // Do the read
+    this->total_time += time_interp(size, s_read_times);
     memcpy(dest, &this->memory[src_addr], size);
     return ESP_ROM_SPIFLASH_RESULT_OK;
 }
@@ -256,4 +286,14 @@ void SpiFlash::reset_erase_cycles()
 void SpiFlash::reset_total_erase_cycles()
 {
     this->total_erase_cycles = 0;
-}
\ No newline at end of file
+}
+
+uint32_t SpiFlash::get_total_time()
+{
+    return this->total_time;
+}
+
+void SpiFlash::reset_total_time()
+{
+    this->total_time = 0;
+}
@@ -54,6 +54,9 @@ public:
     void reset_erase_cycles();
     void reset_total_erase_cycles();
 
+    uint32_t get_total_time();
+    void reset_total_time();
+
     uint8_t* get_memory_ptr(uint32_t src_address);
 
 private:
@@ -75,6 +78,9 @@ private:
     uint32_t total_erase_cycles;
     uint32_t total_erase_cycles_limit;
 
+    // Estimated time of all flash operations, in microseconds
+    uint32_t total_time;
+
     void deinit();
 };
 
@@ -38,11 +38,24 @@ static_assert(sizeof(wl_state_t) % 32 == 0, "wl_state_t structure size must be m
 
 WL_Flash::WL_Flash()
 {
+#if CONFIG_WL_WRITE_CACHE
+    for (size_t i = 0; i < CONFIG_WL_WRITE_CACHE_SECTORS; i++) {
+        this->cache[i].valid = false;
+        this->cache[i].dirty = false;
+        this->cache[i].data = NULL;
+    }
+#endif // CONFIG_WL_WRITE_CACHE
 }
 
 WL_Flash::~WL_Flash()
 {
     free(this->temp_buff);
+    free(this->move_buff);
+#if CONFIG_WL_WRITE_CACHE
+    for (size_t i = 0; i < CONFIG_WL_WRITE_CACHE_SECTORS; i++) {
+        free(this->cache[i].data);
+    }
+#endif // CONFIG_WL_WRITE_CACHE
 }
 
 esp_err_t WL_Flash::config(wl_config_t *cfg, Flash_Access *flash_drv)
@@ -77,6 +90,9 @@ esp_err_t WL_Flash::config(wl_config_t *cfg, Flash_Access *flash_drv)
     if (this->cfg.page_size < this->cfg.sector_size) {
         result = ESP_ERR_INVALID_ARG;
     }
+    if ((this->cfg.page_size % CONFIG_WL_MOVE_CHUNK_SIZE) != 0) {
+        result = ESP_ERR_INVALID_ARG;
+    }
     WL_RESULT_CHECK(result);
 
     this->state_size = this->cfg.sector_size;
@@ -112,6 +128,20 @@ esp_err_t WL_Flash::config(wl_config_t *cfg, Flash_Access *flash_drv)
         result = ESP_ERR_NO_MEM;
     }
     WL_RESULT_CHECK(result);
+    this->move_buff = (uint8_t *)malloc(CONFIG_WL_MOVE_CHUNK_SIZE);
+    if (this->move_buff == NULL) {
+        result = ESP_ERR_NO_MEM;
+    }
+    WL_RESULT_CHECK(result);
+#if CONFIG_WL_WRITE_CACHE
+    for (size_t i = 0; i < CONFIG_WL_WRITE_CACHE_SECTORS; i++) {
+        this->cache[i].data = (uint8_t *)malloc(this->cfg.sector_size);
+        if (this->cache[i].data == NULL) {
+            result = ESP_ERR_NO_MEM;
+        }
+        WL_RESULT_CHECK(result);
+    }
+#endif // CONFIG_WL_WRITE_CACHE
     this->configured = true;
     return ESP_OK;
 }
@@ -125,6 +155,8 @@ esp_err_t WL_Flash::init()
     }
     // If flow will be interrupted by error, then this flag will be false
     this->initialized = false;
+    // A move interrupted by reset is started again from erasing the dummy block
+    this->move_started = false;
     // Init states if it is first time...
     this->flash_drv->read(this->addr_state1, &this->state, sizeof(wl_state_t));
     wl_state_t sa_copy;
@@ -427,63 +459,73 @@ bool WL_Flash::OkBuffSet(int n)
 
 esp_err_t WL_Flash::updateWL()
 {
-    esp_err_t result = ESP_OK;
     this->state.access_count++;
-    if (this->state.access_count < this->state.max_count) {
-        return result;
+    if (this->state.access_count <= this->state.max_count) {
+        // When the move becomes due, its first step is left to maintenanceStep() or to the next erase
+        return ESP_OK;
     }
-    // Here we have to move the block and increase the state
-    this->state.access_count = 0;
-    ESP_LOGV(TAG, "%s - access_count= 0x%08x, pos= 0x%08x", __func__, this->state.access_count, this->state.pos);
-    // copy data to dummy block
+    return this->moveStep(NULL);
+}
+
+esp_err_t WL_Flash::moveStep(bool *done)
+{
+    esp_err_t result = ESP_OK;
+    if (done != NULL) {
+        *done = false;
+    }
+    // The block [pos+1] is copied to the dummy block [pos] in steps, so that one step never
+    // takes longer than erasing the dummy block or copying CONFIG_WL_MOVE_CHUNK_SIZE bytes.
     size_t data_addr = this->state.pos + 1; // next block, [pos+1] copy to [pos]
     if (data_addr >= this->state.max_pos) {
         data_addr = 0;
     }
     data_addr = this->cfg.start_addr + data_addr * this->cfg.page_size;
-    this->dummy_addr = this->cfg.start_addr + this->state.pos * this->cfg.page_size;
-    result = this->flash_drv->erase_range(this->dummy_addr, this->cfg.page_size);
-    if (result != ESP_OK) {
-        ESP_LOGE(TAG, "%s - erase wl dummy sector result= 0x%08x", __func__, result);
-        this->state.access_count = this->state.max_count - 1; // we will update next time
+    if (!this->move_started) {
+        ESP_LOGV(TAG, "%s - access_count= 0x%08x, pos= 0x%08x", __func__, this->state.access_count, this->state.pos);
+        this->dummy_addr = this->cfg.start_addr + this->state.pos * this->cfg.page_size;
+        result = this->flash_drv->erase_range(this->dummy_addr, this->cfg.page_size);
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "%s - erase wl dummy sector result= 0x%08x", __func__, result);
+            return result; // we will try again on the next step
+        }
+        this->move_started = true;
+        this->move_offset = 0;
         return result;
     }
 
-    size_t copy_count = this->cfg.page_size / this->cfg.temp_buff_size;
-    for (size_t i = 0; i < copy_count; i++) {
-        result = this->flash_drv->read(data_addr + i * this->cfg.temp_buff_size, this->temp_buff, this->cfg.temp_buff_size);
+    if (this->move_offset < this->cfg.page_size) {
+        result = this->flash_drv->read(data_addr + this->move_offset, this->move_buff, CONFIG_WL_MOVE_CHUNK_SIZE);
         if (result != ESP_OK) {
             ESP_LOGE(TAG, "%s - not possible to read buffer, will try next time, result= 0x%08x", __func__, result);
-            this->state.access_count = this->state.max_count - 1; // we will update next time
             return result;
         }
-        result = this->flash_drv->write(this->dummy_addr + i * this->cfg.temp_buff_size, this->temp_buff, this->cfg.temp_buff_size);
+        result = this->flash_drv->write(this->dummy_addr + this->move_offset, this->move_buff, CONFIG_WL_MOVE_CHUNK_SIZE);
         if (result != ESP_OK) {
             ESP_LOGE(TAG, "%s - not possible to write buffer, will try next time, result= 0x%08x", __func__, result);
-            this->state.access_count = this->state.max_count - 1; // we will update next time
+            return result;
+        }
+        this->move_offset += CONFIG_WL_MOVE_CHUNK_SIZE;
+        if (this->move_offset < this->cfg.page_size) {
             return result;
         }
     }
     // done... block moved.
-    // Here we will update structures...
-    // Update bits and save to flash:
+    // Update bits of the position in both state copies. The same bits are written to both of them.
     uint32_t byte_pos = this->state.pos * this->cfg.wr_size;
     this->fillOkBuff(this->state.pos);
-    // write state to mem. We updating only affected bits
-    result |= this->flash_drv->write(this->addr_state1 + sizeof(wl_state_t) + byte_pos, this->temp_buff, this->cfg.wr_size);
+    result = this->flash_drv->write(this->addr_state1 + sizeof(wl_state_t) + byte_pos, this->temp_buff, this->cfg.wr_size);
     if (result != ESP_OK) {
         ESP_LOGE(TAG, "%s - update position 1 result= 0x%08x", __func__, result);
-        this->state.access_count = this->state.max_count - 1; // we will update next time
         return result;
     }
-    this->fillOkBuff(this->state.pos);
-    result |= this->flash_drv->write(this->addr_state2 + sizeof(wl_state_t) + byte_pos, this->temp_buff, this->cfg.wr_size);
+    result = this->flash_drv->write(this->addr_state2 + sizeof(wl_state_t) + byte_pos, this->temp_buff, this->cfg.wr_size);
     if (result != ESP_OK) {
         ESP_LOGE(TAG, "%s - update position 2 result= 0x%08x", __func__, result);
-        this->state.access_count = this->state.max_count - 1; // we will update next time
         return result;
     }
 
+    this->move_started = false;
+    this->state.access_count = 0;
     this->state.pos++;
     if (this->state.pos >= this->state.max_pos) {
         this->state.pos = 0;
@@ -511,9 +553,50 @@ esp_err_t WL_Flash::updateWL()
     } else {
         ESP_LOGE(TAG, "%s - result= 0x%08x", __func__, result);
     }
+    if (done != NULL) {
+        *done = true;
+    }
+    return result;
+}
+
+esp_err_t WL_Flash::moveBeforeAccess(size_t virt_addr)
+{
+    esp_err_t result = ESP_OK;
+    if (!this->move_started || this->move_offset == 0) {
+        return result;
+    }
+    size_t data_pos = this->state.pos + 1;
+    if (data_pos >= this->state.max_pos) {
+        data_pos = 0;
+    }
+    if (virt_addr / this->cfg.page_size != data_pos) {
+        return result;
+    }
+    // Part of the block has been copied already, changes to it would be lost. Finish the move first.
+    bool done = false;
+    while (!done) {
+        result = this->moveStep(&done);
+        WL_RESULT_CHECK(result);
+    }
     return result;
 }
 
+esp_err_t WL_Flash::maintenanceStep(bool *done)
+{
+    if (!this->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (this->state.access_count < this->state.max_count) {
+        if (done != NULL) {
+            *done = true;
+        }
+        return ESP_OK;
+    }
+    return this->moveStep(done);
+}
+
+
+
 size_t WL_Flash::calcAddr(size_t addr)
 {
     size_t result = (this->flash_size - this->state.move_count * this->cfg.page_size + addr) % this->flash_size;
@@ -550,8 +633,28 @@ esp_err_t WL_Flash::erase_sector(size_t sector)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - sector= 0x%08x", __func__, (uint32_t) sector);
+#if CONFIG_WL_WRITE_CACHE
+    // The erase is done in RAM, flash is erased only when the sector is written back
+    cache_slot_t *slot = this->cacheFind(sector);
+    if (slot == NULL) {
+        result = this->cacheAlloc(sector, &slot);
+        WL_RESULT_CHECK(result);
+    }
+    memset(slot->data, 0xff, this->cfg.sector_size);
+    slot->dirty = true;
+#else
+    result = this->eraseSectorDirect(sector);
+#endif // CONFIG_WL_WRITE_CACHE
+    return result;
+}
+
+esp_err_t WL_Flash::eraseSectorDirect(size_t sector)
+{
+    esp_err_t result = ESP_OK;
     result = this->updateWL();
     WL_RESULT_CHECK(result);
+    result = this->moveBeforeAccess(this->calcAddr(sector * this->cfg.sector_size));
+    WL_RESULT_CHECK(result);
     size_t virt_addr = this->calcAddr(sector * this->cfg.sector_size);
     result = this->flash_drv->erase_sector((this->cfg.start_addr + virt_addr) / this->cfg.sector_size);
     WL_RESULT_CHECK(result);
@@ -581,12 +684,48 @@ esp_err_t WL_Flash::write(size_t dest_addr, const void *src, size_t size)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - dest_addr= 0x%08x, size= 0x%08x", __func__, (uint32_t) dest_addr, (uint32_t) size);
+#if CONFIG_WL_WRITE_CACHE
+    const uint8_t *src_data = (const uint8_t *)src;
+    while (size > 0) {
+        size_t offset = dest_addr % this->cfg.sector_size;
+        size_t part_size = this->cfg.sector_size - offset;
+        if (part_size > size) {
+            part_size = size;
+        }
+        cache_slot_t *slot = this->cacheFind(dest_addr / this->cfg.sector_size);
+        if (slot != NULL) {
+            // Same result as programming flash: bits can only be cleared
+            for (size_t i = 0; i < part_size; i++) {
+                slot->data[offset + i] &= src_data[i];
+            }
+            slot->dirty = true;
+        } else {
+            result = this->writeDirect(dest_addr, src_data, part_size);
+            WL_RESULT_CHECK(result);
+        }
+        dest_addr += part_size;
+        src_data += part_size;
+        size -= part_size;
+    }
+#else
+    result = this->writeDirect(dest_addr, src, size);
+#endif // CONFIG_WL_WRITE_CACHE
+    return result;
+}
+
+esp_err_t WL_Flash::writeDirect(size_t dest_addr, const void *src, size_t size)
+{
+    esp_err_t result = ESP_OK;
     uint32_t count = (size - 1) / this->cfg.page_size;
     for (size_t i = 0; i < count; i++) {
+        result = this->moveBeforeAccess(this->calcAddr(dest_addr + i * this->cfg.page_size));
+        WL_RESULT_CHECK(result);
         size_t virt_addr = this->calcAddr(dest_addr + i * this->cfg.page_size);
         result = this->flash_drv->write(this->cfg.start_addr + virt_addr, &((uint8_t *)src)[i * this->cfg.page_size], this->cfg.page_size);
         WL_RESULT_CHECK(result);
     }
+    result = this->moveBeforeAccess(this->calcAddr(dest_addr + count * this->cfg.page_size));
+    WL_RESULT_CHECK(result);
     size_t virt_addr_last = this->calcAddr(dest_addr + count * this->cfg.page_size);
     result = this->flash_drv->write(this->cfg.start_addr + virt_addr_last, &((uint8_t *)src)[count * this->cfg.page_size], size - count * this->cfg.page_size);
     WL_RESULT_CHECK(result);
@@ -600,6 +739,34 @@ esp_err_t WL_Flash::read(size_t src_addr, void *dest, size_t size)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - src_addr= 0x%08x, size= 0x%08x", __func__, (uint32_t) src_addr, (uint32_t) size);
+#if CONFIG_WL_WRITE_CACHE
+    uint8_t *dest_data = (uint8_t *)dest;
+    while (size > 0) {
+        size_t offset = src_addr % this->cfg.sector_size;
+        size_t part_size = this->cfg.sector_size - offset;
+        if (part_size > size) {
+            part_size = size;
+        }
+        cache_slot_t *slot = this->cacheFind(src_addr / this->cfg.sector_size);
+        if (slot != NULL) {
+            memcpy(dest_data, &slot->data[offset], part_size);
+        } else {
+            result = this->readDirect(src_addr, dest_data, part_size);
+            WL_RESULT_CHECK(result);
+        }
+        src_addr += part_size;
+        dest_data += part_size;
+        size -= part_size;
+    }
+#else
+    result = this->readDirect(src_addr, dest, size);
+#endif // CONFIG_WL_WRITE_CACHE
+    return result;
+}
+
+esp_err_t WL_Flash::readDirect(size_t src_addr, void *dest, size_t size)
+{
+    esp_err_t result = ESP_OK;
     uint32_t count = (size - 1) / this->cfg.page_size;
     for (size_t i = 0; i < count; i++) {
         size_t virt_addr = this->calcAddr(src_addr + i * this->cfg.page_size);
@@ -624,9 +791,85 @@ wl_config_t *WL_Flash::get_cfg()
 
 esp_err_t WL_Flash::flush()
 {
-    esp_err_t result = ESP_OK;
-    this->state.access_count = this->state.max_count - 1;
-    result = this->updateWL();
+    esp_err_t result = this->sync();
+    WL_RESULT_CHECK(result);
+    // Complete the move which is in progress, or do one more
+    if (this->state.access_count < this->state.max_count) {
+        this->state.access_count = this->state.max_count;
+    }
+    bool done = false;
+    while (!done && result == ESP_OK) {
+        result = this->moveStep(&done);
+    }
     ESP_LOGD(TAG, "%s - result= 0x%08x, move_count= 0x%08x", __func__, result, this->state.move_count);
     return result;
 }
+
+esp_err_t WL_Flash::sync()
+{
+    esp_err_t result = ESP_OK;
+#if CONFIG_WL_WRITE_CACHE
+    if (!this->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (size_t i = 0; i < CONFIG_WL_WRITE_CACHE_SECTORS; i++) {
+        result = this->cacheWriteBack(&this->cache[i]);
+        WL_RESULT_CHECK(result);
+    }
+#endif // CONFIG_WL_WRITE_CACHE
+    return result;
+}
+
+#if CONFIG_WL_WRITE_CACHE
+WL_Flash::cache_slot_t *WL_Flash::cacheFind(size_t sector)
+{
+    for (size_t i = 0; i < CONFIG_WL_WRITE_CACHE_SECTORS; i++) {
+        cache_slot_t *slot = &this->cache[i];
+        if (slot->valid && slot->sector == sector) {
+            slot->last_access = ++this->cache_access_count;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t WL_Flash::cacheAlloc(size_t sector, cache_slot_t **out_slot)
+{
+    esp_err_t result = ESP_OK;
+    // Take a free slot, or the least recently used one
+    cache_slot_t *slot = &this->cache[0];
+    for (size_t i = 0; i < CONFIG_WL_WRITE_CACHE_SECTORS; i++) {
+        if (!this->cache[i].valid) {
+            slot = &this->cache[i];
+            break;
+        }
+        if ((int32_t)(this->cache[i].last_access - slot->last_access) < 0) {
+            slot = &this->cache[i];
+        }
+    }
+    // If the write back fails, the slot keeps its data and will be written back on the next attempt
+    result = this->cacheWriteBack(slot);
+    WL_RESULT_CHECK(result);
+    ESP_LOGV(TAG, "%s - sector= 0x%08x, slot= %i", __func__, (uint32_t) sector, (int)(slot - this->cache));
+    slot->sector = sector;
+    slot->valid = true;
+    slot->last_access = ++this->cache_access_count;
+    *out_slot = slot;
+    return result;
+}
+
+esp_err_t WL_Flash::cacheWriteBack(cache_slot_t *slot)
+{
+    esp_err_t result = ESP_OK;
+    if (!slot->valid || !slot->dirty) {
+        return result;
+    }
+    ESP_LOGD(TAG, "%s - sector= 0x%08x", __func__, (uint32_t) slot->sector);
+    result = this->eraseSectorDirect(slot->sector);
+    WL_RESULT_CHECK(result);
+    result = this->writeDirect(slot->sector * this->cfg.sector_size, slot->data, this->cfg.sector_size);
+    WL_RESULT_CHECK(result);
+    slot->dirty = false;
+    return result;
+}
+#endif // CONFIG_WL_WRITE_CACHE
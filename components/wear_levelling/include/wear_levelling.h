@@ -112,6 +112,42 @@ esp_err_t wl_write(wl_handle_t handle, size_t dest_addr, const void *src, size_t
 */
 esp_err_t wl_read(wl_handle_t handle, size_t src_addr, void *dest, size_t size);
 
+/**
+* @brief Write data held in the WL write cache to flash
+*
+* If the write cache is enabled (CONFIG_WL_WRITE_CACHE), wl_erase_range and wl_write
+* may keep recently erased sectors in RAM, so data written after the last call of
+* this function can be lost if power goes down. wl_unmount writes the cache back too.
+* Without the write cache this function does nothing.
+*
+* @param handle WL module handle that was initialized before
+*
+* @return
+*       - ESP_OK, if the cached data was written successfully;
+*       - or one of error codes from lower-level flash driver.
+*/
+esp_err_t wl_flush(wl_handle_t handle);
+
+/**
+* @brief Do one step of the wear levelling block move, if a move is due
+*
+* After a number of erase operations, wear levelling moves one flash sector to
+* the spare sector. The move is done in steps: erasing the spare sector, and copying
+* CONFIG_WL_MOVE_CHUNK_SIZE bytes at a time. Each erase operation which comes after
+* the move became due does one step of the move. Calling this function from a
+* low priority task when the application is idle does the steps ahead of time, so
+* that wl_erase_range and wl_write calls don't have to do them.
+*
+* @param handle WL module handle that was initialized before
+* @param[out] done set to true if no move is due, or if this step has completed the move.
+*                  Can be NULL if the caller doesn't need to know.
+*
+* @return
+*       - ESP_OK, if the step was done successfully;
+*       - or one of error codes from lower-level flash driver.
+*/
+esp_err_t wl_maintenance_step(wl_handle_t handle, bool *done);
+
 /**
 * @brief Get size of the WL storage
 *
@@ -15,6 +15,7 @@
 #define _WL_Flash_H_
 
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include "Flash_Access.h"
 #include "WL_Config.h"
 #include "WL_State.h"
@@ -43,6 +44,8 @@ public :
     esp_err_t read(size_t src_addr, void *dest, size_t size) override;
 
     esp_err_t flush() override;
+    esp_err_t sync();
+    esp_err_t maintenanceStep(bool *done);
 
     Flash_Access *get_drv();
     wl_config_t *get_cfg();
@@ -67,8 +70,37 @@ protected:
     size_t dummy_addr;
     uint32_t pos_data[4];
 
+    // Move of the dummy block which is in progress
+    bool move_started = false;
+    size_t move_offset = 0;
+    uint8_t *move_buff = NULL;
+
+#if CONFIG_WL_WRITE_CACHE
+    // Logical sector held in RAM; it is written back to flash by sync() or when the slot is reused
+    typedef struct {
+        size_t sector;
+        uint32_t last_access;
+        bool valid;
+        bool dirty;
+        uint8_t *data;
+    } cache_slot_t;
+
+    cache_slot_t cache[CONFIG_WL_WRITE_CACHE_SECTORS];
+    uint32_t cache_access_count = 0;
+
+    cache_slot_t *cacheFind(size_t sector);
+    esp_err_t cacheAlloc(size_t sector, cache_slot_t **out_slot);
+    esp_err_t cacheWriteBack(cache_slot_t *slot);
+#endif // CONFIG_WL_WRITE_CACHE
+
+    esp_err_t eraseSectorDirect(size_t sector);
+    esp_err_t writeDirect(size_t dest_addr, const void *src, size_t size);
+    esp_err_t readDirect(size_t src_addr, void *dest, size_t size);
+
     esp_err_t initSections();
     esp_err_t updateWL();
+    esp_err_t moveStep(bool *done);
+    esp_err_t moveBeforeAccess(size_t virt_addr);
     esp_err_t recoverPos();
     size_t calcAddr(size_t addr);
 
@@ -6,4 +6,5 @@
 #define CONFIG_ESPTOOLPY_FLASHSIZE "8MB"
 //currently use the legacy implementation, since the stubs for new HAL are not done yet
 #define CONFIG_SPI_FLASH_USE_LEGACY_IMPL 1
-
+#define CONFIG_WL_MOVE_CHUNK_SIZE 1024
+#define CONFIG_ESP_CRC32_TABLE_SLICES 8
@@ -0,0 +1,5 @@
+#pragma once
+// sdkconfig/sdkconfig.h with the optional write cache enabled, see "make test"
+#include "../sdkconfig/sdkconfig.h"
+#define CONFIG_WL_WRITE_CACHE 1
+#define CONFIG_WL_WRITE_CACHE_SECTORS 4
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 #include "esp_spi_flash.h"
 #include "esp_partition.h"
@@ -90,6 +92,150 @@ TEST_CASE("write and read back data", "[wear_levelling]")
     free(read);
 }
 
+#if CONFIG_WL_WRITE_CACHE
+// Updates the same way FAT does when small files are appended: FAT table and directory
+// sectors are rewritten every time, data goes to the next free sector.
+static uint32_t fat_like_workload(wl_handle_t wl_handle, bool flush_every_write)
+{
+    const uint32_t updates = 200;
+    const uint32_t data_sectors = 8;
+    size_t sector_size = wl_sector_size(wl_handle);
+    uint32_t *sector_data = new uint32_t[sector_size / sizeof(uint32_t)];
+
+    spiflash.reset_total_erase_cycles();
+    for (uint32_t k = 0; k < updates; k++) {
+        uint32_t sectors[] = {0, 1, 2 + k % data_sectors};
+        for (uint32_t sector : sectors) {
+            for (uint32_t m = 0; m < sector_size / sizeof(uint32_t); m++) {
+                sector_data[m] = sector * sector_size + k + m;
+            }
+            REQUIRE(wl_erase_range(wl_handle, sector * sector_size, sector_size) == ESP_OK);
+            REQUIRE(wl_write(wl_handle, sector * sector_size, sector_data, sector_size) == ESP_OK);
+            if (flush_every_write) {
+                REQUIRE(wl_flush(wl_handle) == ESP_OK);
+            }
+        }
+    }
+    REQUIRE(wl_flush(wl_handle) == ESP_OK);
+    uint32_t erase_cycles = spiflash.get_total_erase_cycles();
+
+    // The last update of every sector must be in flash after a remount
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+    for (uint32_t sector = 0; sector < 2 + data_sectors; sector++) {
+        uint32_t k = updates - 1;
+        if (sector >= 2) {
+            k -= (updates - 1 - (sector - 2)) % data_sectors;
+        }
+        REQUIRE(wl_read(wl_handle, sector * sector_size, sector_data, sector_size) == ESP_OK);
+        for (uint32_t m = 0; m < sector_size / sizeof(uint32_t); m++) {
+            REQUIRE(sector_data[m] == sector * sector_size + k + m);
+        }
+    }
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+
+    delete[] sector_data;
+    return erase_cycles;
+}
+
+TEST_CASE("write cache reduces erases of rewritten sectors", "[wear_levelling]")
+{
+    _spi_flash_init(CONFIG_ESPTOOLPY_FLASHSIZE, CONFIG_WL_SECTOR_SIZE * 16, CONFIG_WL_SECTOR_SIZE, CONFIG_WL_SECTOR_SIZE, "partition_table.bin");
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    wl_handle_t wl_handle;
+
+    // Flushing after every write gives the same flash operations as without the cache
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+    uint32_t write_through_erases = fat_like_workload(wl_handle, true);
+
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+    uint32_t cached_erases = fat_like_workload(wl_handle, false);
+
+    printf("erase cycles: write through %d, cached %d\n", write_through_erases, cached_erases);
+    // FAT and directory sectors stay in the cache, only data sectors are written back
+    REQUIRE(cached_erases * 2 < write_through_erases);
+}
+#endif // CONFIG_WL_WRITE_CACHE
+
+// Returns the estimated flash time of every sector update, in microseconds
+static std::vector<uint32_t> update_latencies(wl_handle_t wl_handle, bool idle_maintenance)
+{
+    const uint32_t updates = 400;
+    const uint32_t used_sectors = 16;
+    size_t sector_size = wl_sector_size(wl_handle);
+    uint32_t *sector_data = new uint32_t[sector_size / sizeof(uint32_t)];
+    std::vector<uint32_t> latencies;
+
+    for (uint32_t k = 0; k < updates; k++) {
+        uint32_t sector = k % used_sectors;
+        for (uint32_t m = 0; m < sector_size / sizeof(uint32_t); m++) {
+            sector_data[m] = sector * sector_size + k + m;
+        }
+        if (idle_maintenance) {
+            bool done = false;
+            while (!done) {
+                REQUIRE(wl_maintenance_step(wl_handle, &done) == ESP_OK);
+            }
+        }
+
+        spiflash.reset_total_time();
+        REQUIRE(wl_erase_range(wl_handle, sector * sector_size, sector_size) == ESP_OK);
+        REQUIRE(wl_write(wl_handle, sector * sector_size, sector_data, sector_size) == ESP_OK);
+        latencies.push_back(spiflash.get_total_time());
+    }
+
+    delete[] sector_data;
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, uint32_t p)
+{
+    return sorted[(sorted.size() - 1) * p / 100];
+}
+
+TEST_CASE("wear levelling moves are done in steps", "[wear_levelling]")
+{
+    _spi_flash_init(CONFIG_ESPTOOLPY_FLASHSIZE, CONFIG_WL_SECTOR_SIZE * 16, CONFIG_WL_SECTOR_SIZE, CONFIG_WL_SECTOR_SIZE, "partition_table.bin");
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    wl_handle_t wl_handle;
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+
+    std::vector<uint32_t> foreground = update_latencies(wl_handle, false);
+    std::vector<uint32_t> idle = update_latencies(wl_handle, true);
+
+    printf("update latency, us:         p50    p90    p99    max\n");
+    printf("moves in foreground:     %6d %6d %6d %6d\n", percentile(foreground, 50), percentile(foreground, 90),
+           percentile(foreground, 99), foreground.back());
+    printf("moves in maintenance:    %6d %6d %6d %6d\n", percentile(idle, 50), percentile(idle, 90),
+           percentile(idle, 99), idle.back());
+
+    // A foreground update does one step of a move at most, which is not longer than erasing a sector
+    REQUIRE(foreground.back() < 2 * percentile(foreground, 50));
+    // With the moves done by wl_maintenance_step(), updates take the same time
+    REQUIRE(idle.back() == percentile(idle, 50));
+
+    // The moved data stays readable
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+    size_t sector_size = wl_sector_size(wl_handle);
+    uint32_t *sector_data = new uint32_t[sector_size / sizeof(uint32_t)];
+    for (uint32_t sector = 0; sector < 16; sector++) {
+        uint32_t k = 400 - 16 + sector;
+        REQUIRE(wl_read(wl_handle, sector * sector_size, sector_data, sector_size) == ESP_OK);
+        for (uint32_t m = 0; m < sector_size / sizeof(uint32_t); m++) {
+            REQUIRE(sector_data[m] == sector * sector_size + k + m);
+        }
+    }
+    delete[] sector_data;
+    // done is optional
+    REQUIRE(wl_maintenance_step(wl_handle, NULL) == ESP_OK);
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+}
+
 TEST_CASE("power down test", "[wear_levelling]")
 {
     _spi_flash_init(CONFIG_ESPTOOLPY_FLASHSIZE, CONFIG_WL_SECTOR_SIZE * 16, CONFIG_WL_SECTOR_SIZE, CONFIG_WL_SECTOR_SIZE, "partition_table.bin");
@@ -225,6 +225,30 @@ esp_err_t wl_read(wl_handle_t handle, size_t src_addr, void *dest, size_t size)
     return result;
 }
 
+esp_err_t wl_flush(wl_handle_t handle)
+{
+    esp_err_t result = check_handle(handle, __func__);
+    if (result != ESP_OK) {
+        return result;
+    }
+    _lock_acquire(&s_instances[handle].lock);
+    result = s_instances[handle].instance->sync();
+    _lock_release(&s_instances[handle].lock);
+    return result;
+}
+
+esp_err_t wl_maintenance_step(wl_handle_t handle, bool *done)
+{
+    esp_err_t result = check_handle(handle, __func__);
+    if (result != ESP_OK) {
+        return result;
+    }
+    _lock_acquire(&s_instances[handle].lock);
+    result = s_instances[handle].instance->maintenanceStep(done);
+    _lock_release(&s_instances[handle].lock);
+    return result;
+}
+
 size_t wl_size(wl_handle_t handle)
 {
     esp_err_t err = check_handle(handle, __func__);
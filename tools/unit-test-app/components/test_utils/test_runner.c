@@ -47,6 +47,9 @@ void test_main(void)
 
 void unity_reset_leak_checks(void)
 {
+#ifdef CONFIG_HEAP_SLAB_CACHE
+    heap_caps_slab_cache_flush();
+#endif
     before_free_8bit = heap_caps_get_free_size(MALLOC_CAP_8BIT);
     before_free_32bit = heap_caps_get_free_size(MALLOC_CAP_32BIT);
 
@@ -137,6 +140,11 @@ void tearDown(void)
     /* clean up some of the newlib's lazy allocations */
     esp_reent_cleanup();
 
+#ifdef CONFIG_HEAP_SLAB_CACHE
+    /* blocks held in the small allocation caches would be counted as leaked */
+    heap_caps_slab_cache_flush();
+#endif
+
     size_t after_free_8bit = heap_caps_get_free_size(MALLOC_CAP_8BIT);
     size_t after_free_32bit = heap_caps_get_free_size(MALLOC_CAP_32BIT);
     /* We want the teardown to have this file in the printout if TEST_ASSERT fails */